@@ -14,10 +14,12 @@
 //
 // Defines TimeSeriesFramerCalculator.
 #include <math.h>
+#include <string.h>
 
-#include <deque>
+#include <algorithm>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "Eigen/Core"
 #include "audio/dsp/window_functions.h"
@@ -90,6 +92,14 @@ class TimeSeriesFramerCalculator : public CalculatorBase {
  private:
   // Adds input data to the internal buffer.
   void EnqueueInput(CalculatorContext* cc);
+  // Moves the buffered samples to the first columns of sample_buffer_, making
+  // room for at least min_size samples in total.
+  void CompactSampleBuffer(int min_size);
+  // Removes the first num_samples samples from the buffer.
+  void DropSamples(int num_samples) {
+    sample_buffer_start_ += num_samples;
+    sample_buffer_size_ -= num_samples;
+  }
   // Constructs and emits framed output packets.
   void FrameOutput(CalculatorContext* cc);
 
@@ -144,9 +154,16 @@ class TimeSeriesFramerCalculator : public CalculatorBase {
   Timestamp current_timestamp_;
   int num_channels_;
 
-  // Each entry in this deque consists of a single sample, i.e. a
-  // single column vector, and its timestamp.
-  std::deque<std::pair<Matrix, Timestamp>> sample_buffer_;
+  // The buffered samples, one per column, are the sample_buffer_size_ columns
+  // of sample_buffer_ starting at sample_buffer_start_. Since Matrix is column
+  // major, they are contiguous in memory, and each output frame is copied out
+  // with a single block copy. The columns before sample_buffer_start_ are
+  // reclaimed by CompactSampleBuffer once the end of the buffer is reached.
+  Matrix sample_buffer_;
+  int sample_buffer_start_;
+  int sample_buffer_size_;
+  // The timestamp of each column of sample_buffer_.
+  std::vector<Timestamp> sample_timestamps_;
 
   bool use_window_;
   Matrix window_;
@@ -157,44 +174,67 @@ REGISTER_CALCULATOR(TimeSeriesFramerCalculator);
 
 void TimeSeriesFramerCalculator::EnqueueInput(CalculatorContext* cc) {
   const Matrix& input_frame = cc->Inputs().Index(0).Get<Matrix>();
+  const int num_samples = input_frame.cols();
+  if (sample_buffer_start_ + sample_buffer_size_ + num_samples >
+      sample_buffer_.cols()) {
+    CompactSampleBuffer(sample_buffer_size_ + num_samples);
+  }
+  const int end = sample_buffer_start_ + sample_buffer_size_;
+  sample_buffer_.middleCols(end, num_samples) = input_frame;
+  for (int i = 0; i < num_samples; ++i) {
+    sample_timestamps_[end + i] =
+        CurrentSampleTimestamp(cc->InputTimestamp(), i);
+  }
+  sample_buffer_size_ += num_samples;
+}
 
-  for (int i = 0; i < input_frame.cols(); ++i) {
-    sample_buffer_.emplace_back(std::make_pair(
-        input_frame.col(i), CurrentSampleTimestamp(cc->InputTimestamp(), i)));
+void TimeSeriesFramerCalculator::CompactSampleBuffer(int min_size) {
+  // Keeping at least half of the buffer free after compaction bounds the
+  // amortized cost of moving samples to a constant per sample.
+  if (2 * min_size > sample_buffer_.cols()) {
+    const int capacity = std::max(2 * min_size, 2 * frame_duration_samples_);
+    Matrix buffer(num_channels_, capacity);
+    buffer.leftCols(sample_buffer_size_) =
+        sample_buffer_.middleCols(sample_buffer_start_, sample_buffer_size_);
+    sample_buffer_.swap(buffer);
+    sample_timestamps_.resize(capacity);
+  } else if (sample_buffer_start_ > 0 && sample_buffer_size_ > 0) {
+    // The source and destination columns may overlap.
+    memmove(sample_buffer_.data(),
+            sample_buffer_.col(sample_buffer_start_).data(),
+            sizeof(float) * num_channels_ * sample_buffer_size_);
   }
+  if (sample_buffer_start_ > 0) {
+    auto first = sample_timestamps_.begin() + sample_buffer_start_;
+    std::move(first, first + sample_buffer_size_, sample_timestamps_.begin());
+  }
+  sample_buffer_start_ = 0;
 }
 
 void TimeSeriesFramerCalculator::FrameOutput(CalculatorContext* cc) {
-  while (sample_buffer_.size() >=
+  while (sample_buffer_size_ >=
          frame_duration_samples_ + samples_still_to_drop_) {
-    while (samples_still_to_drop_ > 0) {
-      sample_buffer_.pop_front();
-      --samples_still_to_drop_;
-    }
+    DropSamples(samples_still_to_drop_);
+    samples_still_to_drop_ = 0;
     const int frame_step_samples = next_frame_step_samples();
-    std::unique_ptr<Matrix> output_frame(
-        new Matrix(num_channels_, frame_duration_samples_));
-    for (int i = 0; i < std::min(frame_step_samples, frame_duration_samples_);
-         ++i) {
-      output_frame->col(i) = sample_buffer_.front().first;
-      current_timestamp_ = sample_buffer_.front().second;
-      sample_buffer_.pop_front();
+    const auto frame = sample_buffer_.middleCols(sample_buffer_start_,
+                                                 frame_duration_samples_);
+    std::unique_ptr<Matrix> output_frame;
+    if (use_window_) {
+      output_frame.reset(
+          new Matrix((frame.array() * window_.array()).matrix()));
+    } else {
+      output_frame.reset(new Matrix(frame));
     }
+    current_timestamp_ =
+        sample_timestamps_[sample_buffer_start_ + frame_duration_samples_ - 1];
+    DropSamples(std::min(frame_step_samples, frame_duration_samples_));
     const int frame_overlap_samples =
         frame_duration_samples_ - frame_step_samples;
-    if (frame_overlap_samples > 0) {
-      for (int i = 0; i < frame_overlap_samples; ++i) {
-        output_frame->col(i + frame_step_samples) = sample_buffer_[i].first;
-        current_timestamp_ = sample_buffer_[i].second;
-      }
-    } else {
+    if (frame_overlap_samples < 0) {
       samples_still_to_drop_ = -frame_overlap_samples;
     }
 
-    if (use_window_) {
-      *output_frame = (output_frame->array() * window_.array()).matrix();
-    }
-
     cc->Outputs().Index(0).Add(output_frame.release(),
                                CurrentOutputTimestamp());
     ++cumulative_output_frames_;
@@ -221,17 +261,16 @@ absl::Status TimeSeriesFramerCalculator::Process(CalculatorContext* cc) {
 }
 
 absl::Status TimeSeriesFramerCalculator::Close(CalculatorContext* cc) {
-  while (samples_still_to_drop_ > 0 && !sample_buffer_.empty()) {
-    sample_buffer_.pop_front();
-    --samples_still_to_drop_;
-  }
-  if (!sample_buffer_.empty() && pad_final_packet_) {
+  const int num_dropped = std::min(samples_still_to_drop_, sample_buffer_size_);
+  DropSamples(num_dropped);
+  samples_still_to_drop_ -= num_dropped;
+  if (sample_buffer_size_ > 0 && pad_final_packet_) {
     std::unique_ptr<Matrix> output_frame(new Matrix);
     output_frame->setZero(num_channels_, frame_duration_samples_);
-    for (int i = 0; i < sample_buffer_.size(); ++i) {
-      output_frame->col(i) = sample_buffer_[i].first;
-      current_timestamp_ = sample_buffer_[i].second;
-    }
+    output_frame->leftCols(sample_buffer_size_) =
+        sample_buffer_.middleCols(sample_buffer_start_, sample_buffer_size_);
+    current_timestamp_ =
+        sample_timestamps_[sample_buffer_start_ + sample_buffer_size_ - 1];
 
     cc->Outputs().Index(0).Add(output_frame.release(),
                                CurrentOutputTimestamp());
@@ -291,6 +330,10 @@ absl::Status TimeSeriesFramerCalculator::Open(CalculatorContext* cc) {
   cumulative_completed_samples_ = 0;
   cumulative_output_frames_ = 0;
   samples_still_to_drop_ = 0;
+  sample_buffer_.resize(num_channels_, 0);
+  sample_buffer_start_ = 0;
+  sample_buffer_size_ = 0;
+  sample_timestamps_.clear();
   initial_input_timestamp_ = Timestamp::Unstarted();
   current_timestamp_ = Timestamp::Unstarted();
 
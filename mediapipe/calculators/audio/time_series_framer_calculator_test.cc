@@ -25,9 +25,11 @@
 #include "mediapipe/framework/calculator_runner.h"
 #include "mediapipe/framework/formats/matrix.h"
 #include "mediapipe/framework/formats/time_series_header.pb.h"
+#include "mediapipe/framework/port/benchmark.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
 #include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/util/time_series_test_util.h"
 
@@ -481,5 +483,65 @@ TEST_F(TimeSeriesFramerCalculatorTimestampingTest, UseCumulativeTimeStamp) {
   CheckOutputTimestamps();
 }
 
+// Frames 8-channel audio at 48 kHz, arriving in packets of 10 ms, into
+// Hann-windowed frames of 25 ms with a 15 ms overlap. Each iteration frames
+// one second of audio.
+void BM_FrameAudio(benchmark::State& state) {
+  constexpr double kSampleRate = 48000.0;
+  constexpr int kNumChannels = 8;
+  constexpr int kSamplesPerPacket = 480;
+  constexpr int kPacketsPerIteration = 100;
+  CalculatorGraph graph;
+  CHECK(graph
+            .Initialize(ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+              input_stream: "input"
+              node {
+                calculator: "TimeSeriesFramerCalculator"
+                input_stream: "input"
+                output_stream: "output"
+                options {
+                  [mediapipe.TimeSeriesFramerCalculatorOptions.ext] {
+                    frame_duration_seconds: 0.025
+                    frame_overlap_seconds: 0.015
+                    window_function: HANN
+                  }
+                }
+              }
+            )pb"))
+            .ok());
+  int64 num_frames = 0;
+  CHECK(graph
+            .ObserveOutputStream("output",
+                                 [&num_frames](const Packet& packet) {
+                                   ++num_frames;
+                                   return absl::OkStatus();
+                                 })
+            .ok());
+  auto header = new TimeSeriesHeader();
+  header->set_sample_rate(kSampleRate);
+  header->set_num_channels(kNumChannels);
+  CHECK(graph.StartRun({}, {{"input", Adopt(header)}}).ok());
+
+  const Matrix input = Matrix::Random(kNumChannels, kSamplesPerPacket);
+  int64 num_samples = 0;
+  for (auto _ : state) {
+    for (int i = 0; i < kPacketsPerIteration; ++i) {
+      const Timestamp timestamp(round(num_samples / kSampleRate *
+                                      Timestamp::kTimestampUnitsPerSecond));
+      CHECK(graph
+                .AddPacketToInputStream(
+                    "input", MakePacket<Matrix>(input).At(timestamp))
+                .ok());
+      num_samples += kSamplesPerPacket;
+    }
+    CHECK(graph.WaitUntilIdle().ok());
+  }
+  CHECK(graph.CloseAllInputStreams().ok());
+  CHECK(graph.WaitUntilDone().ok());
+  state.SetItemsProcessed(num_samples);
+  state.counters["frames"] = num_frames;
+}
+BENCHMARK(BM_FrameAudio)->UseRealTime();
+
 }  // namespace
 }  // namespace mediapipe
@@ -25,7 +25,8 @@ namespace mediapipe {
 // input side packets through, unchanged.  Otherwise, the input side
 // packets will be ignored (allowing PassThroughCalculator to be used to
 // test internal behavior).  Any options may be specified and will be
-// ignored.
+// ignored.  Batches of input timestamps (see BatchInputStreamHandler) are
+// passed through in a single Process() call.
 class PassThroughCalculator : public CalculatorBase {
  public:
   static absl::Status GetContract(CalculatorContract* cc) {
@@ -56,6 +57,8 @@ class PassThroughCalculator : public CalculatorBase {
             &cc->InputSidePackets().Get(id));
       }
     }
+    cc->SetTimestampOffset(TimestampDiff(0));
+    cc->SetProcessBatches(true);
     return absl::OkStatus();
   }
 
@@ -72,22 +75,24 @@ class PassThroughCalculator : public CalculatorBase {
         cc->OutputSidePackets().Get(id).Set(cc->InputSidePackets().Get(id));
       }
     }
-    cc->SetOffset(TimestampDiff(0));
     return absl::OkStatus();
   }
 
   absl::Status Process(CalculatorContext* cc) final {
-    cc->GetCounter("PassThrough")->Increment();
+    cc->GetCounter("PassThrough")->IncrementBy(cc->BatchSize());
     if (cc->Inputs().NumEntries() == 0) {
       return tool::StatusStop();
     }
     for (CollectionItemId id = cc->Inputs().BeginId();
          id < cc->Inputs().EndId(); ++id) {
-      if (!cc->Inputs().Get(id).IsEmpty()) {
-        VLOG(3) << "Passing " << cc->Inputs().Get(id).Name() << " to "
-                << cc->Outputs().Get(id).Name() << " at "
-                << cc->InputTimestamp().DebugString();
-        cc->Outputs().Get(id).AddPacket(cc->Inputs().Get(id).Value());
+      for (int i = 0; i < cc->BatchSize(); ++i) {
+        const Packet& packet = cc->Inputs().Get(id).BatchValue(i);
+        if (!packet.IsEmpty()) {
+          VLOG(3) << "Passing " << cc->Inputs().Get(id).Name() << " to "
+                  << cc->Outputs().Get(id).Name() << " at "
+                  << packet.Timestamp().DebugString();
+          cc->Outputs().Get(id).AddPacket(packet);
+        }
       }
     }
     return absl::OkStatus();
@@ -19,6 +19,7 @@
 #include "absl/memory/memory.h"
 #include "absl/strings/substitute.h"
 #include "mediapipe/calculators/tensor/image_to_tensor_converter.h"
+#include "mediapipe/calculators/tensor/image_to_tensor_converter_opencv.h"
 #include "mediapipe/calculators/tensor/image_to_tensor_utils.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_runner.h"
@@ -29,6 +30,7 @@
 #include "mediapipe/framework/formats/image_frame_opencv.h"
 #include "mediapipe/framework/formats/rect.pb.h"
 #include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/port/benchmark.h"
 #include "mediapipe/framework/port/gtest.h"
 #include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/port/opencv_core_inc.h"
@@ -482,5 +484,105 @@ TEST(ImageToTensorCalculatorTest, NoOpExceptRangeBorderZero) {
           BorderMode::kZero, roi);
 }
 
+TEST(ImageToTensorConverterOpenCvTest, ConvertBatchMatchesConvert) {
+  cv::Mat input = GetRgba(
+      "/mediapipe/calculators/tensor/testdata/image_to_tensor/input.jpg");
+  mediapipe::Image image(std::make_shared<mediapipe::ImageFrame>(
+      ImageFormat::SRGBA, input.cols, input.rows, input.step, input.data,
+      [](uint8*) {}));
+  const std::vector<RotatedRect> rois = {
+      {/*center_x=*/0.65f * input.cols, /*center_y=*/0.4f * input.rows,
+       /*width=*/0.5f * input.cols, /*height=*/0.5f * input.rows,
+       /*rotation=*/0.0f},
+      {/*center_x=*/0.5f * input.cols, /*center_y=*/0.5f * input.rows,
+       /*width=*/1.5f * input.cols, /*height=*/1.1f * input.rows,
+       /*rotation=*/-0.7f}};
+  constexpr Size kOutputDims = {64, 32};
+  for (auto tensor_type :
+       {Tensor::ElementType::kFloat32, Tensor::ElementType::kUInt8}) {
+    auto converter =
+        CreateOpenCvConverter(/*cc=*/nullptr, BorderMode::kZero, tensor_type);
+    MP_ASSERT_OK(converter);
+    auto batch = (*converter)->ConvertBatch(image, rois, kOutputDims,
+                                            /*range_min=*/0.0f,
+                                            /*range_max=*/255.0f);
+    MP_ASSERT_OK(batch);
+    EXPECT_EQ(batch->shape().dims,
+              std::vector<int>({2, kOutputDims.height, kOutputDims.width, 3}));
+    const int roi_bytes = batch->bytes() / rois.size();
+    auto batch_view = batch->GetCpuReadView();
+    for (int i = 0; i < rois.size(); ++i) {
+      auto single = (*converter)->Convert(image, rois[i], kOutputDims,
+                                          /*range_min=*/0.0f,
+                                          /*range_max=*/255.0f);
+      MP_ASSERT_OK(single);
+      auto single_view = single->GetCpuReadView();
+      EXPECT_EQ(0, memcmp(single_view.buffer<uint8>(),
+                          batch_view.buffer<uint8>() + i * roi_bytes,
+                          roi_bytes));
+    }
+  }
+}
+
+// The rotated ROI, output size and range of the converter benchmarks.
+constexpr RotatedRect kBenchmarkRoi = {/*center_x=*/300.0f,
+                                       /*center_y=*/200.0f,
+                                       /*width=*/250.0f, /*height=*/250.0f,
+                                       /*rotation=*/0.3f};
+constexpr Size kBenchmarkOutputDims = {256, 256};
+
+void BM_OpenCvConverter(benchmark::State& state) {
+  cv::Mat input = GetRgba(
+      "/mediapipe/calculators/tensor/testdata/image_to_tensor/input.jpg");
+  mediapipe::Image image(std::make_shared<mediapipe::ImageFrame>(
+      ImageFormat::SRGBA, input.cols, input.rows, input.step, input.data,
+      [](uint8*) {}));
+  auto converter = CreateOpenCvConverter(/*cc=*/nullptr, BorderMode::kZero,
+                                         Tensor::ElementType::kFloat32)
+                       .value();
+  for (auto _ : state) {
+    auto tensor = converter->Convert(image, kBenchmarkRoi, kBenchmarkOutputDims,
+                                     /*range_min=*/-1.0f, /*range_max=*/1.0f);
+    benchmark::DoNotOptimize(tensor);
+  }
+}
+BENCHMARK(BM_OpenCvConverter);
+
+// The chain of OpenCV calls the converter used before: a perspective warp into
+// an 8-bit image, alpha removal and conversion into the float tensor.
+void BM_OpenCvWarpChain(benchmark::State& state) {
+  cv::Mat input = GetRgba(
+      "/mediapipe/calculators/tensor/testdata/image_to_tensor/input.jpg");
+  const cv::RotatedRect rotated_rect(
+      cv::Point2f(kBenchmarkRoi.center_x, kBenchmarkRoi.center_y),
+      cv::Size2f(kBenchmarkRoi.width, kBenchmarkRoi.height),
+      kBenchmarkRoi.rotation * 180.f / M_PI);
+  cv::Mat src_points;
+  cv::boxPoints(rotated_rect, src_points);
+  const float dst_width = kBenchmarkOutputDims.width;
+  const float dst_height = kBenchmarkOutputDims.height;
+  float dst_corners[8] = {0.0f,      dst_height, 0.0f,      0.0f,
+                          dst_width, 0.0f,       dst_width, dst_height};
+  cv::Mat projection_matrix = cv::getPerspectiveTransform(
+      src_points, cv::Mat(4, 2, CV_32F, dst_corners));
+  for (auto _ : state) {
+    Tensor tensor(Tensor::ElementType::kFloat32,
+                  Tensor::Shape{1, kBenchmarkOutputDims.height,
+                                kBenchmarkOutputDims.width, 3});
+    auto view = tensor.GetCpuWriteView();
+    cv::Mat dst(kBenchmarkOutputDims.height, kBenchmarkOutputDims.width,
+                CV_32FC3, view.buffer<float>());
+    cv::Mat transformed;
+    cv::warpPerspective(input, transformed, projection_matrix,
+                        cv::Size(dst_width, dst_height), cv::INTER_LINEAR,
+                        cv::BORDER_CONSTANT);
+    cv::Mat rgb;
+    cv::cvtColor(transformed, rgb, cv::COLOR_RGBA2RGB);
+    rgb.convertTo(dst, CV_32FC3, 2.0f / 255.0f, -1.0f);
+    benchmark::DoNotOptimize(tensor);
+  }
+}
+BENCHMARK(BM_OpenCvWarpChain);
+
 }  // namespace
 }  // namespace mediapipe
@@ -15,6 +15,8 @@
 #ifndef MEDIAPIPE_CALCULATORS_TENSOR_IMAGE_TO_TENSOR_CONVERTER_H_
 #define MEDIAPIPE_CALCULATORS_TENSOR_IMAGE_TO_TENSOR_CONVERTER_H_
 
+#include <vector>
+
 #include "mediapipe/calculators/tensor/image_to_tensor_utils.h"
 #include "mediapipe/framework/formats/image.h"
 #include "mediapipe/framework/formats/tensor.h"
@@ -49,6 +51,16 @@ class ImageToTensorConverter {
                                          const RotatedRect& roi,
                                          const Size& output_dims,
                                          float range_min, float range_max) = 0;
+
+  // Converts several regions of interest of the same image into a single
+  // tensor, whose first dimension indexes @rois in order.
+  // Not all converters support this.
+  virtual absl::StatusOr<Tensor> ConvertBatch(
+      const mediapipe::Image& input, const std::vector<RotatedRect>& rois,
+      const Size& output_dims, float range_min, float range_max) {
+    return absl::UnimplementedError(
+        "Batched conversion is not supported by this converter.");
+  }
 };
 
 }  // namespace mediapipe
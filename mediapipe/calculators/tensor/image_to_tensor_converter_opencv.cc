@@ -14,9 +14,12 @@
 
 #include "mediapipe/calculators/tensor/image_to_tensor_converter_opencv.h"
 
+#include <algorithm>
 #include <cmath>
 #include <memory>
+#include <vector>
 
+#include "absl/types/span.h"
 #include "mediapipe/calculators/tensor/image_to_tensor_converter.h"
 #include "mediapipe/calculators/tensor/image_to_tensor_utils.h"
 #include "mediapipe/framework/calculator_framework.h"
@@ -26,44 +29,52 @@
 #include "mediapipe/framework/formats/tensor.h"
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/opencv_core_inc.h"
-#include "mediapipe/framework/port/opencv_imgproc_inc.h"
 #include "mediapipe/framework/port/statusor.h"
 
 namespace mediapipe {
 
 namespace {
 
+// Converts a sampled and range-transformed pixel value to the tensor type,
+// rounding and saturating integer types as cv::Mat::convertTo does.
+template <typename T>
+inline T ConvertValue(float value) {
+  return cv::saturate_cast<T>(value);
+}
+
+template <>
+inline float ConvertValue<float>(float value) {
+  return value;
+}
+
 class OpenCvProcessor : public ImageToTensorConverter {
  public:
   OpenCvProcessor(BorderMode border_mode, Tensor::ElementType tensor_type)
-      : tensor_type_(tensor_type) {
-    switch (border_mode) {
-      case BorderMode::kReplicate:
-        border_mode_ = cv::BORDER_REPLICATE;
-        break;
-      case BorderMode::kZero:
-        border_mode_ = cv::BORDER_CONSTANT;
-        break;
-    }
-    switch (tensor_type_) {
-      case Tensor::ElementType::kInt8:
-        mat_type_ = CV_8SC3;
-        break;
-      case Tensor::ElementType::kFloat32:
-        mat_type_ = CV_32FC3;
-        break;
-      case Tensor::ElementType::kUInt8:
-        mat_type_ = CV_8UC3;
-        break;
-      default:
-        mat_type_ = -1;
-    }
-  }
+      : border_mode_(border_mode), tensor_type_(tensor_type) {}
 
   absl::StatusOr<Tensor> Convert(const mediapipe::Image& input,
                                  const RotatedRect& roi,
                                  const Size& output_dims, float range_min,
                                  float range_max) override {
+    return ConvertRois(input, absl::MakeConstSpan(&roi, 1), output_dims,
+                       range_min, range_max);
+  }
+
+  absl::StatusOr<Tensor> ConvertBatch(const mediapipe::Image& input,
+                                      const std::vector<RotatedRect>& rois,
+                                      const Size& output_dims, float range_min,
+                                      float range_max) override {
+    if (rois.empty()) {
+      return InvalidArgumentError("At least one ROI is required.");
+    }
+    return ConvertRois(input, rois, output_dims, range_min, range_max);
+  }
+
+ private:
+  absl::StatusOr<Tensor> ConvertRois(const mediapipe::Image& input,
+                                     absl::Span<const RotatedRect> rois,
+                                     const Size& output_dims, float range_min,
+                                     float range_max) {
     if (input.image_format() != mediapipe::ImageFormat::SRGB &&
         input.image_format() != mediapipe::ImageFormat::SRGBA) {
       return InvalidArgumentError(
@@ -72,73 +83,134 @@ class OpenCvProcessor : public ImageToTensorConverter {
     }
     auto src = mediapipe::formats::MatView(&input);
 
-    constexpr int kNumChannels = 3;
-    Tensor tensor(tensor_type_, Tensor::Shape{1, output_dims.height,
-                                              output_dims.width, kNumChannels});
-    auto buffer_view = tensor.GetCpuWriteView();
-    cv::Mat dst;
-    switch (tensor_type_) {
-      case Tensor::ElementType::kInt8:
-        dst = cv::Mat(output_dims.height, output_dims.width, mat_type_,
-                      buffer_view.buffer<int8>());
-        break;
-      case Tensor::ElementType::kFloat32:
-        dst = cv::Mat(output_dims.height, output_dims.width, mat_type_,
-                      buffer_view.buffer<float>());
-        break;
-      case Tensor::ElementType::kUInt8:
-        dst = cv::Mat(output_dims.height, output_dims.width, mat_type_,
-                      buffer_view.buffer<uint8>());
-        break;
-      default:
-        return InvalidArgumentError(
-            absl::StrCat("Unsupported tensor type: ", tensor_type_));
-    }
-
-    const cv::RotatedRect rotated_rect(cv::Point2f(roi.center_x, roi.center_y),
-                                       cv::Size2f(roi.width, roi.height),
-                                       roi.rotation * 180.f / M_PI);
-    cv::Mat src_points;
-    cv::boxPoints(rotated_rect, src_points);
-
-    const float dst_width = output_dims.width;
-    const float dst_height = output_dims.height;
-    /* clang-format off */
-    float dst_corners[8] = {0.0f,      dst_height,
-                            0.0f,      0.0f,
-                            dst_width, 0.0f,
-                            dst_width, dst_height};
-    /* clang-format on */
-
-    cv::Mat dst_points = cv::Mat(4, 2, CV_32F, dst_corners);
-    cv::Mat projection_matrix =
-        cv::getPerspectiveTransform(src_points, dst_points);
-    cv::Mat transformed;
-    cv::warpPerspective(*src, transformed, projection_matrix,
-                        cv::Size(dst_width, dst_height),
-                        /*flags=*/cv::INTER_LINEAR,
-                        /*borderMode=*/border_mode_);
-
-    if (transformed.channels() > kNumChannels) {
-      cv::Mat proper_channels_mat;
-      cv::cvtColor(transformed, proper_channels_mat, cv::COLOR_RGBA2RGB);
-      transformed = proper_channels_mat;
-    }
-
     constexpr float kInputImageRangeMin = 0.0f;
     constexpr float kInputImageRangeMax = 255.0f;
     ASSIGN_OR_RETURN(
         auto transform,
         GetValueRangeTransformation(kInputImageRangeMin, kInputImageRangeMax,
                                     range_min, range_max));
-    transformed.convertTo(dst, mat_type_, transform.scale, transform.offset);
+
+    Tensor tensor(tensor_type_,
+                  Tensor::Shape{static_cast<int>(rois.size()),
+                                output_dims.height, output_dims.width,
+                                kNumChannels});
+    auto buffer_view = tensor.GetCpuWriteView();
+    const int roi_size = output_dims.height * output_dims.width * kNumChannels;
+    for (int i = 0; i < rois.size(); ++i) {
+      switch (tensor_type_) {
+        case Tensor::ElementType::kInt8:
+          ExtractRoi(*src, rois[i], output_dims, transform,
+                     buffer_view.buffer<int8>() + i * roi_size);
+          break;
+        case Tensor::ElementType::kFloat32:
+          ExtractRoi(*src, rois[i], output_dims, transform,
+                     buffer_view.buffer<float>() + i * roi_size);
+          break;
+        case Tensor::ElementType::kUInt8:
+          ExtractRoi(*src, rois[i], output_dims, transform,
+                     buffer_view.buffer<uint8>() + i * roi_size);
+          break;
+        default:
+          return InvalidArgumentError(
+              absl::StrCat("Unsupported tensor type: ", tensor_type_));
+      }
+    }
     return tensor;
   }
 
- private:
-  enum cv::BorderTypes border_mode_;
-  Tensor::ElementType tensor_type_;
-  int mat_type_;
+  // Samples @roi of @src with bilinear interpolation into an RGB image of
+  // @output_dims at @dst, mapping the pixel values with @transform.
+  //
+  // This is the same mapping as warping @src with the perspective transform
+  // from the corners of @roi to the corners of the output, then dropping the
+  // alpha channel and converting the values, but it is done in a single pass
+  // and without intermediate images. Each output row is sampled into row_
+  // first, so that the value conversion runs as a separate loop over
+  // contiguous floats, which the compiler vectorizes.
+  template <typename T>
+  void ExtractRoi(const cv::Mat& src, const RotatedRect& roi,
+                  const Size& output_dims, const ValueTransformation& transform,
+                  T* dst) {
+    // Output pixel (x, y) samples @src at origin + x * step_x + y * step_y.
+    const float cos_r = std::cos(roi.rotation);
+    const float sin_r = std::sin(roi.rotation);
+    const float scale_x = roi.width / output_dims.width;
+    const float scale_y = roi.height / output_dims.height;
+    const float step_x_x = scale_x * cos_r;
+    const float step_x_y = scale_x * sin_r;
+    const float step_y_x = -scale_y * sin_r;
+    const float step_y_y = scale_y * cos_r;
+    const float origin_x =
+        roi.center_x - 0.5f * (roi.width * cos_r - roi.height * sin_r);
+    const float origin_y =
+        roi.center_y - 0.5f * (roi.width * sin_r + roi.height * cos_r);
+
+    const int src_channels = src.channels();
+    const int row_size = output_dims.width * kNumChannels;
+    row_.resize(row_size);
+    for (int y = 0; y < output_dims.height; ++y) {
+      const float row_x = origin_x + y * step_y_x;
+      const float row_y = origin_y + y * step_y_y;
+      float* out = row_.data();
+      for (int x = 0; x < output_dims.width; ++x, out += kNumChannels) {
+        const float src_x = row_x + x * step_x_x;
+        const float src_y = row_y + x * step_x_y;
+        const int x0 = static_cast<int>(std::floor(src_x));
+        const int y0 = static_cast<int>(std::floor(src_y));
+        const float fx = src_x - x0;
+        const float fy = src_y - y0;
+        const uint8* top_left;
+        const uint8* top_right;
+        const uint8* bottom_left;
+        const uint8* bottom_right;
+        if (x0 >= 0 && y0 >= 0 && x0 + 1 < src.cols && y0 + 1 < src.rows) {
+          top_left = src.ptr<uint8>(y0) + x0 * src_channels;
+          top_right = top_left + src_channels;
+          bottom_left = top_left + src.step[0];
+          bottom_right = bottom_left + src_channels;
+        } else {
+          top_left = BorderPixel(src, x0, y0);
+          top_right = BorderPixel(src, x0 + 1, y0);
+          bottom_left = BorderPixel(src, x0, y0 + 1);
+          bottom_right = BorderPixel(src, x0 + 1, y0 + 1);
+        }
+        for (int c = 0; c < kNumChannels; ++c) {
+          const float top = top_left[c] + fx * (top_right[c] - top_left[c]);
+          const float bottom =
+              bottom_left[c] + fx * (bottom_right[c] - bottom_left[c]);
+          out[c] = top + fy * (bottom - top);
+        }
+      }
+      T* dst_row = dst + y * row_size;
+      for (int i = 0; i < row_size; ++i) {
+        dst_row[i] = ConvertValue<T>(row_[i] * transform.scale +
+                                     transform.offset);
+      }
+    }
+  }
+
+  // Returns the pixel of @src at (x, y), which may lie outside of @src.
+  const uint8* BorderPixel(const cv::Mat& src, int x, int y) const {
+    static constexpr uint8 kZeroPixel[4] = {0, 0, 0, 0};
+    if (x < 0 || y < 0 || x >= src.cols || y >= src.rows) {
+      switch (border_mode_) {
+        case BorderMode::kZero:
+          return kZeroPixel;
+        case BorderMode::kReplicate:
+          x = std::min(std::max(x, 0), src.cols - 1);
+          y = std::min(std::max(y, 0), src.rows - 1);
+          break;
+      }
+    }
+    return src.ptr<uint8>(y) + x * src.channels();
+  }
+
+  static constexpr int kNumChannels = 3;
+
+  const BorderMode border_mode_;
+  const Tensor::ElementType tensor_type_;
+  // One output row, before value conversion.
+  std::vector<float> row_;
 };
 
 }  // namespace
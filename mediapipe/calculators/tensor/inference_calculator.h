@@ -51,6 +51,11 @@ namespace api2 {
 //
 // Input:
 //  TENSORS - Vector of Tensors
+//  BATCH_END (optional) - Runs the pending batch right away, when batching
+//                         is enabled with max_batch_size > 1 (CPU only). Can
+//                         be connected to the BATCH_END output of a
+//                         BeginLoopCalculator so that the inputs of a loop are
+//                         run together.
 //
 // Output:
 //  TENSORS - Vector of Tensors
@@ -99,6 +104,7 @@ namespace api2 {
 class InferenceCalculator : public NodeIntf {
  public:
   static constexpr Input<std::vector<Tensor>> kInTensors{"TENSORS"};
+  static constexpr Input<Timestamp>::Optional kInBatchEnd{"BATCH_END"};
   // Deprecated. Prefers to use "OP_RESOLVER" input side packet instead.
   // TODO: Removes the "CUSTOM_OP_RESOLVER" side input after the
   // migration.
@@ -111,7 +117,7 @@ class InferenceCalculator : public NodeIntf {
   static constexpr SideInput<
       mediapipe::InferenceCalculatorOptions::Delegate>::Optional kDelegate{
       "DELEGATE"};
-  MEDIAPIPE_NODE_CONTRACT(kInTensors, kSideInCustomOpResolver,
+  MEDIAPIPE_NODE_CONTRACT(kInTensors, kInBatchEnd, kSideInCustomOpResolver,
                           kSideInOpResolver, kSideInModel, kOutTensors,
                           kDelegate);
 
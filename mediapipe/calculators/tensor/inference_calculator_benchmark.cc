@@ -0,0 +1,104 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Measures the throughput of InferenceCalculatorCpu with an interpreter pool:
+//
+//   bazel run -c opt \
+//     //mediapipe/calculators/tensor:inference_calculator_benchmark
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_replace.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr int kTensorWidth = 8;
+constexpr int kTensorHeight = 8;
+constexpr int kTensorChannels = 3;
+
+// The interpreters share cpu_num_thread threads.
+constexpr char kGraphWithInterpreterPool[] = R"(
+    input_stream: "tensor_in"
+    num_threads: $num_interpreters
+    node {
+      calculator: "InferenceCalculator"
+      input_stream: "TENSORS:tensor_in"
+      output_stream: "TENSORS:tensor_out"
+      max_in_flight: $num_interpreters
+      output_stream_handler {
+        output_stream_handler: "InOrderOutputStreamHandler"
+      }
+      options {
+        [mediapipe.InferenceCalculatorOptions.ext] {
+          model_path: "mediapipe/calculators/tensor/testdata/add.bin"
+          delegate { tflite {} }
+          cpu_num_thread: 4
+          num_interpreters: $num_interpreters
+        }
+      }
+    }
+  )";
+
+std::vector<Tensor> CreateInputs() {
+  std::vector<Tensor> input_vec;
+  input_vec.emplace_back(
+      Tensor::ElementType::kFloat32,
+      Tensor::Shape{1, kTensorHeight, kTensorWidth, kTensorChannels});
+  auto view = input_vec.back().GetCpuWriteView();
+  auto tensor_buffer = view.buffer<float>();
+  for (int i = 0; i < input_vec.back().shape().num_elements(); i++) {
+    tensor_buffer[i] = 1;
+  }
+  return input_vec;
+}
+
+// Measures the throughput of the calculator for state.range(0) interpreters.
+void BM_InterpreterPool(benchmark::State& state) {
+  constexpr int kInputsPerIteration = 16;
+  CalculatorGraphConfig graph_config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(absl::StrReplaceAll(
+          kGraphWithInterpreterPool,
+          {{"$num_interpreters", absl::StrCat(state.range(0))}}));
+  CalculatorGraph graph(graph_config);
+  CHECK(graph.StartRun({}).ok());
+  int64 timestamp = 0;
+  for (auto _ : state) {
+    for (int i = 0; i < kInputsPerIteration; ++i) {
+      CHECK(graph
+                .AddPacketToInputStream(
+                    "tensor_in", MakePacket<std::vector<Tensor>>(CreateInputs())
+                                     .At(Timestamp(++timestamp)))
+                .ok());
+    }
+    CHECK(graph.WaitUntilIdle().ok());
+  }
+  CHECK(graph.CloseInputStream("tensor_in").ok());
+  CHECK(graph.WaitUntilDone().ok());
+  state.SetItemsProcessed(state.iterations() * kInputsPerIteration);
+}
+BENCHMARK(BM_InterpreterPool)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
+
+BENCHMARK_MAIN();
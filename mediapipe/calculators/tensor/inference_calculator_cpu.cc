@@ -12,12 +12,16 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <cstring>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "absl/memory/memory.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "mediapipe/calculators/tensor/inference_calculator.h"
 #include "tensorflow/lite/interpreter_builder.h"
 #if defined(MEDIAPIPE_ANDROID)
@@ -62,15 +66,30 @@ int GetXnnpackNumThreads(
   return GetXnnpackDefaultNumThreads();
 }
 
+// Returns the number of threads for each of |num_interpreters| interpreters
+// that run at the same time, so that together they use |num_threads|. A
+// negative |num_threads| leaves the choice to TfLite.
+int NumThreadsPerInterpreter(int num_threads, int num_interpreters) {
+  if (num_threads <= 0) return num_threads;
+  return std::max(1, num_threads / num_interpreters);
+}
+
+// Copies the input tensor into the slot for `batch_index` of the interpreter's
+// input tensor.
 template <typename T>
-void CopyTensorBuffer(const Tensor& input_tensor,
-                      tflite::Interpreter* interpreter,
-                      int input_tensor_index) {
+absl::Status CopyTensorBuffer(const Tensor& input_tensor,
+                              tflite::Interpreter* interpreter,
+                              int input_tensor_index, int batch_index) {
+  RET_CHECK_LE((batch_index + 1) * input_tensor.bytes(),
+               interpreter->input_tensor(input_tensor_index)->bytes)
+      << "Input tensor " << input_tensor_index << " is too large.";
   auto input_tensor_view = input_tensor.GetCpuReadView();
   auto input_tensor_buffer = input_tensor_view.buffer<T>();
   T* local_tensor_buffer =
-      interpreter->typed_input_tensor<T>(input_tensor_index);
+      interpreter->typed_input_tensor<T>(input_tensor_index) +
+      batch_index * input_tensor.shape().num_elements();
   std::memcpy(local_tensor_buffer, input_tensor_buffer, input_tensor.bytes());
+  return absl::OkStatus();
 }
 
 }  // namespace
@@ -81,20 +100,72 @@ class InferenceCalculatorCpuImpl
   static absl::Status UpdateContract(CalculatorContract* cc);
 
   absl::Status Open(CalculatorContext* cc) override;
+  absl::Status Reset(CalculatorContext* cc) override;
   absl::Status Process(CalculatorContext* cc) override;
   absl::Status Close(CalculatorContext* cc) override;
 
  private:
+  // An interpreter and the delegate it was built with.
+  struct InterpreterInstance {
+    TfLiteDelegatePtr delegate;
+    std::unique_ptr<tflite::Interpreter> interpreter;
+  };
+
   absl::Status InitInterpreter(CalculatorContext* cc);
+  // Returns true if the interpreters of the previous run were built from the
+  // same model, op resolver and delegate as this run would use.
+  bool CanReuseInterpreters(CalculatorContext* cc);
+  absl::StatusOr<std::unique_ptr<InterpreterInstance>> BuildInterpreter(
+      CalculatorContext* cc, const tflite::FlatBufferModel& model,
+      const tflite::OpResolver& op_resolver);
   absl::Status LoadDelegate(CalculatorContext* cc,
-                            tflite::InterpreterBuilder* interpreter_builder);
-  absl::Status AllocateTensors();
+                            tflite::InterpreterBuilder* interpreter_builder,
+                            TfLiteDelegatePtr* delegate);
+  absl::Status AllocateTensors(tflite::Interpreter* interpreter);
+
+  // Takes an idle interpreter, waiting for one if all of them are running.
+  tflite::Interpreter* AcquireInterpreter();
+  void ReleaseInterpreter(tflite::Interpreter* interpreter);
+
+  // Runs the interpreter on a single input and sends its outputs.
+  absl::Status RunInference(CalculatorContext* cc,
+                            const std::vector<Tensor>& input_tensors,
+                            tflite::Interpreter* interpreter);
+  // Copies the input tensors of one batch item into the interpreter.
+  absl::Status CopyInputs(const std::vector<Tensor>& input_tensors,
+                          int batch_index, tflite::Interpreter* interpreter);
+  // Copies the output tensors of one batch item out of the interpreter.
+  absl::StatusOr<std::unique_ptr<std::vector<Tensor>>> CopyOutputs(
+      int batch_index, int batch_size, tflite::Interpreter* interpreter);
+  // Resizes the batch dimension of the interpreter's inputs.
+  absl::Status ResizeBatch(int batch_size);
+  // Runs the pending batch and sends its outputs.
+  absl::Status RunBatch(CalculatorContext* cc);
 
   // TfLite requires us to keep the model alive as long as the interpreter is.
   Packet<TfLiteModelPtr> model_packet_;
-  std::unique_ptr<tflite::Interpreter> interpreter_;
-  TfLiteDelegatePtr delegate_;
+  // The interpreters built from the model. There are several of them when
+  // num_interpreters > 1, so that concurrent Process calls can run at once.
+  std::vector<std::unique_ptr<InterpreterInstance>> interpreters_;
+  absl::Mutex idle_mutex_;
+  std::vector<tflite::Interpreter*> idle_interpreters_
+      ABSL_GUARDED_BY(idle_mutex_);
   TfLiteType input_tensor_type_ = TfLiteType::kTfLiteNoType;
+  // The serialized DELEGATE side packet the interpreters were built with,
+  // empty if there is none.
+  std::string delegate_side_packet_;
+
+  // Batching state, used when max_batch_size > 1.
+  int max_batch_size_ = 1;
+  absl::Duration max_batch_latency_;
+  // The input dimensions of the model for a single batch item.
+  std::vector<std::vector<int>> input_dims_;
+  // The batch size that the interpreter's tensors are allocated for.
+  int batch_size_ = 1;
+  // The inputs waiting to be run, in timestamp order.
+  std::vector<Packet<std::vector<Tensor>>> batch_;
+  // The arrival time of the first input in batch_.
+  absl::Time batch_start_time_;
 };
 
 absl::Status InferenceCalculatorCpuImpl::UpdateContract(
@@ -102,36 +173,189 @@ absl::Status InferenceCalculatorCpuImpl::UpdateContract(
   const auto& options = cc->Options<::mediapipe::InferenceCalculatorOptions>();
   RET_CHECK(!options.model_path().empty() ^ kSideInModel(cc).IsConnected())
       << "Either model as side packet or model path in options is required.";
+  RET_CHECK_GE(options.num_interpreters(), 1);
+  RET_CHECK(options.num_interpreters() == 1 || options.max_batch_size() <= 1)
+      << "Batching requires a single interpreter.";
+  if (options.max_batch_size() > 1) {
+    // Queued inputs are sent at their own timestamps by a later Process or
+    // Close call, so the output bound is set explicitly.
+    cc->SetTimestampOffset(TimestampDiff::Unset());
+    // Timestamp bound updates without inputs run the pending batch.
+    cc->SetProcessTimestampBounds(true);
+  }
+  // Reset() keeps the interpreters when the graph is run again.
+  cc->SetReusableAcrossRuns(true);
 
   return absl::OkStatus();
 }
 
 absl::Status InferenceCalculatorCpuImpl::Open(CalculatorContext* cc) {
+  const auto& options = cc->Options<mediapipe::InferenceCalculatorOptions>();
+  max_batch_size_ = options.max_batch_size();
+  max_batch_latency_ = absl::Microseconds(options.max_batch_latency_us());
   return InitInterpreter(cc);
 }
 
+absl::Status InferenceCalculatorCpuImpl::Reset(CalculatorContext* cc) {
+  if (CanReuseInterpreters(cc)) {
+    return absl::OkStatus();
+  }
+  {
+    absl::MutexLock lock(&idle_mutex_);
+    idle_interpreters_.clear();
+  }
+  interpreters_.clear();
+  batch_size_ = 1;
+  return Open(cc);
+}
+
+bool InferenceCalculatorCpuImpl::CanReuseInterpreters(CalculatorContext* cc) {
+  if (interpreters_.empty()) {
+    return false;
+  }
+  // The model from the options is the same in every run.
+  if (!kSideInModel(cc).IsEmpty() &&
+      kSideInModel(cc).Get().get() != model_packet_.Get().get()) {
+    return false;
+  }
+  // Op resolvers cannot be compared.
+  if (kSideInOpResolver(cc).IsConnected() ||
+      kSideInCustomOpResolver(cc).IsConnected()) {
+    return false;
+  }
+  const std::string delegate_side_packet =
+      kDelegate(cc).IsEmpty() ? "" : kDelegate(cc).Get().SerializeAsString();
+  return delegate_side_packet == delegate_side_packet_;
+}
+
 absl::Status InferenceCalculatorCpuImpl::Process(CalculatorContext* cc) {
+  if (max_batch_size_ > 1) {
+    // Without any packet, this call only reports that no input arrives up to
+    // its timestamp, so the batch runs instead of waiting for a later input.
+    const bool bound_update =
+        kInTensors(cc).IsEmpty() && kInBatchEnd(cc).IsEmpty();
+    if (!kInTensors(cc).IsEmpty()) {
+      RET_CHECK(!kInTensors(cc)->empty());
+      if (batch_.empty()) batch_start_time_ = absl::Now();
+      batch_.push_back(kInTensors(cc));
+    }
+    if (static_cast<int>(batch_.size()) >= max_batch_size_ ||
+        !kInBatchEnd(cc).IsEmpty() || bound_update ||
+        (max_batch_latency_ > absl::ZeroDuration() && !batch_.empty() &&
+         absl::Now() - batch_start_time_ >= max_batch_latency_)) {
+      MP_RETURN_IF_ERROR(RunBatch(cc));
+    }
+    // The bound stays at the first queued input until its batch has run.
+    if (batch_.empty()) {
+      kOutTensors(cc).SetNextTimestampBound(
+          cc->InputTimestamp().NextAllowedInStream());
+    }
+    return absl::OkStatus();
+  }
+
   if (kInTensors(cc).IsEmpty()) {
     return absl::OkStatus();
   }
   const auto& input_tensors = *kInTensors(cc);
   RET_CHECK(!input_tensors.empty());
-  auto output_tensors = absl::make_unique<std::vector<Tensor>>();
 
+  tflite::Interpreter* interpreter = AcquireInterpreter();
+  absl::Status status = RunInference(cc, input_tensors, interpreter);
+  ReleaseInterpreter(interpreter);
+  return status;
+}
+
+absl::Status InferenceCalculatorCpuImpl::RunInference(
+    CalculatorContext* cc, const std::vector<Tensor>& input_tensors,
+    tflite::Interpreter* interpreter) {
   // Read CPU input into tensors.
+  MP_RETURN_IF_ERROR(CopyInputs(input_tensors, /*batch_index=*/0, interpreter));
+
+  // Run inference.
+  RET_CHECK_EQ(interpreter->Invoke(), kTfLiteOk);
+
+  // Output result tensors (CPU).
+  ASSIGN_OR_RETURN(auto output_tensors,
+                   CopyOutputs(/*batch_index=*/0, /*batch_size=*/1,
+                               interpreter));
+  kOutTensors(cc).Send(std::move(output_tensors));
+  return absl::OkStatus();
+}
+
+tflite::Interpreter* InferenceCalculatorCpuImpl::AcquireInterpreter() {
+  absl::MutexLock lock(&idle_mutex_);
+  idle_mutex_.Await(absl::Condition(
+      +[](std::vector<tflite::Interpreter*>* idle) { return !idle->empty(); },
+      &idle_interpreters_));
+  tflite::Interpreter* interpreter = idle_interpreters_.back();
+  idle_interpreters_.pop_back();
+  return interpreter;
+}
+
+void InferenceCalculatorCpuImpl::ReleaseInterpreter(
+    tflite::Interpreter* interpreter) {
+  absl::MutexLock lock(&idle_mutex_);
+  idle_interpreters_.push_back(interpreter);
+}
+
+absl::Status InferenceCalculatorCpuImpl::RunBatch(CalculatorContext* cc) {
+  if (batch_.empty()) {
+    return absl::OkStatus();
+  }
+  const int batch_size = batch_.size();
+  tflite::Interpreter* interpreter = interpreters_[0]->interpreter.get();
+  MP_RETURN_IF_ERROR(ResizeBatch(batch_size));
+  for (int b = 0; b < batch_size; ++b) {
+    MP_RETURN_IF_ERROR(CopyInputs(batch_[b].Get(), b, interpreter));
+  }
+  RET_CHECK_EQ(interpreter->Invoke(), kTfLiteOk);
+  for (int b = 0; b < batch_size; ++b) {
+    ASSIGN_OR_RETURN(auto output_tensors,
+                     CopyOutputs(b, batch_size, interpreter));
+    kOutTensors(cc).Send(std::move(output_tensors), batch_[b].timestamp());
+  }
+  batch_.clear();
+  return absl::OkStatus();
+}
+
+absl::Status InferenceCalculatorCpuImpl::ResizeBatch(int batch_size) {
+  if (batch_size == batch_size_) {
+    return absl::OkStatus();
+  }
+  tflite::Interpreter* interpreter = interpreters_[0]->interpreter.get();
+  const auto& input_indexes = interpreter->inputs();
+  for (int i = 0; i < input_indexes.size(); ++i) {
+    std::vector<int> dims = input_dims_[i];
+    RET_CHECK(!dims.empty()) << "Batching requires inputs with a batch "
+                                "dimension.";
+    dims[0] *= batch_size;
+    RET_CHECK_EQ(interpreter->ResizeInputTensor(input_indexes[i], dims),
+                 kTfLiteOk);
+  }
+  MP_RETURN_IF_ERROR(AllocateTensors(interpreter));
+  batch_size_ = batch_size;
+  return absl::OkStatus();
+}
+
+absl::Status InferenceCalculatorCpuImpl::CopyInputs(
+    const std::vector<Tensor>& input_tensors, int batch_index,
+    tflite::Interpreter* interpreter) {
   for (int i = 0; i < input_tensors.size(); ++i) {
     switch (input_tensor_type_) {
       case TfLiteType::kTfLiteFloat16:
       case TfLiteType::kTfLiteFloat32: {
-        CopyTensorBuffer<float>(input_tensors[i], interpreter_.get(), i);
+        MP_RETURN_IF_ERROR(CopyTensorBuffer<float>(
+            input_tensors[i], interpreter, i, batch_index));
         break;
       }
       case TfLiteType::kTfLiteUInt8: {
-        CopyTensorBuffer<uint8>(input_tensors[i], interpreter_.get(), i);
+        MP_RETURN_IF_ERROR(CopyTensorBuffer<uint8>(
+            input_tensors[i], interpreter, i, batch_index));
         break;
       }
       case TfLiteType::kTfLiteInt8: {
-        CopyTensorBuffer<int8>(input_tensors[i], interpreter_.get(), i);
+        MP_RETURN_IF_ERROR(CopyTensorBuffer<int8>(
+            input_tensors[i], interpreter, i, batch_index));
         break;
       }
       default:
@@ -139,61 +363,102 @@ absl::Status InferenceCalculatorCpuImpl::Process(CalculatorContext* cc) {
             absl::StrCat("Unsupported input tensor type:", input_tensor_type_));
     }
   }
+  return absl::OkStatus();
+}
 
-  // Run inference.
-  RET_CHECK_EQ(interpreter_->Invoke(), kTfLiteOk);
-
-  // Output result tensors (CPU).
-  const auto& tensor_indexes = interpreter_->outputs();
+absl::StatusOr<std::unique_ptr<std::vector<Tensor>>>
+InferenceCalculatorCpuImpl::CopyOutputs(int batch_index, int batch_size,
+                                        tflite::Interpreter* interpreter) {
+  auto output_tensors = absl::make_unique<std::vector<Tensor>>();
+  const auto& tensor_indexes = interpreter->outputs();
   output_tensors->reserve(tensor_indexes.size());
   for (int i = 0; i < tensor_indexes.size(); ++i) {
-    TfLiteTensor* tensor = interpreter_->tensor(tensor_indexes[i]);
-    output_tensors->emplace_back(
-        Tensor::ElementType::kFloat32,
-        Tensor::Shape{std::vector<int>{
-            tensor->dims->data, tensor->dims->data + tensor->dims->size}});
+    TfLiteTensor* tensor = interpreter->tensor(tensor_indexes[i]);
+    std::vector<int> dims(tensor->dims->data,
+                          tensor->dims->data + tensor->dims->size);
+    if (batch_size > 1) {
+      RET_CHECK(!dims.empty() && dims[0] % batch_size == 0)
+          << "Output tensor " << i << " cannot be split into " << batch_size
+          << " batch items.";
+      dims[0] /= batch_size;
+    }
+    output_tensors->emplace_back(Tensor::ElementType::kFloat32,
+                                 Tensor::Shape{dims});
+    const int num_elements = output_tensors->back().shape().num_elements();
     auto cpu_view = output_tensors->back().GetCpuWriteView();
-    std::memcpy(cpu_view.buffer<float>(), tensor->data.f,
+    std::memcpy(cpu_view.buffer<float>(),
+                tensor->data.f + batch_index * num_elements,
                 output_tensors->back().bytes());
   }
-  kOutTensors(cc).Send(std::move(output_tensors));
-  return absl::OkStatus();
+  return output_tensors;
 }
 
 absl::Status InferenceCalculatorCpuImpl::Close(CalculatorContext* cc) {
-  interpreter_ = nullptr;
-  delegate_ = nullptr;
-  return absl::OkStatus();
+  // The interpreters are kept for Reset(), and are destroyed with the
+  // calculator.
+  return RunBatch(cc);
 }
 
 absl::Status InferenceCalculatorCpuImpl::InitInterpreter(
     CalculatorContext* cc) {
   ASSIGN_OR_RETURN(model_packet_, GetModelAsPacket(cc));
+  delegate_side_packet_ =
+      kDelegate(cc).IsEmpty() ? "" : kDelegate(cc).Get().SerializeAsString();
   const auto& model = *model_packet_.Get();
   ASSIGN_OR_RETURN(auto op_resolver_packet, GetOpResolverAsPacket(cc));
   const auto& op_resolver = op_resolver_packet.Get();
+  const int num_interpreters =
+      cc->Options<mediapipe::InferenceCalculatorOptions>().num_interpreters();
+  for (int i = 0; i < num_interpreters; ++i) {
+    ASSIGN_OR_RETURN(auto instance, BuildInterpreter(cc, model, op_resolver));
+    interpreters_.push_back(std::move(instance));
+  }
+  absl::MutexLock lock(&idle_mutex_);
+  for (const auto& instance : interpreters_) {
+    idle_interpreters_.push_back(instance->interpreter.get());
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<
+    std::unique_ptr<InferenceCalculatorCpuImpl::InterpreterInstance>>
+InferenceCalculatorCpuImpl::BuildInterpreter(
+    CalculatorContext* cc, const tflite::FlatBufferModel& model,
+    const tflite::OpResolver& op_resolver) {
+  auto instance = absl::make_unique<InterpreterInstance>();
   tflite::InterpreterBuilder interpreter_builder(model, op_resolver);
-  MP_RETURN_IF_ERROR(LoadDelegate(cc, &interpreter_builder));
+  MP_RETURN_IF_ERROR(
+      LoadDelegate(cc, &interpreter_builder, &instance->delegate));
 #if defined(__EMSCRIPTEN__)
   interpreter_builder.SetNumThreads(1);
 #else
-  interpreter_builder.SetNumThreads(
-      cc->Options<mediapipe::InferenceCalculatorOptions>().cpu_num_thread());
+  const auto& options = cc->Options<mediapipe::InferenceCalculatorOptions>();
+  interpreter_builder.SetNumThreads(NumThreadsPerInterpreter(
+      options.cpu_num_thread(), options.num_interpreters()));
 #endif  // __EMSCRIPTEN__
 
-  RET_CHECK_EQ(interpreter_builder(&interpreter_), kTfLiteOk);
-  RET_CHECK(interpreter_);
-  return AllocateTensors();
+  RET_CHECK_EQ(interpreter_builder(&instance->interpreter), kTfLiteOk);
+  RET_CHECK(instance->interpreter);
+  tflite::Interpreter* interpreter = instance->interpreter.get();
+  input_dims_.clear();
+  for (int index : interpreter->inputs()) {
+    const TfLiteIntArray* dims = interpreter->tensor(index)->dims;
+    input_dims_.emplace_back(dims->data, dims->data + dims->size);
+  }
+  MP_RETURN_IF_ERROR(AllocateTensors(interpreter));
+  return instance;
 }
 
-absl::Status InferenceCalculatorCpuImpl::AllocateTensors() {
-  RET_CHECK_EQ(interpreter_->AllocateTensors(), kTfLiteOk);
-  input_tensor_type_ = interpreter_->tensor(interpreter_->inputs()[0])->type;
+absl::Status InferenceCalculatorCpuImpl::AllocateTensors(
+    tflite::Interpreter* interpreter) {
+  RET_CHECK_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+  input_tensor_type_ = interpreter->tensor(interpreter->inputs()[0])->type;
   return absl::OkStatus();
 }
 
 absl::Status InferenceCalculatorCpuImpl::LoadDelegate(
-    CalculatorContext* cc, tflite::InterpreterBuilder* interpreter_builder) {
+    CalculatorContext* cc, tflite::InterpreterBuilder* interpreter_builder,
+    TfLiteDelegatePtr* delegate) {
   const auto& calculator_opts =
       cc->Options<mediapipe::InferenceCalculatorOptions>();
   auto opts_delegate = calculator_opts.delegate();
@@ -233,9 +498,9 @@ absl::Status InferenceCalculatorCpuImpl::LoadDelegate(
     options.accelerator_name = nnapi.has_accelerator_name()
                                    ? nnapi.accelerator_name().c_str()
                                    : nullptr;
-    delegate_ = TfLiteDelegatePtr(new tflite::StatefulNnApiDelegate(options),
+    *delegate = TfLiteDelegatePtr(new tflite::StatefulNnApiDelegate(options),
                                   [](TfLiteDelegate*) {});
-    interpreter_builder->AddDelegate(delegate_.get());
+    interpreter_builder->AddDelegate(delegate->get());
     return absl::OkStatus();
   }
 #endif  // MEDIAPIPE_ANDROID
@@ -248,11 +513,12 @@ absl::Status InferenceCalculatorCpuImpl::LoadDelegate(
 
   if (use_xnnpack) {
     auto xnnpack_opts = TfLiteXNNPackDelegateOptionsDefault();
-    xnnpack_opts.num_threads =
-        GetXnnpackNumThreads(opts_has_delegate, opts_delegate);
-    delegate_ = TfLiteDelegatePtr(TfLiteXNNPackDelegateCreate(&xnnpack_opts),
+    xnnpack_opts.num_threads = NumThreadsPerInterpreter(
+        GetXnnpackNumThreads(opts_has_delegate, opts_delegate),
+        calculator_opts.num_interpreters());
+    *delegate = TfLiteDelegatePtr(TfLiteXNNPackDelegateCreate(&xnnpack_opts),
                                   &TfLiteXNNPackDelegateDelete);
-    interpreter_builder->AddDelegate(delegate_.get());
+    interpreter_builder->AddDelegate(delegate->get());
   }
 
   return absl::OkStatus();
@@ -95,8 +95,50 @@ constexpr char kGraphWithModelAsInputSidePacket[] = R"(
       }
     }
   )";
+constexpr char kGraphWithGatedBatching[] = R"(
+    input_stream: "tensor_in"
+    input_stream: "allow"
+    node {
+      calculator: "GateCalculator"
+      input_stream: "tensor_in"
+      input_stream: "ALLOW:allow"
+      output_stream: "gated_tensor"
+    }
+    node {
+      calculator: "InferenceCalculator"
+      input_stream: "TENSORS:gated_tensor"
+      output_stream: "TENSORS:tensor_out"
+      options {
+        [mediapipe.InferenceCalculatorOptions.ext] {
+          model_path: "mediapipe/calculators/tensor/testdata/add.bin"
+          delegate { tflite {} }
+          max_batch_size: 4
+        }
+      }
+    }
+  )";
+constexpr char kGraphWithInterpreterPool[] = R"(
+    input_stream: "tensor_in"
+    num_threads: $num_interpreters
+    node {
+      calculator: "InferenceCalculator"
+      input_stream: "TENSORS:tensor_in"
+      output_stream: "TENSORS:tensor_out"
+      max_in_flight: $num_interpreters
+      output_stream_handler {
+        output_stream_handler: "InOrderOutputStreamHandler"
+      }
+      options {
+        [mediapipe.InferenceCalculatorOptions.ext] {
+          model_path: "mediapipe/calculators/tensor/testdata/add.bin"
+          delegate { tflite {} }
+          num_interpreters: $num_interpreters
+        }
+      }
+    }
+  )";
 
-std::vector<Tensor> CreateInputs() {
+std::vector<Tensor> CreateInputs(float value = 1) {
   std::vector<Tensor> input_vec;
   // Prepare input tensor.
   input_vec.emplace_back(
@@ -107,7 +149,7 @@ std::vector<Tensor> CreateInputs() {
     auto num_elements = input_vec.back().shape().num_elements();
     auto tensor_buffer = view.buffer<float>();
     for (int i = 0; i < num_elements; i++) {
-      tensor_buffer[i] = 1;
+      tensor_buffer[i] = value;
     }
   }
 
@@ -174,5 +216,111 @@ TEST(InferenceCalculatorTest, ModelAsInputSidePacketSmokeTest) {
   DoSmokeTest(kGraphWithModelAsInputSidePacket);
 }
 
+// Runs three inputs with a maximum batch size of two: the first two inputs run
+// as one batch, and the last one runs when the graph is closed.
+TEST(InferenceCalculatorTest, BatchesInputsOfSeveralTimestamps) {
+  CalculatorGraphConfig graph_config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(absl::StrReplaceAll(
+          kGraphWithModelPathInOption,
+          {{"$delegate", "delegate { tflite {} } max_batch_size: 2"}}));
+  std::vector<Packet> output_packets;
+  tool::AddVectorSink("tensor_out", &graph_config, &output_packets);
+  CalculatorGraph graph(graph_config);
+  MP_ASSERT_OK(graph.StartRun({}));
+  for (int t = 0; t < 3; ++t) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "tensor_in",
+        MakePacket<std::vector<Tensor>>(CreateInputs(t + 1)).At(Timestamp(t))));
+  }
+  MP_ASSERT_OK(graph.WaitUntilIdle());
+  EXPECT_EQ(2, output_packets.size());
+  MP_ASSERT_OK(graph.CloseInputStream("tensor_in"));
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  ASSERT_EQ(3, output_packets.size());
+  for (int t = 0; t < 3; ++t) {
+    EXPECT_EQ(Timestamp(t), output_packets[t].Timestamp());
+    const auto& result_vec = output_packets[t].Get<std::vector<Tensor>>();
+    ASSERT_EQ(1, result_vec.size());
+    const Tensor& result = result_vec[0];
+    EXPECT_EQ(result.shape().dims,
+              std::vector<int>({1, kTensorHeight, kTensorWidth,
+                                kTensorChannels}));
+    auto view = result.GetCpuReadView();
+    auto result_buffer = view.buffer<float>();
+    for (int i = 0; i < result.shape().num_elements(); i++) {
+      ASSERT_EQ(3 * (t + 1), result_buffer[i]);
+    }
+  }
+}
+
+// Drops the third input at the gate: the timestamp bound update that replaces
+// it runs the pending batch without waiting for more inputs.
+TEST(InferenceCalculatorTest, RunsBatchOnTimestampBoundUpdate) {
+  CalculatorGraphConfig graph_config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(kGraphWithGatedBatching);
+  std::vector<Packet> output_packets;
+  tool::AddVectorSink("tensor_out", &graph_config, &output_packets);
+  CalculatorGraph graph(graph_config);
+  MP_ASSERT_OK(graph.StartRun({}));
+  for (int t = 0; t < 3; ++t) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "tensor_in",
+        MakePacket<std::vector<Tensor>>(CreateInputs(t + 1)).At(Timestamp(t))));
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "allow", MakePacket<bool>(t < 2).At(Timestamp(t))));
+  }
+  MP_ASSERT_OK(graph.WaitUntilIdle());
+  ASSERT_EQ(2, output_packets.size());
+  EXPECT_EQ(Timestamp(0), output_packets[0].Timestamp());
+  EXPECT_EQ(Timestamp(1), output_packets[1].Timestamp());
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+  EXPECT_EQ(2, output_packets.size());
+}
+
+// Runs several inputs through a pool of two interpreters, and checks that the
+// outputs come back in timestamp order.
+TEST(InferenceCalculatorTest, RunsConcurrentInputsOnInterpreterPool) {
+  CalculatorGraphConfig graph_config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(absl::StrReplaceAll(
+          kGraphWithInterpreterPool, {{"$num_interpreters", "2"}}));
+  std::vector<Packet> output_packets;
+  tool::AddVectorSink("tensor_out", &graph_config, &output_packets);
+  CalculatorGraph graph(graph_config);
+  MP_ASSERT_OK(graph.StartRun({}));
+  constexpr int kNumInputs = 10;
+  for (int t = 0; t < kNumInputs; ++t) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "tensor_in",
+        MakePacket<std::vector<Tensor>>(CreateInputs(t + 1)).At(Timestamp(t))));
+  }
+  MP_ASSERT_OK(graph.CloseInputStream("tensor_in"));
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  ASSERT_EQ(kNumInputs, output_packets.size());
+  for (int t = 0; t < kNumInputs; ++t) {
+    EXPECT_EQ(Timestamp(t), output_packets[t].Timestamp());
+    const auto& result_vec = output_packets[t].Get<std::vector<Tensor>>();
+    ASSERT_EQ(1, result_vec.size());
+    const Tensor& result = result_vec[0];
+    auto view = result.GetCpuReadView();
+    auto result_buffer = view.buffer<float>();
+    for (int i = 0; i < result.shape().num_elements(); i++) {
+      ASSERT_EQ(3 * (t + 1), result_buffer[i]);
+    }
+  }
+}
+
+TEST(InferenceCalculatorTest, RejectsInterpreterPoolWithBatching) {
+  CalculatorGraphConfig graph_config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(absl::StrReplaceAll(
+          kGraphWithModelPathInOption,
+          {{"$delegate",
+            "delegate { tflite {} } max_batch_size: 2 num_interpreters: 2"}}));
+  CalculatorGraph graph;
+  EXPECT_FALSE(graph.Initialize(graph_config).ok());
+}
+
 }  // namespace
 }  // namespace mediapipe
@@ -12,6 +12,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cmath>
+#include <limits>
 #include <unordered_map>
 #include <vector>
 
@@ -65,16 +67,41 @@ namespace api2 {
 
 namespace {
 
+// Anchors in structure-of-arrays layout, so that box decoding reads each field
+// from a contiguous array.
+struct AnchorArrays {
+  std::vector<float> y_center;
+  std::vector<float> x_center;
+  std::vector<float> h;
+  std::vector<float> w;
+
+  void resize(int num_boxes) {
+    y_center.resize(num_boxes);
+    x_center.resize(num_boxes);
+    h.resize(num_boxes);
+    w.resize(num_boxes);
+  }
+};
+
 void ConvertRawValuesToAnchors(const float* raw_anchors, int num_boxes,
-                               std::vector<Anchor>* anchors) {
-  anchors->clear();
+                               AnchorArrays* anchors) {
+  anchors->resize(num_boxes);
   for (int i = 0; i < num_boxes; ++i) {
-    Anchor new_anchor;
-    new_anchor.set_y_center(raw_anchors[i * kNumCoordsPerBox + 0]);
-    new_anchor.set_x_center(raw_anchors[i * kNumCoordsPerBox + 1]);
-    new_anchor.set_h(raw_anchors[i * kNumCoordsPerBox + 2]);
-    new_anchor.set_w(raw_anchors[i * kNumCoordsPerBox + 3]);
-    anchors->push_back(new_anchor);
+    anchors->y_center[i] = raw_anchors[i * kNumCoordsPerBox + 0];
+    anchors->x_center[i] = raw_anchors[i * kNumCoordsPerBox + 1];
+    anchors->h[i] = raw_anchors[i * kNumCoordsPerBox + 2];
+    anchors->w[i] = raw_anchors[i * kNumCoordsPerBox + 3];
+  }
+}
+
+void ConvertAnchorsToArrays(const std::vector<Anchor>& anchors,
+                            AnchorArrays* anchor_arrays) {
+  anchor_arrays->resize(anchors.size());
+  for (int i = 0; i < anchors.size(); ++i) {
+    anchor_arrays->y_center[i] = anchors[i].y_center();
+    anchor_arrays->x_center[i] = anchors[i].x_center();
+    anchor_arrays->h[i] = anchors[i].h();
+    anchor_arrays->w[i] = anchors[i].w();
   }
 }
 
@@ -91,6 +118,18 @@ void ConvertAnchorsToRawValues(const std::vector<Anchor>& anchors,
   }
 }
 
+// Returns the raw score below which a box cannot reach |min_score| after the
+// sigmoid. It is lowered by a margin that covers the rounding error of the
+// float sigmoid, so that it only rejects boxes that the exact check rejects.
+float MinLogitForScore(float min_score) {
+  if (min_score <= 0.f || min_score >= 1.f) {
+    return -std::numeric_limits<float>::infinity();
+  }
+  const double logit = std::log(min_score / (1.0 - min_score));
+  const double margin = 1e-4 + 1e-5 / (min_score * (1.0 - min_score));
+  return static_cast<float>(logit - margin);
+}
+
 absl::Status CheckCustomTensorMapping(
     const TensorsToDetectionsCalculatorOptions::TensorMapping& tensor_mapping) {
   RET_CHECK(tensor_mapping.has_detections_tensor_index() &&
@@ -194,10 +233,14 @@ class TensorsToDetectionsCalculator : public Node {
 
   absl::Status LoadOptions(CalculatorContext* cc);
   absl::Status GpuInit(CalculatorContext* cc);
-  absl::Status DecodeBoxes(const float* raw_boxes,
-                           const std::vector<Anchor>& anchors,
-                           std::vector<float>* boxes);
-  absl::Status ConvertToDetections(const float* detection_boxes,
+  void SelectCandidateBoxes(const float* raw_scores,
+                            std::vector<int>* candidates);
+  void ScoreBoxes(const float* raw_scores, const std::vector<int>& candidates,
+                  std::vector<int>* box_indices, std::vector<float>* scores,
+                  std::vector<int>* classes);
+  void DecodeBoxes(const float* raw_boxes, const std::vector<int>& box_indices,
+                   std::vector<float>* boxes);
+  absl::Status ConvertToDetections(int num_boxes, const float* detection_boxes,
                                    const float* detection_scores,
                                    const int* detection_classes,
                                    std::vector<Detection>* output_detections);
@@ -205,6 +248,7 @@ class TensorsToDetectionsCalculator : public Node {
                                float box_xmax, float score, int class_id,
                                bool flip_vertically);
   bool IsClassIndexAllowed(int class_index);
+  float ScoreFromRawValue(float raw_score);
 
   int num_classes_ = 0;
   int num_boxes_ = 0;
@@ -219,13 +263,25 @@ class TensorsToDetectionsCalculator : public Node {
   // Allowed or ignored class indices based on provided options or side packet.
   // These are used to filter out the output detection results.
   ClassIndexSet class_index_set_;
+  // The class indices in [0, num_classes_) that pass class_index_set_.
+  std::vector<int> allowed_classes_;
+  // Raw scores below this value cannot pass min_score_thresh.
+  float min_candidate_score_ = -std::numeric_limits<float>::infinity();
 
   TensorsToDetectionsCalculatorOptions options_;
   bool scores_tensor_index_is_set_ = false;
   TensorsToDetectionsCalculatorOptions::TensorMapping tensor_mapping_;
   std::vector<int> box_indices_ = {0, 1, 2, 3};
   bool has_custom_box_indices_ = false;
-  std::vector<Anchor> anchors_;
+  AnchorArrays anchors_;
+
+  // Buffers reused across calls to ProcessCPU.
+  std::vector<float> max_raw_scores_;
+  std::vector<int> candidate_boxes_;
+  std::vector<int> selected_boxes_;
+  std::vector<float> selected_scores_;
+  std::vector<int> selected_classes_;
+  std::vector<float> decoded_boxes_;
 
 #ifndef MEDIAPIPE_DISABLE_GL_COMPUTE
   mediapipe::GlCalculatorHelper gpu_helper_;
@@ -356,50 +412,23 @@ absl::Status TensorsToDetectionsCalculator::ProcessCPU(
         auto raw_anchors = anchor_view.buffer<float>();
         ConvertRawValuesToAnchors(raw_anchors, num_boxes_, &anchors_);
       } else if (!kInAnchors(cc).IsEmpty()) {
-        anchors_ = *kInAnchors(cc);
+        RET_CHECK_EQ(kInAnchors(cc)->size(), num_boxes_);
+        ConvertAnchorsToArrays(*kInAnchors(cc), &anchors_);
       } else {
         return absl::UnavailableError("No anchor data available.");
       }
       anchors_init_ = true;
     }
-    std::vector<float> boxes(num_boxes_ * num_coords_);
-    MP_RETURN_IF_ERROR(DecodeBoxes(raw_boxes, anchors_, &boxes));
-
-    std::vector<float> detection_scores(num_boxes_);
-    std::vector<int> detection_classes(num_boxes_);
-
-    // Filter classes by scores.
-    for (int i = 0; i < num_boxes_; ++i) {
-      int class_id = -1;
-      float max_score = -std::numeric_limits<float>::max();
-      // Find the top score for box i.
-      for (int score_idx = 0; score_idx < num_classes_; ++score_idx) {
-        if (IsClassIndexAllowed(score_idx)) {
-          auto score = raw_scores[i * num_classes_ + score_idx];
-          if (options_.sigmoid_score()) {
-            if (options_.has_score_clipping_thresh()) {
-              score = score < -options_.score_clipping_thresh()
-                          ? -options_.score_clipping_thresh()
-                          : score;
-              score = score > options_.score_clipping_thresh()
-                          ? options_.score_clipping_thresh()
-                          : score;
-            }
-            score = 1.0f / (1.0f + std::exp(-score));
-          }
-          if (max_score < score) {
-            max_score = score;
-            class_id = score_idx;
-          }
-        }
-      }
-      detection_scores[i] = max_score;
-      detection_classes[i] = class_id;
-    }
 
-    MP_RETURN_IF_ERROR(
-        ConvertToDetections(boxes.data(), detection_scores.data(),
-                            detection_classes.data(), output_detections));
+    // Scores are checked first, so that only the boxes that pass
+    // min_score_thresh are decoded and converted to detections.
+    SelectCandidateBoxes(raw_scores, &candidate_boxes_);
+    ScoreBoxes(raw_scores, candidate_boxes_, &selected_boxes_,
+               &selected_scores_, &selected_classes_);
+    DecodeBoxes(raw_boxes, selected_boxes_, &decoded_boxes_);
+    MP_RETURN_IF_ERROR(ConvertToDetections(
+        selected_boxes_.size(), decoded_boxes_.data(), selected_scores_.data(),
+        selected_classes_.data(), output_detections));
   } else {
     // Postprocessing on CPU with postprocessing op (e.g. anchor decoding and
     // non-maximum suppression) within the model.
@@ -444,9 +473,9 @@ absl::Status TensorsToDetectionsCalculator::ProcessCPU(
     for (int i = 0; i < num_boxes_; ++i) {
       detection_classes[i] = static_cast<int>(detection_classes_ptr[i]);
     }
-    MP_RETURN_IF_ERROR(ConvertToDetections(detection_boxes, detection_scores,
-                                           detection_classes.data(),
-                                           output_detections));
+    MP_RETURN_IF_ERROR(ConvertToDetections(
+        num_boxes_, detection_boxes, detection_scores,
+        detection_classes.data(), output_detections));
   }
   return absl::OkStatus();
 }
@@ -524,7 +553,8 @@ absl::Status TensorsToDetectionsCalculator::ProcessGPU(
   }
   auto decoded_boxes_view = decoded_boxes_buffer_->GetCpuReadView();
   auto boxes = decoded_boxes_view.buffer<float>();
-  MP_RETURN_IF_ERROR(ConvertToDetections(boxes, detection_scores.data(),
+  MP_RETURN_IF_ERROR(ConvertToDetections(num_boxes_, boxes,
+                                         detection_scores.data(),
                                          detection_classes.data(),
                                          output_detections));
 #elif MEDIAPIPE_METAL_ENABLED
@@ -610,7 +640,8 @@ absl::Status TensorsToDetectionsCalculator::ProcessGPU(
   }
   auto decoded_boxes_view = decoded_boxes_buffer_->GetCpuReadView();
   auto boxes = decoded_boxes_view.buffer<float>();
-  MP_RETURN_IF_ERROR(ConvertToDetections(boxes, detection_scores.data(),
+  MP_RETURN_IF_ERROR(ConvertToDetections(num_boxes_, boxes,
+                                         detection_scores.data(),
                                          detection_classes.data(),
                                          output_detections));
 
@@ -681,6 +712,18 @@ absl::Status TensorsToDetectionsCalculator::LoadOptions(CalculatorContext* cc) {
       class_index_set_.values.insert(options_.ignore_classes(i));
     }
   }
+  allowed_classes_.clear();
+  for (int i = 0; i < num_classes_; ++i) {
+    if (IsClassIndexAllowed(i)) {
+      allowed_classes_.push_back(i);
+    }
+  }
+  if (options_.has_min_score_thresh()) {
+    min_candidate_score_ =
+        options_.sigmoid_score()
+            ? MinLogitForScore(options_.min_score_thresh())
+            : options_.min_score_thresh();
+  }
 
   if (options_.has_tensor_mapping()) {
     RET_CHECK_OK(CheckCustomTensorMapping(options_.tensor_mapping()));
@@ -716,74 +759,151 @@ absl::Status TensorsToDetectionsCalculator::LoadOptions(CalculatorContext* cc) {
   return absl::OkStatus();
 }
 
-absl::Status TensorsToDetectionsCalculator::DecodeBoxes(
-    const float* raw_boxes, const std::vector<Anchor>& anchors,
-    std::vector<float>* boxes) {
+void TensorsToDetectionsCalculator::SelectCandidateBoxes(
+    const float* raw_scores, std::vector<int>* candidates) {
+  // The sigmoid is monotonic, so the max raw score of each box is compared with
+  // min_candidate_score_ instead of evaluating the sigmoid for every score.
+  // The loops below have no data-dependent branches, so that the compiler can
+  // vectorize them.
+  float clip_min = -std::numeric_limits<float>::infinity();
+  float clip_max = std::numeric_limits<float>::infinity();
+  if (options_.sigmoid_score() && options_.has_score_clipping_thresh()) {
+    clip_min = -options_.score_clipping_thresh();
+    clip_max = options_.score_clipping_thresh();
+  }
+  max_raw_scores_.assign(num_boxes_, -std::numeric_limits<float>::infinity());
+  float* max_scores = max_raw_scores_.data();
+  for (int class_id : allowed_classes_) {
+    const float* class_scores = raw_scores + class_id;
+    for (int i = 0; i < num_boxes_; ++i) {
+      float score = class_scores[i * num_classes_];
+      score = score < clip_min ? clip_min : score;
+      score = score > clip_max ? clip_max : score;
+      max_scores[i] = score > max_scores[i] ? score : max_scores[i];
+    }
+  }
+
+  candidates->clear();
   for (int i = 0; i < num_boxes_; ++i) {
-    const int box_offset = i * num_coords_ + options_.box_coord_offset();
-
-    float y_center = raw_boxes[box_offset];
-    float x_center = raw_boxes[box_offset + 1];
-    float h = raw_boxes[box_offset + 2];
-    float w = raw_boxes[box_offset + 3];
-    if (options_.reverse_output_order()) {
-      x_center = raw_boxes[box_offset];
-      y_center = raw_boxes[box_offset + 1];
-      w = raw_boxes[box_offset + 2];
-      h = raw_boxes[box_offset + 3];
+    if (max_scores[i] >= min_candidate_score_) {
+      candidates->push_back(i);
+    }
+  }
+}
+
+void TensorsToDetectionsCalculator::ScoreBoxes(
+    const float* raw_scores, const std::vector<int>& candidates,
+    std::vector<int>* box_indices, std::vector<float>* scores,
+    std::vector<int>* classes) {
+  box_indices->clear();
+  scores->clear();
+  classes->clear();
+  for (int i : candidates) {
+    int class_id = -1;
+    float max_score = -std::numeric_limits<float>::max();
+    // Find the top score for box i.
+    for (int score_idx : allowed_classes_) {
+      const float score =
+          ScoreFromRawValue(raw_scores[i * num_classes_ + score_idx]);
+      if (max_score < score) {
+        max_score = score;
+        class_id = score_idx;
+      }
+    }
+    if (options_.has_min_score_thresh() &&
+        max_score < options_.min_score_thresh()) {
+      continue;
     }
+    box_indices->push_back(i);
+    scores->push_back(max_score);
+    classes->push_back(class_id);
+  }
+}
 
-    x_center =
-        x_center / options_.x_scale() * anchors[i].w() + anchors[i].x_center();
-    y_center =
-        y_center / options_.y_scale() * anchors[i].h() + anchors[i].y_center();
+float TensorsToDetectionsCalculator::ScoreFromRawValue(float raw_score) {
+  float score = raw_score;
+  if (options_.sigmoid_score()) {
+    if (options_.has_score_clipping_thresh()) {
+      score = score < -options_.score_clipping_thresh()
+                  ? -options_.score_clipping_thresh()
+                  : score;
+      score = score > options_.score_clipping_thresh()
+                  ? options_.score_clipping_thresh()
+                  : score;
+    }
+    score = 1.0f / (1.0f + std::exp(-score));
+  }
+  return score;
+}
 
-    if (options_.apply_exponential_on_box_size()) {
-      h = std::exp(h / options_.h_scale()) * anchors[i].h();
-      w = std::exp(w / options_.w_scale()) * anchors[i].w();
+void TensorsToDetectionsCalculator::DecodeBoxes(
+    const float* raw_boxes, const std::vector<int>& box_indices,
+    std::vector<float>* boxes) {
+  const bool reverse = options_.reverse_output_order();
+  const int y_center_index = reverse ? 1 : 0;
+  const int x_center_index = reverse ? 0 : 1;
+  const int h_index = reverse ? 3 : 2;
+  const int w_index = reverse ? 2 : 3;
+  const bool apply_exponential = options_.apply_exponential_on_box_size();
+  const float x_scale = options_.x_scale();
+  const float y_scale = options_.y_scale();
+  const float h_scale = options_.h_scale();
+  const float w_scale = options_.w_scale();
+  const int num_keypoints = options_.num_keypoints();
+  const int keypoint_coord_offset = options_.keypoint_coord_offset();
+  const int num_values_per_keypoint = options_.num_values_per_keypoint();
+  const float* anchor_y_center = anchors_.y_center.data();
+  const float* anchor_x_center = anchors_.x_center.data();
+  const float* anchor_h = anchors_.h.data();
+  const float* anchor_w = anchors_.w.data();
+
+  // Boxes are written in the layout of raw_boxes, packed to the selected
+  // boxes.
+  boxes->resize(box_indices.size() * num_coords_);
+  float* decoded = boxes->data();
+  for (int j = 0; j < box_indices.size(); ++j) {
+    const int i = box_indices[j];
+    const float* raw_box =
+        raw_boxes + i * num_coords_ + options_.box_coord_offset();
+    float* box = decoded + j * num_coords_;
+
+    const float x_center =
+        raw_box[x_center_index] / x_scale * anchor_w[i] + anchor_x_center[i];
+    const float y_center =
+        raw_box[y_center_index] / y_scale * anchor_h[i] + anchor_y_center[i];
+    float h;
+    float w;
+    if (apply_exponential) {
+      h = std::exp(raw_box[h_index] / h_scale) * anchor_h[i];
+      w = std::exp(raw_box[w_index] / w_scale) * anchor_w[i];
     } else {
-      h = h / options_.h_scale() * anchors[i].h();
-      w = w / options_.w_scale() * anchors[i].w();
+      h = raw_box[h_index] / h_scale * anchor_h[i];
+      w = raw_box[w_index] / w_scale * anchor_w[i];
     }
 
-    const float ymin = y_center - h / 2.f;
-    const float xmin = x_center - w / 2.f;
-    const float ymax = y_center + h / 2.f;
-    const float xmax = x_center + w / 2.f;
-
-    (*boxes)[i * num_coords_ + 0] = ymin;
-    (*boxes)[i * num_coords_ + 1] = xmin;
-    (*boxes)[i * num_coords_ + 2] = ymax;
-    (*boxes)[i * num_coords_ + 3] = xmax;
-
-    if (options_.num_keypoints()) {
-      for (int k = 0; k < options_.num_keypoints(); ++k) {
-        const int offset = i * num_coords_ + options_.keypoint_coord_offset() +
-                           k * options_.num_values_per_keypoint();
-
-        float keypoint_y = raw_boxes[offset];
-        float keypoint_x = raw_boxes[offset + 1];
-        if (options_.reverse_output_order()) {
-          keypoint_x = raw_boxes[offset];
-          keypoint_y = raw_boxes[offset + 1];
-        }
-
-        (*boxes)[offset] = keypoint_x / options_.x_scale() * anchors[i].w() +
-                           anchors[i].x_center();
-        (*boxes)[offset + 1] =
-            keypoint_y / options_.y_scale() * anchors[i].h() +
-            anchors[i].y_center();
-      }
+    box[0] = y_center - h / 2.f;
+    box[1] = x_center - w / 2.f;
+    box[2] = y_center + h / 2.f;
+    box[3] = x_center + w / 2.f;
+
+    const float* raw_keypoints =
+        raw_boxes + i * num_coords_ + keypoint_coord_offset;
+    float* keypoints = box + keypoint_coord_offset;
+    for (int k = 0; k < num_keypoints * num_values_per_keypoint;
+         k += num_values_per_keypoint) {
+      const float keypoint_x = raw_keypoints[k + (reverse ? 0 : 1)];
+      const float keypoint_y = raw_keypoints[k + (reverse ? 1 : 0)];
+      keypoints[k] = keypoint_x / x_scale * anchor_w[i] + anchor_x_center[i];
+      keypoints[k + 1] =
+          keypoint_y / y_scale * anchor_h[i] + anchor_y_center[i];
     }
   }
-
-  return absl::OkStatus();
 }
 
 absl::Status TensorsToDetectionsCalculator::ConvertToDetections(
-    const float* detection_boxes, const float* detection_scores,
+    int num_boxes, const float* detection_boxes, const float* detection_scores,
     const int* detection_classes, std::vector<Detection>* output_detections) {
-  for (int i = 0; i < num_boxes_; ++i) {
+  for (int i = 0; i < num_boxes; ++i) {
     if (max_results_ > 0 && output_detections->size() == max_results_) {
       break;
     }
@@ -0,0 +1,241 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <random>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/calculators/tensor/tensors_to_detections_calculator.pb.h"
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/formats/detection.pb.h"
+#include "mediapipe/framework/formats/object_detection/anchor.pb.h"
+#include "mediapipe/framework/formats/tensor.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+using Node = ::mediapipe::CalculatorGraphConfig::Node;
+
+Anchor MakeAnchor(float x_center, float y_center, float w, float h) {
+  Anchor anchor;
+  anchor.set_x_center(x_center);
+  anchor.set_y_center(y_center);
+  anchor.set_w(w);
+  anchor.set_h(h);
+  return anchor;
+}
+
+// Returns the raw box and score tensors of a model with |num_boxes| outputs.
+std::unique_ptr<std::vector<Tensor>> MakeTensors(
+    int num_boxes, const std::vector<float>& raw_boxes,
+    const std::vector<float>& raw_scores) {
+  auto tensors = absl::make_unique<std::vector<Tensor>>();
+  for (const auto* values : {&raw_boxes, &raw_scores}) {
+    tensors->emplace_back(
+        Tensor::ElementType::kFloat32,
+        Tensor::Shape{1, num_boxes,
+                      static_cast<int>(values->size()) / num_boxes});
+    auto view = tensors->back().GetCpuWriteView();
+    std::copy(values->begin(), values->end(), view.buffer<float>());
+  }
+  return tensors;
+}
+
+TEST(TensorsToDetectionsCalculatorTest, DecodesBoxesAboveThreshold) {
+  CalculatorRunner runner(ParseTextProtoOrDie<Node>(R"pb(
+    calculator: "TensorsToDetectionsCalculator"
+    input_stream: "TENSORS:tensors"
+    input_side_packet: "ANCHORS:anchors"
+    output_stream: "DETECTIONS:detections"
+    options {
+      [mediapipe.TensorsToDetectionsCalculatorOptions.ext] {
+        num_classes: 1
+        num_boxes: 3
+        num_coords: 6
+        keypoint_coord_offset: 4
+        num_keypoints: 1
+        num_values_per_keypoint: 2
+        reverse_output_order: true
+        sigmoid_score: true
+        score_clipping_thresh: 100.0
+        x_scale: 10.0
+        y_scale: 10.0
+        w_scale: 10.0
+        h_scale: 10.0
+        min_score_thresh: 0.5
+      }
+    }
+  )pb"));
+  runner.MutableSidePackets()->Tag("ANCHORS") =
+      MakePacket<std::vector<Anchor>>(std::vector<Anchor>{
+          MakeAnchor(0.1f, 0.1f, 1.f, 1.f), MakeAnchor(0.5f, 0.5f, 1.f, 1.f),
+          MakeAnchor(0.9f, 0.9f, 1.f, 1.f)});
+  // Box 0 is below the threshold, and box 2 has a negative width.
+  const std::vector<float> raw_boxes = {
+      0.f, 0.f, 1.f, 1.f,  0.f,  0.f,  //
+      1.f, 2.f, 3.f, 4.f,  -1.f, 1.f,  //
+      0.f, 0.f, -3.f, 4.f, 0.f,  0.f,
+  };
+  const std::vector<float> raw_scores = {-1.f, 2.f, 200.f};
+  runner.MutableInputs()->Tag("TENSORS").packets.push_back(
+      Adopt(MakeTensors(3, raw_boxes, raw_scores).release())
+          .At(Timestamp(0)));
+  MP_ASSERT_OK(runner.Run());
+
+  const auto& packets = runner.Outputs().Tag("DETECTIONS").packets;
+  ASSERT_EQ(1, packets.size());
+  const auto& detections = packets[0].Get<std::vector<Detection>>();
+  ASSERT_EQ(1, detections.size());
+  const Detection& detection = detections[0];
+  EXPECT_FLOAT_EQ(1.f / (1.f + std::exp(-2.f)), detection.score(0));
+  EXPECT_EQ(0, detection.label_id(0));
+  const auto& box = detection.location_data().relative_bounding_box();
+  EXPECT_FLOAT_EQ(0.45f, box.xmin());
+  EXPECT_FLOAT_EQ(0.5f, box.ymin());
+  EXPECT_FLOAT_EQ(0.3f, box.width());
+  EXPECT_FLOAT_EQ(0.4f, box.height());
+  ASSERT_EQ(1, detection.location_data().relative_keypoints_size());
+  EXPECT_FLOAT_EQ(0.4f, detection.location_data().relative_keypoints(0).x());
+  EXPECT_FLOAT_EQ(0.6f, detection.location_data().relative_keypoints(0).y());
+}
+
+TEST(TensorsToDetectionsCalculatorTest, KeepsTopAllowedClass) {
+  CalculatorRunner runner(ParseTextProtoOrDie<Node>(R"pb(
+    calculator: "TensorsToDetectionsCalculator"
+    input_stream: "TENSORS:tensors"
+    input_side_packet: "ANCHORS:anchors"
+    output_stream: "DETECTIONS:detections"
+    options {
+      [mediapipe.TensorsToDetectionsCalculatorOptions.ext] {
+        num_classes: 3
+        num_boxes: 3
+        num_coords: 4
+        ignore_classes: 0
+        x_scale: 1.0
+        y_scale: 1.0
+        w_scale: 1.0
+        h_scale: 1.0
+        min_score_thresh: 0.5
+        max_results: 1
+      }
+    }
+  )pb"));
+  runner.MutableSidePackets()->Tag("ANCHORS") =
+      MakePacket<std::vector<Anchor>>(
+          std::vector<Anchor>(3, MakeAnchor(0.5f, 0.5f, 1.f, 1.f)));
+  const std::vector<float> raw_boxes(3 * 4, 0.1f);
+  // Box 0 only passes with the ignored class, and box 2 exceeds max_results.
+  const std::vector<float> raw_scores = {
+      0.9f, 0.2f, 0.1f,  //
+      0.1f, 0.6f, 0.7f,  //
+      0.0f, 0.8f, 0.0f,
+  };
+  runner.MutableInputs()->Tag("TENSORS").packets.push_back(
+      Adopt(MakeTensors(3, raw_boxes, raw_scores).release())
+          .At(Timestamp(0)));
+  MP_ASSERT_OK(runner.Run());
+
+  const auto& packets = runner.Outputs().Tag("DETECTIONS").packets;
+  ASSERT_EQ(1, packets.size());
+  const auto& detections = packets[0].Get<std::vector<Detection>>();
+  ASSERT_EQ(1, detections.size());
+  EXPECT_FLOAT_EQ(0.7f, detections[0].score(0));
+  EXPECT_EQ(2, detections[0].label_id(0));
+}
+
+// Decodes the output tensors of the full-range face detection model:
+// 2304 anchors, 1 class, and 16 coords per box (4 box + 6 keypoints x 2).
+void BM_DecodeFaceDetectionFullRange(benchmark::State& state) {
+  constexpr int kNumBoxes = 2304;
+  constexpr int kNumCoords = 16;
+  constexpr int kGridSize = 48;
+  CalculatorGraphConfig config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "tensors"
+        input_side_packet: "anchors"
+        node {
+          calculator: "TensorsToDetectionsCalculator"
+          input_stream: "TENSORS:tensors"
+          input_side_packet: "ANCHORS:anchors"
+          output_stream: "DETECTIONS:detections"
+          options {
+            [mediapipe.TensorsToDetectionsCalculatorOptions.ext] {
+              num_classes: 1
+              num_boxes: 2304
+              num_coords: 16
+              box_coord_offset: 0
+              keypoint_coord_offset: 4
+              num_keypoints: 6
+              num_values_per_keypoint: 2
+              sigmoid_score: true
+              score_clipping_thresh: 100.0
+              reverse_output_order: true
+              x_scale: 192.0
+              y_scale: 192.0
+              h_scale: 192.0
+              w_scale: 192.0
+              min_score_thresh: 0.6
+            }
+          }
+        }
+      )pb");
+  std::vector<Anchor> anchors;
+  for (int y = 0; y < kGridSize; ++y) {
+    for (int x = 0; x < kGridSize; ++x) {
+      anchors.push_back(MakeAnchor((x + 0.5f) / kGridSize,
+                                   (y + 0.5f) / kGridSize, 1.f, 1.f));
+    }
+  }
+
+  // Most boxes score far below the threshold, as in a typical frame.
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> box_value(-10.f, 10.f);
+  std::uniform_real_distribution<float> score_value(-20.f, 1.f);
+  std::vector<float> raw_boxes(kNumBoxes * kNumCoords);
+  for (float& value : raw_boxes) value = box_value(rng);
+  std::vector<float> raw_scores(kNumBoxes);
+  for (float& value : raw_scores) value = score_value(rng);
+  Packet tensors =
+      Adopt(MakeTensors(kNumBoxes, raw_boxes, raw_scores).release());
+
+  CalculatorGraph graph;
+  CHECK(graph.Initialize(config).ok());
+  CHECK(graph
+            .ObserveOutputStream("detections",
+                                 [](const Packet&) { return absl::OkStatus(); })
+            .ok());
+  CHECK(graph
+            .StartRun({{"anchors", MakePacket<std::vector<Anchor>>(
+                                       std::move(anchors))}})
+            .ok());
+  int64 timestamp = 0;
+  for (auto _ : state) {
+    CHECK(graph.AddPacketToInputStream("tensors",
+                                       tensors.At(Timestamp(timestamp++)))
+              .ok());
+    CHECK(graph.WaitUntilIdle().ok());
+  }
+  CHECK(graph.CloseAllInputStreams().ok());
+  CHECK(graph.WaitUntilDone().ok());
+}
+BENCHMARK(BM_DecodeFaceDetectionFullRange)->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
@@ -12,16 +12,27 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <deque>
 #include <memory>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 #include <utility>
+#include <vector>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/memory/memory.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/calculators/tensorflow/tfrecord_reader_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mediapipe/framework/tool/status_util.h"
 #include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/platform/env.h"
@@ -33,12 +44,15 @@ const char kTFRecordPath[] = "TFRECORD_PATH";
 const char kRecordIndex[] = "RECORD_INDEX";
 const char kExampleTag[] = "EXAMPLE";
 const char kSequenceExampleTag[] = "SEQUENCE_EXAMPLE";
+const char kRecordTag[] = "RECORD";
 
 // Reads a tensorflow example/sequence example from a tfrecord file.
 // If the "RECORD_INDEX" input side packet is provided, the calculator is going
 // to fetch the example/sequence example of the tfrecord file at the target
 // record index. Otherwise, the reader always reads the first example/sequence
-// example of the tfrecord file.
+// example of the tfrecord file. With the "RECORD" tag, the record is output as
+// a serialized string, to be parsed by the calculator that consumes it, e.g.
+// the UnpackMediaSequenceCalculator.
 //
 // Example config:
 // node {
@@ -47,35 +61,175 @@ const char kSequenceExampleTag[] = "SEQUENCE_EXAMPLE";
 //   input_side_packet: "RECORD_INDEX:record_index"
 //   output_side_packet: "SEQUENCE_EXAMPLE:sequence_example"
 // }
+//
+// If the output is a stream rather than a side packet, the calculator instead
+// streams all the records of all the tfrecord files that match the
+// TFRECORD_PATH pattern, e.g. "/data/train-*.tfrecord", in the order of the
+// file names. The timestamp of each packet is the index of its record. A
+// background thread reads and parses up to prefetch_records records ahead of
+// the graph.
+//
+// Example config:
+// node {
+//   calculator: "TFRecordReaderCalculator"
+//   input_side_packet: "TFRECORD_PATH:tfrecord_pattern"
+//   output_stream: "RECORD:serialized_sequence_examples"
+//   node_options: {
+//     [type.googleapis.com/mediapipe.TFRecordReaderCalculatorOptions] {
+//       prefetch_records: 64
+//     }
+//   }
+// }
 class TFRecordReaderCalculator : public CalculatorBase {
  public:
   static absl::Status GetContract(CalculatorContract* cc);
 
+  ~TFRecordReaderCalculator() override;
+
   absl::Status Open(CalculatorContext* cc) override;
   absl::Status Process(CalculatorContext* cc) override;
+  absl::Status Close(CalculatorContext* cc) override;
+
+ private:
+  // Reads the record at the RECORD_INDEX into the output side packet.
+  absl::Status ReadRecordAtIndex(CalculatorContext* cc);
+
+  // Runs on read_thread_, queueing the records of all the files.
+  void ReadRecords(const std::vector<std::string>& paths,
+                   const TFRecordReaderCalculatorOptions& options);
+  // Queues the records of one file. Returns early if the reading is stopped.
+  absl::Status ReadRecordsFromFile(
+      const std::string& path, const TFRecordReaderCalculatorOptions& options);
+  // Returns the packet of the output_tag_ type for the record.
+  absl::StatusOr<Packet> MakeRecordPacket(const tensorflow::tstring& record);
+  void StopReadThread();
+
+  bool CanPrefetchOrIsStopped() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return stop_reading_ ||
+           prefetched_records_.size() < static_cast<size_t>(prefetch_records_);
+  }
+  bool HasRecordOrIsDone() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return !prefetched_records_.empty() || reading_done_;
+  }
+
+  // The tag of the output stream, if the records are streamed.
+  std::string output_tag_;
+  int prefetch_records_ = 0;
+  int64 num_records_ = 0;
+
+  std::thread read_thread_;
+  absl::Mutex mutex_;
+  std::deque<Packet> prefetched_records_ ABSL_GUARDED_BY(mutex_);
+  absl::Status read_status_ ABSL_GUARDED_BY(mutex_);
+  bool reading_done_ ABSL_GUARDED_BY(mutex_) = false;
+  bool stop_reading_ ABSL_GUARDED_BY(mutex_) = false;
 };
 
 absl::Status TFRecordReaderCalculator::GetContract(CalculatorContract* cc) {
   cc->InputSidePackets().Tag(kTFRecordPath).Set<std::string>();
+
+  if (cc->Outputs().NumEntries() > 0) {
+    RET_CHECK_EQ(cc->Outputs().NumEntries(), 1)
+        << "TFRecordReaderCalculator streams either Tensorflow examples, "
+           "sequence examples or records.";
+    RET_CHECK_EQ(cc->OutputSidePackets().NumEntries(), 0)
+        << "TFRecordReaderCalculator outputs either streams or side packets.";
+    RET_CHECK(!cc->InputSidePackets().HasTag(kRecordIndex))
+        << "RECORD_INDEX is only supported with output side packets.";
+    if (cc->Outputs().HasTag(kExampleTag)) {
+      cc->Outputs().Tag(kExampleTag).Set<tensorflow::Example>();
+    } else if (cc->Outputs().HasTag(kSequenceExampleTag)) {
+      cc->Outputs()
+          .Tag(kSequenceExampleTag)
+          .Set<tensorflow::SequenceExample>();
+    } else {
+      RET_CHECK(cc->Outputs().HasTag(kRecordTag))
+          << "TFRecordReaderCalculator must output either Tensorflow examples, "
+             "sequence examples or records.";
+      cc->Outputs().Tag(kRecordTag).Set<std::string>();
+    }
+    return absl::OkStatus();
+  }
+
   if (cc->InputSidePackets().HasTag(kRecordIndex)) {
     cc->InputSidePackets().Tag(kRecordIndex).Set<int>();
   }
 
   RET_CHECK(cc->OutputSidePackets().HasTag(kExampleTag) ||
-            cc->OutputSidePackets().HasTag(kSequenceExampleTag))
-      << "TFRecordReaderCalculator must output either Tensorflow example or "
-         "sequence example.";
+            cc->OutputSidePackets().HasTag(kSequenceExampleTag) ||
+            cc->OutputSidePackets().HasTag(kRecordTag))
+      << "TFRecordReaderCalculator must output either Tensorflow example, "
+         "sequence example or record.";
   if (cc->OutputSidePackets().HasTag(kExampleTag)) {
     cc->OutputSidePackets().Tag(kExampleTag).Set<tensorflow::Example>();
-  } else {
+  } else if (cc->OutputSidePackets().HasTag(kSequenceExampleTag)) {
     cc->OutputSidePackets()
         .Tag(kSequenceExampleTag)
         .Set<tensorflow::SequenceExample>();
+  } else {
+    cc->OutputSidePackets().Tag(kRecordTag).Set<std::string>();
   }
   return absl::OkStatus();
 }
 
+TFRecordReaderCalculator::~TFRecordReaderCalculator() { StopReadThread(); }
+
 absl::Status TFRecordReaderCalculator::Open(CalculatorContext* cc) {
+  if (cc->Outputs().NumEntries() == 0) {
+    return ReadRecordAtIndex(cc);
+  }
+
+  const std::string& pattern =
+      cc->InputSidePackets().Tag(kTFRecordPath).Get<std::string>();
+  std::vector<std::string> paths;
+  auto tf_status =
+      tensorflow::Env::Default()->GetMatchingPaths(pattern, &paths);
+  RET_CHECK(tf_status.ok())
+      << "Failed to match tfrecord files: " << tf_status.ToString();
+  RET_CHECK(!paths.empty()) << "No tfrecord files match " << pattern;
+  std::sort(paths.begin(), paths.end());
+
+  if (cc->Outputs().HasTag(kExampleTag)) {
+    output_tag_ = kExampleTag;
+  } else if (cc->Outputs().HasTag(kSequenceExampleTag)) {
+    output_tag_ = kSequenceExampleTag;
+  } else {
+    output_tag_ = kRecordTag;
+  }
+  const auto& options = cc->Options<TFRecordReaderCalculatorOptions>();
+  prefetch_records_ = std::max(1, options.prefetch_records());
+  read_thread_ =
+      std::thread([this, paths, options] { ReadRecords(paths, options); });
+  return absl::OkStatus();
+}
+
+absl::Status TFRecordReaderCalculator::Process(CalculatorContext* cc) {
+  if (output_tag_.empty()) {
+    return absl::OkStatus();
+  }
+  Packet packet;
+  {
+    absl::MutexLock lock(&mutex_);
+    mutex_.Await(
+        absl::Condition(this, &TFRecordReaderCalculator::HasRecordOrIsDone));
+    if (prefetched_records_.empty()) {
+      MP_RETURN_IF_ERROR(read_status_);
+      return tool::StatusStop();
+    }
+    packet = std::move(prefetched_records_.front());
+    prefetched_records_.pop_front();
+  }
+  cc->Outputs().Tag(output_tag_).AddPacket(std::move(packet));
+  return absl::OkStatus();
+}
+
+absl::Status TFRecordReaderCalculator::Close(CalculatorContext* cc) {
+  StopReadThread();
+  return absl::OkStatus();
+}
+
+absl::Status TFRecordReaderCalculator::ReadRecordAtIndex(
+    CalculatorContext* cc) {
   std::unique_ptr<tensorflow::RandomAccessFile> file;
   auto tf_status = tensorflow::Env::Default()->NewRandomAccessFile(
       cc->InputSidePackets().Tag(kTFRecordPath).Get<std::string>(), &file);
@@ -101,13 +255,17 @@ absl::Status TFRecordReaderCalculator::Open(CalculatorContext* cc) {
         cc->OutputSidePackets()
             .Tag(kExampleTag)
             .Set(MakePacket<tensorflow::Example>(std::move(tf_example)));
-      } else {
+      } else if (cc->OutputSidePackets().HasTag(kSequenceExampleTag)) {
         tensorflow::SequenceExample tf_sequence_example;
         tf_sequence_example.ParseFromString(example_str);
         cc->OutputSidePackets()
             .Tag(kSequenceExampleTag)
             .Set(MakePacket<tensorflow::SequenceExample>(
                 std::move(tf_sequence_example)));
+      } else {
+        cc->OutputSidePackets()
+            .Tag(kRecordTag)
+            .Set(MakePacket<std::string>(std::string(example_str)));
       }
     }
     ++current_idx;
@@ -116,8 +274,77 @@ absl::Status TFRecordReaderCalculator::Open(CalculatorContext* cc) {
   return absl::OkStatus();
 }
 
-absl::Status TFRecordReaderCalculator::Process(CalculatorContext* cc) {
-  return absl::OkStatus();
+void TFRecordReaderCalculator::ReadRecords(
+    const std::vector<std::string>& paths,
+    const TFRecordReaderCalculatorOptions& options) {
+  absl::Status status;
+  for (const std::string& path : paths) {
+    status = ReadRecordsFromFile(path, options);
+    if (!status.ok()) {
+      break;
+    }
+  }
+  absl::MutexLock lock(&mutex_);
+  read_status_ = status;
+  reading_done_ = true;
+}
+
+absl::Status TFRecordReaderCalculator::ReadRecordsFromFile(
+    const std::string& path, const TFRecordReaderCalculatorOptions& options) {
+  std::unique_ptr<tensorflow::RandomAccessFile> file;
+  auto tf_status = tensorflow::Env::Default()->NewRandomAccessFile(path, &file);
+  RET_CHECK(tf_status.ok())
+      << "Failed to open tfrecord file: " << tf_status.ToString();
+  tensorflow::io::RecordReaderOptions reader_options;
+  reader_options.buffer_size = options.read_buffer_size();
+  tensorflow::io::SequentialRecordReader reader(file.get(), reader_options);
+  while (true) {
+    tensorflow::tstring record;
+    tf_status = reader.ReadRecord(&record);
+    if (tensorflow::errors::IsOutOfRange(tf_status)) {
+      return absl::OkStatus();
+    }
+    RET_CHECK(tf_status.ok()) << "Failed to read tfrecord " << path << ": "
+                              << tf_status.ToString();
+    ASSIGN_OR_RETURN(Packet packet, MakeRecordPacket(record));
+
+    absl::MutexLock lock(&mutex_);
+    mutex_.Await(absl::Condition(
+        this, &TFRecordReaderCalculator::CanPrefetchOrIsStopped));
+    if (stop_reading_) {
+      return absl::OkStatus();
+    }
+    prefetched_records_.push_back(
+        std::move(packet).At(Timestamp(num_records_++)));
+  }
+}
+
+absl::StatusOr<Packet> TFRecordReaderCalculator::MakeRecordPacket(
+    const tensorflow::tstring& record) {
+  if (output_tag_ == kExampleTag) {
+    auto tf_example = absl::make_unique<tensorflow::Example>();
+    RET_CHECK(tf_example->ParseFromArray(record.data(), record.size()))
+        << "Failed to parse Tensorflow example.";
+    return Adopt(tf_example.release());
+  } else if (output_tag_ == kSequenceExampleTag) {
+    auto tf_sequence_example = absl::make_unique<tensorflow::SequenceExample>();
+    RET_CHECK(
+        tf_sequence_example->ParseFromArray(record.data(), record.size()))
+        << "Failed to parse Tensorflow sequence example.";
+    return Adopt(tf_sequence_example.release());
+  }
+  return MakePacket<std::string>(record.data(), record.size());
+}
+
+void TFRecordReaderCalculator::StopReadThread() {
+  if (!read_thread_.joinable()) {
+    return;
+  }
+  {
+    absl::MutexLock lock(&mutex_);
+    stop_reading_ = true;
+  }
+  read_thread_.join();
 }
 
 REGISTER_CALCULATOR(TFRecordReaderCalculator);
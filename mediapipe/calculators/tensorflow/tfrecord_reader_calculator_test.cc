@@ -0,0 +1,153 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mediapipe/calculators/tensorflow/tfrecord_reader_calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/deps/file_path.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+
+namespace mediapipe {
+namespace {
+
+namespace tf = ::tensorflow;
+
+constexpr char kTFRecordPathTag[] = "TFRECORD_PATH";
+constexpr char kRecordIndexTag[] = "RECORD_INDEX";
+constexpr char kSequenceExampleTag[] = "SEQUENCE_EXAMPLE";
+constexpr char kRecordTag[] = "RECORD";
+
+tf::SequenceExample MakeSequenceExample(int id) {
+  tf::SequenceExample sequence_example;
+  (*sequence_example.mutable_context()->mutable_feature())["id"]
+      .mutable_int64_list()
+      ->add_value(id);
+  return sequence_example;
+}
+
+// Writes the sequence examples with ids [first_id, first_id + num_records).
+void WriteTFRecord(const std::string& path, int first_id, int num_records) {
+  std::unique_ptr<tf::WritableFile> file;
+  ASSERT_TRUE(tf::Env::Default()->NewWritableFile(path, &file).ok());
+  tf::io::RecordWriter writer(file.get());
+  for (int id = first_id; id < first_id + num_records; ++id) {
+    ASSERT_TRUE(
+        writer.WriteRecord(MakeSequenceExample(id).SerializeAsString()).ok());
+  }
+  ASSERT_TRUE(writer.Close().ok());
+  ASSERT_TRUE(file->Close().ok());
+}
+
+int64 GetId(const tf::SequenceExample& sequence_example) {
+  return sequence_example.context().feature().at("id").int64_list().value(0);
+}
+
+class TFRecordReaderCalculatorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    dir_ = file::JoinPath(getenv("TEST_TMPDIR"),
+                          ::testing::UnitTest::GetInstance()
+                              ->current_test_info()
+                              ->name());
+    ASSERT_TRUE(tf::Env::Default()->RecursivelyCreateDir(dir_).ok());
+    WriteTFRecord(file::JoinPath(dir_, "shard-00000.tfrecord"), 0, 5);
+    WriteTFRecord(file::JoinPath(dir_, "shard-00001.tfrecord"), 5, 7);
+  }
+
+  std::string dir_;
+};
+
+TEST_F(TFRecordReaderCalculatorTest, ReadsRecordAtIndex) {
+  CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"pb(
+    calculator: "TFRecordReaderCalculator"
+    input_side_packet: "TFRECORD_PATH:path"
+    input_side_packet: "RECORD_INDEX:index"
+    output_side_packet: "SEQUENCE_EXAMPLE:sequence_example"
+  )pb"));
+  runner.MutableSidePackets()->Tag(kTFRecordPathTag) =
+      MakePacket<std::string>(file::JoinPath(dir_, "shard-00001.tfrecord"));
+  runner.MutableSidePackets()->Tag(kRecordIndexTag) = MakePacket<int>(3);
+  MP_ASSERT_OK(runner.Run());
+  EXPECT_EQ(8, GetId(runner.OutputSidePackets()
+                         .Tag(kSequenceExampleTag)
+                         .Get<tf::SequenceExample>()));
+}
+
+TEST_F(TFRecordReaderCalculatorTest, StreamsSequenceExamplesOfAllShards) {
+  auto node = ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"pb(
+    calculator: "TFRecordReaderCalculator"
+    input_side_packet: "TFRECORD_PATH:path"
+    output_stream: "SEQUENCE_EXAMPLE:sequence_examples"
+  )pb");
+  // Fewer prefetched records than records, so that the reading waits for the
+  // graph.
+  node.mutable_options()
+      ->MutableExtension(TFRecordReaderCalculatorOptions::ext)
+      ->set_prefetch_records(2);
+  CalculatorRunner runner(node);
+  runner.MutableSidePackets()->Tag(kTFRecordPathTag) =
+      MakePacket<std::string>(file::JoinPath(dir_, "shard-*.tfrecord"));
+  MP_ASSERT_OK(runner.Run());
+
+  const std::vector<Packet>& packets =
+      runner.Outputs().Tag(kSequenceExampleTag).packets;
+  ASSERT_EQ(12, packets.size());
+  for (int i = 0; i < packets.size(); ++i) {
+    EXPECT_EQ(Timestamp(i), packets[i].Timestamp());
+    EXPECT_EQ(i, GetId(packets[i].Get<tf::SequenceExample>()));
+  }
+}
+
+TEST_F(TFRecordReaderCalculatorTest, StreamsSerializedRecords) {
+  CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"pb(
+    calculator: "TFRecordReaderCalculator"
+    input_side_packet: "TFRECORD_PATH:path"
+    output_stream: "RECORD:records"
+  )pb"));
+  runner.MutableSidePackets()->Tag(kTFRecordPathTag) =
+      MakePacket<std::string>(file::JoinPath(dir_, "shard-00000.tfrecord"));
+  MP_ASSERT_OK(runner.Run());
+
+  const std::vector<Packet>& packets = runner.Outputs().Tag(kRecordTag).packets;
+  ASSERT_EQ(5, packets.size());
+  for (int i = 0; i < packets.size(); ++i) {
+    EXPECT_EQ(MakeSequenceExample(i).SerializeAsString(),
+              packets[i].Get<std::string>());
+  }
+}
+
+TEST_F(TFRecordReaderCalculatorTest, FailsIfNoFileMatches) {
+  CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"pb(
+    calculator: "TFRecordReaderCalculator"
+    input_side_packet: "TFRECORD_PATH:path"
+    output_stream: "RECORD:records"
+  )pb"));
+  runner.MutableSidePackets()->Tag(kTFRecordPathTag) =
+      MakePacket<std::string>(file::JoinPath(dir_, "missing-*.tfrecord"));
+  EXPECT_FALSE(runner.Run().ok());
+}
+
+}  // namespace
+}  // namespace mediapipe
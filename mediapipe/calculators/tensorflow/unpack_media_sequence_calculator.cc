@@ -13,11 +13,14 @@
 // limitations under the License.
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/memory/memory.h"
 #include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "mediapipe/calculators/core/packet_resampler_calculator.pb.h"
 #include "mediapipe/calculators/tensorflow/unpack_media_sequence_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/location.h"
+#include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/util/audio_decoder.pb.h"
 #include "mediapipe/util/sequence/media_sequence.h"
@@ -97,10 +100,11 @@ namespace mpms = mediapipe::mediasequence;
 //   }
 // }
 //
-// The calculator also takes a tf.SequenceExample as a side input and outputs
-// the data in streams from the SequenceExample at the proper timestamps. The
-// SequenceExample must conform to the description in media_sequence.h.
-// Timestamps in the SequenceExample must be in sequential order.
+// The calculator also takes a tf.SequenceExample, or its serialization as a
+// string, as a side input and outputs the data in streams from the
+// SequenceExample at the proper timestamps. The SequenceExample must conform
+// to the description in media_sequence.h. Timestamps in the SequenceExample
+// must be in sequential order.
 //
 // The following output stream tags are supported:
 //   IMAGE: encoded images as strings. (IMAGE_${NAME} is supported.)
@@ -121,7 +125,9 @@ class UnpackMediaSequenceCalculator : public CalculatorBase {
   static absl::Status GetContract(CalculatorContract* cc) {
     const auto& options = cc->Options<UnpackMediaSequenceCalculatorOptions>();
     RET_CHECK(cc->InputSidePackets().HasTag(kSequenceExampleTag));
-    cc->InputSidePackets().Tag(kSequenceExampleTag).Set<tf::SequenceExample>();
+    cc->InputSidePackets()
+        .Tag(kSequenceExampleTag)
+        .SetOneOf<tf::SequenceExample, std::string>();
     // Optional side inputs.
     if (cc->InputSidePackets().HasTag(kDatasetRootDirTag)) {
       cc->InputSidePackets().Tag(kDatasetRootDirTag).Set<std::string>();
@@ -189,6 +195,15 @@ class UnpackMediaSequenceCalculator : public CalculatorBase {
   absl::Status Open(CalculatorContext* cc) override {
     // Copy the packet to copy the otherwise inaccessible shared ptr.
     example_packet_holder_ = cc->InputSidePackets().Tag(kSequenceExampleTag);
+    if (example_packet_holder_.ValidateAsType<std::string>().ok()) {
+      // Serialized records, e.g. from the TFRecordReaderCalculator, are only
+      // parsed by the graph that unpacks them.
+      auto sequence = absl::make_unique<tf::SequenceExample>();
+      RET_CHECK(sequence->ParseFromString(
+          example_packet_holder_.Get<std::string>()))
+          << "Failed to parse the serialized SequenceExample.";
+      example_packet_holder_ = Adopt(sequence.release());
+    }
     sequence_ = &example_packet_holder_.Get<tf::SequenceExample>();
 
     // Collect the timestamps for all streams keyed by the timestamp feature's
@@ -203,9 +218,8 @@ class UnpackMediaSequenceCalculator : public CalculatorBase {
         LOG(INFO) << "Found feature timestamps: " << map_kv.first
                   << " with size: " << map_kv.second.feature_size();
         int64 recent_timestamp = Timestamp::PreStream().Value();
-        for (int i = 0; i < map_kv.second.feature_size(); ++i) {
-          int64 next_timestamp =
-              mpms::GetInt64sAt(*sequence_, map_kv.first, i).Get(0);
+        for (const tf::Feature& feature : map_kv.second.feature()) {
+          int64 next_timestamp = feature.int64_list().value(0);
           RET_CHECK_GT(next_timestamp, recent_timestamp)
               << "Timestamps must be sequential. If you're seeing this message "
               << "you may have added images to the same SequenceExample twice. "
@@ -245,12 +259,11 @@ class UnpackMediaSequenceCalculator : public CalculatorBase {
     }
     current_timestamp_index_ = 0;
     process_poststream_ = false;
+    MP_RETURN_IF_ERROR(InitializeStreams(cc));
 
     // Determine the data path and output it.
     const auto& options = cc->Options<UnpackMediaSequenceCalculatorOptions>();
-    const auto& sequence = cc->InputSidePackets()
-                               .Tag(kSequenceExampleTag)
-                               .Get<tensorflow::SequenceExample>();
+    const auto& sequence = *sequence_;
     if (cc->OutputSidePackets().HasTag(kDataPath)) {
       std::string root_directory = "";
       if (cc->InputSidePackets().HasTag(kDatasetRootDirTag)) {
@@ -375,75 +388,21 @@ class UnpackMediaSequenceCalculator : public CalculatorBase {
       }
     }
 
-    for (const auto& map_kv : timestamps_) {
-      for (int i = 0; i < map_kv.second.size(); ++i) {
-        if (map_kv.second[i] >= start_timestamp &&
-            map_kv.second[i] < end_timestamp) {
-          const Timestamp current_timestamp =
-              map_kv.second[i] == Timestamp::PostStream().Value()
-                  ? Timestamp::PostStream()
-                  : Timestamp(map_kv.second[i]);
-
-          if (absl::StrContains(map_kv.first, mpms::GetImageTimestampKey())) {
-            std::vector<std::string> pieces = absl::StrSplit(map_kv.first, '/');
-            std::string feature_key = "";
-            std::string possible_tag = kImageTag;
-            if (pieces[0] != "image") {
-              feature_key = pieces[0];
-              possible_tag = absl::StrCat(kImageTag, "_", feature_key);
-            }
-            if (cc->Outputs().HasTag(possible_tag)) {
-              cc->Outputs()
-                  .Tag(possible_tag)
-                  .Add(new std::string(
-                           mpms::GetImageEncodedAt(feature_key, *sequence_, i)),
-                       current_timestamp);
-            }
-          }
-
-          if (cc->Outputs().HasTag(kForwardFlowImageTag) &&
-              map_kv.first == mpms::GetForwardFlowTimestampKey()) {
-            cc->Outputs()
-                .Tag(kForwardFlowImageTag)
-                .Add(new std::string(
-                         mpms::GetForwardFlowEncodedAt(*sequence_, i)),
-                     current_timestamp);
-          }
-          if (absl::StrContains(map_kv.first, mpms::GetBBoxTimestampKey())) {
-            std::vector<std::string> pieces = absl::StrSplit(map_kv.first, '/');
-            std::string feature_key = "";
-            std::string possible_tag = kBBoxTag;
-            if (pieces[0] != "region") {
-              feature_key = pieces[0];
-              possible_tag = absl::StrCat(kBBoxTag, "_", feature_key);
-            }
-            if (cc->Outputs().HasTag(possible_tag)) {
-              const auto& bboxes = mpms::GetBBoxAt(feature_key, *sequence_, i);
-              cc->Outputs()
-                  .Tag(possible_tag)
-                  .Add(new std::vector<Location>(bboxes.begin(), bboxes.end()),
-                       current_timestamp);
-            }
-          }
-
-          if (absl::StrContains(map_kv.first, "feature")) {
-            std::vector<std::string> pieces = absl::StrSplit(map_kv.first, '/');
-            RET_CHECK_GT(pieces.size(), 1)
-                << "Failed to parse the feature substring before / from key "
-                << map_kv.first;
-            std::string feature_key = pieces[0];
-            std::string possible_tag = kFloatFeaturePrefixTag + feature_key;
-            if (cc->Outputs().HasTag(possible_tag)) {
-              const auto& float_list =
-                  mpms::GetFeatureFloatsAt(feature_key, *sequence_, i);
-              cc->Outputs()
-                  .Tag(possible_tag)
-                  .Add(new std::vector<float>(float_list.begin(),
-                                              float_list.end()),
-                       current_timestamp);
-            }
-          }
+    // Each stream emits its values from where the previous call stopped, as the
+    // windows are visited in order.
+    for (UnpackedStream& stream : streams_) {
+      const std::vector<int64>& timestamps = *stream.timestamps;
+      for (; stream.next_index < timestamps.size() &&
+             timestamps[stream.next_index] < end_timestamp;
+           ++stream.next_index) {
+        if (timestamps[stream.next_index] < start_timestamp) {
+          continue;
         }
+        const Timestamp current_timestamp =
+            timestamps[stream.next_index] == Timestamp::PostStream().Value()
+                ? Timestamp::PostStream()
+                : Timestamp(timestamps[stream.next_index]);
+        AddPacket(cc, stream, current_timestamp);
       }
     }
 
@@ -462,6 +421,127 @@ class UnpackMediaSequenceCalculator : public CalculatorBase {
     }
   }
 
+  // The kinds of data that are unpacked into output streams.
+  enum class StreamKind { kEncoded, kBBox, kFloats };
+
+  // An output stream together with the data it is unpacked from.
+  struct UnpackedStream {
+    StreamKind kind;
+    CollectionItemId id;
+    // The timestamps of the feature list, owned by timestamps_.
+    const std::vector<int64>* timestamps;
+    // The prefix of the feature keys, used to unpack bounding boxes.
+    std::string prefix;
+    // The encoded images, owned by the SequenceExample.
+    const tf::FeatureList* encoded = nullptr;
+    // The float features of all timesteps.
+    mpms::FeatureListValues<float> floats;
+    // The index of the next timestamp to output.
+    int next_index = 0;
+  };
+
+  // Determines which feature lists feed the connected output streams, so that
+  // Process() does not need to parse or look up feature keys.
+  absl::Status InitializeStreams(CalculatorContext* cc) {
+    streams_.clear();
+    const auto& feature_lists = sequence_->feature_lists().feature_list();
+    for (const auto& map_kv : timestamps_) {
+      const std::string& key = map_kv.first;
+      const std::string first_piece = key.substr(0, key.find('/'));
+      if (absl::StrContains(key, mpms::GetImageTimestampKey())) {
+        const std::string prefix = first_piece == "image" ? "" : first_piece;
+        const std::string tag =
+            prefix.empty() ? kImageTag : absl::StrCat(kImageTag, "_", prefix);
+        if (cc->Outputs().HasTag(tag)) {
+          UnpackedStream stream = MakeStream(cc, StreamKind::kEncoded, tag,
+                                             map_kv.second, prefix);
+          const auto it =
+              feature_lists.find(mpms::GetImageEncodedKey(prefix));
+          RET_CHECK(it != feature_lists.end())
+              << "Missing encoded images for " << key;
+          RET_CHECK_GE(it->second.feature_size(), map_kv.second.size())
+              << "Fewer encoded images than timestamps for " << key;
+          stream.encoded = &it->second;
+          streams_.push_back(std::move(stream));
+        }
+      }
+      if (cc->Outputs().HasTag(kForwardFlowImageTag) &&
+          key == mpms::GetForwardFlowTimestampKey()) {
+        UnpackedStream stream = MakeStream(cc, StreamKind::kEncoded,
+                                           kForwardFlowImageTag, map_kv.second,
+                                           mpms::kForwardFlowPrefix);
+        const auto it = feature_lists.find(mpms::GetForwardFlowEncodedKey());
+        RET_CHECK(it != feature_lists.end())
+            << "Missing encoded images for " << key;
+        RET_CHECK_GE(it->second.feature_size(), map_kv.second.size())
+            << "Fewer encoded images than timestamps for " << key;
+        stream.encoded = &it->second;
+        streams_.push_back(std::move(stream));
+      }
+      if (absl::StrContains(key, mpms::GetBBoxTimestampKey())) {
+        const std::string prefix = first_piece == "region" ? "" : first_piece;
+        const std::string tag =
+            prefix.empty() ? kBBoxTag : absl::StrCat(kBBoxTag, "_", prefix);
+        if (cc->Outputs().HasTag(tag)) {
+          streams_.push_back(
+              MakeStream(cc, StreamKind::kBBox, tag, map_kv.second, prefix));
+        }
+      }
+      if (absl::StrContains(key, "feature")) {
+        RET_CHECK(absl::StrContains(key, "/"))
+            << "Failed to parse the feature substring before / from key "
+            << key;
+        const std::string tag = kFloatFeaturePrefixTag + first_piece;
+        if (cc->Outputs().HasTag(tag)) {
+          UnpackedStream stream = MakeStream(cc, StreamKind::kFloats, tag,
+                                             map_kv.second, first_piece);
+          stream.floats = mpms::GetAllFeatureFloats(first_piece, *sequence_);
+          RET_CHECK_GE(stream.floats.size(), map_kv.second.size())
+              << "Fewer float features than timestamps for " << key;
+          streams_.push_back(std::move(stream));
+        }
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  UnpackedStream MakeStream(CalculatorContext* cc, StreamKind kind,
+                            const std::string& tag,
+                            const std::vector<int64>& timestamps,
+                            const std::string& prefix) {
+    UnpackedStream stream;
+    stream.kind = kind;
+    stream.id = cc->Outputs().GetId(tag, 0);
+    stream.timestamps = &timestamps;
+    stream.prefix = prefix;
+    return stream;
+  }
+
+  // Outputs the values of the stream at stream.next_index.
+  void AddPacket(CalculatorContext* cc, const UnpackedStream& stream,
+                 Timestamp timestamp) {
+    const int index = stream.next_index;
+    OutputStream& output = cc->Outputs().Get(stream.id);
+    switch (stream.kind) {
+      case StreamKind::kEncoded:
+        output.Add(new std::string(
+                       stream.encoded->feature(index).bytes_list().value(0)),
+                   timestamp);
+        break;
+      case StreamKind::kBBox: {
+        const auto& bboxes = mpms::GetBBoxAt(stream.prefix, *sequence_, index);
+        output.Add(new std::vector<Location>(bboxes.begin(), bboxes.end()),
+                   timestamp);
+        break;
+      }
+      case StreamKind::kFloats:
+        output.Add(new std::vector<float>(stream.floats.begin(index),
+                                          stream.floats.end(index)),
+                   timestamp);
+        break;
+    }
+  }
+
   // Hold a copy of the packet to prevent the shared_ptr from dying and then
   // access the SequenceExample with a handy pointer.
   const tf::SequenceExample* sequence_;
@@ -483,6 +563,8 @@ class UnpackMediaSequenceCalculator : public CalculatorBase {
   // Default keypoint location when missing.
   float default_keypoint_location_;
   bool process_poststream_;
+  // The output streams to unpack in Process().
+  std::vector<UnpackedStream> streams_;
 };
 REGISTER_CALCULATOR(UnpackMediaSequenceCalculator);
 }  // namespace mediapipe
@@ -14,11 +14,13 @@
 
 #include "absl/memory/memory.h"
 #include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
 #include "mediapipe/calculators/core/packet_resampler_calculator.pb.h"
 #include "mediapipe/calculators/tensorflow/unpack_media_sequence_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_runner.h"
 #include "mediapipe/framework/formats/location.h"
+#include "mediapipe/framework/port/benchmark.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
 #include "mediapipe/framework/port/rectangle.h"
@@ -137,6 +139,30 @@ TEST_F(UnpackMediaSequenceCalculatorTest, UnpacksOneImage) {
   }
 }
 
+TEST_F(UnpackMediaSequenceCalculatorTest, UnpacksSerializedSequenceExample) {
+  SetUpCalculator({"IMAGE:images"}, {});
+  tf::SequenceExample input_sequence;
+  std::string test_image_string = "test_image_string";
+  int num_images = 2;
+  for (int i = 0; i < num_images; ++i) {
+    mpms::AddImageTimestamp(i, &input_sequence);
+    mpms::AddImageEncoded(test_image_string, &input_sequence);
+  }
+
+  runner_->MutableSidePackets()->Tag(kSequenceExampleTag) =
+      MakePacket<std::string>(input_sequence.SerializeAsString());
+
+  MP_ASSERT_OK(runner_->Run());
+
+  const std::vector<Packet>& output_packets =
+      runner_->Outputs().Tag(kImageTag).packets;
+  ASSERT_EQ(num_images, output_packets.size());
+  for (int i = 0; i < num_images; ++i) {
+    EXPECT_EQ(Timestamp(i), output_packets[i].Timestamp());
+    EXPECT_EQ(test_image_string, output_packets[i].Get<std::string>());
+  }
+}
+
 TEST_F(UnpackMediaSequenceCalculatorTest, UnpacksTwoImages) {
   SetUpCalculator({"IMAGE:images"}, {});
   auto input_sequence = absl::make_unique<tf::SequenceExample>();
@@ -360,6 +386,20 @@ TEST_F(UnpackMediaSequenceCalculatorTest, UnpacksTwoFloatLists) {
   }
 }
 
+TEST_F(UnpackMediaSequenceCalculatorTest, FailsOnMissingFloatLists) {
+  SetUpCalculator({"FLOAT_FEATURE_TEST:test"}, {});
+  auto input_sequence = absl::make_unique<tf::SequenceExample>();
+  mpms::AddFeatureFloats("TEST", std::vector<float>(2, 1.0),
+                         input_sequence.get());
+  mpms::AddFeatureTimestamp("TEST", 0, input_sequence.get());
+  mpms::AddFeatureTimestamp("TEST", 1, input_sequence.get());
+
+  runner_->MutableSidePackets()->Tag(kSequenceExampleTag) =
+      Adopt(input_sequence.release());
+
+  EXPECT_FALSE(runner_->Run().ok());
+}
+
 TEST_F(UnpackMediaSequenceCalculatorTest, UnpacksNonOverlappingTimestamps) {
   SetUpCalculator({"IMAGE:images", "FLOAT_FEATURE_OTHER:other"}, {});
   auto input_sequence = absl::make_unique<tf::SequenceExample>();
@@ -660,5 +700,36 @@ TEST_F(UnpackMediaSequenceCalculatorTest, GetFrameRateFromExample) {
             image_frame_rate_);
 }
 
+// Unpacks range(0) timesteps of range(1) float features with 128 values each.
+void BM_UnpackFloatFeatures(benchmark::State& state) {
+  const int num_timesteps = state.range(0);
+  const int num_features = state.range(1);
+  CalculatorGraphConfig::Node config;
+  config.set_calculator("UnpackMediaSequenceCalculator");
+  config.add_input_side_packet("SEQUENCE_EXAMPLE:input_sequence");
+  tf::SequenceExample sequence;
+  for (int f = 0; f < num_features; ++f) {
+    const std::string prefix = absl::StrCat("FEATURE", f);
+    config.add_output_stream(
+        absl::StrCat("FLOAT_FEATURE_", prefix, ":feature", f));
+    for (int i = 0; i < num_timesteps; ++i) {
+      mpms::AddFeatureFloats(prefix, std::vector<float>(128, i), &sequence);
+      mpms::AddFeatureTimestamp(prefix, i, &sequence);
+    }
+  }
+  const Packet sequence_packet = MakePacket<tf::SequenceExample>(sequence);
+  for (auto _ : state) {
+    CalculatorRunner runner(config);
+    runner.MutableSidePackets()->Tag(kSequenceExampleTag) = sequence_packet;
+    CHECK(runner.Run().ok());
+  }
+  state.SetItemsProcessed(state.iterations() * num_timesteps * num_features);
+}
+BENCHMARK(BM_UnpackFloatFeatures)
+    ->Args({100, 1})
+    ->Args({1000, 1})
+    ->Args({1000, 8})
+    ->Args({5000, 8});
+
 }  // namespace
 }  // namespace mediapipe
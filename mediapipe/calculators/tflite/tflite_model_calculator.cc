@@ -19,6 +19,7 @@
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/packet.h"
 #include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/util/tflite/tflite_model_loader.h"
 #include "tensorflow/lite/model.h"
 
 namespace mediapipe {
@@ -26,12 +27,16 @@ namespace mediapipe {
 // Loads TfLite model from model blob specified as input side packet and outputs
 // corresponding side packet.
 //
-// Input side packets:
+// Input side packets (exactly one of):
 //   MODEL_BLOB - TfLite model blob/file-contents (std::string). You can read
 //                model blob from file (using whatever APIs you have) and pass
 //                it to the graph as input side packet or you can use some of
 //                calculators like LocalFileContentsCalculator to get model
 //                blob and use it as input here.
+//   MODEL_PATH - Path to the TfLite model resource (std::string). The model
+//                is loaded with TfLiteModelLoader, which maps the file rather
+//                than copying it, and shares it with every other user of the
+//                same path in the process.
 //
 // Output side packets:
 //   MODEL - TfLite model. (std::unique_ptr<tflite::FlatBufferModel,
@@ -52,12 +57,28 @@ class TfLiteModelCalculator : public CalculatorBase {
                       std::function<void(tflite::FlatBufferModel*)>>;
 
   static absl::Status GetContract(CalculatorContract* cc) {
-    cc->InputSidePackets().Tag("MODEL_BLOB").Set<std::string>();
+    RET_CHECK(cc->InputSidePackets().HasTag("MODEL_BLOB") ^
+              cc->InputSidePackets().HasTag("MODEL_PATH"))
+        << "Exactly one of MODEL_BLOB and MODEL_PATH must be specified.";
+    if (cc->InputSidePackets().HasTag("MODEL_BLOB")) {
+      cc->InputSidePackets().Tag("MODEL_BLOB").Set<std::string>();
+    } else {
+      cc->InputSidePackets().Tag("MODEL_PATH").Set<std::string>();
+    }
     cc->OutputSidePackets().Tag("MODEL").Set<TfLiteModelPtr>();
     return absl::OkStatus();
   }
 
   absl::Status Open(CalculatorContext* cc) override {
+    if (cc->InputSidePackets().HasTag("MODEL_PATH")) {
+      ASSIGN_OR_RETURN(
+          auto model,
+          TfLiteModelLoader::LoadFromPath(
+              cc->InputSidePackets().Tag("MODEL_PATH").Get<std::string>()));
+      cc->OutputSidePackets().Tag("MODEL").Set(std::move(model));
+      return absl::OkStatus();
+    }
+
     const Packet& model_packet = cc->InputSidePackets().Tag("MODEL_BLOB");
     const std::string& model_blob = model_packet.Get<std::string>();
     std::unique_ptr<tflite::FlatBufferModel> model =
@@ -85,4 +85,55 @@ TEST(TfLiteModelCalculatorTest, SmokeTest) {
   }
 }
 
+TEST(TfLiteModelCalculatorTest, SharesModelsLoadedFromPath) {
+  CalculatorGraphConfig graph_config = ParseTextProtoOrDie<
+      CalculatorGraphConfig>(
+      R"pb(
+        node {
+          calculator: "ConstantSidePacketCalculator"
+          output_side_packet: "PACKET:model_path"
+          options: {
+            [mediapipe.ConstantSidePacketCalculatorOptions.ext]: {
+              packet {
+                string_value: "mediapipe/calculators/tflite/testdata/add.bin"
+              }
+            }
+          }
+        }
+
+        node {
+          calculator: "TfLiteModelCalculator"
+          input_side_packet: "MODEL_PATH:model_path"
+          output_side_packet: "MODEL:model1"
+        }
+
+        node {
+          calculator: "TfLiteModelCalculator"
+          input_side_packet: "MODEL_PATH:model_path"
+          output_side_packet: "MODEL:model2"
+        }
+      )pb");
+  using TfLiteModelPtr =
+      std::unique_ptr<tflite::FlatBufferModel,
+                      std::function<void(tflite::FlatBufferModel*)>>;
+  CalculatorGraph graph(graph_config);
+  MP_ASSERT_OK(graph.StartRun({}));
+  MP_ASSERT_OK(graph.WaitUntilIdle());
+  auto status_or_packet1 = graph.GetOutputSidePacket("model1");
+  MP_ASSERT_OK(status_or_packet1);
+  auto status_or_packet2 = graph.GetOutputSidePacket("model2");
+  MP_ASSERT_OK(status_or_packet2);
+  const auto& model1 = status_or_packet1.value().Get<TfLiteModelPtr>();
+  const auto& model2 = status_or_packet2.value().Get<TfLiteModelPtr>();
+
+  auto expected_model = tflite::FlatBufferModel::BuildFromFile(
+      "mediapipe/calculators/tflite/testdata/add.bin");
+  EXPECT_EQ(model1->GetModel()->subgraphs()->size(),
+            expected_model->GetModel()->subgraphs()->size());
+  // Both calculators use the same mapping of the model file.
+  EXPECT_EQ(model1.get(), model2.get());
+  MP_ASSERT_OK(graph.CloseAllPacketSources());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+}
+
 }  // namespace mediapipe
@@ -22,6 +22,7 @@
 #include "mediapipe/framework/formats/detection.pb.h"
 #include "mediapipe/framework/formats/location_data.pb.h"
 #include "mediapipe/framework/formats/rect.pb.h"
+#include "mediapipe/framework/packet_arena.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status.h"
 
@@ -40,6 +41,22 @@ constexpr char kNormRectsTag[] = "NORM_RECTS";
 constexpr float kMinFloat = std::numeric_limits<float>::lowest();
 constexpr float kMaxFloat = std::numeric_limits<float>::max();
 
+// Creates the payload of an output packet at the input timestamp. The payload
+// is carved from the timestamp's packet arena if the graph provides arenas.
+template <typename T>
+T* CreateOutput(ServiceBinding<PacketArenaPool>& arenas, CalculatorContext* cc,
+                Packet* packet) {
+  if (arenas.IsAvailable()) {
+    auto arena = arenas.GetObject().ForTimestamp(cc->InputTimestamp());
+    T* output = arena->Create<T>();
+    *packet = arena->PacketFor(output).At(cc->InputTimestamp());
+    return output;
+  }
+  T* output = new T();
+  *packet = Adopt(output).At(cc->InputTimestamp());
+  return output;
+}
+
 absl::Status NormRectFromKeyPoints(const LocationData& location_data,
                                    NormalizedRect* rect) {
   RET_CHECK_GT(location_data.relative_keypoints_size(), 1)
@@ -162,6 +179,7 @@ absl::Status DetectionsToRectsCalculator::GetContract(CalculatorContract* cc) {
   if (cc->Outputs().HasTag(kNormRectsTag)) {
     cc->Outputs().Tag(kNormRectsTag).Set<std::vector<NormalizedRect>>();
   }
+  cc->UseService(kPacketArenaService).Optional();
 
   return absl::OkStatus();
 }
@@ -190,6 +208,7 @@ absl::Status DetectionsToRectsCalculator::Open(CalculatorContext* cc) {
 
   output_zero_rect_for_empty_detections_ =
       options_.output_zero_rect_for_empty_detections();
+  arenas_ = cc->Service(kPacketArenaService);
 
   return absl::OkStatus();
 }
@@ -240,31 +259,31 @@ absl::Status DetectionsToRectsCalculator::Process(CalculatorContext* cc) {
   const DetectionSpec detection_spec = GetDetectionSpec(cc);
 
   if (cc->Outputs().HasTag(kRectTag)) {
-    auto output_rect = absl::make_unique<Rect>();
+    Packet packet;
+    Rect* output_rect = CreateOutput<Rect>(arenas_, cc, &packet);
     MP_RETURN_IF_ERROR(
-        DetectionToRect(detections[0], detection_spec, output_rect.get()));
+        DetectionToRect(detections[0], detection_spec, output_rect));
     if (rotate_) {
       float rotation;
       MP_RETURN_IF_ERROR(
           ComputeRotation(detections[0], detection_spec, &rotation));
       output_rect->set_rotation(rotation);
     }
-    cc->Outputs().Tag(kRectTag).Add(output_rect.release(),
-                                    cc->InputTimestamp());
+    cc->Outputs().Tag(kRectTag).AddPacket(std::move(packet));
   }
   if (cc->Outputs().HasTag(kNormRectTag)) {
-    auto output_rect = absl::make_unique<NormalizedRect>();
-    MP_RETURN_IF_ERROR(DetectionToNormalizedRect(detections[0], detection_spec,
-                                                 output_rect.get()));
+    Packet packet;
+    NormalizedRect* output_rect =
+        CreateOutput<NormalizedRect>(arenas_, cc, &packet);
+    MP_RETURN_IF_ERROR(
+        DetectionToNormalizedRect(detections[0], detection_spec, output_rect));
     if (rotate_) {
       float rotation;
       MP_RETURN_IF_ERROR(
           ComputeRotation(detections[0], detection_spec, &rotation));
       output_rect->set_rotation(rotation);
     }
-    cc->Outputs()
-        .Tag(kNormRectTag)
-        .Add(output_rect.release(), cc->InputTimestamp());
+    cc->Outputs().Tag(kNormRectTag).AddPacket(std::move(packet));
   }
   if (cc->Outputs().HasTag(kRectsTag)) {
     auto output_rects = absl::make_unique<std::vector<Rect>>(detections.size());
@@ -23,6 +23,7 @@
 #include "mediapipe/framework/formats/detection.pb.h"
 #include "mediapipe/framework/formats/location_data.pb.h"
 #include "mediapipe/framework/formats/rect.pb.h"
+#include "mediapipe/framework/packet_arena.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status.h"
 
@@ -110,6 +111,8 @@ class DetectionsToRectsCalculator : public CalculatorBase {
   float target_angle_ = 0.0f;  // In radians.
   bool rotate_;
   bool output_zero_rect_for_empty_detections_;
+  // Provides the memory of the single rect outputs, if the graph has arenas.
+  ServiceBinding<PacketArenaPool> arenas_;
 };
 
 }  // namespace mediapipe
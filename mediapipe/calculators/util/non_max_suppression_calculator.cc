@@ -18,6 +18,7 @@
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "mediapipe/calculators/util/non_max_suppression_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/detection.pb.h"
@@ -25,12 +26,13 @@
 #include "mediapipe/framework/formats/location.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/rectangle.h"
+#include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status.h"
+#include "mediapipe/util/non_max_suppression.h"
 
 namespace mediapipe {
 
 typedef std::vector<Detection> Detections;
-typedef std::vector<std::pair<int, float>> IndexedScores;
 
 namespace {
 
@@ -73,51 +75,18 @@ bool RetainMaxScoringLabelOnly(Detection* detection) {
   return true;
 }
 
-// Computes an overlap similarity between two rectangles. Similarity measure is
-// defined by overlap_type parameter.
-float OverlapSimilarity(
-    const NonMaxSuppressionCalculatorOptions::OverlapType overlap_type,
-    const Rectangle_f& rect1, const Rectangle_f& rect2) {
-  if (!rect1.Intersects(rect2)) return 0.0f;
-  const float intersection_area = Rectangle_f(rect1).Intersect(rect2).Area();
-  float normalization;
+OverlapType ToOverlapType(
+    NonMaxSuppressionCalculatorOptions::OverlapType overlap_type) {
   switch (overlap_type) {
     case NonMaxSuppressionCalculatorOptions::JACCARD:
-      normalization = Rectangle_f(rect1).Union(rect2).Area();
-      break;
+      return OverlapType::kJaccard;
     case NonMaxSuppressionCalculatorOptions::MODIFIED_JACCARD:
-      normalization = rect2.Area();
-      break;
+      return OverlapType::kModifiedJaccard;
     case NonMaxSuppressionCalculatorOptions::INTERSECTION_OVER_UNION:
-      normalization = rect1.Area() + rect2.Area() - intersection_area;
-      break;
+      return OverlapType::kIntersectionOverUnion;
     default:
       LOG(FATAL) << "Unrecognized overlap type: " << overlap_type;
   }
-  return normalization > 0.0f ? intersection_area / normalization : 0.0f;
-}
-
-// Computes an overlap similarity between two locations by first extracting the
-// relative box (dimension normalized by frame width/height) from the location.
-float OverlapSimilarity(
-    const int frame_width, const int frame_height,
-    const NonMaxSuppressionCalculatorOptions::OverlapType overlap_type,
-    const Location& location1, const Location& location2) {
-  const auto rect1 = location1.ConvertToRelativeBBox(frame_width, frame_height);
-  const auto rect2 = location2.ConvertToRelativeBBox(frame_width, frame_height);
-  return OverlapSimilarity(overlap_type, rect1, rect2);
-}
-
-// Computes an overlap similarity between two locations by first extracting the
-// relative box from the location. It assumes that a relative-box representation
-// is already available in the location, and therefore frame width and height
-// are not needed for further normalization.
-float OverlapSimilarity(
-    const NonMaxSuppressionCalculatorOptions::OverlapType overlap_type,
-    const Location& location1, const Location& location2) {
-  const auto rect1 = location1.GetRelativeBBox();
-  const auto rect2 = location2.GetRelativeBBox();
-  return OverlapSimilarity(overlap_type, rect1, rect2);
 }
 
 }  // namespace
@@ -177,6 +146,15 @@ class NonMaxSuppressionCalculator : public CalculatorBase {
         << "max_num_detections=0 is not a valid value. Please choose a "
         << "positive number of you want to limit the number of output "
         << "detections, or set -1 if you do not want any limit.";
+    RET_CHECK_NE(options_.overlap_type(),
+                 NonMaxSuppressionCalculatorOptions::UNSPECIFIED_OVERLAP_TYPE)
+        << "Unrecognized overlap type.";
+    nms_options_.overlap_type = ToOverlapType(options_.overlap_type());
+    nms_options_.min_suppression_threshold =
+        options_.min_suppression_threshold();
+    nms_options_.min_score = options_.min_score_threshold();
+    nms_options_.max_num_boxes = options_.max_num_detections();
+    nms_options_.class_aware = options_.class_aware_suppression();
     return absl::OkStatus();
   }
 
@@ -214,33 +192,42 @@ class NonMaxSuppressionCalculator : public CalculatorBase {
       }
     }
 
-    // Copy all the scores (there is a single score in each detection after
-    // the above pruning) to an indexed vector for sorting. The first value is
-    // the index of the detection in the original vector from which the score
-    // stems, while the second is the actual score.
-    IndexedScores indexed_scores;
-    indexed_scores.reserve(pruned_detections.size());
+    // Collect the boxes of the detections for suppression. There is a single
+    // score in each detection after the above pruning.
+    const bool weighted =
+        options_.algorithm() == NonMaxSuppressionCalculatorOptions::WEIGHTED;
+    std::vector<ScoredBox> boxes(pruned_detections.size());
     for (int index = 0; index < pruned_detections.size(); ++index) {
-      indexed_scores.push_back(
-          std::make_pair(index, pruned_detections[index].score(0)));
+      const auto& detection = pruned_detections[index];
+      const Location location(detection.location_data());
+      ScoredBox& box = boxes[index];
+      if (!weighted && cc->Inputs().HasTag(kImageTag)) {
+        const auto& frame = cc->Inputs().Tag(kImageTag).Get<ImageFrame>();
+        box.rect =
+            location.ConvertToRelativeBBox(frame.Width(), frame.Height());
+      } else {
+        box.rect = location.GetRelativeBBox();
+      }
+      box.score = detection.score(0);
+      if (options_.class_aware_suppression()) {
+        box.class_id = GetClassId(detection);
+      }
     }
-    std::sort(indexed_scores.begin(), indexed_scores.end(), SortBySecond);
 
-    const int max_num_detections =
-        (options_.max_num_detections() > -1)
-            ? options_.max_num_detections()
-            : static_cast<int>(indexed_scores.size());
-    // A set of detections and locations, wrapping the location data from each
-    // detection, which are retained after the non-maximum suppression.
+    const int max_num_detections = (options_.max_num_detections() > -1)
+                                       ? options_.max_num_detections()
+                                       : static_cast<int>(boxes.size());
+    // A set of detections which are retained after the non-maximum
+    // suppression.
     auto* retained_detections = new Detections();
     retained_detections->reserve(max_num_detections);
 
-    if (options_.algorithm() == NonMaxSuppressionCalculatorOptions::WEIGHTED) {
-      WeightedNonMaxSuppression(indexed_scores, pruned_detections,
-                                max_num_detections, cc, retained_detections);
+    if (weighted) {
+      WeightedNonMaxSuppression(pruned_detections, boxes, retained_detections);
     } else {
-      NonMaxSuppression(indexed_scores, pruned_detections, max_num_detections,
-                        cc, retained_detections);
+      for (int index : NonMaxSuppression(boxes, nms_options_)) {
+        retained_detections->push_back(pruned_detections[index]);
+      }
     }
 
     cc->Outputs().Index(0).Add(retained_detections, cc->InputTimestamp());
@@ -249,83 +236,29 @@ class NonMaxSuppressionCalculator : public CalculatorBase {
   }
 
  private:
-  void NonMaxSuppression(const IndexedScores& indexed_scores,
-                         const Detections& detections, int max_num_detections,
-                         CalculatorContext* cc, Detections* output_detections) {
-    std::vector<Location> retained_locations;
-    retained_locations.reserve(max_num_detections);
-    // We traverse the detections by decreasing score.
-    for (const auto& indexed_score : indexed_scores) {
-      const auto& detection = detections[indexed_score.first];
-      if (options_.min_score_threshold() > 0 &&
-          detection.score(0) < options_.min_score_threshold()) {
-        break;
-      }
-      const Location location(detection.location_data());
-      bool suppressed = false;
-      // The current detection is suppressed iff there exists a retained
-      // detection, whose location overlaps more than the specified
-      // threshold with the location of the current detection.
-      for (const auto& retained_location : retained_locations) {
-        float similarity;
-        if (cc->Inputs().HasTag(kImageTag)) {
-          const auto& frame = cc->Inputs().Tag(kImageTag).Get<ImageFrame>();
-          similarity = OverlapSimilarity(frame.Width(), frame.Height(),
-                                         options_.overlap_type(),
-                                         retained_location, location);
-        } else {
-          similarity = OverlapSimilarity(options_.overlap_type(),
-                                         retained_location, location);
-        }
-        if (similarity > options_.min_suppression_threshold()) {
-          suppressed = true;
-          break;
-        }
-      }
-      if (!suppressed) {
-        output_detections->push_back(detection);
-        retained_locations.push_back(location);
-      }
-      if (output_detections->size() >= max_num_detections) {
-        break;
-      }
+  // Returns the class of a detection with a single label. Detections with a
+  // string label get negative ids, so that they never match a label id.
+  int GetClassId(const Detection& detection) {
+    if (detection.label_id_size() > 0) {
+      return detection.label_id(0);
     }
+    auto it = label_class_ids_.find(detection.label(0));
+    if (it == label_class_ids_.end()) {
+      it = label_class_ids_
+               .emplace(detection.label(0), -1 - label_class_ids_.size())
+               .first;
+    }
+    return it->second;
   }
 
-  void WeightedNonMaxSuppression(const IndexedScores& indexed_scores,
-                                 const Detections& detections,
-                                 int max_num_detections, CalculatorContext* cc,
+  void WeightedNonMaxSuppression(const Detections& detections,
+                                 const std::vector<ScoredBox>& boxes,
                                  Detections* output_detections) {
-    IndexedScores remained_indexed_scores;
-    remained_indexed_scores.assign(indexed_scores.begin(),
-                                   indexed_scores.end());
-
-    IndexedScores remained;
-    IndexedScores candidates;
-    output_detections->clear();
-    while (!remained_indexed_scores.empty()) {
-      const int original_indexed_scores_size = remained_indexed_scores.size();
-      const auto& detection = detections[remained_indexed_scores[0].first];
-      if (options_.min_score_threshold() > 0 &&
-          detection.score(0) < options_.min_score_threshold()) {
-        break;
-      }
-      remained.clear();
-      candidates.clear();
-      const Location location(detection.location_data());
-      // This includes the first box.
-      for (const auto& indexed_score : remained_indexed_scores) {
-        Location rest_location(detections[indexed_score.first].location_data());
-        float similarity =
-            OverlapSimilarity(options_.overlap_type(), rest_location, location);
-        if (similarity > options_.min_suppression_threshold()) {
-          candidates.push_back(indexed_score);
-        } else {
-          remained.push_back(indexed_score);
-        }
-      }
+    for (const auto& cluster :
+         mediapipe::WeightedNonMaxSuppression(boxes, nms_options_)) {
+      const auto& detection = detections[cluster.top_index];
       auto weighted_detection = detection;
-      if (!candidates.empty()) {
+      if (!cluster.members.empty()) {
         const int num_keypoints =
             detection.location_data().relative_keypoints_size();
         std::vector<float> keypoints(num_keypoints * 2);
@@ -334,21 +267,20 @@ class NonMaxSuppressionCalculator : public CalculatorBase {
         float w_xmax = 0.0f;
         float w_ymax = 0.0f;
         float total_score = 0.0f;
-        for (const auto& candidate : candidates) {
-          total_score += candidate.second;
-          const auto& location_data =
-              detections[candidate.first].location_data();
+        for (int member : cluster.members) {
+          const float score = boxes[member].score;
+          total_score += score;
+          const auto& location_data = detections[member].location_data();
           const auto& bbox = location_data.relative_bounding_box();
-          w_xmin += bbox.xmin() * candidate.second;
-          w_ymin += bbox.ymin() * candidate.second;
-          w_xmax += (bbox.xmin() + bbox.width()) * candidate.second;
-          w_ymax += (bbox.ymin() + bbox.height()) * candidate.second;
+          w_xmin += bbox.xmin() * score;
+          w_ymin += bbox.ymin() * score;
+          w_xmax += (bbox.xmin() + bbox.width()) * score;
+          w_ymax += (bbox.ymin() + bbox.height()) * score;
 
           for (int i = 0; i < num_keypoints; ++i) {
-            keypoints[i * 2] +=
-                location_data.relative_keypoints(i).x() * candidate.second;
+            keypoints[i * 2] += location_data.relative_keypoints(i).x() * score;
             keypoints[i * 2 + 1] +=
-                location_data.relative_keypoints(i).y() * candidate.second;
+                location_data.relative_keypoints(i).y() * score;
           }
         }
         auto* weighted_location = weighted_detection.mutable_location_data()
@@ -366,19 +298,13 @@ class NonMaxSuppressionCalculator : public CalculatorBase {
           keypoint->set_y(keypoints[i * 2 + 1] / total_score);
         }
       }
-
       output_detections->push_back(weighted_detection);
-      // Breaks the loop if the size of indexed scores doesn't change after an
-      // iteration.
-      if (original_indexed_scores_size == remained.size()) {
-        break;
-      } else {
-        remained_indexed_scores = std::move(remained);
-      }
     }
   }
 
   NonMaxSuppressionCalculatorOptions options_;
+  NonMaxSuppressionOptions nms_options_;
+  absl::flat_hash_map<std::string, int> label_class_ids_;
 };
 REGISTER_CALCULATOR(NonMaxSuppressionCalculator);
 
@@ -36,6 +36,7 @@
 #include "mediapipe/util/tracking/box_tracker.pb.h"
 #include "mediapipe/util/tracking/flow_packager.pb.h"
 #include "mediapipe/util/tracking/tracking.h"
+#include "mediapipe/util/tracking/tracking_frame.h"
 #include "mediapipe/util/tracking/tracking_visualization_utilities.h"
 
 #if defined(MEDIAPIPE_MOBILE)
@@ -61,6 +62,7 @@ constexpr char kFeaturesTag[] = "FEATURES";
 constexpr char kVideoTag[] = "VIDEO";
 constexpr char kTrackedBoxesTag[] = "TRACKED_BOXES";
 constexpr char kTrackingTag[] = "TRACKING";
+constexpr char kTrackingFrameTag[] = "TRACKING_FRAME";
 
 // A calculator to detect reappeared box positions from single frame.
 //
@@ -69,6 +71,10 @@ constexpr char kTrackingTag[] = "TRACKING";
 //             descriptors.
 //   VIDEO:    Optional input video stream tracked boxes are rendered over
 //             (Required if VIZ is specified).
+//   TRACKING_FRAME: Optional TrackingFrame of VIDEO (see
+//             TrackingFrameCalculator). If present, features are extracted
+//             from it instead of from VIDEO, reusing its grayscale frame and
+//             pyramid.
 //   FEATURES: Input feature points (std::vector<cv::KeyPoint>) in the original
 //             pixel space.
 //   DESCRIPTORS: Input feature descriptors (std::vector<float>). Actual feature
@@ -136,6 +142,10 @@ absl::Status BoxDetectorCalculator::GetContract(CalculatorContract* cc) {
     cc->Inputs().Tag(kVideoTag).Set<ImageFrame>();
   }
 
+  if (cc->Inputs().HasTag(kTrackingFrameTag)) {
+    cc->Inputs().Tag(kTrackingFrameTag).Set<TrackingFrame>();
+  }
+
   if (cc->Inputs().HasTag(kFeaturesTag)) {
     RET_CHECK(cc->Inputs().HasTag(kDescriptorsTag))
         << "FEATURES and DESCRIPTORS need to be specified together.";
@@ -269,6 +279,10 @@ absl::Status BoxDetectorCalculator::Process(CalculatorContext* cc) {
                                   : nullptr;
   InputStream* video_stream =
       cc->Inputs().HasTag(kVideoTag) ? &(cc->Inputs().Tag(kVideoTag)) : nullptr;
+  InputStream* tracking_frame_stream =
+      cc->Inputs().HasTag(kTrackingFrameTag)
+          ? &(cc->Inputs().Tag(kTrackingFrameTag))
+          : nullptr;
   InputStream* feature_stream = cc->Inputs().HasTag(kFeaturesTag)
                                     ? &(cc->Inputs().Tag(kFeaturesTag))
                                     : nullptr;
@@ -277,9 +291,10 @@ absl::Status BoxDetectorCalculator::Process(CalculatorContext* cc) {
                                        : nullptr;
 
   CHECK(track_stream != nullptr || video_stream != nullptr ||
+        tracking_frame_stream != nullptr ||
         (feature_stream != nullptr && descriptor_stream != nullptr))
       << "One and only one of {tracking_data, input image frame, "
-         "feature/descriptor} need to be valid.";
+         "tracking frame, feature/descriptor} need to be valid.";
 
   InputStream* tracked_boxes_stream =
       cc->Inputs().HasTag(kTrackedBoxesTag)
@@ -302,6 +317,20 @@ absl::Status BoxDetectorCalculator::Process(CalculatorContext* cc) {
 
     box_detector_->DetectAndAddBox(tracking_data, tracked_boxes, timestamp_msec,
                                    detected_boxes.get());
+  } else if (tracking_frame_stream != nullptr) {
+    // Detect from the precomputed grayscale frame and pyramid.
+    if (tracking_frame_stream->IsEmpty()) {
+      return absl::OkStatus();
+    }
+
+    TimedBoxProtoList tracked_boxes;
+    if (tracked_boxes_stream != nullptr && !tracked_boxes_stream->IsEmpty()) {
+      tracked_boxes = tracked_boxes_stream->Get<TimedBoxProtoList>();
+    }
+
+    box_detector_->DetectAndAddBox(
+        tracking_frame_stream->Get<TrackingFrame>(), tracked_boxes,
+        timestamp_msec, detected_boxes.get());
   } else if (video_stream != nullptr) {
     // Detect from input frame
     if (video_stream->IsEmpty()) {
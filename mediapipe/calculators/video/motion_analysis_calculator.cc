@@ -35,7 +35,9 @@
 #include "mediapipe/util/tracking/motion_analysis.h"
 #include "mediapipe/util/tracking/motion_estimation.h"
 #include "mediapipe/util/tracking/motion_models.h"
+#include "mediapipe/util/tracking/parallel_motion_analysis.h"
 #include "mediapipe/util/tracking/region_flow.pb.h"
+#include "mediapipe/util/tracking/tracking_frame.h"
 
 namespace mediapipe {
 
@@ -50,6 +52,7 @@ constexpr char kCameraTag[] = "CAMERA";
 constexpr char kFlowTag[] = "FLOW";
 constexpr char kSelectionTag[] = "SELECTION";
 constexpr char kVideoTag[] = "VIDEO";
+constexpr char kTrackingFrameTag[] = "TRACKING_FRAME";
 
 using mediapipe::AffineAdapter;
 using mediapipe::CameraMotion;
@@ -75,6 +78,11 @@ const char kOptionsTag[] = "OPTIONS";
 //   SELECTION: Optional input stream to perform analysis only on selected
 //              frames. If present needs to contain camera motion
 //              and features.
+//   TRACKING_FRAME: Optional TrackingFrame of VIDEO (see
+//              TrackingFrameCalculator) that is tracked instead of VIDEO,
+//              sharing its grayscale conversion and pyramid with other
+//              calculators. Requires VIDEO and can not be used with
+//              SELECTION, metadata or parallel_chunk_analysis.
 //
 // Input side packets:
 //   CSV_FILE:  Read motion models as homographies from CSV file. Expected
@@ -117,7 +125,8 @@ class MotionAnalysisCalculator : public CalculatorBase {
  private:
   // Outputs results to Outputs() if MotionAnalysis buffered sufficient results.
   // Otherwise no-op. Set flush to true to force output of all buffered data.
-  void OutputMotionAnalyzedFrames(bool flush, CalculatorContext* cc);
+  // Fails if parallel chunk analysis could not analyze a frame.
+  absl::Status OutputMotionAnalyzedFrames(bool flush, CalculatorContext* cc);
 
   // Lazy init function to be called on Process.
   absl::Status InitOnProcess(InputStream* video_stream,
@@ -165,6 +174,7 @@ class MotionAnalysisCalculator : public CalculatorBase {
   // Input indicators for each stream.
   bool selection_input_ = false;
   bool video_input_ = false;
+  bool tracking_frame_input_ = false;
 
   // Output indicators for each stream.
   bool region_flow_feature_output_ = false;
@@ -196,6 +206,8 @@ class MotionAnalysisCalculator : public CalculatorBase {
   int hybrid_meta_offset_ = 0;
 
   std::unique_ptr<MotionAnalysis> motion_analysis_;
+  // Set if parallel_chunk_analysis is requested.
+  std::unique_ptr<ParallelMotionAnalysis> parallel_motion_analysis_;
 
   std::unique_ptr<MixtureRowWeights> row_weights_;
 };
@@ -216,6 +228,13 @@ absl::Status MotionAnalysisCalculator::GetContract(CalculatorContract* cc) {
             cc->Inputs().HasTag(kSelectionTag))
       << "Either VIDEO, SELECTION must be specified.";
 
+  if (cc->Inputs().HasTag(kTrackingFrameTag)) {
+    RET_CHECK(cc->Inputs().HasTag(kVideoTag) &&
+              !cc->Inputs().HasTag(kSelectionTag))
+        << "TRACKING_FRAME requires VIDEO and can not be used with SELECTION.";
+    cc->Inputs().Tag(kTrackingFrameTag).Set<TrackingFrame>();
+  }
+
   if (cc->Outputs().HasTag(kFlowTag)) {
     cc->Outputs().Tag(kFlowTag).Set<RegionFlowFeatureList>();
   }
@@ -269,6 +288,7 @@ absl::Status MotionAnalysisCalculator::Open(CalculatorContext* cc) {
 
   video_input_ = cc->Inputs().HasTag(kVideoTag);
   selection_input_ = cc->Inputs().HasTag(kSelectionTag);
+  tracking_frame_input_ = cc->Inputs().HasTag(kTrackingFrameTag);
   region_flow_feature_output_ = cc->Outputs().HasTag(kFlowTag);
   camera_motion_output_ = cc->Outputs().HasTag(kCameraTag);
   saliency_output_ = cc->Outputs().HasTag(kSaliencyTag);
@@ -364,6 +384,23 @@ absl::Status MotionAnalysisCalculator::Open(CalculatorContext* cc) {
     }
   }
 
+  if (options_.parallel_chunk_analysis()) {
+    RET_CHECK(video_input_ && !selection_input_ && !csv_file_input_ &&
+              !hybrid_meta_analysis_)
+        << "Parallel chunk analysis requires VIDEO input without SELECTION "
+        << "or metadata.";
+    RET_CHECK(!with_saliency_ && !grayscale_output_)
+        << "Parallel chunk analysis does not support saliency or grayscale "
+        << "output.";
+  }
+
+  if (tracking_frame_input_) {
+    RET_CHECK(!csv_file_input_ && !hybrid_meta_analysis_ &&
+              !options_.parallel_chunk_analysis())
+        << "TRACKING_FRAME can not be used with metadata or parallel chunk "
+        << "analysis.";
+  }
+
   if (options_.bypass_mode()) {
     cc->SetOffset(TimestampDiff(0));
   }
@@ -466,6 +503,11 @@ absl::Status MotionAnalysisCalculator::Process(CalculatorContext* cc) {
     // We do not need MotionAnalysis when using just metadata.
     motion_analysis_.reset(new MotionAnalysis(options_.analysis_options(),
                                               frame_width_, frame_height_));
+    // MotionAnalysis is still used to render results in this case.
+    if (options_.parallel_chunk_analysis()) {
+      parallel_motion_analysis_.reset(new ParallelMotionAnalysis(
+          options_.analysis_options(), frame_width_, frame_height_));
+    }
   }
 
   std::unique_ptr<FrameSelectionResult> frame_selection_result;
@@ -532,6 +574,13 @@ absl::Status MotionAnalysisCalculator::Process(CalculatorContext* cc) {
             input_view, timestamp.Value(), initial_transform, nullptr, nullptr,
             &subtract_helper, &meta_features_[hybrid_meta_offset_]);
         ++hybrid_meta_offset_;
+      } else if (parallel_motion_analysis_) {
+        parallel_motion_analysis_->AddFrame(input_view, timestamp.Value());
+      } else if (tracking_frame_input_ &&
+                 !cc->Inputs().Tag(kTrackingFrameTag).IsEmpty()) {
+        motion_analysis_->AddTrackingFrame(
+            cc->Inputs().Tag(kTrackingFrameTag).Get<TrackingFrame>(),
+            input_view, timestamp.Value());
       } else {
         motion_analysis_->AddFrame(input_view, timestamp.Value());
       }
@@ -590,7 +639,7 @@ absl::Status MotionAnalysisCalculator::Process(CalculatorContext* cc) {
     }
 
     // Output other results, if we have any yet.
-    OutputMotionAnalyzedFrames(false, cc);
+    MP_RETURN_IF_ERROR(OutputMotionAnalyzedFrames(false, cc));
   }
 
   return absl::OkStatus();
@@ -599,7 +648,7 @@ absl::Status MotionAnalysisCalculator::Process(CalculatorContext* cc) {
 absl::Status MotionAnalysisCalculator::Close(CalculatorContext* cc) {
   // Guard against empty videos.
   if (motion_analysis_) {
-    OutputMotionAnalyzedFrames(true, cc);
+    MP_RETURN_IF_ERROR(OutputMotionAnalyzedFrames(true, cc));
   }
   if (csv_file_input_) {
     if (!meta_motions_.empty()) {
@@ -610,20 +659,27 @@ absl::Status MotionAnalysisCalculator::Close(CalculatorContext* cc) {
   return absl::OkStatus();
 }
 
-void MotionAnalysisCalculator::OutputMotionAnalyzedFrames(
+absl::Status MotionAnalysisCalculator::OutputMotionAnalyzedFrames(
     bool flush, CalculatorContext* cc) {
   std::vector<std::unique_ptr<RegionFlowFeatureList>> features;
   std::vector<std::unique_ptr<CameraMotion>> camera_motions;
   std::vector<std::unique_ptr<SalientPointFrame>> saliency;
 
   const int buffer_size = timestamp_buffer_.size();
-  const int num_results = motion_analysis_->GetResults(
-      flush, &features, &camera_motions, with_saliency_ ? &saliency : nullptr);
+  int num_results = 0;
+  if (parallel_motion_analysis_) {
+    ASSIGN_OR_RETURN(num_results, parallel_motion_analysis_->GetResults(
+                                      flush, &features, &camera_motions));
+  } else {
+    num_results =
+        motion_analysis_->GetResults(flush, &features, &camera_motions,
+                                     with_saliency_ ? &saliency : nullptr);
+  }
 
   CHECK_LE(num_results, buffer_size);
 
   if (num_results == 0) {
-    return;
+    return absl::OkStatus();
   }
 
   for (int k = 0; k < num_results; ++k) {
@@ -705,6 +761,7 @@ void MotionAnalysisCalculator::OutputMotionAnalyzedFrames(
     packet_buffer_.erase(packet_buffer_.begin(),
                          packet_buffer_.begin() + num_results);
   }
+  return absl::OkStatus();
 }
 
 absl::Status MotionAnalysisCalculator::InitOnProcess(
@@ -14,10 +14,17 @@
 
 #include <stdlib.h>
 
+#include <deque>
+#include <thread>  // NOLINT(build/c++11)
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/calculators/video/opencv_video_decoder_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/image_format.pb.h"
 #include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/formats/shared_image_frame_pool.h"
 #include "mediapipe/framework/formats/video_stream_header.h"
 #include "mediapipe/framework/port/opencv_imgproc_inc.h"
 #include "mediapipe/framework/port/opencv_video_inc.h"
@@ -32,6 +39,7 @@ constexpr char kSavedAudioPathTag[] = "SAVED_AUDIO_PATH";
 constexpr char kVideoPrestreamTag[] = "VIDEO_PRESTREAM";
 constexpr char kVideoTag[] = "VIDEO";
 constexpr char kInputFilePathTag[] = "INPUT_FILE_PATH";
+constexpr char kOptionsTag[] = "OPTIONS";
 
 // cv::VideoCapture set data type to unsigned char by default. Therefore, the
 // image format is only related to the number of channles the cv::Mat has.
@@ -66,6 +74,9 @@ ImageFormat::Format GetImageFormat(int num_channels) {
 //       Timestamp::PreStream() for the corresponding stream.
 // Input Side Packets:
 //   INPUT_FILE_PATH: The input file path.
+//   OPTIONS: Optional OpenCvVideoDecoderCalculatorOptions, which override the
+//       node options. E.g. the time range of the chunk of the video that the
+//       graph processes.
 //
 // Example config:
 // node {
@@ -75,6 +86,25 @@ ImageFormat::Format GetImageFormat(int num_channels) {
 //   output_stream: "VIDEO_PRESTREAM:video_header"
 // }
 //
+// With prefetch_frames set, a dedicated thread decodes the frames ahead of
+// the graph, so that decoding overlaps with the processing of the previous
+// frames. The frames are decoded into frames from the graph's image frame
+// pool, and converted to RGB in place.
+//
+// Example config:
+// node {
+//   calculator: "OpenCvVideoDecoderCalculator"
+//   input_side_packet: "INPUT_FILE_PATH:input_file_path"
+//   output_stream: "VIDEO:video_frames"
+//   node_options: {
+//     [type.googleapis.com/mediapipe.OpenCvVideoDecoderCalculatorOptions] {
+//       prefetch_frames: 8
+//       start_time: 10
+//       end_time: 20
+//     }
+//   }
+// }
+//
 // OpenCV's VideoCapture doesn't decode audio tracks. If the audio tracks need
 // to be saved, specify an output side packet with tag "SAVED_AUDIO_PATH".
 // The calculator will call FFmpeg binary to save audio tracks as an aac file.
@@ -94,7 +124,13 @@ class OpenCvVideoDecoderCalculator : public CalculatorBase {
  public:
   static absl::Status GetContract(CalculatorContract* cc) {
     cc->InputSidePackets().Tag(kInputFilePathTag).Set<std::string>();
+    if (cc->InputSidePackets().HasTag(kOptionsTag)) {
+      cc->InputSidePackets()
+          .Tag(kOptionsTag)
+          .Set<OpenCvVideoDecoderCalculatorOptions>();
+    }
     cc->Outputs().Tag(kVideoTag).Set<ImageFrame>();
+    cc->UseService(kImageFramePoolService).Optional();
     if (cc->Outputs().HasTag(kVideoPrestreamTag)) {
       cc->Outputs().Tag(kVideoPrestreamTag).Set<VideoHeader>();
     }
@@ -107,6 +143,16 @@ class OpenCvVideoDecoderCalculator : public CalculatorBase {
   absl::Status Open(CalculatorContext* cc) override {
     const std::string& input_file_path =
         cc->InputSidePackets().Tag(kInputFilePathTag).Get<std::string>();
+    const auto& options = tool::RetrieveOptions(
+        cc->Options<OpenCvVideoDecoderCalculatorOptions>(),
+        cc->InputSidePackets(), kOptionsTag);
+    if (options.has_start_time()) {
+      start_timestamp_ = Timestamp::FromSeconds(options.start_time());
+    }
+    if (options.has_end_time()) {
+      end_timestamp_ = Timestamp::FromSeconds(options.end_time());
+    }
+    pool_ = cc->Service(kImageFramePoolService);
     cap_ = absl::make_unique<cv::VideoCapture>(input_file_path);
     if (!cap_->isOpened()) {
       return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
@@ -152,8 +198,13 @@ class OpenCvVideoDecoderCalculator : public CalculatorBase {
           .Add(header.release(), Timestamp::PreStream());
       cc->Outputs().Tag(kVideoPrestreamTag).Close();
     }
-    // Rewind to the very first frame.
-    cap_->set(cv::CAP_PROP_POS_AVI_RATIO, 0);
+    if (start_timestamp_ != Timestamp::Min()) {
+      // Use millisecond as the unit of time of the seek.
+      cap_->set(cv::CAP_PROP_POS_MSEC, start_timestamp_.Seconds() * 1000);
+    } else {
+      // Rewind to the very first frame.
+      cap_->set(cv::CAP_PROP_POS_AVI_RATIO, 0);
+    }
 
     if (cc->OutputSidePackets().HasTag(kSavedAudioPathTag)) {
 #ifdef HAVE_FFMPEG
@@ -183,39 +234,34 @@ class OpenCvVideoDecoderCalculator : public CalculatorBase {
                 "config.";
 #endif
     }
+
+    prefetch_frames_ = options.prefetch_frames();
+    if (prefetch_frames_ > 0) {
+      decode_thread_ = std::thread([this] { DecodeLoop(); });
+    }
     return absl::OkStatus();
   }
 
   absl::Status Process(CalculatorContext* cc) override {
-    auto image_frame = absl::make_unique<ImageFrame>(format_, width_, height_,
-                                                     /*alignment_boundary=*/1);
-    // Use microsecond as the unit of time.
-    Timestamp timestamp(cap_->get(cv::CAP_PROP_POS_MSEC) * 1000);
-    if (format_ == ImageFormat::GRAY8) {
-      cv::Mat frame = formats::MatView(image_frame.get());
-      ReadFrame(frame);
-      if (frame.empty()) {
-        return tool::StatusStop();
-      }
-    } else {
-      cv::Mat tmp_frame;
-      ReadFrame(tmp_frame);
-      if (tmp_frame.empty()) {
+    DecodedFrame frame;
+    if (decode_thread_.joinable()) {
+      absl::MutexLock lock(&mutex_);
+      mutex_.Await(absl::Condition(
+          this, &OpenCvVideoDecoderCalculator::HasFrameOrIsDone));
+      if (prefetched_frames_.empty()) {
         return tool::StatusStop();
       }
-      if (format_ == ImageFormat::SRGB) {
-        cv::cvtColor(tmp_frame, formats::MatView(image_frame.get()),
-                     cv::COLOR_BGR2RGB);
-      } else if (format_ == ImageFormat::SRGBA) {
-        cv::cvtColor(tmp_frame, formats::MatView(image_frame.get()),
-                     cv::COLOR_BGRA2RGBA);
-      }
+      frame = std::move(prefetched_frames_.front());
+      prefetched_frames_.pop_front();
+    } else if (!DecodeFrame(&frame)) {
+      return tool::StatusStop();
     }
     // If the timestamp of the current frame is not greater than the one of the
     // previous frame, the new frame will be discarded.
-    if (prev_timestamp_ < timestamp) {
-      cc->Outputs().Tag(kVideoTag).Add(image_frame.release(), timestamp);
-      prev_timestamp_ = timestamp;
+    if (prev_timestamp_ < frame.timestamp) {
+      cc->Outputs().Tag(kVideoTag).Add(frame.image_frame.release(),
+                                       frame.timestamp);
+      prev_timestamp_ = frame.timestamp;
       decoded_frames_++;
     }
 
@@ -223,10 +269,13 @@ class OpenCvVideoDecoderCalculator : public CalculatorBase {
   }
 
   absl::Status Close(CalculatorContext* cc) override {
+    StopDecodeThread();
     if (cap_ && cap_->isOpened()) {
       cap_->release();
     }
-    if (decoded_frames_ != frame_count_) {
+    const bool decodes_whole_video = start_timestamp_ == Timestamp::Min() &&
+                                     end_timestamp_ == Timestamp::Max();
+    if (decodes_whole_video && decoded_frames_ != frame_count_) {
       LOG(WARNING) << "Not all the frames are decoded (total frames: "
                    << frame_count_ << " vs decoded frames: " << decoded_frames_
                    << ").";
@@ -234,6 +283,8 @@ class OpenCvVideoDecoderCalculator : public CalculatorBase {
     return absl::OkStatus();
   }
 
+  ~OpenCvVideoDecoderCalculator() override { StopDecodeThread(); }
+
   // Sometimes an empty frame is returned even though there are more frames.
   void ReadFrame(cv::Mat& frame) {
     cap_->read(frame);
@@ -243,6 +294,88 @@ class OpenCvVideoDecoderCalculator : public CalculatorBase {
   }
 
  private:
+  struct DecodedFrame {
+    std::unique_ptr<ImageFrame> image_frame;
+    Timestamp timestamp;
+  };
+
+  // Decodes the next frame within the time range into a frame from the pool.
+  // Returns false at the end of the time range or of the video.
+  bool DecodeFrame(DecodedFrame* decoded) {
+    while (true) {
+      auto image_frame = NewImageFrame(pool_, format_, width_, height_,
+                                       /*alignment_boundary=*/1);
+      // Use microsecond as the unit of time.
+      Timestamp timestamp(cap_->get(cv::CAP_PROP_POS_MSEC) * 1000);
+      cv::Mat frame_view = formats::MatView(image_frame.get());
+      cv::Mat frame = frame_view;
+      ReadFrame(frame);
+      if (frame.empty() || timestamp >= end_timestamp_) {
+        return false;
+      }
+      // Seeking may stop at a key frame before the start time.
+      if (timestamp < start_timestamp_) {
+        continue;
+      }
+      // VideoCapture decodes into the pixels of the frame if they fit, and
+      // allocates new ones otherwise.
+      if (frame.data != frame_view.data) {
+        frame.copyTo(frame_view);
+      }
+      if (format_ == ImageFormat::SRGB) {
+        cv::cvtColor(frame_view, frame_view, cv::COLOR_BGR2RGB);
+      } else if (format_ == ImageFormat::SRGBA) {
+        cv::cvtColor(frame_view, frame_view, cv::COLOR_BGRA2RGBA);
+      }
+      decoded->image_frame = std::move(image_frame);
+      decoded->timestamp = timestamp;
+      return true;
+    }
+  }
+
+  // Runs on decode_thread_, keeping up to prefetch_frames_ decoded frames
+  // ahead of Process().
+  void DecodeLoop() {
+    while (true) {
+      {
+        absl::MutexLock lock(&mutex_);
+        mutex_.Await(absl::Condition(
+            this, &OpenCvVideoDecoderCalculator::CanPrefetchOrIsStopped));
+        if (stop_decoding_) {
+          return;
+        }
+      }
+      DecodedFrame frame;
+      const bool decoded = DecodeFrame(&frame);
+      absl::MutexLock lock(&mutex_);
+      if (!decoded) {
+        decoding_done_ = true;
+        return;
+      }
+      prefetched_frames_.push_back(std::move(frame));
+    }
+  }
+
+  void StopDecodeThread() {
+    if (!decode_thread_.joinable()) {
+      return;
+    }
+    {
+      absl::MutexLock lock(&mutex_);
+      stop_decoding_ = true;
+    }
+    decode_thread_.join();
+  }
+
+  bool HasFrameOrIsDone() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return !prefetched_frames_.empty() || decoding_done_;
+  }
+
+  bool CanPrefetchOrIsStopped() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return prefetched_frames_.size() < static_cast<size_t>(prefetch_frames_) ||
+           stop_decoding_;
+  }
+
   std::unique_ptr<cv::VideoCapture> cap_;
   int width_;
   int height_;
@@ -250,6 +383,17 @@ class OpenCvVideoDecoderCalculator : public CalculatorBase {
   int decoded_frames_ = 0;
   ImageFormat::Format format_;
   Timestamp prev_timestamp_ = Timestamp::Unset();
+  Timestamp start_timestamp_ = Timestamp::Min();
+  Timestamp end_timestamp_ = Timestamp::Max();
+  ServiceBinding<SharedImageFramePool> pool_;
+
+  // The decoding thread is only started if prefetch_frames_ > 0.
+  int prefetch_frames_ = 0;
+  std::thread decode_thread_;
+  absl::Mutex mutex_;
+  std::deque<DecodedFrame> prefetched_frames_ ABSL_GUARDED_BY(mutex_);
+  bool decoding_done_ ABSL_GUARDED_BY(mutex_) = false;
+  bool stop_decoding_ ABSL_GUARDED_BY(mutex_) = false;
 };
 
 REGISTER_CALCULATOR(OpenCvVideoDecoderCalculator);
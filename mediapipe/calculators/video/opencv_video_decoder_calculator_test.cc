@@ -12,16 +12,20 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "mediapipe/calculators/video/opencv_video_decoder_calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_runner.h"
 #include "mediapipe/framework/deps/file_path.h"
 #include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/formats/image_frame_opencv.h"
 #include "mediapipe/framework/formats/video_stream_header.h"
+#include "mediapipe/framework/port/benchmark.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
 #include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/opencv_core_inc.h"
+#include "mediapipe/framework/port/opencv_imgproc_inc.h"
 #include "mediapipe/framework/port/parse_text_proto.h"
 #include "mediapipe/framework/port/status_matchers.h"
 #include "mediapipe/framework/tool/test_util.h"
@@ -33,6 +37,7 @@ namespace {
 constexpr char kVideoTag[] = "VIDEO";
 constexpr char kVideoPrestreamTag[] = "VIDEO_PRESTREAM";
 constexpr char kInputFilePathTag[] = "INPUT_FILE_PATH";
+constexpr char kOptionsTag[] = "OPTIONS";
 constexpr char kTestPackageRoot[] = "mediapipe/calculators/video";
 
 TEST(OpenCvVideoDecoderCalculatorTest, TestMp4Avc720pVideo) {
@@ -168,5 +173,126 @@ TEST(OpenCvVideoDecoderCalculatorTest, TestMkvVp8Video) {
   }
 }
 
+TEST(OpenCvVideoDecoderCalculatorTest, PrefetchesSameFrames) {
+  std::vector<Packet> frames[2];
+  for (int prefetch_frames : {0, 4}) {
+    CalculatorGraphConfig::Node node_config =
+        ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"pb(
+          calculator: "OpenCvVideoDecoderCalculator"
+          input_side_packet: "INPUT_FILE_PATH:input_file_path"
+          output_stream: "VIDEO:video")pb");
+    node_config.mutable_options()
+        ->MutableExtension(OpenCvVideoDecoderCalculatorOptions::ext)
+        ->set_prefetch_frames(prefetch_frames);
+    CalculatorRunner runner(node_config);
+    runner.MutableSidePackets()->Tag(kInputFilePathTag) =
+        MakePacket<std::string>(file::JoinPath(GetTestDataDir(kTestPackageRoot),
+                                               "format_FLV_H264_AAC.video"));
+    MP_ASSERT_OK(runner.Run());
+    frames[prefetch_frames > 0] = runner.Outputs().Tag(kVideoTag).packets;
+  }
+
+  ASSERT_EQ(180, frames[0].size());
+  ASSERT_EQ(frames[0].size(), frames[1].size());
+  for (int i = 0; i < frames[0].size(); ++i) {
+    EXPECT_EQ(frames[0][i].Timestamp(), frames[1][i].Timestamp());
+    cv::Mat expected_mat = formats::MatView(&frames[0][i].Get<ImageFrame>());
+    cv::Mat output_mat = formats::MatView(&frames[1][i].Get<ImageFrame>());
+    EXPECT_EQ(0, cv::norm(expected_mat, output_mat, cv::NORM_INF));
+  }
+}
+
+TEST(OpenCvVideoDecoderCalculatorTest, DecodesTimeRange) {
+  CalculatorGraphConfig::Node node_config =
+      ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"pb(
+        calculator: "OpenCvVideoDecoderCalculator"
+        input_side_packet: "INPUT_FILE_PATH:input_file_path"
+        input_side_packet: "OPTIONS:options"
+        output_stream: "VIDEO:video")pb");
+  CalculatorRunner runner(node_config);
+  runner.MutableSidePackets()->Tag(kInputFilePathTag) =
+      MakePacket<std::string>(file::JoinPath(GetTestDataDir(kTestPackageRoot),
+                                             "format_MKV_VP8_VORBIS.video"));
+  OpenCvVideoDecoderCalculatorOptions options;
+  options.set_prefetch_frames(2);
+  options.set_start_time(2.0);
+  options.set_end_time(3.0);
+  runner.MutableSidePackets()->Tag(kOptionsTag) =
+      MakePacket<OpenCvVideoDecoderCalculatorOptions>(options);
+  MP_ASSERT_OK(runner.Run());
+
+  // The video has 30 frames per second.
+  const std::vector<Packet>& packets = runner.Outputs().Tag(kVideoTag).packets;
+  EXPECT_NEAR(30, packets.size(), 1);
+  for (const Packet& packet : packets) {
+    EXPECT_GE(packet.Timestamp(), Timestamp::FromSeconds(2.0));
+    EXPECT_LT(packet.Timestamp(), Timestamp::FromSeconds(3.0));
+  }
+}
+
+// Stands in for the processing of the frames by a graph.
+class BlurCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<ImageFrame>();
+    cc->Outputs().Index(0).Set<ImageFrame>();
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    const ImageFrame& input = cc->Inputs().Index(0).Get<ImageFrame>();
+    auto output = absl::make_unique<ImageFrame>(
+        input.Format(), input.Width(), input.Height());
+    cv::GaussianBlur(formats::MatView(&input),
+                     formats::MatView(output.get()), cv::Size(9, 9), 0);
+    cc->Outputs().Index(0).Add(output.release(), cc->InputTimestamp());
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(BlurCalculator);
+
+// Decodes a video with range(0) prefetched frames, and processes the frames
+// on another thread.
+void BM_DecodeVideo(benchmark::State& state) {
+  CalculatorGraphConfig config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_side_packet: "input_file_path"
+        num_threads: 2
+        node {
+          calculator: "OpenCvVideoDecoderCalculator"
+          input_side_packet: "INPUT_FILE_PATH:input_file_path"
+          output_stream: "VIDEO:video"
+        }
+        node {
+          calculator: "BlurCalculator"
+          input_stream: "video"
+          output_stream: "blurred_video"
+        }
+      )pb");
+  config.mutable_node(0)
+      ->mutable_options()
+      ->MutableExtension(OpenCvVideoDecoderCalculatorOptions::ext)
+      ->set_prefetch_frames(state.range(0));
+  const std::string video_path = file::JoinPath(
+      GetTestDataDir(kTestPackageRoot), "format_MP4_AVC720P_AAC.video");
+  int64 num_frames = 0;
+  for (auto _ : state) {
+    CalculatorGraph graph;
+    CHECK(graph.Initialize(config).ok());
+    CHECK(graph
+              .ObserveOutputStream("blurred_video",
+                                   [&num_frames](const Packet&) {
+                                     ++num_frames;
+                                     return absl::OkStatus();
+                                   })
+              .ok());
+    CHECK(graph.Run({{"input_file_path", MakePacket<std::string>(video_path)}})
+              .ok());
+  }
+  state.counters["frames_per_second"] =
+      benchmark::Counter(num_frames, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_DecodeVideo)->Arg(0)->Arg(8)->UseRealTime();
+
 }  // namespace
 }  // namespace mediapipe
@@ -0,0 +1,101 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/calculators/video/tracking_frame_calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/port/opencv_core_inc.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/util/tracking/tracking_frame.h"
+
+namespace mediapipe {
+
+constexpr char kVideoTag[] = "VIDEO";
+constexpr char kTrackingFrameTag[] = "TRACKING_FRAME";
+
+// Computes the grayscale frame at tracking resolution and its Lucas-Kanade
+// pyramid once per frame, so that they can be shared by
+// MotionAnalysisCalculator and BoxDetectorCalculator (see
+// mediapipe/util/tracking/tracking_frame.h).
+//
+// Input streams:
+//   VIDEO:          Input video stream (ImageFrame, SRGB, SRGBA or GRAY8).
+//
+// Output streams:
+//   TRACKING_FRAME: TrackingFrame of each input frame.
+//
+// Example config:
+// node {
+//   calculator: "TrackingFrameCalculator"
+//   input_stream: "VIDEO:input_video"
+//   output_stream: "TRACKING_FRAME:tracking_frame"
+//   options {
+//     [mediapipe.TrackingFrameCalculatorOptions.ext] {
+//       output_width: 320
+//       output_height: 240
+//     }
+//   }
+// }
+class TrackingFrameCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Tag(kVideoTag).Set<ImageFrame>();
+    cc->Outputs().Tag(kTrackingFrameTag).Set<TrackingFrame>();
+    return absl::OkStatus();
+  }
+
+  absl::Status Open(CalculatorContext* cc) override {
+    cc->SetOffset(TimestampDiff(0));
+    options_ = cc->Options<TrackingFrameCalculatorOptions>();
+    RET_CHECK_GE(options_.output_width(), 0);
+    RET_CHECK_GE(options_.output_height(), 0);
+    RET_CHECK_GE(options_.pyramid_levels(), 0);
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    const ImageFrame& frame = cc->Inputs().Tag(kVideoTag).Get<ImageFrame>();
+    RET_CHECK(frame.Format() == ImageFormat::SRGB ||
+              frame.Format() == ImageFormat::SRGBA ||
+              frame.Format() == ImageFormat::GRAY8)
+        << "Unsupported image format: " << frame.Format();
+
+    const int width =
+        options_.output_width() > 0 ? options_.output_width() : frame.Width();
+    const int height = options_.output_height() > 0 ? options_.output_height()
+                                                    : frame.Height();
+    auto tracking_frame = absl::make_unique<TrackingFrame>();
+    ComputeTrackingFrame(formats::MatView(&frame), width, height,
+                         options_.pyramid_levels(),
+                         options_.tracking_window_size(),
+                         options_.compute_derivative_in_pyramid(),
+                         tracking_frame.get());
+    cc->Outputs()
+        .Tag(kTrackingFrameTag)
+        .Add(tracking_frame.release(), cc->InputTimestamp());
+    return absl::OkStatus();
+  }
+
+ private:
+  TrackingFrameCalculatorOptions options_;
+};
+
+REGISTER_CALCULATOR(TrackingFrameCalculator);
+
+}  // namespace mediapipe
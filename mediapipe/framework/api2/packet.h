@@ -447,8 +447,13 @@ inline Packet<internal::Generic> Packet<internal::Generic>::At(
 
 template <typename T, typename... Args>
 Packet<T> MakePacket(Args&&... args) {
-  return Packet<T>(std::make_shared<packet_internal::Holder<T>>(
-      new T(std::forward<Args>(args)...)));
+  if constexpr (packet_internal::kUseInlinePayload<T>) {
+    return Packet<T>(std::make_shared<packet_internal::InlineHolder<T>>(
+        std::forward<Args>(args)...));
+  } else {
+    return Packet<T>(std::make_shared<packet_internal::Holder<T>>(
+        new T(std::forward<Args>(args)...)));
+  }
 }
 
 template <typename T>
@@ -48,7 +48,9 @@ namespace mediapipe {
 // The entire calculator is constructed and destroyed for each graph run
 // (set of input side packets, which could mean once per video, or once
 // per image).  Any expensive operations and large objects should be
-// input side packets.
+// input side packets.  Calculators that declare
+// cc->SetReusableAcrossRuns(true) in GetContract() are instead kept after a
+// successful run, and Reset() replaces Open() in the next run of the graph.
 //
 // The framework calls Open() to initialize the calculator.
 // If appropriate, Open() should call cc->SetOffset() or
@@ -123,6 +125,15 @@ class CalculatorBase {
   // destructor).
   virtual absl::Status Open(CalculatorContext* cc) { return absl::OkStatus(); }
 
+  // Is called instead of Open() at the start of a graph run, on a calculator
+  // that was opened in an earlier run of the same graph and whose contract
+  // declares SetReusableAcrossRuns(true).  Close() was called at the end of
+  // the earlier run.  Like Open(), Reset() sees the input side packets of the
+  // new run and sets up its output streams, but it may keep the state that
+  // does not depend on the changed side packets.  The same failure semantics
+  // as for Open() apply.  The default implementation calls Open().
+  virtual absl::Status Reset(CalculatorContext* cc) { return Open(cc); }
+
   // Processes the incoming inputs. May call the methods on cc to access
   // inputs and produce outputs.
   //
@@ -16,7 +16,7 @@
 #define MEDIAPIPE_FRAMEWORK_CALCULATOR_CONTEXT_H_
 
 #include <memory>
-#include <queue>
+#include <deque>
 #include <string>
 #include <utility>
 
@@ -85,6 +85,22 @@ class CalculatorContext {
                                      : input_timestamps_.front();
   }
 
+  // Returns the number of input timestamps of this Process() call. It is only
+  // greater than one for a calculator whose contract declares
+  // SetProcessBatches(true), and whose input stream handler batches input
+  // sets (see BatchInputStreamHandler). Such a calculator processes all the
+  // timestamps of the batch in one call, reading the inputs of the i-th one
+  // with InputStreamShard::BatchValue(i) and adding its outputs with
+  // timestamp BatchInputTimestamp(i).
+  int BatchSize() const { return batch_size_; }
+
+  // Returns the |index|-th input timestamp of the batch. BatchInputTimestamp(0)
+  // is the same as InputTimestamp().
+  Timestamp BatchInputTimestamp(int index) const {
+    CHECK_LT(index, batch_size_);
+    return input_timestamps_[index];
+  }
+
   // Returns a reference to the input side packet set.
   const PacketSet& InputSidePackets() const;
   // Returns a reference to the output side packet collection.
@@ -125,16 +141,29 @@ class CalculatorContext {
 
   bool HasInputTimestamp() const { return !input_timestamps_.empty(); }
 
+  // Returns the number of input timestamps before Timestamp::Done(), which
+  // are the timestamps of Process() calls.
+  int NumberOfProcessTimestamps() const {
+    int num_timestamps = 0;
+    while (num_timestamps < input_timestamps_.size() &&
+           input_timestamps_[num_timestamps].IsAllowedInStream()) {
+      ++num_timestamps;
+    }
+    return num_timestamps;
+  }
+
   // Adds a new input timestamp by the friend class CalculatorContextManager.
   void PushInputTimestamp(Timestamp input_timestamp) {
-    input_timestamps_.push(input_timestamp);
+    input_timestamps_.push_back(input_timestamp);
   }
 
   void PopInputTimestamp() {
     CHECK(!input_timestamps_.empty());
-    input_timestamps_.pop();
+    input_timestamps_.pop_front();
   }
 
+  void SetBatchSize(int batch_size) { batch_size_ = batch_size; }
+
   void SetGraphStatus(const absl::Status& status) { graph_status_ = status; }
 
   // Interface for the friend class Calculator.
@@ -153,7 +182,9 @@ class CalculatorContext {
   mutable std::unique_ptr<InputStreamSet> input_streams_;
   mutable std::unique_ptr<OutputStreamSet> output_streams_;
   // The queue of timestamp values to Process() in this calculator context.
-  std::queue<Timestamp> input_timestamps_;
+  std::deque<Timestamp> input_timestamps_;
+  // The number of input timestamps processed by the current Process() call.
+  int batch_size_ = 1;
 
   // The status of the graph run. Only used when Close() is called.
   absl::Status graph_status_;
@@ -106,6 +106,17 @@ class CalculatorContextManager {
     calculator_context->PopInputTimestamp();
   }
 
+  int NumberOfProcessTimestamps(
+      const CalculatorContext& calculator_context) const {
+    return calculator_context.NumberOfProcessTimestamps();
+  }
+
+  void SetBatchSizeInContext(CalculatorContext* calculator_context,
+                             int batch_size) {
+    CHECK(calculator_context);
+    calculator_context->SetBatchSize(batch_size);
+  }
+
   void SetGraphStatusInContext(CalculatorContext* calculator_context,
                                const absl::Status& status) {
     CHECK(calculator_context);
@@ -133,6 +133,25 @@ class CalculatorContract {
   void SetTimestampOffset(TimestampDiff offset) { timestamp_offset_ = offset; }
   TimestampDiff GetTimestampOffset() const { return timestamp_offset_; }
 
+  // When true, Process() may be called with several input timestamps at once,
+  // if the input stream handler of the node batches input sets. The
+  // calculator then processes all of them in that call (see
+  // CalculatorContext::BatchSize()). Otherwise, Process() is called once per
+  // input timestamp, even for batched input sets.
+  void SetProcessBatches(bool process_batches) {
+    process_batches_ = process_batches;
+  }
+  bool GetProcessBatches() const { return process_batches_; }
+
+  // When true, the calculator is not destroyed at the end of a successful
+  // graph run.  The next run of the same graph calls Reset() on it instead of
+  // constructing a new calculator and calling Open(), so that it can keep
+  // expensive state such as a loaded model.
+  void SetReusableAcrossRuns(bool reusable) {
+    reusable_across_runs_ = reusable;
+  }
+  bool GetReusableAcrossRuns() const { return reusable_across_runs_; }
+
   class GraphServiceRequest {
    public:
     // APIs that should be used by calculators.
@@ -188,6 +207,8 @@ class CalculatorContract {
   ServiceReqMap service_requests_;
   bool process_timestamps_ = false;
   TimestampDiff timestamp_offset_ = TimestampDiff::Unset();
+  bool reusable_across_runs_ = false;
+  bool process_batches_ = false;
 
   friend class CalculatorNode;
 };
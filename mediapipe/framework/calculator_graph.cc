@@ -370,6 +370,25 @@ absl::Status CalculatorGraph::InitializeExecutors() {
                                                  use_application_thread));
   }
 
+  // Shard the scheduler queues of the executors that ask for work stealing,
+  // one shard per worker thread.
+  for (const ExecutorConfig& executor_config :
+       validated_graph_->Config().executor()) {
+    const ThreadPoolExecutorOptions& options =
+        executor_config.options().GetExtension(ThreadPoolExecutorOptions::ext);
+    if (!options.use_work_stealing_queue() || use_application_thread_) {
+      continue;
+    }
+    int num_shards = options.num_threads();
+    if (num_shards <= 0) {
+      num_shards = executor_config.name().empty() && default_num_threads_ > 0
+                       ? default_num_threads_
+                       : mediapipe::NumCPUCores();
+    }
+    MP_RETURN_IF_ERROR(
+        scheduler_.SetQueueNumShards(executor_config.name(), num_shards));
+  }
+
   return absl::OkStatus();
 }
 
@@ -403,6 +422,7 @@ absl::Status CalculatorGraph::InitializeDefaultExecutor(
         std::max({validated_graph_->Config().node().size(),
                   validated_graph_->Config().packet_generator().size(), 1}));
   }
+  default_num_threads_ = num_threads;
   MP_RETURN_IF_ERROR(
       CreateDefaultThreadPool(default_executor_options, num_threads));
   return absl::OkStatus();
@@ -443,6 +463,14 @@ absl::Status CalculatorGraph::Initialize(
   return Initialize(std::move(validated_graph), side_packets);
 }
 
+absl::Status CalculatorGraph::Initialize(
+    const CompiledGraphConfig& compiled_config,
+    const std::map<std::string, Packet>& side_packets) {
+  auto validated_graph = absl::make_unique<ValidatedGraphConfig>();
+  MP_RETURN_IF_ERROR(validated_graph->Initialize(compiled_config));
+  return Initialize(std::move(validated_graph), side_packets);
+}
+
 absl::Status CalculatorGraph::Initialize(
     const std::vector<CalculatorGraphConfig>& input_configs,
     const std::vector<CalculatorGraphTemplate>& input_templates,
@@ -629,6 +657,11 @@ absl::Status CalculatorGraph::PrepareGpu() {
 }
 #endif  // !MEDIAPIPE_DISABLE_GPU
 
+void CalculatorGraph::SetResourceProfiler(
+    const std::string& name, std::function<void(ResourceProfile*)> profiler) {
+  profiler_->SetResourceProfiler(name, std::move(profiler));
+}
+
 absl::Status CalculatorGraph::PrepareServices() {
   for (const auto& node : nodes_) {
     for (const auto& [key, request] : node->Contract().ServiceRequests()) {
@@ -23,6 +23,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -34,6 +35,7 @@
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_base.h"
 #include "mediapipe/framework/calculator_node.h"
+#include "mediapipe/framework/compiled_graph_config.pb.h"
 #include "mediapipe/framework/counter_factory.h"
 #include "mediapipe/framework/executor.h"
 #include "mediapipe/framework/graph_output_stream.h"
@@ -51,6 +53,7 @@
 #include "mediapipe/framework/port.h"
 #include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/status_macros.h"
 #include "mediapipe/framework/scheduler.h"
 #include "mediapipe/framework/thread_pool_executor.pb.h"
 
@@ -61,8 +64,23 @@ class GpuResources;
 struct GpuSharedData;
 #endif  // !MEDIAPIPE_DISABLE_GPU
 
+class ResourceProfile;
+
 typedef absl::StatusOr<OutputStreamPoller> StatusOrPoller;
 
+namespace internal {
+
+// True if T reports its usage through a method
+// void GetResourceProfile(ResourceProfile*) const.
+template <typename T, typename = void>
+struct HasResourceProfile : std::false_type {};
+template <typename T>
+struct HasResourceProfile<
+    T, std::void_t<decltype(std::declval<const T&>().GetResourceProfile(
+           std::declval<ResourceProfile*>()))>> : std::true_type {};
+
+}  // namespace internal
+
 // The class representing a DAG of calculator nodes.
 //
 // CalculatorGraph is the primary API for the MediaPipe Framework.
@@ -131,6 +149,14 @@ class CalculatorGraph {
   // Convenience version which does not take side packets.
   absl::Status Initialize(CalculatorGraphConfig config);
 
+  // Initializes the graph from a config compiled ahead of time by
+  // ValidatedGraphConfig::Compile(), such as the output of the compile_graph
+  // tool.  Subgraph expansion and the topological sort of the nodes are
+  // skipped.
+  absl::Status Initialize(
+      const CompiledGraphConfig& compiled_config,
+      const std::map<std::string, Packet>& side_packets = {});
+
   // Initializes the CalculatorGraph from the specified graph and subgraph
   // configs.  Template graph and subgraph configs can be specified through
   // |input_templates|.  Every subgraph must have its graph type specified in
@@ -371,11 +397,24 @@ class CalculatorGraph {
   absl::Status SetGpuResources(std::shared_ptr<GpuResources> resources);
 #endif  // !MEDIAPIPE_DISABLE_GPU
 
+  // If T has a GetResourceProfile(ResourceProfile*) method, such as the
+  // resource pools, the usage of the object is reported as a ResourceProfile
+  // named after the service in the GraphProfile.
   template <typename T>
   absl::Status SetServiceObject(const GraphService<T>& service,
                                 std::shared_ptr<T> object) {
     // TODO: check that the graph has not been started!
-    return service_manager_.SetServiceObject(service, object);
+    MP_RETURN_IF_ERROR(service_manager_.SetServiceObject(service, object));
+    if constexpr (internal::HasResourceProfile<T>::value) {
+      std::weak_ptr<T> weak_object = object;
+      SetResourceProfiler(service.key,
+                          [weak_object](ResourceProfile* profile) {
+                            if (auto object = weak_object.lock()) {
+                              object->GetResourceProfile(profile);
+                            }
+                          });
+    }
+    return absl::OkStatus();
   }
 
   template <typename T>
@@ -494,6 +533,10 @@ class CalculatorGraph {
 
   absl::Status PrepareServices();
 
+  // Reports the usage of a service object in the GraphProfile.
+  void SetResourceProfiler(const std::string& name,
+                           std::function<void(ResourceProfile*)> profiler);
+
 #if !MEDIAPIPE_DISABLE_GPU
   absl::Status MaybeSetUpGpuServiceFromLegacySidePacket(Packet legacy_sp);
   // Helper for PrepareForRun. If it returns a non-empty map, those packets
@@ -620,6 +663,10 @@ class CalculatorGraph {
   // True if the default executor uses the application thread.
   bool use_application_thread_ = false;
 
+  // The number of worker threads of the default executor, if the graph
+  // created it. 0 otherwise.
+  int default_num_threads_ = 0;
+
   // Condition variable that waits until all input streams that depend on a
   // graph input stream are below the maximum queue size.
   absl::CondVar wait_to_add_packet_cond_var_
@@ -0,0 +1,110 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/calculator_graph_pool.h"
+
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/validated_graph_config.h"
+
+namespace mediapipe {
+
+absl::StatusOr<std::unique_ptr<CalculatorGraphPool>>
+CalculatorGraphPool::Create(
+    const CalculatorGraphConfig& config, const Options& options,
+    const std::map<std::string, Packet>& shared_side_packets) {
+  RET_CHECK_GE(options.num_initial_graphs, 0);
+  RET_CHECK_GE(options.max_idle_graphs, 0);
+  auto pool =
+      absl::WrapUnique(new CalculatorGraphPool(options, shared_side_packets));
+  MP_RETURN_IF_ERROR(pool->Initialize(config));
+  return pool;
+}
+
+CalculatorGraphPool::CalculatorGraphPool(
+    const Options& options,
+    const std::map<std::string, Packet>& shared_side_packets)
+    : options_(options), shared_side_packets_(shared_side_packets) {}
+
+CalculatorGraphPool::~CalculatorGraphPool() = default;
+
+absl::Status CalculatorGraphPool::Initialize(
+    const CalculatorGraphConfig& config) {
+  // Subgraphs are expanded and the nodes are sorted once, and every instance
+  // is initialized from the compiled config.
+  ValidatedGraphConfig validated_graph;
+  MP_RETURN_IF_ERROR(validated_graph.Initialize(config));
+  ASSIGN_OR_RETURN(compiled_config_, validated_graph.Compile());
+
+  for (int i = 0; i < options_.num_initial_graphs; ++i) {
+    ASSIGN_OR_RETURN(std::unique_ptr<Instance> instance, CreateInstance());
+    absl::MutexLock lock(&mutex_);
+    idle_instances_.push_back(std::move(instance));
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::unique_ptr<CalculatorGraphPool::Instance>>
+CalculatorGraphPool::CreateInstance() const {
+  auto instance = absl::make_unique<Instance>();
+  MP_RETURN_IF_ERROR(
+      instance->graph.Initialize(compiled_config_, shared_side_packets_));
+  for (const std::string& stream_name : options_.output_streams) {
+    ASSIGN_OR_RETURN(OutputStreamPoller poller,
+                     instance->graph.AddOutputStreamPoller(stream_name));
+    instance->pollers.push_back(std::move(poller));
+  }
+  return instance;
+}
+
+absl::StatusOr<std::unique_ptr<CalculatorGraphPool::Instance>>
+CalculatorGraphPool::Acquire() {
+  {
+    absl::MutexLock lock(&mutex_);
+    if (!idle_instances_.empty()) {
+      std::unique_ptr<Instance> instance = std::move(idle_instances_.back());
+      idle_instances_.pop_back();
+      return instance;
+    }
+  }
+  // Initialized without holding the lock, as it might load models.
+  return CreateInstance();
+}
+
+void CalculatorGraphPool::Release(std::unique_ptr<Instance> instance) {
+  if (!instance) {
+    return;
+  }
+  for (OutputStreamPoller& poller : instance->pollers) {
+    poller.Reset();
+  }
+  {
+    absl::MutexLock lock(&mutex_);
+    if (idle_instances_.size() < options_.max_idle_graphs) {
+      idle_instances_.push_back(std::move(instance));
+      return;
+    }
+  }
+  // Destroyed without holding the lock.
+  instance.reset();
+}
+
+int CalculatorGraphPool::NumIdleGraphs() const {
+  absl::MutexLock lock(&mutex_);
+  return idle_instances_.size();
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,132 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Defines CalculatorGraphPool, which keeps initialized instances of a graph
+// so that short sessions, such as requests of a server, do not pay for the
+// initialization of a graph and of its calculators every time.
+
+#ifndef MEDIAPIPE_FRAMEWORK_CALCULATOR_GRAPH_POOL_H_
+#define MEDIAPIPE_FRAMEWORK_CALCULATOR_GRAPH_POOL_H_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/compiled_graph_config.pb.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+
+namespace mediapipe {
+
+// A pool of initialized instances of the same graph. An instance is acquired
+// for a session, run once or several times, and released back to the pool
+// after its last run is done. The next session reuses it with its own input
+// side packets, and skips the validation of the config, the creation of the
+// nodes and the shared side packets.
+//
+// Calculators that declare CalculatorContract::SetReusableAcrossRuns() are
+// also kept across runs, and are Reset() instead of being constructed and
+// opened again. InferenceCalculator does so to keep its TfLite interpreters.
+//
+// Graph observers cannot be removed from a graph, so the outputs of an
+// instance are read from the pollers that the pool adds to every instance.
+//
+// Example:
+//   CalculatorGraphPool::Options options;
+//   options.output_streams = {"detections"};
+//   ASSIGN_OR_RETURN(auto pool,
+//                    CalculatorGraphPool::Create(config, options,
+//                                                {{"model", model_packet}}));
+//   ...
+//   // For each session.
+//   ASSIGN_OR_RETURN(auto instance, pool->Acquire());
+//   MP_RETURN_IF_ERROR(instance->graph.StartRun({{"image", image_packet}}));
+//   MP_RETURN_IF_ERROR(instance->graph.CloseAllPacketSources());
+//   Packet packet;
+//   while (instance->pollers[0].Next(&packet)) {
+//     ...
+//   }
+//   absl::Status status = instance->graph.WaitUntilDone();
+//   pool->Release(std::move(instance));
+//
+// This class is thread-safe.
+class CalculatorGraphPool {
+ public:
+  struct Options {
+    // The number of instances created by Create().
+    int num_initial_graphs = 0;
+    // The maximum number of released instances kept by the pool. Instances
+    // released when the pool is full are destroyed.
+    int max_idle_graphs = 4;
+    // The graph output streams for which a poller is added to every instance,
+    // in the order of Instance::pollers.
+    std::vector<std::string> output_streams;
+  };
+
+  struct Instance {
+    CalculatorGraph graph;
+    std::vector<OutputStreamPoller> pollers;
+  };
+
+  // Compiles the config once, and creates |options.num_initial_graphs|
+  // instances of the graph. The |shared_side_packets| are passed to all
+  // instances when they are initialized.
+  static absl::StatusOr<std::unique_ptr<CalculatorGraphPool>> Create(
+      const CalculatorGraphConfig& config, const Options& options,
+      const std::map<std::string, Packet>& shared_side_packets = {});
+
+  CalculatorGraphPool(const CalculatorGraphPool&) = delete;
+  CalculatorGraphPool& operator=(const CalculatorGraphPool&) = delete;
+
+  ~CalculatorGraphPool();
+
+  // Returns an idle instance, or a new one if there is none. The instance is
+  // not running.
+  absl::StatusOr<std::unique_ptr<Instance>> Acquire();
+
+  // Returns an instance to the pool. Must be called after WaitUntilDone() of
+  // the last run of the instance, whatever its status. The packets left in
+  // the pollers are dropped.
+  void Release(std::unique_ptr<Instance> instance);
+
+  // Returns the number of instances waiting in the pool.
+  int NumIdleGraphs() const;
+
+ private:
+  CalculatorGraphPool(const Options& options,
+                      const std::map<std::string, Packet>& shared_side_packets);
+
+  absl::Status Initialize(const CalculatorGraphConfig& config);
+
+  // Creates and initializes a new instance.
+  absl::StatusOr<std::unique_ptr<Instance>> CreateInstance() const;
+
+  const Options options_;
+  const std::map<std::string, Packet> shared_side_packets_;
+  CompiledGraphConfig compiled_config_;
+
+  mutable absl::Mutex mutex_;
+  // The most recently released instance is acquired first, as its memory is
+  // the most likely to still be cached.
+  std::vector<std::unique_ptr<Instance>> idle_instances_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_CALCULATOR_GRAPH_POOL_H_
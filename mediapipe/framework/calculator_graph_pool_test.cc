@@ -0,0 +1,242 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/calculator_graph_pool.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::ElementsAre;
+
+int num_constructed = 0;
+int num_opened = 0;
+int num_reset = 0;
+
+// Adds the SHARED and SESSION side packets to every input packet, and counts
+// the calls to its constructor, Open() and Reset(). Reusable across runs.
+// Fails on a negative sum.
+class CountingAddCalculator : public CalculatorBase {
+ public:
+  CountingAddCalculator() { ++num_constructed; }
+
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<int>();
+    cc->Outputs().Index(0).Set<int>();
+    cc->InputSidePackets().Tag("SHARED").Set<int>();
+    cc->InputSidePackets().Tag("SESSION").Set<int>();
+    cc->SetReusableAcrossRuns(true);
+    return absl::OkStatus();
+  }
+
+  absl::Status Open(CalculatorContext* cc) override {
+    ++num_opened;
+    return Configure(cc);
+  }
+
+  absl::Status Reset(CalculatorContext* cc) override {
+    ++num_reset;
+    return Configure(cc);
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    const int sum = cc->Inputs().Index(0).Get<int>() + offset_;
+    RET_CHECK_GE(sum, 0);
+    cc->Outputs().Index(0).AddPacket(
+        MakePacket<int>(sum).At(cc->InputTimestamp()));
+    return absl::OkStatus();
+  }
+
+ private:
+  absl::Status Configure(CalculatorContext* cc) {
+    offset_ = cc->InputSidePackets().Tag("SHARED").Get<int>() +
+              cc->InputSidePackets().Tag("SESSION").Get<int>();
+    return absl::OkStatus();
+  }
+
+  int offset_ = 0;
+};
+REGISTER_CALCULATOR(CountingAddCalculator);
+
+// The same calculator, without SetReusableAcrossRuns().
+class NonReusableCountingAddCalculator : public CountingAddCalculator {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    MP_RETURN_IF_ERROR(CountingAddCalculator::GetContract(cc));
+    cc->SetReusableAcrossRuns(false);
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(NonReusableCountingAddCalculator);
+
+CalculatorGraphConfig MakeConfig(const std::string& calculator) {
+  CalculatorGraphConfig config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "in"
+        output_stream: "out"
+        input_side_packet: "shared"
+        input_side_packet: "session"
+        node {
+          input_stream: "in"
+          output_stream: "out"
+          input_side_packet: "SHARED:shared"
+          input_side_packet: "SESSION:session"
+        }
+      )pb");
+  config.mutable_node(0)->set_calculator(calculator);
+  return config;
+}
+
+class CalculatorGraphPoolTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    num_constructed = 0;
+    num_opened = 0;
+    num_reset = 0;
+  }
+
+  // Runs a session on an instance of the pool, and returns the outputs.
+  absl::StatusOr<std::vector<int>> RunSession(CalculatorGraphPool* pool,
+                                              int session,
+                                              const std::vector<int>& inputs) {
+    ASSIGN_OR_RETURN(auto instance, pool->Acquire());
+    RET_CHECK_EQ(instance->pollers.size(), 1);
+    MP_RETURN_IF_ERROR(
+        instance->graph.StartRun({{"session", MakePacket<int>(session)}}));
+    for (int i = 0; i < inputs.size(); ++i) {
+      MP_RETURN_IF_ERROR(instance->graph.AddPacketToInputStream(
+          "in", MakePacket<int>(inputs[i]).At(Timestamp(i))));
+    }
+    MP_RETURN_IF_ERROR(instance->graph.CloseAllPacketSources());
+    std::vector<int> outputs;
+    Packet packet;
+    while (instance->pollers[0].Next(&packet)) {
+      outputs.push_back(packet.Get<int>());
+    }
+    absl::Status status = instance->graph.WaitUntilDone();
+    pool->Release(std::move(instance));
+    MP_RETURN_IF_ERROR(status);
+    return outputs;
+  }
+};
+
+TEST_F(CalculatorGraphPoolTest, ReusesInstancesAndCalculators) {
+  CalculatorGraphPool::Options options;
+  options.num_initial_graphs = 1;
+  options.output_streams = {"out"};
+  auto pool_or = CalculatorGraphPool::Create(
+      MakeConfig("CountingAddCalculator"), options,
+      {{"shared", MakePacket<int>(100)}});
+  MP_ASSERT_OK(pool_or);
+  auto pool = std::move(pool_or).value();
+  EXPECT_EQ(pool->NumIdleGraphs(), 1);
+
+  for (int session = 0; session < 3; ++session) {
+    auto outputs_or = RunSession(pool.get(), 10 * session, {1, 2});
+    MP_ASSERT_OK(outputs_or);
+    EXPECT_THAT(outputs_or.value(),
+                ElementsAre(101 + 10 * session, 102 + 10 * session));
+    EXPECT_EQ(pool->NumIdleGraphs(), 1);
+  }
+  // The calculator is opened by the first session, and reset by the others.
+  EXPECT_EQ(num_constructed, 1);
+  EXPECT_EQ(num_opened, 1);
+  EXPECT_EQ(num_reset, 2);
+}
+
+TEST_F(CalculatorGraphPoolTest, ReconstructsNonReusableCalculators) {
+  CalculatorGraphPool::Options options;
+  options.output_streams = {"out"};
+  auto pool_or = CalculatorGraphPool::Create(
+      MakeConfig("NonReusableCountingAddCalculator"), options,
+      {{"shared", MakePacket<int>(100)}});
+  MP_ASSERT_OK(pool_or);
+  auto pool = std::move(pool_or).value();
+  EXPECT_EQ(pool->NumIdleGraphs(), 0);
+
+  for (int session = 0; session < 3; ++session) {
+    auto outputs_or = RunSession(pool.get(), session, {1});
+    MP_ASSERT_OK(outputs_or);
+    EXPECT_THAT(outputs_or.value(), ElementsAre(101 + session));
+  }
+  EXPECT_EQ(pool->NumIdleGraphs(), 1);
+  EXPECT_EQ(num_constructed, 3);
+  EXPECT_EQ(num_opened, 3);
+  EXPECT_EQ(num_reset, 0);
+}
+
+TEST_F(CalculatorGraphPoolTest, ReopensCalculatorsAfterFailedRun) {
+  CalculatorGraphPool::Options options;
+  options.output_streams = {"out"};
+  auto pool_or = CalculatorGraphPool::Create(
+      MakeConfig("CountingAddCalculator"), options,
+      {{"shared", MakePacket<int>(100)}});
+  MP_ASSERT_OK(pool_or);
+  auto pool = std::move(pool_or).value();
+
+  MP_ASSERT_OK(RunSession(pool.get(), 0, {1}));
+  EXPECT_FALSE(RunSession(pool.get(), -200, {1}).ok());
+  auto outputs_or = RunSession(pool.get(), 0, {2});
+  MP_ASSERT_OK(outputs_or);
+  EXPECT_THAT(outputs_or.value(), ElementsAre(102));
+  // The calculator that failed is dropped, and a new one is opened.
+  EXPECT_EQ(num_constructed, 2);
+  EXPECT_EQ(num_opened, 2);
+  EXPECT_EQ(num_reset, 1);
+}
+
+TEST_F(CalculatorGraphPoolTest, KeepsAtMostMaxIdleGraphs) {
+  CalculatorGraphPool::Options options;
+  options.max_idle_graphs = 2;
+  options.output_streams = {"out"};
+  auto pool_or = CalculatorGraphPool::Create(
+      MakeConfig("CountingAddCalculator"), options,
+      {{"shared", MakePacket<int>(0)}});
+  MP_ASSERT_OK(pool_or);
+  auto pool = std::move(pool_or).value();
+
+  std::vector<std::unique_ptr<CalculatorGraphPool::Instance>> instances;
+  for (int i = 0; i < 3; ++i) {
+    auto instance_or = pool->Acquire();
+    MP_ASSERT_OK(instance_or);
+    instances.push_back(std::move(instance_or).value());
+  }
+  EXPECT_EQ(pool->NumIdleGraphs(), 0);
+  for (auto& instance : instances) {
+    pool->Release(std::move(instance));
+  }
+  EXPECT_EQ(pool->NumIdleGraphs(), 2);
+}
+
+TEST_F(CalculatorGraphPoolTest, FailsOnInvalidConfig) {
+  CalculatorGraphPool::Options options;
+  EXPECT_FALSE(CalculatorGraphPool::Create(MakeConfig("NoSuchCalculator"),
+                                           options)
+                   .ok());
+}
+
+}  // namespace
+}  // namespace mediapipe
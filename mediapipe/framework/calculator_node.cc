@@ -418,12 +418,16 @@ absl::Status CalculatorNode::PrepareForRun(
   MP_RETURN_IF_ERROR(calculator_context_manager_.PrepareForRun(std::bind(
       &CalculatorNode::ConnectShardsToStreams, this, std::placeholders::_1)));
 
-  ASSIGN_OR_RETURN(
-      auto calculator_factory,
-      CalculatorBaseRegistry::CreateByNameInNamespace(
-          validated_graph_->Package(), calculator_state_->CalculatorType()));
-  calculator_ = calculator_factory->CreateCalculator(
-      calculator_context_manager_.GetDefaultCalculatorContext());
+  // A calculator kept by CleanupAfterRun() is reused.
+  if (!calculator_) {
+    ASSIGN_OR_RETURN(
+        auto calculator_factory,
+        CalculatorBaseRegistry::CreateByNameInNamespace(
+            validated_graph_->Package(), calculator_state_->CalculatorType()));
+    calculator_ = calculator_factory->CreateCalculator(
+        calculator_context_manager_.GetDefaultCalculatorContext());
+    calculator_opened_ = false;
+  }
 
   needs_to_close_ = false;
 
@@ -495,7 +499,9 @@ absl::Status CalculatorNode::OpenNode() {
   } else {
     MEDIAPIPE_PROFILING(OPEN, default_context);
     LegacyCalculatorSupport::Scoped<CalculatorContext> s(default_context);
-    result = calculator_->Open(default_context);
+    result = calculator_opened_ ? calculator_->Reset(default_context)
+                                : calculator_->Open(default_context);
+    calculator_opened_ = result.ok();
   }
 
   calculator_context_manager_.PopInputTimestampFromContext(default_context);
@@ -633,7 +639,11 @@ void CalculatorNode::CleanupAfterRun(const absl::Status& graph_status) {
         Timestamp::Done());
     CloseNode(graph_status, /*graph_run_ended=*/true).IgnoreError();
   }
-  calculator_ = nullptr;
+  if (!Contract().GetReusableAcrossRuns() || !calculator_opened_ ||
+      !graph_status.ok()) {
+    calculator_ = nullptr;
+    calculator_opened_ = false;
+  }
   // All pending output packets are automatically dropped when calculator
   // context manager destroys all calculator context objects.
   calculator_context_manager_.CleanupAfterRun();
@@ -851,11 +861,23 @@ absl::Status CalculatorNode::ProcessNode(
       const Timestamp input_timestamp = calculator_context->InputTimestamp();
       // The node is ready for Process().
       if (input_timestamp.IsAllowedInStream()) {
+        // A calculator that processes batches gets all the input timestamps
+        // of the context in a single Process() call.
+        const int batch_size =
+            Contract().GetProcessBatches()
+                ? calculator_context_manager_.NumberOfProcessTimestamps(
+                      *calculator_context)
+                : 1;
         input_stream_handler_->FinalizeInputSet(input_timestamp, inputs);
         output_stream_handler_->PrepareOutputs(input_timestamp, outputs);
+        calculator_context_manager_.SetBatchSizeInContext(calculator_context,
+                                                          batch_size);
+        const Timestamp last_timestamp =
+            calculator_context->BatchInputTimestamp(batch_size - 1);
 
         VLOG(2) << "Calling Calculator::Process() for node: " << DebugName()
-                << " timestamp: " << input_timestamp;
+                << " timestamp: " << input_timestamp
+                << " batch size: " << batch_size;
 
         if (OutputsAreConstant(calculator_context)) {
           // Do nothing.
@@ -870,9 +892,14 @@ absl::Status CalculatorNode::ProcessNode(
         VLOG(2) << "Called Calculator::Process() for node: " << DebugName()
                 << " timestamp: " << input_timestamp;
 
-        // Removes one packet from each shard and progresses to the next input
-        // timestamp.
-        input_stream_handler_->ClearCurrentInputs(calculator_context);
+        // Removes one packet from each shard per processed input timestamp
+        // and progresses to the next input timestamp.
+        calculator_context_manager_.SetBatchSizeInContext(calculator_context,
+                                                          1);
+        for (int b = 0; b < batch_size; ++b) {
+          input_stream_handler_->ClearCurrentInputs(calculator_context);
+        }
+        i += batch_size - 1;
 
         // Nodes are allowed to return StatusStop() to cause the termination
         // of the graph. This is different from an error in that it will
@@ -884,7 +911,7 @@ absl::Status CalculatorNode::ProcessNode(
                         "Calculator::Process() for node \"$0\" failed: ",
                         DebugName());
         }
-        output_stream_handler_->PostProcess(input_timestamp);
+        output_stream_handler_->PostProcess(last_timestamp);
         if (result == tool::StatusStop()) {
           return result;
         }
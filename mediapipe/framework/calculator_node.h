@@ -136,8 +136,9 @@ class CalculatorNode {
   // Called when a source node's layer becomes active.
   void ActivateNode() ABSL_LOCKS_EXCLUDED(status_mutex_);
   // Cleans up the node after the CalculatorGraph has been run. Deletes
-  // the Calculator managed by this node. graph_status is the status of
-  // the graph run.
+  // the Calculator managed by this node, unless it can be reused for the next
+  // run (see CalculatorContract::SetReusableAcrossRuns). graph_status is the
+  // status of the graph run.
   void CleanupAfterRun(const absl::Status& graph_status)
       ABSL_LOCKS_EXCLUDED(status_mutex_);
 
@@ -288,6 +289,9 @@ class CalculatorNode {
 
   // The calculator.
   std::unique_ptr<CalculatorBase> calculator_;
+  // True if calculator_ has been opened, in this or an earlier run.  Such a
+  // calculator is reset instead of opened when the node is opened.
+  bool calculator_opened_ = false;
   // Keeps data which a Calculator subclass needs access to.
   std::unique_ptr<CalculatorState> calculator_state_;
 
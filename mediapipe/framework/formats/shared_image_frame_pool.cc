@@ -0,0 +1,150 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/shared_image_frame_pool.h"
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/logging.h"
+
+namespace mediapipe {
+
+const GraphService<SharedImageFramePool> kImageFramePoolService(
+    "kImageFramePoolService");
+
+std::shared_ptr<SharedImageFramePool> SharedImageFramePool::Create(
+    int64 max_available_bytes) {
+  return std::shared_ptr<SharedImageFramePool>(
+      new SharedImageFramePool(max_available_bytes));
+}
+
+SharedImageFramePool::SharedImageFramePool(int64 max_available_bytes)
+    : max_available_bytes_(max_available_bytes) {}
+
+std::unique_ptr<ImageFrame> SharedImageFramePool::GetFrame(
+    ImageFormat::Format format, int width, int height,
+    uint32 alignment_boundary) {
+  const BufferSpec spec = {format, width, height, alignment_boundary};
+  PixelData pixel_data;
+  int width_step;
+  {
+    absl::MutexLock lock(&mutex_);
+    Bucket& bucket = GetBucket(spec);
+    bucket.last_use = ++clock_;
+    width_step = bucket.width_step;
+    ++num_allocations_;
+    if (!bucket.available.empty()) {
+      pixel_data = std::move(bucket.available.back());
+      bucket.available.pop_back();
+      available_bytes_ -= bucket.buffer_size;
+    } else {
+      ++num_misses_;
+      resident_bytes_ += bucket.buffer_size;
+    }
+  }
+  if (!pixel_data) {
+    ImageFrame frame(format, width, height, alignment_boundary);
+    DCHECK_EQ(frame.WidthStep(), width_step);
+    pixel_data = frame.Release();
+  }
+
+  // The deleter of the frame hands the pixel data back to the pool, or frees
+  // it if the pool is gone.
+  std::weak_ptr<SharedImageFramePool> weak_pool(shared_from_this());
+  ImageFrame::Deleter free_pixel_data = pixel_data.get_deleter();
+  return absl::make_unique<ImageFrame>(
+      format, width, height, width_step, pixel_data.release(),
+      [weak_pool, spec, free_pixel_data](uint8* data) {
+        PixelData pixel_data(data, free_pixel_data);
+        if (auto pool = weak_pool.lock()) {
+          pool->Return(spec, std::move(pixel_data));
+        }
+      });
+}
+
+void SharedImageFramePool::GetResourceProfile(ResourceProfile* profile) const {
+  absl::MutexLock lock(&mutex_);
+  profile->set_num_allocations(num_allocations_);
+  profile->set_num_misses(num_misses_);
+  profile->set_resident_bytes(resident_bytes_);
+}
+
+int64 SharedImageFramePool::available_bytes() const {
+  absl::MutexLock lock(&mutex_);
+  return available_bytes_;
+}
+
+SharedImageFramePool::Bucket& SharedImageFramePool::GetBucket(
+    const BufferSpec& spec) {
+  Bucket& bucket = buckets_[spec];
+  if (bucket.width_step == 0) {
+    // Same as the ImageFrame constructor.
+    bucket.width_step = spec.width *
+                        ImageFrame::NumberOfChannelsForFormat(spec.format) *
+                        ImageFrame::ByteDepthForFormat(spec.format);
+    if (spec.alignment_boundary > 1) {
+      bucket.width_step =
+          ((bucket.width_step - 1) | (spec.alignment_boundary - 1)) + 1;
+    }
+    bucket.buffer_size = static_cast<int64>(bucket.width_step) * spec.height;
+  }
+  return bucket;
+}
+
+void SharedImageFramePool::Return(const BufferSpec& spec,
+                                  PixelData pixel_data) {
+  // Declared before the lock, so that the trimmed buffers are freed without
+  // holding it.
+  std::vector<PixelData> trimmed;
+  absl::MutexLock lock(&mutex_);
+  Bucket& bucket = GetBucket(spec);
+  bucket.available.push_back(std::move(pixel_data));
+  available_bytes_ += bucket.buffer_size;
+  Trim(&trimmed);
+}
+
+void SharedImageFramePool::Trim(std::vector<PixelData>* trimmed) {
+  while (available_bytes_ > max_available_bytes_) {
+    auto lru = buckets_.end();
+    for (auto it = buckets_.begin(); it != buckets_.end(); ++it) {
+      if (it->second.available.empty()) continue;
+      if (lru == buckets_.end() ||
+          it->second.last_use < lru->second.last_use) {
+        lru = it;
+      }
+    }
+    Bucket& bucket = lru->second;
+    trimmed->push_back(std::move(bucket.available.back()));
+    bucket.available.pop_back();
+    available_bytes_ -= bucket.buffer_size;
+    resident_bytes_ -= bucket.buffer_size;
+    if (bucket.available.empty()) {
+      // Frames still in use recreate the bucket when they are returned.
+      buckets_.erase(lru);
+    }
+  }
+}
+
+std::unique_ptr<ImageFrame> NewImageFrame(
+    ServiceBinding<SharedImageFramePool> pool, ImageFormat::Format format,
+    int width, int height, uint32 alignment_boundary) {
+  if (pool.IsAvailable()) {
+    return pool.GetObject().GetFrame(format, width, height,
+                                     alignment_boundary);
+  }
+  return absl::make_unique<ImageFrame>(format, width, height,
+                                       alignment_boundary);
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,150 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_FORMATS_SHARED_IMAGE_FRAME_POOL_H_
+#define MEDIAPIPE_FRAMEWORK_FORMATS_SHARED_IMAGE_FRAME_POOL_H_
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/graph_service.h"
+#include "mediapipe/framework/port/integral_types.h"
+
+namespace mediapipe {
+
+class ResourceProfile;
+
+// A pool of ImageFrame pixel buffers of any size, shared by the CPU
+// calculators of a graph.
+//
+// Buffers are bucketed by format, width, height and alignment boundary. The
+// frames returned by GetFrame() give their buffer back to the pool when they
+// are destroyed, so that a graph processing frames of steady sizes stops
+// allocating pixel data after its first few frames, whichever calculators
+// the frames pass through. Buffers waiting for reuse are kept up to a total of
+// max_available_bytes; beyond that, the buffers of the least recently used
+// buckets are freed first.
+//
+// When it is set as the object of kImageFramePoolService, its usage is reported
+// in the GraphProfile as a ResourceProfile named after the service. This class
+// is thread-safe.
+class SharedImageFramePool
+    : public std::enable_shared_from_this<SharedImageFramePool> {
+ public:
+  static constexpr int64 kDefaultMaxAvailableBytes = 64 << 20;
+
+  static std::shared_ptr<SharedImageFramePool> Create(
+      int64 max_available_bytes = kDefaultMaxAvailableBytes);
+  SharedImageFramePool(const SharedImageFramePool&) = delete;
+  SharedImageFramePool& operator=(const SharedImageFramePool&) = delete;
+
+  // Returns a frame of the given format and size, with rows aligned as by the
+  // ImageFrame constructor. The contents of its pixels are unspecified.
+  std::unique_ptr<ImageFrame> GetFrame(
+      ImageFormat::Format format, int width, int height,
+      uint32 alignment_boundary = ImageFrame::kDefaultAlignmentBoundary)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Fills in the statistics of the pool. An allocation is a call to
+  // GetFrame(); a miss is counted whenever it could not reuse a buffer.
+  // Resident bytes include both the buffers in use and the available ones.
+  void GetResourceProfile(ResourceProfile* profile) const
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // The total size of the buffers waiting for reuse.
+  int64 available_bytes() const ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  struct BufferSpec {
+    ImageFormat::Format format;
+    int width;
+    int height;
+    uint32 alignment_boundary;
+
+    bool operator==(const BufferSpec& other) const {
+      return format == other.format && width == other.width &&
+             height == other.height &&
+             alignment_boundary == other.alignment_boundary;
+    }
+    template <typename H>
+    friend H AbslHashValue(H h, const BufferSpec& spec) {
+      return H::combine(std::move(h), spec.format, spec.width, spec.height,
+                        spec.alignment_boundary);
+    }
+  };
+
+  using PixelData = std::unique_ptr<uint8[], ImageFrame::Deleter>;
+
+  struct Bucket {
+    int width_step = 0;
+    int64 buffer_size = 0;
+    std::vector<PixelData> available;
+    // The value of clock_ when the bucket was last used.
+    int64 last_use = 0;
+  };
+
+  explicit SharedImageFramePool(int64 max_available_bytes);
+
+  // Returns the bucket of spec, creating it if needed.
+  Bucket& GetBucket(const BufferSpec& spec)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Takes back the pixel data of a destroyed frame.
+  void Return(const BufferSpec& spec, PixelData pixel_data)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+  // Moves available buffers to `trimmed`, least recently used buckets first,
+  // until at most max_available_bytes_ remain.
+  void Trim(std::vector<PixelData>* trimmed)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const int64 max_available_bytes_;
+
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_map<BufferSpec, Bucket> buckets_ ABSL_GUARDED_BY(mutex_);
+  int64 clock_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64 available_bytes_ ABSL_GUARDED_BY(mutex_) = 0;
+
+  int64 num_allocations_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64 num_misses_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64 resident_bytes_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+// Provides a SharedImageFramePool to the calculators of a graph. The service is
+// not created by default. A graph opts in by providing a pool before StartRun:
+//
+//   graph.SetServiceObject(kImageFramePoolService,
+//                          SharedImageFramePool::Create());
+//
+// Calculators use it by requesting the service in GetContract():
+//
+//   cc->UseService(kImageFramePoolService).Optional();
+//
+// and then allocating their output frames with NewImageFrame(), which falls
+// back to a new ImageFrame when the graph has no pool.
+extern const GraphService<SharedImageFramePool> kImageFramePoolService;
+
+// Returns a frame from `pool` if it is available, and a newly allocated frame
+// otherwise. The contents of its pixels are unspecified.
+std::unique_ptr<ImageFrame> NewImageFrame(
+    ServiceBinding<SharedImageFramePool> pool, ImageFormat::Format format,
+    int width, int height,
+    uint32 alignment_boundary = ImageFrame::kDefaultAlignmentBoundary);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_FORMATS_SHARED_IMAGE_FRAME_POOL_H_
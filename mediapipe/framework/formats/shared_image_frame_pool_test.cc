@@ -0,0 +1,200 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/shared_image_frame_pool.h"
+
+#include <memory>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+ResourceProfile GetProfile(const SharedImageFramePool& pool) {
+  ResourceProfile profile;
+  pool.GetResourceProfile(&profile);
+  return profile;
+}
+
+TEST(SharedImageFramePoolTest, ReusesBuffersOfTheSameSpec) {
+  auto pool = SharedImageFramePool::Create();
+  auto frame = pool->GetFrame(ImageFormat::SRGB, 10, 20);
+  EXPECT_EQ(ImageFormat::SRGB, frame->Format());
+  EXPECT_EQ(10, frame->Width());
+  EXPECT_EQ(20, frame->Height());
+  EXPECT_EQ(32, frame->WidthStep());
+  const uint8* pixel_data = frame->PixelData();
+  frame.reset();
+  EXPECT_EQ(32 * 20, pool->available_bytes());
+
+  frame = pool->GetFrame(ImageFormat::SRGB, 10, 20);
+  EXPECT_EQ(pixel_data, frame->PixelData());
+  EXPECT_EQ(0, pool->available_bytes());
+  ResourceProfile profile = GetProfile(*pool);
+  EXPECT_EQ(2, profile.num_allocations());
+  EXPECT_EQ(1, profile.num_misses());
+  EXPECT_EQ(32 * 20, profile.resident_bytes());
+}
+
+TEST(SharedImageFramePoolTest, BucketsByFormatSizeAndAlignment) {
+  auto pool = SharedImageFramePool::Create();
+  pool->GetFrame(ImageFormat::SRGB, 10, 20);
+  pool->GetFrame(ImageFormat::SRGBA, 10, 20);
+  pool->GetFrame(ImageFormat::SRGB, 20, 10);
+  pool->GetFrame(ImageFormat::SRGB, 10, 20, /*alignment_boundary=*/1);
+  EXPECT_EQ(4, GetProfile(*pool).num_misses());
+  pool->GetFrame(ImageFormat::SRGB, 10, 20, /*alignment_boundary=*/1);
+  EXPECT_EQ(4, GetProfile(*pool).num_misses());
+}
+
+TEST(SharedImageFramePoolTest, TrimsLeastRecentlyUsedBuckets) {
+  constexpr int kFrameBytes = 100 * 100;
+  auto pool = SharedImageFramePool::Create(
+      /*max_available_bytes=*/2 * kFrameBytes);
+  auto old_frame = pool->GetFrame(ImageFormat::GRAY8, 100, 100, 1);
+  auto new_frame = pool->GetFrame(ImageFormat::GRAY8, 50, 200, 1);
+  auto newest_frame = pool->GetFrame(ImageFormat::GRAY8, 200, 50, 1);
+  const uint8* new_pixel_data = new_frame->PixelData();
+  old_frame.reset();
+  new_frame.reset();
+  newest_frame.reset();
+  EXPECT_EQ(2 * kFrameBytes, pool->available_bytes());
+  EXPECT_EQ(2 * kFrameBytes, GetProfile(*pool).resident_bytes());
+
+  // The buffer of old_frame was freed; the one of new_frame is reused.
+  EXPECT_EQ(new_pixel_data,
+            pool->GetFrame(ImageFormat::GRAY8, 50, 200, 1)->PixelData());
+  EXPECT_EQ(3, GetProfile(*pool).num_misses());
+  pool->GetFrame(ImageFormat::GRAY8, 100, 100, 1);
+  EXPECT_EQ(4, GetProfile(*pool).num_misses());
+}
+
+TEST(SharedImageFramePoolTest, FramesMayOutliveThePool) {
+  auto pool = SharedImageFramePool::Create();
+  auto frame = pool->GetFrame(ImageFormat::SRGB, 10, 20);
+  pool.reset();
+  frame->SetToZero();
+}
+
+TEST(SharedImageFramePoolTest, NewImageFrameWithoutPool) {
+  auto frame = NewImageFrame(ServiceBinding<SharedImageFramePool>(),
+                             ImageFormat::SRGBA, 10, 20);
+  EXPECT_EQ(ImageFormat::SRGBA, frame->Format());
+  EXPECT_EQ(10, frame->Width());
+  EXPECT_EQ(20, frame->Height());
+}
+
+// Emits a frame of the input size for each input frame.
+class PooledFrameCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<ImageFrame>();
+    cc->Outputs().Index(0).Set<ImageFrame>();
+    cc->UseService(kImageFramePoolService).Optional();
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) final {
+    const auto& input = cc->Inputs().Index(0).Get<ImageFrame>();
+    auto output =
+        NewImageFrame(cc->Service(kImageFramePoolService), input.Format(),
+                      input.Width(), input.Height());
+    output->CopyPixelData(input.Format(), input.Width(), input.Height(),
+                          input.PixelData(),
+                          ImageFrame::kDefaultAlignmentBoundary);
+    cc->Outputs().Index(0).Add(output.release(), cc->InputTimestamp());
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(PooledFrameCalculator);
+
+TEST(SharedImageFramePoolTest, ReportsUsageInGraphProfile) {
+  auto config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "in"
+    output_stream: "out"
+    node {
+      calculator: "PooledFrameCalculator"
+      input_stream: "in"
+      output_stream: "out"
+    }
+    profiler_config { enable_profiler: true }
+  )pb");
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.SetServiceObject(kImageFramePoolService,
+                                      SharedImageFramePool::Create()));
+  MP_ASSERT_OK(graph.ObserveOutputStream(
+      "out", [](const Packet& packet) { return absl::OkStatus(); }));
+  MP_ASSERT_OK(graph.StartRun({}));
+  for (int i = 0; i < 5; ++i) {
+    auto frame = absl::make_unique<ImageFrame>(ImageFormat::SRGB, 8, 8);
+    frame->SetToZero();
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "in", Adopt(frame.release()).At(Timestamp(i))));
+    MP_ASSERT_OK(graph.WaitUntilIdle());
+  }
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  GraphProfile profile;
+  MP_ASSERT_OK(graph.profiler()->CaptureProfile(&profile));
+  const ResourceProfile* pool_profile = nullptr;
+  for (const auto& resource_profile : profile.resource_profiles()) {
+    if (resource_profile.name() == kImageFramePoolService.key) {
+      pool_profile = &resource_profile;
+    }
+  }
+  ASSERT_NE(nullptr, pool_profile);
+  EXPECT_EQ(5, pool_profile->num_allocations());
+  EXPECT_EQ(1, pool_profile->num_misses());
+}
+
+TEST(SharedImageFramePoolTest, GraphHasNoPoolByDefault) {
+  auto config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "in"
+    output_stream: "out"
+    node {
+      calculator: "PooledFrameCalculator"
+      input_stream: "in"
+      output_stream: "out"
+    }
+  )pb");
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  int num_outputs = 0;
+  MP_ASSERT_OK(graph.ObserveOutputStream("out", [&](const Packet& packet) {
+    ++num_outputs;
+    return absl::OkStatus();
+  }));
+  MP_ASSERT_OK(graph.StartRun({}));
+  auto frame = absl::make_unique<ImageFrame>(ImageFormat::SRGB, 8, 8);
+  frame->SetToZero();
+  MP_ASSERT_OK(graph.AddPacketToInputStream(
+      "in", Adopt(frame.release()).At(Timestamp(0))));
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+  EXPECT_EQ(1, num_outputs);
+  EXPECT_EQ(nullptr, graph.GetServiceObject(kImageFramePoolService));
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,285 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Microbenchmarks for the hot paths of the framework: packets, timestamps,
+// input and output stream managers, the scheduler, and full graph runs.
+//
+// The results are written to stdout as JSON unless --benchmark_format is
+// given, so that they can be collected and compared across builds:
+//
+//   bazel run -c opt //mediapipe/framework:framework_benchmark -- \
+//     --benchmark_out=/tmp/framework_benchmark.json \
+//     --benchmark_out_format=json
+
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/input_stream_handler.h"
+#include "mediapipe/framework/input_stream_manager.h"
+#include "mediapipe/framework/output_stream_manager.h"
+#include "mediapipe/framework/output_stream_shard.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/timestamp.h"
+#include "mediapipe/framework/tool/tag_map_helper.h"
+
+namespace mediapipe {
+namespace {
+
+// The number of packets sent through a graph in each benchmark iteration.
+constexpr int kPacketsPerRun = 100;
+
+void BM_MakePacket(benchmark::State& state) {
+  int64 t = 0;
+  for (auto _ : state) {
+    Packet packet = MakePacket<int>(t).At(Timestamp(t));
+    benchmark::DoNotOptimize(packet);
+    ++t;
+  }
+}
+BENCHMARK(BM_MakePacket);
+
+void BM_CopyPacket(benchmark::State& state) {
+  const Packet packet = MakePacket<std::string>("packet").At(Timestamp(0));
+  for (auto _ : state) {
+    Packet copy = packet;
+    benchmark::DoNotOptimize(copy);
+  }
+}
+BENCHMARK(BM_CopyPacket);
+
+void BM_PacketGet(benchmark::State& state) {
+  const Packet packet = MakePacket<int>(1).At(Timestamp(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(packet.Get<int>());
+  }
+}
+BENCHMARK(BM_PacketGet);
+
+void BM_TimestampArithmetic(benchmark::State& state) {
+  Timestamp timestamp(0);
+  const TimestampDiff offset(1);
+  for (auto _ : state) {
+    timestamp = (timestamp + offset).NextAllowedInStream();
+    benchmark::DoNotOptimize(timestamp < Timestamp::Max());
+    benchmark::DoNotOptimize(timestamp - Timestamp(0));
+  }
+}
+BENCHMARK(BM_TimestampArithmetic);
+
+// Adds batches of range(0) packets to an InputStreamManager and pops them.
+void BM_InputStreamManagerAddAndPop(benchmark::State& state) {
+  const int batch_size = state.range(0);
+  PacketType packet_type;
+  packet_type.Set<int>();
+  InputStreamManager manager;
+  CHECK(manager.Initialize("stream", &packet_type, false).ok());
+  manager.SetQueueSizeCallbacks([](InputStreamManager*, bool*) {},
+                                [](InputStreamManager*, bool*) {});
+  manager.PrepareForRun();
+  std::list<Packet> packets(batch_size);
+  int64 t = 0;
+  bool notify;
+  int num_packets_dropped;
+  bool stream_is_done;
+  for (auto _ : state) {
+    const int64 begin = t;
+    for (Packet& packet : packets) {
+      packet = MakePacket<int>(t).At(Timestamp(t));
+      ++t;
+    }
+    CHECK(manager.AddPackets(packets, &notify).ok());
+    for (int64 i = begin; i < t; ++i) {
+      Packet packet = manager.PopPacketAtTimestamp(
+          Timestamp(i), &num_packets_dropped, &stream_is_done);
+      benchmark::DoNotOptimize(packet);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * batch_size);
+}
+BENCHMARK(BM_InputStreamManagerAddAndPop)->Arg(1)->Arg(16);
+
+// Propagates each packet added to an OutputStreamShard to range(0) mirrors,
+// as the output stream handler does after Calculator::Process().
+void BM_OutputStreamManagerFanOut(benchmark::State& state) {
+  const int num_mirrors = state.range(0);
+  PacketType packet_type;
+  packet_type.Set<int>();
+  auto error_callback = [](absl::Status status) { CHECK_OK(status); };
+  OutputStreamManager output_stream_manager;
+  CHECK(output_stream_manager.Initialize("stream", &packet_type).ok());
+  output_stream_manager.PrepareForRun(error_callback);
+  OutputStreamShard output_stream_shard;
+  output_stream_shard.SetSpec(output_stream_manager.Spec());
+  output_stream_manager.ResetShard(&output_stream_shard);
+
+  std::shared_ptr<tool::TagMap> tag_map = tool::CreateTagMap(1).value();
+  std::vector<std::unique_ptr<InputStreamHandler>> handlers;
+  std::vector<std::unique_ptr<InputStreamManager>> managers;
+  for (int i = 0; i < num_mirrors; ++i) {
+    handlers.push_back(InputStreamHandlerRegistry::CreateByName(
+                           "DefaultInputStreamHandler", tag_map,
+                           /*cc_manager=*/nullptr, MediaPipeOptions(),
+                           /*calculator_run_in_parallel=*/false)
+                           .value());
+    managers.push_back(absl::make_unique<InputStreamManager>());
+    CHECK(managers.back()->Initialize("stream", &packet_type, false).ok());
+    CHECK(handlers.back()
+              ->InitializeInputStreamManagers(managers.back().get())
+              .ok());
+    output_stream_manager.AddMirror(handlers.back().get(), tag_map->BeginId());
+    handlers.back()->PrepareForRun(
+        []() {}, []() {}, [](CalculatorContext*) {}, error_callback);
+    handlers.back()->SetQueueSizeCallbacks(
+        [](InputStreamManager*, bool*) {}, [](InputStreamManager*, bool*) {});
+  }
+
+  int64 t = 0;
+  int num_packets_dropped;
+  bool stream_is_done;
+  for (auto _ : state) {
+    const Timestamp timestamp(t++);
+    output_stream_shard.AddPacket(MakePacket<int>(0).At(timestamp));
+    const Timestamp bound = output_stream_manager.ComputeOutputTimestampBound(
+        output_stream_shard, timestamp);
+    output_stream_manager.PropagateUpdatesToMirrors(bound,
+                                                    &output_stream_shard);
+    output_stream_manager.ResetShard(&output_stream_shard);
+    for (auto& manager : managers) {
+      Packet packet = manager->PopPacketAtTimestamp(
+          timestamp, &num_packets_dropped, &stream_is_done);
+      benchmark::DoNotOptimize(packet);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * num_mirrors);
+}
+BENCHMARK(BM_OutputStreamManagerFanOut)->Arg(1)->Arg(4)->Arg(16);
+
+// Sends kPacketsPerRun packets to the "in" stream of each graph run.
+void RunGraph(CalculatorGraph* graph) {
+  CHECK(graph->StartRun({}).ok());
+  for (int t = 0; t < kPacketsPerRun; ++t) {
+    CHECK(graph->AddPacketToInputStream("in", MakePacket<int>(t).At(
+                                                  Timestamp(t)))
+              .ok());
+  }
+  CHECK(graph->CloseAllInputStreams().ok());
+  CHECK(graph->WaitUntilDone().ok());
+}
+
+// Returns a graph with |num_nodes| PassThroughCalculators reading the "in"
+// stream, or one after the other if |chain| is true.
+CalculatorGraphConfig PassThroughGraph(int num_nodes, bool chain) {
+  CalculatorGraphConfig config;
+  config.add_input_stream("in");
+  for (int i = 0; i < num_nodes; ++i) {
+    CalculatorGraphConfig::Node* node = config.add_node();
+    node->set_calculator("PassThroughCalculator");
+    node->add_input_stream(chain && i > 0 ? absl::StrCat("s", i - 1) : "in");
+    node->add_output_stream(absl::StrCat("s", i));
+  }
+  return config;
+}
+
+void BM_PassThroughChain(benchmark::State& state) {
+  const int num_nodes = state.range(0);
+  CalculatorGraph graph;
+  CHECK(graph.Initialize(PassThroughGraph(num_nodes, /*chain=*/true)).ok());
+  for (auto _ : state) {
+    RunGraph(&graph);
+  }
+  state.SetItemsProcessed(state.iterations() * kPacketsPerRun);
+}
+BENCHMARK(BM_PassThroughChain)->Arg(1)->Arg(8)->Arg(32)->UseRealTime();
+
+void BM_PassThroughFanOut(benchmark::State& state) {
+  const int num_nodes = state.range(0);
+  CalculatorGraph graph;
+  CHECK(graph.Initialize(PassThroughGraph(num_nodes, /*chain=*/false)).ok());
+  for (auto _ : state) {
+    RunGraph(&graph);
+  }
+  state.SetItemsProcessed(state.iterations() * kPacketsPerRun);
+}
+BENCHMARK(BM_PassThroughFanOut)->Arg(1)->Arg(8)->Arg(32)->UseRealTime();
+
+// Measures the rate at which the scheduler queue dispatches Process() calls
+// to range(0) executor threads. The items of the SchedulerQueue refer to the
+// nodes of a running graph, so it is measured through a wide graph in which
+// every packet of the input stream schedules one task per node.
+void BM_SchedulerQueueThroughput(benchmark::State& state) {
+  constexpr int kNumNodes = 64;
+  CalculatorGraphConfig config = PassThroughGraph(kNumNodes, /*chain=*/false);
+  config.set_num_threads(state.range(0));
+  CalculatorGraph graph;
+  CHECK(graph.Initialize(config).ok());
+  for (auto _ : state) {
+    RunGraph(&graph);
+  }
+  state.SetItemsProcessed(state.iterations() * kPacketsPerRun * kNumNodes);
+}
+BENCHMARK(BM_SchedulerQueueThroughput)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->UseRealTime();
+
+// Runs a single calculator in isolation, as in calculator unit tests.
+void BM_CalculatorRunnerPassThrough(benchmark::State& state) {
+  for (auto _ : state) {
+    CalculatorRunner runner(R"pb(
+      calculator: "PassThroughCalculator"
+      input_stream: "in"
+      output_stream: "out"
+    )pb");
+    auto& packets = runner.MutableInputs()->Index(0).packets;
+    for (int t = 0; t < kPacketsPerRun; ++t) {
+      packets.push_back(MakePacket<int>(t).At(Timestamp(t)));
+    }
+    CHECK(runner.Run().ok());
+  }
+  state.SetItemsProcessed(state.iterations() * kPacketsPerRun);
+}
+BENCHMARK(BM_CalculatorRunnerPassThrough)->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
+
+int main(int argc, char** argv) {
+  // Defaults to JSON output, which keeps the results comparable across builds.
+  std::vector<char*> args(argv, argv + argc);
+  bool has_format = false;
+  for (int i = 1; i < argc; ++i) {
+    has_format |= absl::StartsWith(argv[i], "--benchmark_format");
+  }
+  char json_format[] = "--benchmark_format=json";
+  if (!has_format) args.push_back(json_format);
+  int num_args = args.size();
+  benchmark::Initialize(&num_args, args.data());
+  if (benchmark::ReportUnrecognizedArguments(num_args, args.data())) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
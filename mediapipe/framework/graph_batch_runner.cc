@@ -0,0 +1,243 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/graph_batch_runner.h"
+
+#include <algorithm>
+
+#include "absl/memory/memory.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/thread_pool_executor.h"
+#include "mediapipe/framework/validated_graph_config.h"
+#include "mediapipe/util/cpu_util.h"
+
+namespace mediapipe {
+
+absl::StatusOr<std::unique_ptr<GraphBatchRunner>> GraphBatchRunner::Create(
+    const CalculatorGraphConfig& config, const Options& options,
+    const std::map<std::string, Packet>& shared_side_packets) {
+  RET_CHECK_GT(options.num_graphs, 0);
+  RET_CHECK_GE(options.num_threads, 0);
+  auto runner = absl::WrapUnique(new GraphBatchRunner(options));
+  MP_RETURN_IF_ERROR(runner->Initialize(config, shared_side_packets));
+  return runner;
+}
+
+GraphBatchRunner::GraphBatchRunner(const Options& options)
+    : options_(options) {}
+
+GraphBatchRunner::~GraphBatchRunner() {
+  {
+    absl::MutexLock lock(&mutex_);
+    closed_ = true;
+    cancelled_ = true;
+    jobs_.clear();
+    outputs_.clear();
+    for (auto& instance : instances_) {
+      if (instance->running) {
+        instance->graph.Cancel();
+      }
+    }
+  }
+  // Waits for the running jobs to stop.
+  driver_pool_.reset();
+  collector_pool_.reset();
+}
+
+absl::Status GraphBatchRunner::Initialize(
+    const CalculatorGraphConfig& config,
+    const std::map<std::string, Packet>& shared_side_packets) {
+  // The config is validated and compiled once. Every instance is
+  // initialized from the compiled config, which skips subgraph expansion and
+  // the topological sort.
+  ValidatedGraphConfig validated_graph;
+  MP_RETURN_IF_ERROR(validated_graph.Initialize(config));
+  ASSIGN_OR_RETURN(CompiledGraphConfig compiled_config,
+                   validated_graph.Compile());
+
+  const int num_threads = options_.num_threads > 0 ? options_.num_threads
+                                                   : mediapipe::NumCPUCores();
+  executor_ = std::make_shared<ThreadPoolExecutor>(num_threads);
+  for (int i = 0; i < options_.num_graphs; ++i) {
+    auto instance = absl::make_unique<Instance>();
+    MP_RETURN_IF_ERROR(instance->graph.SetExecutor("", executor_));
+    MP_RETURN_IF_ERROR(
+        instance->graph.Initialize(compiled_config, shared_side_packets));
+    for (const std::string& stream_name : options_.output_streams) {
+      ASSIGN_OR_RETURN(OutputStreamPoller poller,
+                       instance->graph.AddOutputStreamPoller(stream_name));
+      if (options_.max_queued_outputs > 0) {
+        poller.SetMaxQueueSize(options_.max_queued_outputs);
+      }
+      instance->pollers.push_back(std::move(poller));
+    }
+    instances_.push_back(std::move(instance));
+  }
+
+  num_running_instances_ = options_.num_graphs;
+  driver_pool_ = absl::make_unique<ThreadPool>("batch_runner",
+                                               options_.num_graphs);
+  driver_pool_->StartWorkers();
+  // Every stream of every running job has its own collector, so that a
+  // collector never waits for a thread.
+  collector_pool_ = absl::make_unique<ThreadPool>(
+      "batch_collector",
+      std::max<int>(options_.num_graphs * options_.output_streams.size(), 1));
+  collector_pool_->StartWorkers();
+  for (auto& instance : instances_) {
+    driver_pool_->Schedule(
+        [this, instance = instance.get()] { RunJobs(instance); });
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<int64> GraphBatchRunner::AddJob(Job job) {
+  absl::MutexLock lock(&mutex_);
+  RET_CHECK(!closed_) << "No jobs can be added after Close().";
+  const int64 job_id = next_job_id_++;
+  jobs_.emplace_back(job_id, std::move(job));
+  return job_id;
+}
+
+void GraphBatchRunner::Close() {
+  absl::MutexLock lock(&mutex_);
+  closed_ = true;
+}
+
+bool GraphBatchRunner::Next(Output* output) {
+  absl::MutexLock lock(&mutex_);
+  mutex_.Await(absl::Condition(this, &GraphBatchRunner::HasOutputOrIsDone));
+  if (outputs_.empty()) {
+    return false;
+  }
+  *output = std::move(outputs_.front());
+  outputs_.pop_front();
+  return true;
+}
+
+bool GraphBatchRunner::TakeJob(int64* job_id, Job* job) {
+  absl::MutexLock lock(&mutex_);
+  mutex_.Await(absl::Condition(this, &GraphBatchRunner::HasJobOrIsClosed));
+  if (jobs_.empty()) {
+    return false;
+  }
+  *job_id = jobs_.front().first;
+  *job = std::move(jobs_.front().second);
+  jobs_.pop_front();
+  return true;
+}
+
+void GraphBatchRunner::RunJobs(Instance* instance) {
+  int64 job_id;
+  Job job;
+  while (TakeJob(&job_id, &job)) {
+    Output output;
+    output.job_id = job_id;
+    output.status = RunJob(instance, job_id, job);
+    PushOutput(std::move(output));
+  }
+  absl::MutexLock lock(&mutex_);
+  --num_running_instances_;
+}
+
+absl::Status GraphBatchRunner::RunJob(Instance* instance, int64 job_id,
+                                      const Job& job) {
+  CalculatorGraph* graph = &instance->graph;
+  MP_RETURN_IF_ERROR(graph->StartRun(job.side_packets));
+  {
+    absl::MutexLock lock(&mutex_);
+    instance->running = true;
+    if (cancelled_) {
+      graph->Cancel();
+    }
+  }
+  absl::BlockingCounter collectors_done(instance->pollers.size());
+  for (int i = 0; i < instance->pollers.size(); ++i) {
+    collector_pool_->Schedule([this, instance, i, job_id, &collectors_done] {
+      CollectOutputs(&instance->pollers[i], options_.output_streams[i],
+                     job_id);
+      collectors_done.DecrementCount();
+    });
+  }
+
+  absl::Status status = AddInputPackets(graph, job);
+  if (!status.ok()) {
+    graph->Cancel();
+  }
+  // The pollers must be drained before WaitUntilDone(), which closes them.
+  collectors_done.Wait();
+  status.Update(graph->WaitUntilDone());
+  absl::MutexLock lock(&mutex_);
+  instance->running = false;
+  return status;
+}
+
+absl::Status GraphBatchRunner::AddInputPackets(CalculatorGraph* graph,
+                                               const Job& job) {
+  // Packets are added in rounds, one packet per stream, so that a stream
+  // with many packets doesn't block the others when queues are full.
+  size_t num_rounds = 0;
+  for (const auto& stream_packets : job.input_packets) {
+    num_rounds = std::max(num_rounds, stream_packets.second.size());
+  }
+  for (size_t round = 0; round < num_rounds; ++round) {
+    for (const auto& stream_packets : job.input_packets) {
+      if (round < stream_packets.second.size()) {
+        MP_RETURN_IF_ERROR(graph->AddPacketToInputStream(
+            stream_packets.first, stream_packets.second[round]));
+      }
+    }
+  }
+  return graph->CloseAllPacketSources();
+}
+
+void GraphBatchRunner::CollectOutputs(OutputStreamPoller* poller,
+                                      const std::string& stream_name,
+                                      int64 job_id) {
+  Packet packet;
+  while (poller->Next(&packet)) {
+    Output output;
+    output.job_id = job_id;
+    output.stream_name = stream_name;
+    output.packet = std::move(packet);
+    PushOutput(std::move(output));
+  }
+}
+
+bool GraphBatchRunner::HasJobOrIsClosed() const {
+  return !jobs_.empty() || closed_;
+}
+
+bool GraphBatchRunner::HasOutputOrIsDone() const {
+  return !outputs_.empty() || num_running_instances_ == 0;
+}
+
+bool GraphBatchRunner::CanQueueOutput() const {
+  return cancelled_ ||
+         outputs_.size() < static_cast<size_t>(options_.max_queued_outputs);
+}
+
+void GraphBatchRunner::PushOutput(Output output) {
+  absl::MutexLock lock(&mutex_);
+  if (options_.max_queued_outputs > 0) {
+    mutex_.Await(absl::Condition(this, &GraphBatchRunner::CanQueueOutput));
+  }
+  if (cancelled_) {
+    return;
+  }
+  outputs_.push_back(std::move(output));
+}
+
+}  // namespace mediapipe
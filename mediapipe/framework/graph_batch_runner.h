@@ -0,0 +1,188 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Defines GraphBatchRunner, which runs many independent jobs, such as the
+// processing of a set of videos, on several instances of the same graph.
+
+#ifndef MEDIAPIPE_FRAMEWORK_GRAPH_BATCH_RUNNER_H_
+#define MEDIAPIPE_FRAMEWORK_GRAPH_BATCH_RUNNER_H_
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/executor.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mediapipe/framework/port/threadpool.h"
+
+namespace mediapipe {
+
+// Runs a queue of jobs on several instances of the same graph. Each job is
+// one run of a graph instance, and the instances run their calculators on a
+// single shared executor. This keeps all cores busy on an offline batch,
+// even though a single graph run is mostly sequential.
+//
+// The config is validated once. Side packets shared by all jobs, such as
+// models or anchors, are passed to every instance as the same packets, so
+// they are loaded once.
+//
+// Outputs are collected from OutputStreamPollers as the jobs progress, and
+// are returned by Next() in the order they were produced. The outputs of one
+// job and stream are in timestamp order. The outputs of different jobs are
+// interleaved.
+//
+// Example:
+//   GraphBatchRunner::Options options;
+//   options.num_graphs = 16;
+//   options.output_streams = {"detections"};
+//   ASSIGN_OR_RETURN(auto runner,
+//                    GraphBatchRunner::Create(config, options,
+//                                             {{"model", model_packet}}));
+//   for (const std::string& path : video_paths) {
+//     GraphBatchRunner::Job job;
+//     job.side_packets["input_video_path"] = MakePacket<std::string>(path);
+//     ASSIGN_OR_RETURN(int64 job_id, runner->AddJob(std::move(job)));
+//   }
+//   runner->Close();
+//   GraphBatchRunner::Output output;
+//   while (runner->Next(&output)) {
+//     ...
+//   }
+class GraphBatchRunner {
+ public:
+  struct Options {
+    // The number of graph instances, i.e. the number of jobs run at once.
+    int num_graphs = 1;
+    // The number of threads of the executor shared by all graph instances.
+    // If 0, uses one thread per CPU core.
+    int num_threads = 0;
+    // The graph output streams whose packets are returned by Next().
+    std::vector<std::string> output_streams;
+    // If positive, the graph instances are throttled while this many outputs
+    // are waiting to be returned by Next().
+    int max_queued_outputs = -1;
+  };
+
+  // A single run of a graph instance.
+  struct Job {
+    // Input side packets of the run, in addition to the shared ones.
+    std::map<std::string, Packet> side_packets;
+    // The packets added to each graph input stream, in order. The packets
+    // must have timestamps. All graph input streams are closed after the
+    // packets are added.
+    std::map<std::string, std::vector<Packet>> input_packets;
+  };
+
+  struct Output {
+    int64 job_id = 0;
+    // The output stream of the packet. Empty for the last output of a job,
+    // which reports the status of its run.
+    std::string stream_name;
+    Packet packet;
+    // The status of the run. Only set in the last output of a job.
+    absl::Status status;
+  };
+
+  // Creates |options.num_graphs| instances of the graph. The
+  // |shared_side_packets| are passed to all instances when they are
+  // initialized.
+  static absl::StatusOr<std::unique_ptr<GraphBatchRunner>> Create(
+      const CalculatorGraphConfig& config, const Options& options,
+      const std::map<std::string, Packet>& shared_side_packets = {});
+
+  GraphBatchRunner(const GraphBatchRunner&) = delete;
+  GraphBatchRunner& operator=(const GraphBatchRunner&) = delete;
+
+  // Cancels the running jobs, drops the queued jobs and outputs, and waits
+  // for the graph instances to stop.
+  ~GraphBatchRunner();
+
+  // Queues a job and returns its id. Jobs are started in the order they are
+  // added, as graph instances become available.
+  absl::StatusOr<int64> AddJob(Job job);
+
+  // Indicates that no more jobs will be added.
+  void Close();
+
+  // Waits for the next output of any job. Returns false once Close() has
+  // been called and all the outputs of all the jobs have been returned.
+  bool Next(Output* output);
+
+ private:
+  struct Instance {
+    CalculatorGraph graph;
+    // One for each of options_.output_streams.
+    std::vector<OutputStreamPoller> pollers;
+    // Whether a job is running on the graph. Guarded by mutex_.
+    bool running = false;
+  };
+
+  explicit GraphBatchRunner(const Options& options);
+
+  absl::Status Initialize(
+      const CalculatorGraphConfig& config,
+      const std::map<std::string, Packet>& shared_side_packets);
+
+  // Runs queued jobs on the instance until the runner is closed and there
+  // are no jobs left.
+  void RunJobs(Instance* instance);
+
+  absl::Status RunJob(Instance* instance, int64 job_id, const Job& job);
+
+  // Adds the input packets of the job, and closes the graph input streams.
+  static absl::Status AddInputPackets(CalculatorGraph* graph, const Job& job);
+
+  // Moves packets from the poller to the output queue until the stream is
+  // done.
+  void CollectOutputs(OutputStreamPoller* poller,
+                      const std::string& stream_name, int64 job_id);
+
+  // Waits for a job and takes it. Returns false if there are no more jobs.
+  bool TakeJob(int64* job_id, Job* job);
+
+  void PushOutput(Output output);
+
+  bool HasJobOrIsClosed() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  bool HasOutputOrIsDone() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  bool CanQueueOutput() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const Options options_;
+  std::shared_ptr<Executor> executor_;
+  std::vector<std::unique_ptr<Instance>> instances_;
+
+  absl::Mutex mutex_;
+  std::deque<std::pair<int64, Job>> jobs_ ABSL_GUARDED_BY(mutex_);
+  int64 next_job_id_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool closed_ ABSL_GUARDED_BY(mutex_) = false;
+  bool cancelled_ ABSL_GUARDED_BY(mutex_) = false;
+  int num_running_instances_ ABSL_GUARDED_BY(mutex_) = 0;
+  std::deque<Output> outputs_ ABSL_GUARDED_BY(mutex_);
+
+  // Runs RunJobs() once for each instance.
+  std::unique_ptr<ThreadPool> driver_pool_;
+  // Runs CollectOutputs() once for each output stream of each running job.
+  std::unique_ptr<ThreadPool> collector_pool_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_GRAPH_BATCH_RUNNER_H_
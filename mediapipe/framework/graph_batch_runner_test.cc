@@ -0,0 +1,259 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/graph_batch_runner.h"
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+using ::testing::HasSubstr;
+
+// Adds the SHARED and JOB side packets to every input packet. Fails on a
+// negative sum.
+class AddSidePacketsCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<int>();
+    cc->Outputs().Index(0).Set<int>();
+    cc->InputSidePackets().Tag("SHARED").Set<int>();
+    cc->InputSidePackets().Tag("JOB").Set<int>();
+    return absl::OkStatus();
+  }
+
+  absl::Status Open(CalculatorContext* cc) final {
+    offset_ = cc->InputSidePackets().Tag("SHARED").Get<int>() +
+              cc->InputSidePackets().Tag("JOB").Get<int>();
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) final {
+    const int sum = cc->Inputs().Index(0).Get<int>() + offset_;
+    RET_CHECK_GE(sum, 0);
+    cc->Outputs().Index(0).AddPacket(
+        MakePacket<int>(sum).At(cc->InputTimestamp()));
+    return absl::OkStatus();
+  }
+
+ private:
+  int offset_ = 0;
+};
+REGISTER_CALCULATOR(AddSidePacketsCalculator);
+
+CalculatorGraphConfig MakeConfig() {
+  return ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "in"
+    output_stream: "out"
+    input_side_packet: "shared"
+    input_side_packet: "job"
+    node {
+      calculator: "AddSidePacketsCalculator"
+      input_stream: "in"
+      output_stream: "out"
+      input_side_packet: "SHARED:shared"
+      input_side_packet: "JOB:job"
+    }
+  )pb");
+}
+
+GraphBatchRunner::Job MakeJob(int job_offset, int num_packets) {
+  GraphBatchRunner::Job job;
+  job.side_packets["job"] = MakePacket<int>(job_offset);
+  for (int i = 0; i < num_packets; ++i) {
+    job.input_packets["in"].push_back(MakePacket<int>(i).At(Timestamp(i)));
+  }
+  return job;
+}
+
+// The outputs of one job.
+struct JobOutputs {
+  std::vector<int> values;
+  std::vector<Timestamp> timestamps;
+  int num_statuses = 0;
+  absl::Status status;
+};
+
+std::map<int64, JobOutputs> CollectOutputs(GraphBatchRunner* runner) {
+  std::map<int64, JobOutputs> outputs;
+  GraphBatchRunner::Output output;
+  while (runner->Next(&output)) {
+    JobOutputs& job_outputs = outputs[output.job_id];
+    if (output.stream_name.empty()) {
+      ++job_outputs.num_statuses;
+      job_outputs.status = output.status;
+    } else {
+      EXPECT_EQ("out", output.stream_name);
+      EXPECT_EQ(0, job_outputs.num_statuses);
+      job_outputs.values.push_back(output.packet.Get<int>());
+      job_outputs.timestamps.push_back(output.packet.Timestamp());
+    }
+  }
+  return outputs;
+}
+
+TEST(GraphBatchRunnerTest, RunsJobsOnSeveralGraphs) {
+  GraphBatchRunner::Options options;
+  options.num_graphs = 3;
+  options.num_threads = 2;
+  options.output_streams = {"out"};
+  auto status_or_runner = GraphBatchRunner::Create(
+      MakeConfig(), options, {{"shared", MakePacket<int>(100)}});
+  MP_ASSERT_OK(status_or_runner);
+  std::unique_ptr<GraphBatchRunner> runner =
+      std::move(status_or_runner).value();
+  constexpr int kNumJobs = 10;
+  constexpr int kNumPackets = 20;
+  std::vector<int64> job_ids;
+  for (int i = 0; i < kNumJobs; ++i) {
+    absl::StatusOr<int64> job_id =
+        runner->AddJob(MakeJob(i * 1000, kNumPackets));
+    MP_ASSERT_OK(job_id);
+    job_ids.push_back(*job_id);
+  }
+  runner->Close();
+
+  std::map<int64, JobOutputs> outputs = CollectOutputs(runner.get());
+  ASSERT_EQ(kNumJobs, outputs.size());
+  for (int i = 0; i < kNumJobs; ++i) {
+    const JobOutputs& job_outputs = outputs[job_ids[i]];
+    MP_EXPECT_OK(job_outputs.status);
+    EXPECT_EQ(1, job_outputs.num_statuses);
+    std::vector<int> expected_values;
+    std::vector<Timestamp> expected_timestamps;
+    for (int j = 0; j < kNumPackets; ++j) {
+      expected_values.push_back(100 + i * 1000 + j);
+      expected_timestamps.push_back(Timestamp(j));
+    }
+    EXPECT_THAT(job_outputs.values, ElementsAreArray(expected_values));
+    EXPECT_THAT(job_outputs.timestamps, ElementsAreArray(expected_timestamps));
+  }
+}
+
+TEST(GraphBatchRunnerTest, ThrottlesOnQueuedOutputs) {
+  GraphBatchRunner::Options options;
+  options.num_graphs = 2;
+  options.output_streams = {"out"};
+  options.max_queued_outputs = 1;
+  auto status_or_runner = GraphBatchRunner::Create(
+      MakeConfig(), options, {{"shared", MakePacket<int>(0)}});
+  MP_ASSERT_OK(status_or_runner);
+  std::unique_ptr<GraphBatchRunner> runner =
+      std::move(status_or_runner).value();
+  for (int i = 0; i < 4; ++i) {
+    MP_ASSERT_OK(runner->AddJob(MakeJob(0, 50)).status());
+  }
+  runner->Close();
+  std::map<int64, JobOutputs> outputs = CollectOutputs(runner.get());
+  ASSERT_EQ(4, outputs.size());
+  for (const auto& job_outputs : outputs) {
+    MP_EXPECT_OK(job_outputs.second.status);
+    EXPECT_EQ(50, job_outputs.second.values.size());
+  }
+}
+
+TEST(GraphBatchRunnerTest, ReportsFailedJobs) {
+  GraphBatchRunner::Options options;
+  options.num_graphs = 2;
+  options.output_streams = {"out"};
+  auto status_or_runner = GraphBatchRunner::Create(
+      MakeConfig(), options, {{"shared", MakePacket<int>(0)}});
+  MP_ASSERT_OK(status_or_runner);
+  std::unique_ptr<GraphBatchRunner> runner =
+      std::move(status_or_runner).value();
+  absl::StatusOr<int64> failed_job_id = runner->AddJob(MakeJob(-5, 10));
+  MP_ASSERT_OK(failed_job_id);
+  GraphBatchRunner::Job job_without_side_packet = MakeJob(0, 10);
+  job_without_side_packet.side_packets.clear();
+  absl::StatusOr<int64> unstarted_job_id =
+      runner->AddJob(std::move(job_without_side_packet));
+  MP_ASSERT_OK(unstarted_job_id);
+  absl::StatusOr<int64> job_id = runner->AddJob(MakeJob(0, 3));
+  MP_ASSERT_OK(job_id);
+  runner->Close();
+  EXPECT_FALSE(runner->AddJob(MakeJob(0, 3)).ok());
+
+  std::map<int64, JobOutputs> outputs = CollectOutputs(runner.get());
+  ASSERT_EQ(3, outputs.size());
+  EXPECT_THAT(outputs[*failed_job_id].status.ToString(),
+              HasSubstr("(sum)>=(0)"));
+  EXPECT_FALSE(outputs[*unstarted_job_id].status.ok());
+  EXPECT_TRUE(outputs[*unstarted_job_id].values.empty());
+  MP_EXPECT_OK(outputs[*job_id].status);
+  EXPECT_THAT(outputs[*job_id].values, ElementsAre(0, 1, 2));
+}
+
+TEST(GraphBatchRunnerTest, FailsOnUnknownOutputStream) {
+  GraphBatchRunner::Options options;
+  options.output_streams = {"unknown"};
+  EXPECT_FALSE(GraphBatchRunner::Create(MakeConfig(), options,
+                                        {{"shared", MakePacket<int>(0)}})
+                   .ok());
+}
+
+TEST(GraphBatchRunnerTest, DestructorCancelsJobs) {
+  GraphBatchRunner::Options options;
+  options.num_graphs = 2;
+  options.output_streams = {"out"};
+  options.max_queued_outputs = 1;
+  auto status_or_runner = GraphBatchRunner::Create(
+      MakeConfig(), options, {{"shared", MakePacket<int>(0)}});
+  MP_ASSERT_OK(status_or_runner);
+  std::unique_ptr<GraphBatchRunner> runner =
+      std::move(status_or_runner).value();
+  for (int i = 0; i < 4; ++i) {
+    MP_ASSERT_OK(runner->AddJob(MakeJob(0, 1000)).status());
+  }
+  GraphBatchRunner::Output output;
+  ASSERT_TRUE(runner->Next(&output));
+  // Destroys the runner while the jobs are blocked on the full output queue.
+  runner.reset();
+}
+
+// Runs 32 jobs of 100 packets on range(0) graph instances.
+void BM_GraphBatchRunner(benchmark::State& state) {
+  GraphBatchRunner::Options options;
+  options.num_graphs = state.range(0);
+  options.output_streams = {"out"};
+  for (auto _ : state) {
+    auto runner = GraphBatchRunner::Create(MakeConfig(), options,
+                                           {{"shared", MakePacket<int>(0)}});
+    CHECK(runner.ok());
+    for (int i = 0; i < 32; ++i) {
+      CHECK((*runner)->AddJob(MakeJob(0, 100)).ok());
+    }
+    (*runner)->Close();
+    GraphBatchRunner::Output output;
+    while ((*runner)->Next(&output)) {
+      CHECK(output.status.ok());
+    }
+  }
+}
+BENCHMARK(BM_GraphBatchRunner)->Arg(1)->Arg(4)->Arg(16);
+
+}  // namespace
+}  // namespace mediapipe
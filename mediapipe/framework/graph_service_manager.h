@@ -27,7 +27,7 @@ class GraphServiceManager {
     return p.Get<std::shared_ptr<T>>();
   }
 
-  const std::map<std::string, Packet>& ServicePackets() {
+  const std::map<std::string, Packet>& ServicePackets() const {
     return service_packets_;
   }
 
@@ -161,6 +161,16 @@ bool InputStreamHandler::ScheduleInvocations(int max_allowance,
     // Sets *input_bound iff the latest node readiness is kNotReady before the
     // function returns regardless of how many invocations have been scheduled.
     if (node_readiness == NodeReadiness::kNotReady) {
+      if (schedule_incomplete_batches_ &&
+          calculator_context_manager_->ContextHasInputTimestamp(
+              *calculator_context_manager_->GetDefaultCalculatorContext())) {
+        // Schedules the input sets collected so far. input_bound is left
+        // unset, as for any scheduled invocation.
+        schedule_callback_(
+            calculator_context_manager_->GetDefaultCalculatorContext());
+        ++invocations_scheduled;
+        break;
+      }
       if (batch_size_ > 1 &&
           calculator_context_manager_->ContextHasInputTimestamp(
               *calculator_context_manager_->GetDefaultCalculatorContext())) {
@@ -237,6 +237,13 @@ class InputStreamHandler {
   // Batching cannot be combined with late_preparation_ behavior.
   void SetBatchSize(int batch_size);
 
+  // Subclasses can schedule an incomplete batch as soon as no more input sets
+  // are ready, instead of waiting for the batch to be complete or for the
+  // node to be closed. This bounds the latency added by batching.
+  void SetScheduleIncompleteBatches(bool schedule_incomplete_batches) {
+    schedule_incomplete_batches_ = schedule_incomplete_batches;
+  }
+
   // Subclasses can enable late preparation; however it cannot be used along
   // with batching.
   void SetLatePreparation(bool late_preparation);
@@ -300,6 +307,9 @@ class InputStreamHandler {
   // CalculatorNode is scheduled.
   int batch_size_ = 1;
 
+  // Whether an incomplete batch is scheduled when the node is not ready.
+  bool schedule_incomplete_batches_ = false;
+
   // When true, any increase in timestamp bound invokes Calculator::Process.
   bool process_timestamps_ = false;
 
@@ -49,6 +49,7 @@ void InputStreamManager::SetQueueSizeCallbacks(
 void InputStreamManager::PrepareForRun() {
   absl::MutexLock stream_lock(&stream_mutex_);
   queue_.clear();
+  UpdateQueueSize();
   last_reported_stream_full_ = false;
   num_packets_added_ = 0;
   next_timestamp_bound_ = Timestamp::PreStream();
@@ -58,8 +59,7 @@ void InputStreamManager::PrepareForRun() {
 }
 
 bool InputStreamManager::IsEmpty() const {
-  absl::MutexLock stream_lock(&stream_mutex_);
-  return queue_.empty();
+  return queue_size_.load(std::memory_order_acquire) == 0;
 }
 
 Packet InputStreamManager::QueueHead() const {
@@ -157,10 +157,11 @@ absl::Status InputStreamManager::AddOrMovePacketsInternal(Container container,
               << " has added packet at time: " << packet.Timestamp();
       if (std::is_const<
               typename std::remove_reference<Container>::type>::value) {
-        queue_.emplace_back(packet);
+        queue_.push_back(packet);
       } else {
-        queue_.emplace_back(std::move(packet));
+        queue_.push_back(std::move(packet));
       }
+      UpdateQueueSize();
     }
     queue_became_full = (!was_queue_full && max_queue_size_ != -1 &&
                          queue_.size() >= max_queue_size_);
@@ -278,6 +279,7 @@ Packet InputStreamManager::PopPacketAtTimestamp(Timestamp timestamp,
       current_timestamp = packet.Timestamp();
       ++(*num_packets_dropped);
     }
+    UpdateQueueSize();
     // Clear value_ if it doesn't have exactly the right timestamp.
     if (current_timestamp != timestamp) {
       // The timestamp bound reported when no packet is sent.
@@ -315,6 +317,7 @@ Packet InputStreamManager::PopQueueHead(bool* stream_is_done) {
     if (!queue_.empty()) {
       packet = std::move(queue_.front());
       queue_.pop_front();
+      UpdateQueueSize();
     } else {
       packet = Packet();
     }
@@ -337,8 +340,7 @@ int InputStreamManager::NumPacketsAdded() const {
 }
 
 int InputStreamManager::QueueSize() const {
-  absl::MutexLock lock(&stream_mutex_);
-  return static_cast<int>(queue_.size());
+  return queue_size_.load(std::memory_order_acquire);
 }
 
 int InputStreamManager::MaxQueueSize() const {
@@ -376,7 +378,8 @@ Timestamp InputStreamManager::GetMinTimestampAmongNLatest(int n) const {
   if (queue_.empty()) {
     return Timestamp::Unset();
   }
-  return (queue_.cend() - std::min((size_t)n, queue_.size()))->Timestamp();
+  return queue_[queue_.size() - std::min((size_t)n, queue_.size())]
+      .Timestamp();
 }
 
 void InputStreamManager::ErasePacketsEarlierThan(Timestamp timestamp) {
@@ -390,6 +393,7 @@ void InputStreamManager::ErasePacketsEarlierThan(Timestamp timestamp) {
     while (!queue_.empty() && queue_.front().Timestamp() < timestamp) {
       queue_.pop_front();
     }
+    UpdateQueueSize();
 
     VLOG(3) << "Input stream removed packets:" << name_
             << " Size:" << queue_.size();
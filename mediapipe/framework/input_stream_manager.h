@@ -15,7 +15,7 @@
 #ifndef MEDIAPIPE_FRAMEWORK_INPUT_STREAM_MANAGER_H_
 #define MEDIAPIPE_FRAMEWORK_INPUT_STREAM_MANAGER_H_
 
-#include <deque>
+#include <atomic>
 #include <functional>
 #include <list>
 #include <string>
@@ -23,6 +23,7 @@
 #include "absl/base/thread_annotations.h"
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/packet_queue.h"
 #include "mediapipe/framework/packet_type.h"
 #include "mediapipe/framework/port.h"
 #include "mediapipe/framework/port/integral_types.h"
@@ -117,8 +118,8 @@ class InputStreamManager {
   // Turns off the use of packet timestamps.
   void DisableTimestamps();
 
-  // Returns true iff the queue is empty.
-  bool IsEmpty() const ABSL_LOCKS_EXCLUDED(stream_mutex_);
+  // Returns true iff the queue is empty. Does not acquire stream_mutex_.
+  bool IsEmpty() const;
 
   // If the queue is not empty, returns the packet at the front of the queue.
   // Otherwise, returns an empty packet.
@@ -145,8 +146,10 @@ class InputStreamManager {
   // Returns the number of packets in the queue.
   int NumPacketsAdded() const ABSL_LOCKS_EXCLUDED(stream_mutex_);
 
-  // Returns the number of packets in the queue.
-  int QueueSize() const ABSL_LOCKS_EXCLUDED(stream_mutex_);
+  // Returns the number of packets in the queue. Does not acquire
+  // stream_mutex_, so the result may be stale by the time it is used, exactly
+  // as if the lock had been released before returning.
+  int QueueSize() const;
 
   // Returns true iff the queue is full.
   bool IsFull() const ABSL_LOCKS_EXCLUDED(stream_mutex_);
@@ -195,8 +198,17 @@ class InputStreamManager {
   // Returns the smallest timestamp at which this stream might see an input.
   Timestamp MinTimestampOrBoundHelper() const;
 
+  // Publishes the size of queue_ to queue_size_. Must be called after every
+  // change to queue_, before stream_mutex_ is released.
+  void UpdateQueueSize() ABSL_EXCLUSIVE_LOCKS_REQUIRED(stream_mutex_) {
+    queue_size_.store(static_cast<int>(queue_.size()),
+                      std::memory_order_release);
+  }
+
   mutable absl::Mutex stream_mutex_;
-  std::deque<Packet> queue_ ABSL_GUARDED_BY(stream_mutex_);
+  internal::PacketQueue queue_ ABSL_GUARDED_BY(stream_mutex_);
+  // A copy of queue_.size() that can be read without holding stream_mutex_.
+  std::atomic<int> queue_size_{0};
   // The number of packets added to queue_.  Used to verify a packet at
   // Timestamp::PostStream() is the only Packet in the stream.
   int64 num_packets_added_ ABSL_GUARDED_BY(stream_mutex_);
@@ -15,11 +15,15 @@
 #include "mediapipe/framework/input_stream_manager.h"
 
 #include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
 
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 #include "mediapipe/framework/input_stream_shard.h"
 #include "mediapipe/framework/lifetime_tracker.h"
 #include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/benchmark.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
 #include "mediapipe/framework/port/status_matchers.h"
@@ -924,5 +928,89 @@ TEST_F(InputStreamManagerTest, BackwardsInTimeUntimed) {
   EXPECT_TRUE(notify_);
 }
 
+// Interleaves adds and pops so that the packet queue wraps around its
+// circular buffer and grows while wrapped.
+TEST_F(InputStreamManagerTest, InterleavedAddAndPopWrapAround) {
+  int next_to_add = 0;
+  int next_to_pop = 0;
+  for (int round = 0; round < 20; ++round) {
+    std::list<Packet> packets;
+    for (int i = 0; i < round + 3; ++i, ++next_to_add) {
+      packets.push_back(MakePacket<std::string>(absl::StrCat(next_to_add))
+                            .At(Timestamp(next_to_add)));
+    }
+    MP_ASSERT_OK(input_stream_manager_->AddPackets(packets, &notify_));
+    EXPECT_EQ(next_to_add - next_to_pop, input_stream_manager_->QueueSize());
+    EXPECT_EQ(Timestamp(next_to_add - 1),
+              input_stream_manager_->GetMinTimestampAmongNLatest(1));
+    for (int i = 0; i < round + 1; ++i, ++next_to_pop) {
+      popped_packet_ = input_stream_manager_->PopPacketAtTimestamp(
+          Timestamp(next_to_pop), &num_packets_dropped_, &stream_is_done_);
+      EXPECT_EQ(0, num_packets_dropped_);
+      EXPECT_EQ(absl::StrCat(next_to_pop), popped_packet_.Get<std::string>());
+    }
+    EXPECT_EQ(Timestamp(next_to_pop),
+              input_stream_manager_->QueueHead().Timestamp());
+  }
+  EXPECT_EQ(next_to_add - next_to_pop, input_stream_manager_->QueueSize());
+  EXPECT_FALSE(input_stream_manager_->IsEmpty());
+  input_stream_manager_->PrepareForRun();
+  EXPECT_TRUE(input_stream_manager_->IsEmpty());
+  EXPECT_EQ(0, input_stream_manager_->QueueSize());
+}
+
+// Measures packets/sec through range(0) input streams, each with one producer
+// thread calling AddPackets and one consumer thread calling
+// PopPacketAtTimestamp, as an output stream and a node do in a running graph.
+void BM_AddAndPopPackets(benchmark::State& state) {
+  const int num_streams = state.range(0);
+  const int kPacketsPerStream = 10000;
+  PacketType packet_type;
+  packet_type.Set<int>();
+  std::vector<std::unique_ptr<InputStreamManager>> streams;
+  for (int i = 0; i < num_streams; ++i) {
+    streams.push_back(absl::make_unique<InputStreamManager>());
+    CHECK(streams.back()->Initialize("stream", &packet_type, false).ok());
+    streams.back()->SetQueueSizeCallbacks([](InputStreamManager*, bool*) {},
+                                          [](InputStreamManager*, bool*) {});
+  }
+  for (auto _ : state) {
+    std::vector<std::thread> threads;
+    for (auto& stream : streams) {
+      stream->PrepareForRun();
+      InputStreamManager* manager = stream.get();
+      threads.emplace_back([manager]() {
+        std::list<Packet> packets(1);
+        bool notify;
+        for (int t = 0; t < kPacketsPerStream; ++t) {
+          packets.front() = MakePacket<int>(t).At(Timestamp(t));
+          CHECK(manager->AddPackets(packets, &notify).ok());
+        }
+      });
+      threads.emplace_back([manager]() {
+        int num_packets_dropped;
+        bool stream_is_done;
+        for (int t = 0; t < kPacketsPerStream;) {
+          if (manager->IsEmpty()) {
+            std::this_thread::yield();
+            continue;
+          }
+          Packet packet = manager->PopPacketAtTimestamp(
+              Timestamp(t), &num_packets_dropped, &stream_is_done);
+          benchmark::DoNotOptimize(packet);
+          ++t;
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * num_streams *
+                          kPacketsPerStream);
+}
+
+BENCHMARK(BM_AddAndPopPackets)->Arg(1)->Arg(4)->Arg(16)->UseRealTime();
+
 }  // namespace
 }  // namespace mediapipe
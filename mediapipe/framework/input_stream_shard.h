@@ -15,7 +15,7 @@
 #ifndef MEDIAPIPE_FRAMEWORK_INPUT_STREAM_SHARD_H_
 #define MEDIAPIPE_FRAMEWORK_INPUT_STREAM_SHARD_H_
 
-#include <queue>
+#include <deque>
 #include <string>
 #include <utility>
 
@@ -27,6 +27,8 @@ namespace mediapipe {
 // For testing
 class MediaPipeProfilerTestPeer;
 
+class FusedCalculator;
+
 // InputStreamShard, a subclass of InputStream, holds a header packet, a FIFO
 // queue of input packets, and a bool variable to indicate if the stream is
 // completely done. Each call to Calculator::Open(), Calculator::Process(), and
@@ -51,6 +53,13 @@ class InputStreamShard : public InputStream {
     return !packet_queue_.empty() ? packet_queue_.front() : empty_packet_;
   }
 
+  // Returns the packet of the |index|-th input timestamp of a batch (see
+  // CalculatorContext::BatchSize()), or an empty packet if there is no packet
+  // at that timestamp. BatchValue(0) is the same as Value().
+  const Packet& BatchValue(int index) const {
+    return index < packet_queue_.size() ? packet_queue_[index] : empty_packet_;
+  }
+
   // Returns a reference to the name string of the InputStreamManager.
   const std::string& Name() const { return *name_; }
 
@@ -63,7 +72,7 @@ class InputStreamShard : public InputStream {
 
   void ClearCurrentPacket() {
     if (!packet_queue_.empty()) {
-      packet_queue_.pop();
+      packet_queue_.pop_front();
     }
   }
 
@@ -72,7 +81,7 @@ class InputStreamShard : public InputStream {
   void AddPacket(Packet&& value, bool is_done);
 
   // Packet storage for batch processing.
-  std::queue<Packet> packet_queue_;
+  std::deque<Packet> packet_queue_;
   Packet empty_packet_;
 
   // Pointer to the name string of the InputStreamManager.
@@ -81,6 +90,8 @@ class InputStreamShard : public InputStream {
 
   // Accesses InputStreamShard for setting data.
   friend class InputStreamHandler;
+  // Accesses InputStreamShard for setting the data of fused nodes.
+  friend class FusedCalculator;
 };
 
 }  // namespace mediapipe
@@ -26,6 +26,7 @@
 
 namespace mediapipe {
 
+class FusedCalculator;
 class OutputStreamManager;
 
 // The output stream spec shared across all output stream shards and their
@@ -129,6 +130,8 @@ class OutputStreamShard : public OutputStream {
   friend class GraphTracer;
   // Accesses OutputStreamShard for post processing.
   friend class OutputStreamManager;
+  // Accesses OutputStreamShard for forwarding the outputs of fused nodes.
+  friend class FusedCalculator;
 };
 
 }  // namespace mediapipe
@@ -46,6 +46,22 @@ class Packet;
 
 namespace packet_internal {
 class HolderBase;
+template <typename T>
+class InlineHolder;
+
+// The largest payload that MakePacket constructs inside its holder.
+constexpr std::size_t kMaxInlinePayloadSize = 256;
+
+// Whether MakePacket<T> constructs the payload inside the holder, sharing a
+// single allocation with the holder and the reference count. Consume() has to
+// move such a payload out, so this is limited to small types with a
+// non-throwing move constructor. Types whose move falls back to a copy
+// constructor, and large types, are allocated separately, and Consume()
+// releases them without moving or copying.
+template <typename T>
+constexpr bool kUseInlinePayload =
+    !std::is_array<T>::value && std::is_nothrow_move_constructible<T>::value &&
+    sizeof(T) <= kMaxInlinePayloadSize;
 
 Packet Create(HolderBase* holder);
 Packet Create(HolderBase* holder, Timestamp timestamp);
@@ -61,7 +77,8 @@ absl::StatusOr<Packet> PacketFromDynamicProto(const std::string& type_name,
 // the data is specified when accessing the data (using Packet::Get<T>()).
 //
 // The Packet is implemented as a reference-counted pointer.  This means
-// that copying Packets creates a fast, shallow copy.  Packets are
+// that copying Packets creates a fast, shallow copy, which costs a single
+// atomic increment.  Packets are
 // copyable, movable, and assignable.  Packets can be stored in STL
 // containers.  A Packet may optionally contain a timestamp.
 //
@@ -120,6 +137,10 @@ class Packet {
   // method returns error when the packet can't be consumed or copied. If
   // was_copied is not nullptr, it is set to indicate whether the packet
   // data was copied.
+  // A small payload created by MakePacket lives inside the packet's holder
+  // (see packet_internal::kUseInlinePayload). Consuming it allocates a new T
+  // and moves the payload into it with T's move constructor, which counts as
+  // consuming, not copying.
   // Packet is thread-compatible, therefore Packet::ConsumeOrCopy()
   // must be thread-compatible: clients who use this function are
   // responsible for ensuring that no other thread is doing anything
@@ -303,12 +324,23 @@ Packet AdoptAsSyncedPacket(const T* ptr) {
 // provided arguments. Similar to MakeUnique. Especially convenient for arrays,
 // since it ensures the packet gets the right type (see below).
 //
-// Version for scalars.
+// Version for scalars. If T is small and nothrow move-constructible, the
+// payload is constructed inside the holder, and the holder shares its
+// allocation with the reference count, so the packet costs a single heap
+// allocation. Consume() then moves the payload out of the holder instead of
+// transferring the pointer.
 template <typename T,
           typename std::enable_if<!std::is_array<T>::value>::type* = nullptr,
           typename... Args>
 Packet MakePacket(Args&&... args) {  // NOLINT(build/c++11)
-  return Adopt(new T(std::forward<Args>(args)...));
+  if constexpr (packet_internal::kUseInlinePayload<T>) {
+    return packet_internal::Create(
+        std::make_shared<packet_internal::InlineHolder<T>>(
+            std::forward<Args>(args)...),
+        Timestamp::Unset());
+  } else {
+    return Adopt(new T(std::forward<Args>(args)...));
+  }
 }
 
 // Version for arrays. We have to use reinterpret_cast because new T[N]
@@ -393,6 +425,10 @@ class HolderBase {
   GetVectorOfProtoMessageLite() const = 0;
 
   virtual bool HasForeignOwner() const { return false; }
+
+  // Returns true if the payload is stored inside the holder object, rather
+  // than in a separate allocation owned by the holder.
+  virtual bool HasInlinePayload() const { return false; }
 };
 
 // Two helper functions to get the proto base pointers.
@@ -518,6 +554,14 @@ class Holder : public HolderBase {
       return InternalError(
           "Foreign holder can't release data ptr without ownership.");
     }
+    if (HasInlinePayload()) {
+      // The payload lives inside this holder, so it can only be moved out.
+      if constexpr (kUseInlinePayload<U>) {
+        return absl::make_unique<T>(std::move(*const_cast<T*>(ptr_)));
+      } else {
+        return InternalError("Inline payload can't be moved out.");
+      }
+    }
     // Casts away constness to make the data mutable after the release.
     std::unique_ptr<T> data_ptr(const_cast<T*>(ptr_));
     ptr_ = nullptr;
@@ -593,6 +637,28 @@ class ForeignHolder : public Holder<T> {
   bool HasForeignOwner() const final { return true; }
 };
 
+// Like Holder, but constructs the payload inside the holder object instead of
+// adopting a separately allocated one. Created with std::make_shared, the
+// reference count, the holder and the payload share a single allocation.
+template <typename T>
+class InlineHolder : public Holder<T> {
+ public:
+  template <typename... Args>
+  explicit InlineHolder(Args&&... args)
+      : Holder<T>(nullptr), payload_(std::forward<Args>(args)...) {
+    this->ptr_ = &payload_;
+  }
+  ~InlineHolder() override {
+    // Null out ptr_ so it doesn't get deleted by ~Holder. payload_ is
+    // destroyed as a member.
+    this->ptr_ = nullptr;
+  }
+  bool HasInlinePayload() const final { return true; }
+
+ private:
+  T payload_;
+};
+
 template <typename T>
 Holder<T>* HolderBase::As() {
   if (PayloadIsOfType<T>()) {
@@ -762,13 +828,18 @@ inline Timestamp Packet::Timestamp() const { return timestamp_; }
 template <typename T>
 Packet Adopt(const T* ptr) {
   CHECK(ptr != nullptr);
-  return packet_internal::Create(new packet_internal::Holder<T>(ptr));
+  // make_shared places the reference count in the same allocation as the
+  // holder.
+  return packet_internal::Create(
+      std::make_shared<packet_internal::Holder<T>>(ptr), Timestamp::Unset());
 }
 
 template <typename T>
 Packet PointToForeign(const T* ptr) {
   CHECK(ptr != nullptr);
-  return packet_internal::Create(new packet_internal::ForeignHolder<T>(ptr));
+  return packet_internal::Create(
+      std::make_shared<packet_internal::ForeignHolder<T>>(ptr),
+      Timestamp::Unset());
 }
 
 // Equal Packets refer to the same memory contents, like equal pointers.
@@ -0,0 +1,111 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Counts the heap allocations of packet operations. This test replaces the
+// global operator new and delete, so it is kept apart from packet_test.
+
+#include <cstdlib>
+#include <new>
+
+#include "mediapipe/framework/formats/detection.pb.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/integral_types.h"
+
+namespace {
+// The number of calls to the global operator new on the current thread.
+thread_local int64 num_allocations = 0;
+}  // namespace
+
+void* operator new(std::size_t size) {
+  ++num_allocations;
+  void* ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) std::abort();
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+namespace mediapipe {
+namespace {
+
+TEST(PacketAllocationTest, MakePacketAllocatesOnce) {
+  int64 start = num_allocations;
+  Packet packet = MakePacket<int>(7);
+  EXPECT_EQ(1, num_allocations - start);
+
+  // Copies and timestamped copies share the holder.
+  start = num_allocations;
+  Packet copy = packet.At(Timestamp(1));
+  Packet copy_of_copy = copy;
+  EXPECT_EQ(0, num_allocations - start);
+  EXPECT_EQ(packet, copy_of_copy);
+  EXPECT_EQ(7, copy_of_copy.Get<int>());
+}
+
+TEST(PacketAllocationTest, AdoptAllocatesHolderWithReferenceCount) {
+  int* data = new int(7);
+  int64 start = num_allocations;
+  Packet packet = Adopt(data);
+  EXPECT_EQ(1, num_allocations - start);
+  EXPECT_EQ(data, &packet.Get<int>());
+}
+
+// Measures the cost of creating a packet with a small proto payload, and
+// reports the number of heap allocations per packet.
+void BM_MakeDetectionPacket(benchmark::State& state) {
+  Detection detection;
+  detection.add_score(0.5f);
+  int64 start = num_allocations;
+  for (auto _ : state) {
+    Packet packet = MakePacket<Detection>(detection).At(Timestamp(1));
+    benchmark::DoNotOptimize(packet);
+  }
+  state.counters["allocations_per_packet"] =
+      static_cast<double>(num_allocations - start) / state.iterations();
+}
+BENCHMARK(BM_MakeDetectionPacket);
+
+// Same as above, for a packet adopting a separately allocated payload.
+void BM_AdoptDetectionPacket(benchmark::State& state) {
+  Detection detection;
+  detection.add_score(0.5f);
+  int64 start = num_allocations;
+  for (auto _ : state) {
+    Packet packet = Adopt(new Detection(detection)).At(Timestamp(1));
+    benchmark::DoNotOptimize(packet);
+  }
+  state.counters["allocations_per_packet"] =
+      static_cast<double>(num_allocations - start) / state.iterations();
+}
+BENCHMARK(BM_AdoptDetectionPacket);
+
+// Measures the cost of copying a packet to a new timestamp, as done when a
+// packet is fanned out to several input streams.
+void BM_PacketAt(benchmark::State& state) {
+  Packet packet = MakePacket<int>(7);
+  int64 start = num_allocations;
+  int64 t = 0;
+  for (auto _ : state) {
+    Packet copy = packet.At(Timestamp(++t));
+    benchmark::DoNotOptimize(copy);
+  }
+  state.counters["allocations_per_packet"] =
+      static_cast<double>(num_allocations - start) / state.iterations();
+}
+BENCHMARK(BM_PacketAt);
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,192 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/packet_arena.h"
+
+#include <new>
+
+#include "mediapipe/framework/calculator_profile.pb.h"
+
+namespace mediapipe {
+
+const GraphService<PacketArenaPool> kPacketArenaService("kPacketArenaService");
+
+PacketArena::PacketArena(ConstructorKey, std::shared_ptr<PacketArenaPool> pool,
+                         Timestamp timestamp, std::unique_ptr<char[]> block,
+                         size_t block_size)
+    : pool_(std::move(pool)),
+      timestamp_(timestamp),
+      block_(std::move(block)),
+      block_size_(block_size) {
+  arena_.emplace(block_.get(), block_size_);
+}
+
+PacketArena::~PacketArena() {
+  size_t space_allocated = arena_->SpaceAllocated();
+  // The arena keeps its bookkeeping in the first block, so it must be
+  // destroyed before the block is handed back.
+  arena_.reset();
+  pool_->ReleaseBlock(std::move(block_), block_size_, space_allocated);
+}
+
+template <typename T>
+class PacketArenaPool::StorageAllocator {
+ public:
+  using value_type = T;
+
+  explicit StorageAllocator(std::shared_ptr<PacketArenaPool> pool)
+      : pool_(std::move(pool)) {}
+  template <typename U>
+  StorageAllocator(const StorageAllocator<U>& other) : pool_(other.pool_) {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(pool_->AllocateStorage(n * sizeof(T)));
+  }
+  void deallocate(T* p, size_t n) {
+    pool_->DeallocateStorage(p, n * sizeof(T));
+  }
+
+  template <typename U>
+  bool operator==(const StorageAllocator<U>& other) const {
+    return pool_ == other.pool_;
+  }
+  template <typename U>
+  bool operator!=(const StorageAllocator<U>& other) const {
+    return pool_ != other.pool_;
+  }
+
+ private:
+  template <typename U>
+  friend class StorageAllocator;
+
+  std::shared_ptr<PacketArenaPool> pool_;
+};
+
+std::shared_ptr<PacketArenaPool> PacketArenaPool::Create() {
+  return std::shared_ptr<PacketArenaPool>(new PacketArenaPool());
+}
+
+PacketArenaPool::~PacketArenaPool() {
+  for (void* storage : storage_) {
+    ::operator delete(storage);
+  }
+}
+
+std::shared_ptr<PacketArena> PacketArenaPool::ForTimestamp(
+    Timestamp timestamp) {
+  {
+    absl::MutexLock lock(&mutex_);
+    for (const auto& [arena_timestamp, weak_arena] : arenas_) {
+      if (arena_timestamp != timestamp) continue;
+      if (auto arena = weak_arena.lock()) return arena;
+    }
+  }
+
+  // Create the arena without holding mutex_, which its destructor acquires.
+  size_t block_size;
+  std::unique_ptr<char[]> block = AcquireBlock(&block_size);
+  auto arena = std::allocate_shared<PacketArena>(
+      StorageAllocator<PacketArena>(shared_from_this()),
+      PacketArena::ConstructorKey(), shared_from_this(), timestamp,
+      std::move(block), block_size);
+
+  // Declared after `arena`, so that the lock is released before an unused
+  // arena is destroyed.
+  absl::MutexLock lock(&mutex_);
+  std::pair<Timestamp, std::weak_ptr<PacketArena>>* free_entry = nullptr;
+  for (auto& entry : arenas_) {
+    if (entry.second.expired()) {
+      if (!free_entry) free_entry = &entry;
+    } else if (entry.first == timestamp) {
+      // Another thread created an arena for the same timestamp meanwhile.
+      if (auto other_arena = entry.second.lock()) return other_arena;
+    }
+  }
+  if (free_entry) {
+    *free_entry = {timestamp, arena};
+  } else {
+    arenas_.emplace_back(timestamp, arena);
+  }
+  ++num_allocations_;
+  return arena;
+}
+
+void PacketArenaPool::GetResourceProfile(ResourceProfile* profile) const {
+  absl::MutexLock lock(&mutex_);
+  profile->set_num_allocations(num_allocations_);
+  profile->set_num_misses(num_misses_);
+  profile->set_resident_bytes(resident_bytes_);
+}
+
+std::unique_ptr<char[]> PacketArenaPool::AcquireBlock(size_t* block_size) {
+  absl::MutexLock lock(&mutex_);
+  *block_size = block_size_;
+  if (!blocks_.empty()) {
+    std::unique_ptr<char[]> block = std::move(blocks_.back());
+    blocks_.pop_back();
+    return block;
+  }
+  ++num_misses_;
+  resident_bytes_ += block_size_;
+  return std::unique_ptr<char[]>(new char[block_size_]);
+}
+
+void PacketArenaPool::ReleaseBlock(std::unique_ptr<char[]> block,
+                                   size_t block_size, size_t space_allocated) {
+  absl::MutexLock lock(&mutex_);
+  if (space_allocated > block_size) {
+    // The arena outgrew its first block. Hand out blocks large enough for the
+    // next arenas, and drop the smaller ones.
+    ++num_misses_;
+    size_t new_block_size = block_size_;
+    while (new_block_size < space_allocated) new_block_size *= 2;
+    if (new_block_size > block_size_) {
+      resident_bytes_ -= block_size_ * blocks_.size();
+      blocks_.clear();
+      block_size_ = new_block_size;
+    }
+  }
+  if (block_size != block_size_) {
+    resident_bytes_ -= block_size;
+    return;
+  }
+  blocks_.push_back(std::move(block));
+}
+
+void* PacketArenaPool::AllocateStorage(size_t size) {
+  {
+    absl::MutexLock lock(&storage_mutex_);
+    if (size == storage_size_ && !storage_.empty()) {
+      void* storage = storage_.back();
+      storage_.pop_back();
+      return storage;
+    }
+  }
+  return ::operator new(size);
+}
+
+void PacketArenaPool::DeallocateStorage(void* storage, size_t size) {
+  {
+    absl::MutexLock lock(&storage_mutex_);
+    // All PacketArenas are allocated with the same size.
+    if (storage_size_ == 0) storage_size_ = size;
+    if (size == storage_size_) {
+      storage_.push_back(storage);
+      return;
+    }
+  }
+  ::operator delete(storage);
+}
+
+}  // namespace mediapipe
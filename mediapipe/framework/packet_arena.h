@@ -0,0 +1,248 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PACKET_ARENA_H_
+#define MEDIAPIPE_FRAMEWORK_PACKET_ARENA_H_
+
+#include <stddef.h>
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/types/optional.h"
+#include "google/protobuf/arena.h"
+#include "mediapipe/framework/graph_service.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/proto_ns.h"
+#include "mediapipe/framework/timestamp.h"
+
+namespace mediapipe {
+
+class PacketArenaPool;
+class ResourceProfile;
+
+// A region of memory shared by the packets of a single timestamp.
+//
+// Payloads created in a PacketArena, including protobuf messages together with
+// their sub-messages and repeated fields, are carved from a few large blocks
+// instead of being allocated one by one. The same holds for the holder
+// and reference count of the packets returned by MakePacket. Everything is
+// released in bulk when the arena is destroyed, which happens once the last
+// packet and the last std::shared_ptr referencing it are gone. The initial
+// block then returns to the PacketArenaPool, so that a graph running at a
+// steady state does not call the system allocator for its arena payloads.
+//
+// Obtain a PacketArena from PacketArenaPool::ForTimestamp. This class is
+// thread-safe.
+class PacketArena : public std::enable_shared_from_this<PacketArena> {
+ private:
+  struct ConstructorKey {
+    explicit ConstructorKey() = default;
+  };
+
+ public:
+  // Use PacketArenaPool::ForTimestamp instead.
+  PacketArena(ConstructorKey, std::shared_ptr<PacketArenaPool> pool,
+              Timestamp timestamp, std::unique_ptr<char[]> block,
+              size_t block_size);
+  ~PacketArena();
+  PacketArena(const PacketArena&) = delete;
+  PacketArena& operator=(const PacketArena&) = delete;
+
+  // The timestamp whose packets share this arena.
+  Timestamp timestamp() const { return timestamp_; }
+
+  // Constructs a T in the arena. The object is owned by the arena and is
+  // destroyed together with it, so it must not be deleted.
+  template <typename T, typename... Args>
+  T* Create(Args&&... args) {
+    if constexpr (std::is_base_of_v<proto_ns::MessageLite, T>) {
+      return proto_ns::Arena::CreateMessage<T>(&*arena_,
+                                               std::forward<Args>(args)...);
+    } else {
+      return proto_ns::Arena::Create<T>(&*arena_, std::forward<Args>(args)...);
+    }
+  }
+
+  // Returns a packet holding a T constructed in the arena. The packet keeps
+  // the arena alive. Since the payload is owned by the arena, Consume() fails
+  // on the packet and ConsumeOrCopy() returns a copy.
+  template <typename T, typename... Args>
+  Packet MakePacket(Args&&... args) {
+    return PacketFor(Create<T>(std::forward<Args>(args)...));
+  }
+
+  // Returns a packet holding a payload previously created with Create().
+  template <typename T>
+  Packet PacketFor(const T* payload) {
+    std::shared_ptr<packet_internal::HolderBase> holder =
+        std::allocate_shared<packet_internal::ForeignHolder<T>>(
+            Allocator<packet_internal::ForeignHolder<T>>(shared_from_this()),
+            payload);
+    return packet_internal::Create(std::move(holder), Timestamp::Unset());
+  }
+
+  // The underlying protobuf arena.
+  proto_ns::Arena* arena() { return &*arena_; }
+
+ private:
+  friend class PacketArenaPool;
+
+  // Allocates the control blocks of std::allocate_shared from the arena. Each
+  // copy of the allocator keeps the arena alive, which includes the copy
+  // stored in the control block itself.
+  template <typename T>
+  class Allocator {
+   public:
+    using value_type = T;
+
+    explicit Allocator(std::shared_ptr<PacketArena> arena)
+        : arena_(std::move(arena)) {}
+    template <typename U>
+    Allocator(const Allocator<U>& other) : arena_(other.arena_) {}
+
+    T* allocate(size_t n) {
+      static_assert(alignof(T) <= alignof(uint64),
+                    "protobuf arenas only guarantee 8-byte alignment");
+      return reinterpret_cast<T*>(
+          proto_ns::Arena::CreateArray<char>(arena_->arena(), n * sizeof(T)));
+    }
+    // Memory is released together with the arena.
+    void deallocate(T* p, size_t n) {}
+
+    template <typename U>
+    bool operator==(const Allocator<U>& other) const {
+      return arena_ == other.arena_;
+    }
+    template <typename U>
+    bool operator!=(const Allocator<U>& other) const {
+      return arena_ != other.arena_;
+    }
+
+   private:
+    template <typename U>
+    friend class Allocator;
+
+    std::shared_ptr<PacketArena> arena_;
+  };
+
+  std::shared_ptr<PacketArenaPool> pool_;
+  const Timestamp timestamp_;
+  // The first block of arena_, borrowed from pool_.
+  std::unique_ptr<char[]> block_;
+  const size_t block_size_;
+  absl::optional<proto_ns::Arena> arena_;
+};
+
+// A graph-wide pool of PacketArenas, one for each timestamp being processed.
+//
+// The pool recycles the initial blocks of destroyed arenas, and grows the size
+// of the blocks it hands out whenever an arena had to allocate beyond its
+// first block. Its usage is reported in the GraphProfile as a ResourceProfile
+// named after kPacketArenaService.
+//
+// This class is thread-safe.
+class PacketArenaPool : public std::enable_shared_from_this<PacketArenaPool> {
+ public:
+  // The size of the first blocks handed out, before any arena overflows.
+  static constexpr size_t kInitialBlockSize = 4096;
+
+  static std::shared_ptr<PacketArenaPool> Create();
+  ~PacketArenaPool();
+  PacketArenaPool(const PacketArenaPool&) = delete;
+  PacketArenaPool& operator=(const PacketArenaPool&) = delete;
+
+  // Returns the arena shared by the packets of `timestamp`. A new arena is
+  // created if no packet or std::shared_ptr references one.
+  std::shared_ptr<PacketArena> ForTimestamp(Timestamp timestamp)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Fills in the allocation statistics of the pool. An allocation is the
+  // creation of an arena; a miss is counted whenever an arena's initial block
+  // could not be reused, or turned out to be too small.
+  void GetResourceProfile(ResourceProfile* profile) const
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  friend class PacketArena;
+
+  // Allocates the PacketArenas and their control blocks from storage_, so
+  // that creating an arena does not call the system allocator either.
+  template <typename T>
+  class StorageAllocator;
+
+  PacketArenaPool() = default;
+
+  // Returns a block of block_size_ bytes for the first block of an arena.
+  std::unique_ptr<char[]> AcquireBlock(size_t* block_size)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+  // Takes back the first block of a destroyed arena, which allocated
+  // `space_allocated` bytes in total.
+  void ReleaseBlock(std::unique_ptr<char[]> block, size_t block_size,
+                    size_t space_allocated) ABSL_LOCKS_EXCLUDED(mutex_);
+
+  void* AllocateStorage(size_t size) ABSL_LOCKS_EXCLUDED(storage_mutex_);
+  void DeallocateStorage(void* storage, size_t size)
+      ABSL_LOCKS_EXCLUDED(storage_mutex_);
+
+  mutable absl::Mutex mutex_;
+  // The arenas handed out, by timestamp. Expired entries are reused.
+  std::vector<std::pair<Timestamp, std::weak_ptr<PacketArena>>> arenas_
+      ABSL_GUARDED_BY(mutex_);
+  // Unused blocks, all of block_size_ bytes.
+  std::vector<std::unique_ptr<char[]>> blocks_ ABSL_GUARDED_BY(mutex_);
+  size_t block_size_ ABSL_GUARDED_BY(mutex_) = kInitialBlockSize;
+
+  // Separate from mutex_, since releasing a std::weak_ptr in arenas_ can free
+  // the storage of an arena.
+  absl::Mutex storage_mutex_;
+  // Unused storage for PacketArenas, all of storage_size_ bytes.
+  std::vector<void*> storage_ ABSL_GUARDED_BY(storage_mutex_);
+  size_t storage_size_ ABSL_GUARDED_BY(storage_mutex_) = 0;
+
+  int64 num_allocations_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64 num_misses_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64 resident_bytes_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+// Provides a PacketArenaPool to the calculators of a graph. The service is not
+// created by default: a graph opts in by providing a pool before it starts,
+//
+//   graph.SetServiceObject(kPacketArenaService, PacketArenaPool::Create());
+//
+// since packets carved from an arena cannot be consumed downstream (see
+// PacketArena::PacketFor). Calculators use the arenas by requesting the
+// service in GetContract():
+//
+//   cc->UseService(kPacketArenaService).Optional();
+//
+// and then allocating their outputs from the arena of the input timestamp:
+//
+//   auto arenas = cc->Service(kPacketArenaService);
+//   if (arenas.IsAvailable()) {
+//     auto arena = arenas.GetObject().ForTimestamp(cc->InputTimestamp());
+//     auto* rect = arena->Create<NormalizedRect>();
+//     ...
+//     cc->Outputs().Index(0).AddPacket(
+//         arena->PacketFor(rect).At(cc->InputTimestamp()));
+//   }
+extern const GraphService<PacketArenaPool> kPacketArenaService;
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PACKET_ARENA_H_
@@ -0,0 +1,228 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/packet_arena.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/formats/detection.pb.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/timestamp.h"
+
+namespace mediapipe {
+namespace {
+
+ResourceProfile GetProfile(const PacketArenaPool& pool) {
+  ResourceProfile profile;
+  pool.GetResourceProfile(&profile);
+  return profile;
+}
+
+TEST(PacketArenaTest, PacketsOfTheSameTimestampShareAnArena) {
+  auto pool = PacketArenaPool::Create();
+  auto arena = pool->ForTimestamp(Timestamp(1));
+  EXPECT_EQ(arena, pool->ForTimestamp(Timestamp(1)));
+  EXPECT_NE(arena, pool->ForTimestamp(Timestamp(2)));
+  EXPECT_EQ(Timestamp(1), arena->timestamp());
+}
+
+TEST(PacketArenaTest, PacketsKeepTheArenaAlive) {
+  auto pool = PacketArenaPool::Create();
+  Packet packet;
+  {
+    auto arena = pool->ForTimestamp(Timestamp(1));
+    Detection* detection = arena->Create<Detection>();
+    detection->add_label("face");
+    detection->add_score(0.5f);
+    EXPECT_EQ(arena->arena(), detection->GetArena());
+    packet = arena->PacketFor(detection).At(Timestamp(1));
+  }
+  EXPECT_EQ(1, GetProfile(*pool).num_allocations());
+  EXPECT_NE(nullptr, pool->ForTimestamp(Timestamp(1)));
+  EXPECT_EQ(1, GetProfile(*pool).num_allocations());
+  EXPECT_EQ("face", packet.Get<Detection>().label(0));
+
+  packet = Packet();
+  pool->ForTimestamp(Timestamp(1));
+  EXPECT_EQ(2, GetProfile(*pool).num_allocations());
+}
+
+TEST(PacketArenaTest, ConsumeOrCopyCopiesArenaPayload) {
+  auto pool = PacketArenaPool::Create();
+  Packet packet = pool->ForTimestamp(Timestamp(1))->MakePacket<std::string>(
+      "payload");
+  EXPECT_FALSE(packet.Consume<std::string>().ok());
+  auto copy = packet.ConsumeOrCopy<std::string>();
+  MP_ASSERT_OK(copy);
+  EXPECT_EQ("payload", *copy.value());
+}
+
+TEST(PacketArenaTest, RecyclesBlocksOfReleasedArenas) {
+  auto pool = PacketArenaPool::Create();
+  for (int i = 0; i < 10; ++i) {
+    auto arena = pool->ForTimestamp(Timestamp(i));
+    Packet packet = arena->MakePacket<Detection>().At(Timestamp(i));
+  }
+  ResourceProfile profile = GetProfile(*pool);
+  EXPECT_EQ(10, profile.num_allocations());
+  EXPECT_EQ(1, profile.num_misses());
+  EXPECT_EQ(PacketArenaPool::kInitialBlockSize, profile.resident_bytes());
+}
+
+TEST(PacketArenaTest, GrowsBlocksAfterOverflow) {
+  auto pool = PacketArenaPool::Create();
+  for (int i = 0; i < 10; ++i) {
+    auto arena = pool->ForTimestamp(Timestamp(i));
+    arena->Create<Detection>()->mutable_score()->Resize(
+        PacketArenaPool::kInitialBlockSize / sizeof(float), 0.0f);
+  }
+  // The first arena misses its initial block and overflows it; the next ones
+  // get a block large enough.
+  ResourceProfile profile = GetProfile(*pool);
+  EXPECT_EQ(10, profile.num_allocations());
+  EXPECT_EQ(3, profile.num_misses());
+  EXPECT_GT(profile.resident_bytes(), PacketArenaPool::kInitialBlockSize);
+}
+
+// Emits a Detection packet from the packet arena of each input timestamp, or
+// from the heap if the graph provides no arenas.
+class ArenaDetectionCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).SetAny();
+    cc->Outputs().Index(0).Set<Detection>();
+    cc->UseService(kPacketArenaService).Optional();
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) final {
+    auto arenas = cc->Service(kPacketArenaService);
+    if (!arenas.IsAvailable()) {
+      Detection detection;
+      detection.add_label("face");
+      cc->Outputs().Index(0).AddPacket(
+          MakePacket<Detection>(detection).At(cc->InputTimestamp()));
+      return absl::OkStatus();
+    }
+    auto arena = arenas.GetObject().ForTimestamp(cc->InputTimestamp());
+    Detection* detection = arena->Create<Detection>();
+    detection->add_label("face");
+    cc->Outputs().Index(0).AddPacket(
+        arena->PacketFor(detection).At(cc->InputTimestamp()));
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(ArenaDetectionCalculator);
+
+TEST(PacketArenaTest, ReportsUsageInGraphProfile) {
+  auto config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "in"
+    output_stream: "out"
+    node {
+      calculator: "ArenaDetectionCalculator"
+      input_stream: "in"
+      output_stream: "out"
+    }
+    profiler_config { enable_profiler: true }
+  )pb");
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(
+      graph.SetServiceObject(kPacketArenaService, PacketArenaPool::Create()));
+  std::vector<Packet> out_packets;
+  MP_ASSERT_OK(graph.ObserveOutputStream("out", [&](const Packet& packet) {
+    out_packets.push_back(packet);
+    return absl::OkStatus();
+  }));
+  MP_ASSERT_OK(graph.StartRun({}));
+  for (int i = 0; i < 5; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(i).At(Timestamp(i))));
+    MP_ASSERT_OK(graph.WaitUntilIdle());
+  }
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+  ASSERT_EQ(5, out_packets.size());
+  EXPECT_EQ("face", out_packets[4].Get<Detection>().label(0));
+
+  GraphProfile profile;
+  MP_ASSERT_OK(graph.profiler()->CaptureProfile(&profile));
+  ASSERT_EQ(1, profile.resource_profiles_size());
+  EXPECT_EQ(kPacketArenaService.key, profile.resource_profiles(0).name());
+  EXPECT_EQ(5, profile.resource_profiles(0).num_allocations());
+  EXPECT_EQ(5, profile.resource_profiles(0).num_misses());
+
+  // Once the output packets are released, their blocks are reused.
+  out_packets.clear();
+  auto pool = graph.GetServiceObject(kPacketArenaService);
+  ASSERT_NE(nullptr, pool);
+  pool->ForTimestamp(Timestamp(5));
+  EXPECT_EQ(5, GetProfile(*pool).num_misses());
+}
+
+TEST(PacketArenaTest, GraphHasNoArenasByDefault) {
+  auto config = ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+    input_stream: "in"
+    output_stream: "out"
+    node {
+      calculator: "ArenaDetectionCalculator"
+      input_stream: "in"
+      output_stream: "out"
+    }
+  )pb");
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  std::vector<Packet> out_packets;
+  MP_ASSERT_OK(graph.ObserveOutputStream("out", [&](const Packet& packet) {
+    out_packets.push_back(packet);
+    return absl::OkStatus();
+  }));
+  MP_ASSERT_OK(graph.StartRun({}));
+  MP_ASSERT_OK(
+      graph.AddPacketToInputStream("in", MakePacket<int>(0).At(Timestamp(0))));
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+  EXPECT_EQ(nullptr, graph.GetServiceObject(kPacketArenaService));
+
+  // The output is allocated on the heap, so it can be consumed.
+  ASSERT_EQ(1, out_packets.size());
+  Packet packet = std::move(out_packets[0]);
+  out_packets.clear();
+  MP_EXPECT_OK(packet.Consume<Detection>());
+}
+
+void BM_MakeDetectionPacketInArena(benchmark::State& state) {
+  auto pool = PacketArenaPool::Create();
+  int64 timestamp = 0;
+  for (auto _ : state) {
+    auto arena = pool->ForTimestamp(Timestamp(++timestamp));
+    Packet packet = arena->MakePacket<Detection>();
+    benchmark::DoNotOptimize(packet);
+  }
+  state.counters["misses"] = GetProfile(*pool).num_misses();
+}
+BENCHMARK(BM_MakeDetectionPacketInArena);
+
+}  // namespace
+}  // namespace mediapipe
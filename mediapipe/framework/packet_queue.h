@@ -0,0 +1,127 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PACKET_QUEUE_H_
+#define MEDIAPIPE_FRAMEWORK_PACKET_QUEUE_H_
+
+#include <stddef.h>
+
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/logging.h"
+
+namespace mediapipe {
+namespace internal {
+
+// A FIFO queue of packets stored in a single circular buffer.
+//
+// Unlike std::deque, which allocates and frees a block every few dozen
+// elements as the queue slides forward, a PacketQueue only allocates when it
+// grows beyond its current capacity. Once it has reached the steady-state size
+// of a stream, pushing and popping packets never touches the heap.
+//
+// As in std::deque, packets are constructed in place when pushed and
+// destroyed when popped, so that the free slots hold no Packet objects.
+// The capacity is always zero or a power of two, so that positions can be
+// wrapped with a mask. This class is not thread-safe.
+class PacketQueue {
+ public:
+  PacketQueue() = default;
+  PacketQueue(const PacketQueue&) = delete;
+  PacketQueue& operator=(const PacketQueue&) = delete;
+  ~PacketQueue() { clear(); }
+
+  bool empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+  size_t capacity() const { return mask_ + 1; }
+
+  // Returns the packet at the front of the queue. The queue must not be empty.
+  Packet& front() {
+    DCHECK(!empty());
+    return slots_[head_];
+  }
+  const Packet& front() const {
+    DCHECK(!empty());
+    return slots_[head_];
+  }
+
+  // Returns the i-th packet counting from the front of the queue.
+  const Packet& operator[](size_t i) const {
+    DCHECK_LT(i, size_);
+    return slots_[(head_ + i) & mask_];
+  }
+
+  void push_back(const Packet& packet) {
+    if (size_ == capacity()) Grow();
+    new (&slots_[(head_ + size_) & mask_]) Packet(packet);
+    ++size_;
+  }
+  void push_back(Packet&& packet) {
+    if (size_ == capacity()) Grow();
+    new (&slots_[(head_ + size_) & mask_]) Packet(std::move(packet));
+    ++size_;
+  }
+
+  // Removes the packet at the front of the queue and releases its payload.
+  void pop_front() {
+    DCHECK(!empty());
+    slots_[head_].~Packet();
+    head_ = (head_ + 1) & mask_;
+    --size_;
+  }
+
+  // Removes all packets. The capacity is retained.
+  void clear() {
+    while (!empty()) pop_front();
+    head_ = 0;
+  }
+
+ private:
+  struct FreeSlots {
+    void operator()(Packet* slots) const { ::operator delete(slots); }
+  };
+
+  // Doubles the capacity, starting at 8, and moves the packets to the
+  // beginning of the new buffer, preserving their order.
+  void Grow() {
+    size_t capacity = size_ == 0 ? 8 : 2 * size_;
+    std::unique_ptr<Packet[], FreeSlots> slots(
+        static_cast<Packet*>(::operator new(capacity * sizeof(Packet))));
+    for (size_t i = 0; i < size_; ++i) {
+      Packet& packet = slots_[(head_ + i) & mask_];
+      new (&slots[i]) Packet(std::move(packet));
+      packet.~Packet();
+    }
+    slots_ = std::move(slots);
+    mask_ = capacity - 1;
+    head_ = 0;
+  }
+
+  // Storage for capacity() packets, of which only the size_ packets starting
+  // at head_ (modulo the capacity) are constructed.
+  std::unique_ptr<Packet[], FreeSlots> slots_;
+  // capacity() - 1. Wraps to zero capacity while no storage is allocated.
+  size_t mask_ = static_cast<size_t>(-1);
+  // Position of the front of the queue in slots_.
+  size_t head_ = 0;
+  size_t size_ = 0;
+};
+
+}  // namespace internal
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PACKET_QUEUE_H_
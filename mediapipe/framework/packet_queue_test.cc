@@ -0,0 +1,105 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/packet_queue.h"
+
+#include <deque>
+
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace internal {
+namespace {
+
+TEST(PacketQueueTest, PopsPacketsInOrderAcrossWrapAround) {
+  PacketQueue queue;
+  int next_push = 0;
+  int next_pop = 0;
+  // Keeps a few packets queued so that the positions wrap around the buffer.
+  for (int i = 0; i < 5; ++i) queue.push_back(MakePacket<int>(next_push++));
+  for (int i = 0; i < 100; ++i) {
+    queue.push_back(MakePacket<int>(next_push++));
+    ASSERT_EQ(next_pop, queue.front().Get<int>());
+    queue.pop_front();
+    ++next_pop;
+  }
+  EXPECT_EQ(8, queue.capacity());
+  ASSERT_EQ(5, queue.size());
+  for (int i = 0; i < 5; ++i) EXPECT_EQ(next_pop + i, queue[i].Get<int>());
+}
+
+TEST(PacketQueueTest, GrowsAndKeepsOrder) {
+  PacketQueue queue;
+  queue.push_back(MakePacket<int>(-1));
+  queue.pop_front();
+  for (int i = 0; i < 20; ++i) queue.push_back(MakePacket<int>(i));
+  EXPECT_EQ(32, queue.capacity());
+  ASSERT_EQ(20, queue.size());
+  for (int i = 0; i < 20; ++i) EXPECT_EQ(i, queue[i].Get<int>());
+}
+
+// Counts its destructions in the int it points to.
+class DestructionCounter {
+ public:
+  explicit DestructionCounter(int* num_destroyed)
+      : num_destroyed_(num_destroyed) {}
+  ~DestructionCounter() { ++*num_destroyed_; }
+
+ private:
+  int* num_destroyed_;
+};
+
+TEST(PacketQueueTest, PopReleasesPayload) {
+  int num_destroyed = 0;
+  PacketQueue queue;
+  queue.push_back(Adopt(new DestructionCounter(&num_destroyed)));
+  EXPECT_EQ(0, num_destroyed);
+  queue.pop_front();
+  EXPECT_EQ(1, num_destroyed);
+}
+
+TEST(PacketQueueTest, ClearKeepsCapacity) {
+  PacketQueue queue;
+  for (int i = 0; i < 10; ++i) queue.push_back(MakePacket<int>(i));
+  queue.clear();
+  EXPECT_TRUE(queue.empty());
+  EXPECT_EQ(16, queue.capacity());
+}
+
+// Slides a queue of state.range(0) packets forward, as an input stream does
+// when packets are added and consumed at the same rate. Compares PacketQueue
+// with the std::deque that input streams used before.
+template <typename Queue>
+void BM_SlidePackets(benchmark::State& state) {
+  Queue queue;
+  Packet packet = MakePacket<int>(7);
+  for (int i = 0; i < state.range(0); ++i) queue.push_back(packet);
+  for (auto _ : state) {
+    queue.push_back(packet);
+    benchmark::DoNotOptimize(queue.front());
+    queue.pop_front();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_SlidePackets, PacketQueue)->Arg(1)->Arg(16)->Arg(100);
+BENCHMARK_TEMPLATE(BM_SlidePackets, std::deque<Packet>)
+    ->Arg(1)
+    ->Arg(16)
+    ->Arg(100);
+
+}  // namespace
+}  // namespace internal
+}  // namespace mediapipe
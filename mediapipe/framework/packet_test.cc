@@ -14,6 +14,7 @@
 
 #include "mediapipe/framework/packet.h"
 
+#include <array>
 #include <map>
 #include <memory>
 #include <string>
@@ -517,5 +518,55 @@ TEST(PacketTest, SharedPtrWithPacketOwnership) {
   EXPECT_EQ(exist, false);
 }
 
+TEST(PacketTest, ConsumeMovesInlinePayload) {
+  Packet packet = MakePacket<std::vector<int>>(std::vector<int>{1, 2, 3});
+  const int* data = packet.Get<std::vector<int>>().data();
+  absl::StatusOr<std::unique_ptr<std::vector<int>>> result =
+      packet.Consume<std::vector<int>>();
+  MP_ASSERT_OK(result);
+  EXPECT_TRUE(packet.IsEmpty());
+  EXPECT_THAT(*result.value(), testing::ElementsAre(1, 2, 3));
+  // The vector was moved, not copied.
+  EXPECT_EQ(data, result.value()->data());
+}
+
+// A payload whose move constructor falls back to its copy constructor.
+class CopyOnly {
+ public:
+  explicit CopyOnly(int value) : value_(value) {}
+  CopyOnly(const CopyOnly& other) : value_(other.value_) { ++num_copies; }
+  CopyOnly& operator=(const CopyOnly& other) = default;
+  int value() const { return value_; }
+
+  static int num_copies;
+
+ private:
+  int value_;
+};
+int CopyOnly::num_copies = 0;
+
+TEST(PacketTest, ConsumeReleasesCopyOnlyPayload) {
+  CopyOnly::num_copies = 0;
+  Packet packet = MakePacket<CopyOnly>(7);
+  const CopyOnly* data = &packet.Get<CopyOnly>();
+  bool was_copied = true;
+  absl::StatusOr<std::unique_ptr<CopyOnly>> result =
+      packet.ConsumeOrCopy<CopyOnly>(&was_copied);
+  MP_ASSERT_OK(result);
+  EXPECT_FALSE(was_copied);
+  EXPECT_EQ(data, result.value().get());
+  EXPECT_EQ(7, result.value()->value());
+  EXPECT_EQ(0, CopyOnly::num_copies);
+}
+
+TEST(PacketTest, ConsumeReleasesLargePayload) {
+  Packet packet = MakePacket<std::array<float, 1024>>();
+  const std::array<float, 1024>* data = &packet.Get<std::array<float, 1024>>();
+  absl::StatusOr<std::unique_ptr<std::array<float, 1024>>> result =
+      packet.Consume<std::array<float, 1024>>();
+  MP_ASSERT_OK(result);
+  EXPECT_EQ(data, result.value().get());
+}
+
 }  // namespace
 }  // namespace mediapipe
@@ -0,0 +1,89 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PROFILER_EVENT_QUEUE_H_
+#define MEDIAPIPE_FRAMEWORK_PROFILER_EVENT_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace mediapipe {
+
+// A bounded queue for lock-free event logging from a single thread.
+// One writer thread appends events using "push_back", and one reader at a
+// time removes them using "PopAll". Neither of them modifies an atomic that
+// the other one modifies, so the writer never waits for the reader and does
+// not contend with the writers of other queues.
+template <typename T>
+class EventQueue {
+ public:
+  // Create a queue to hold up to |capacity| events.
+  explicit EventQueue(size_t capacity);
+
+  // Appends one event to the queue. Must only be called by the writer.
+  // Returns false if the queue is full.
+  inline bool push_back(const T& event);
+
+  // Moves all queued events to the end of |events|.
+  inline void PopAll(std::vector<T>* events);
+
+  // Returns the number of queued events.
+  inline size_t size() const { return end_ - begin_; }
+
+ private:
+  static constexpr size_t kCacheLineSize = 64;
+
+  std::vector<T> buffer_;
+
+  // The index after the last event, written only by the writer.
+  alignas(kCacheLineSize) std::atomic<size_t> end_;
+  // The writer's copy of begin_, refreshed when the queue looks full.
+  size_t writer_begin_;
+
+  // The index of the first event, written only by the reader.
+  alignas(kCacheLineSize) std::atomic<size_t> begin_;
+};
+
+template <typename T>
+EventQueue<T>::EventQueue(size_t capacity)
+    : buffer_(capacity), end_(0), writer_begin_(0), begin_(0) {}
+
+template <typename T>
+bool EventQueue<T>::push_back(const T& event) {
+  size_t end = end_.load(std::memory_order_relaxed);
+  if (end - writer_begin_ == buffer_.size()) {
+    writer_begin_ = begin_.load(std::memory_order_acquire);
+    if (end - writer_begin_ == buffer_.size()) {
+      return false;
+    }
+  }
+  buffer_[end % buffer_.size()] = event;
+  end_.store(end + 1, std::memory_order_release);
+  return true;
+}
+
+template <typename T>
+void EventQueue<T>::PopAll(std::vector<T>* events) {
+  size_t begin = begin_.load(std::memory_order_relaxed);
+  size_t end = end_.load(std::memory_order_acquire);
+  for (size_t i = begin; i < end; ++i) {
+    events->push_back(buffer_[i % buffer_.size()]);
+  }
+  begin_.store(end, std::memory_order_release);
+}
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PROFILER_EVENT_QUEUE_H_
@@ -0,0 +1,82 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/profiler/event_queue.h"
+
+#include <atomic>
+#include <vector>
+
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/threadpool.h"
+
+namespace {
+
+using testing::ElementsAre;
+
+TEST(EventQueueTest, SequentialWriteAndRead) {
+  mediapipe::EventQueue<int> queue(3);
+  EXPECT_TRUE(queue.push_back(1));
+  EXPECT_TRUE(queue.push_back(2));
+  EXPECT_TRUE(queue.push_back(3));
+  EXPECT_FALSE(queue.push_back(4));
+  EXPECT_EQ(3, queue.size());
+
+  std::vector<int> events;
+  queue.PopAll(&events);
+  EXPECT_THAT(events, ElementsAre(1, 2, 3));
+  EXPECT_EQ(0, queue.size());
+
+  // The queue wraps around once events are popped.
+  EXPECT_TRUE(queue.push_back(5));
+  EXPECT_TRUE(queue.push_back(6));
+  queue.PopAll(&events);
+  EXPECT_THAT(events, ElementsAre(1, 2, 3, 5, 6));
+}
+
+TEST(EventQueueTest, ParallelWriteAndRead) {
+  constexpr int kNumEvents = 10000;
+  mediapipe::EventQueue<int> queue(100);
+  std::vector<int> events;
+  std::atomic_bool done(false);
+  {
+    mediapipe::ThreadPool pool(2);
+    pool.StartWorkers();
+
+    // Start one writer, retrying while the queue is full.
+    pool.Schedule([&]() {
+      for (int i = 0; i < kNumEvents; ++i) {
+        while (!queue.push_back(i)) {
+        }
+      }
+      done = true;
+    });
+
+    // Start one reader.
+    pool.Schedule([&]() {
+      while (!done) {
+        queue.PopAll(&events);
+      }
+      queue.PopAll(&events);
+    });
+  }
+
+  // Validate that every event is read once, in order.
+  ASSERT_EQ(kNumEvents, events.size());
+  for (int i = 0; i < kNumEvents; ++i) {
+    ASSERT_EQ(i, events[i]);
+  }
+}
+
+}  // namespace
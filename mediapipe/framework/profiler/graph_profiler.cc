@@ -651,6 +651,12 @@ absl::StatusOr<std::string> GraphProfiler::GetTraceLogPath() {
   }
 }
 
+void GraphProfiler::SetResourceProfiler(
+    const std::string& name, std::function<void(ResourceProfile*)> profiler) {
+  absl::WriterMutexLock lock(&profiler_mutex_);
+  resource_profilers_[name] = std::move(profiler);
+}
+
 absl::Status GraphProfiler::CaptureProfile(
     GraphProfile* result, PopulateGraphConfig populate_config) {
   // Record the GraphTrace events since the previous WriteProfile.
@@ -680,6 +686,14 @@ absl::Status GraphProfiler::CaptureProfile(
   }
   this->Reset();
   CleanCalculatorProfiles(result);
+  {
+    absl::ReaderMutexLock lock(&profiler_mutex_);
+    for (const auto& [name, profiler] : resource_profilers_) {
+      ResourceProfile* resource_profile = result->add_resource_profiles();
+      resource_profile->set_name(name);
+      profiler(resource_profile);
+    }
+  }
   if (populate_config == PopulateGraphConfig::kFull) {
     *result->mutable_config() = validated_graph_->Config();
     AssignNodeNames(result);
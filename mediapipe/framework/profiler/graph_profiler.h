@@ -17,6 +17,8 @@
 
 #include <atomic>
 #include <cstddef>
+#include <functional>
+#include <map>
 #include <memory>
 #include <set>
 #include <string>
@@ -146,6 +148,13 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
   absl::Status GetCalculatorProfiles(std::vector<CalculatorProfile>*) const
       ABSL_LOCKS_EXCLUDED(profiler_mutex_);
 
+  // Registers a function that reports the usage of a graph-wide resource,
+  // such as a memory pool, in each captured GraphProfile. A function
+  // registered earlier under the same name is replaced.
+  void SetResourceProfiler(const std::string& name,
+                           std::function<void(ResourceProfile*)> profiler)
+      ABSL_LOCKS_EXCLUDED(profiler_mutex_);
+
   // Records recent profiling and tracing data.  Includes events since the
   // previous call to CaptureProfile.
   //
@@ -348,6 +357,10 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
   // The configuration for the graph being profiled.
   const ValidatedGraphConfig* validated_graph_;
 
+  // Functions reporting the usage of graph-wide resources, by resource name.
+  std::map<std::string, std::function<void(ResourceProfile*)>>
+      resource_profilers_ ABSL_GUARDED_BY(profiler_mutex_);
+
   // A private resource for creating GraphProfiles.
   class GraphProfileBuilder;
   std::unique_ptr<GraphProfileBuilder> profile_builder_;
@@ -15,6 +15,9 @@
 #ifndef MEDIAPIPE_FRAMEWORK_PROFILER_MEDIAPIPE_PROFILER_STUB_H_
 #define MEDIAPIPE_FRAMEWORK_PROFILER_MEDIAPIPE_PROFILER_STUB_H_
 
+#include <functional>
+#include <string>
+
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/framework/timestamp.h"
 
@@ -22,12 +25,14 @@ namespace mediapipe {
 class CalculatorProfile;
 class GraphTrace;
 class GraphProfile;
+class ResourceProfile;
 }  // namespace mediapipe
 
 namespace mediapipe {
 using mediapipe::CalculatorProfile;
 using mediapipe::GraphProfile;
 using mediapipe::GraphTrace;
+using mediapipe::ResourceProfile;
 
 class ValidatedGraphConfig;
 class Executor;
@@ -88,6 +93,9 @@ class GraphProfilerStub {
       std::vector<CalculatorProfile>*) const {
     return absl::OkStatus();
   }
+  inline void SetResourceProfiler(
+      const std::string& name, std::function<void(ResourceProfile*)> profiler) {
+  }
   absl::Status CaptureProfile(
       GraphProfile* result,
       PopulateGraphConfig populate_config = PopulateGraphConfig::kNo) {
@@ -14,6 +14,14 @@
 
 #include "mediapipe/framework/profiler/graph_tracer.h"
 
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/memory/memory.h"
 #include "absl/time/time.h"
 #include "mediapipe/framework/calculator_context.h"
 #include "mediapipe/framework/calculator_profile.pb.h"
@@ -30,15 +38,66 @@ using EventType = GraphTrace::EventType;
 
 const absl::Duration kDefaultTraceLogInterval = absl::Milliseconds(500);
 
+// The number of TraceEvents each thread can queue between merges.
+constexpr size_t kThreadQueueCapacity = 1024;
+
 // Returns a unique identifier for the current thread.
 inline int GetCurrentThreadId() {
-  static int next_thread_id = 0;
+  static std::atomic<int> next_thread_id(0);
   static thread_local int thread_id = next_thread_id++;
   return thread_id;
 }
 
+// Returns a unique identifier for a new GraphTracer.
+int64 NewTracerId() {
+  static std::atomic<int64> next_tracer_id(0);
+  return next_tracer_id++;
+}
+
+// Returns a time that orders the events logged by all threads. Unlike the
+// event_time, it does not depend on the profiler clock.
+inline int64 LogTime() {
+  return std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
 }  // namespace
 
+// Lookups take no lock, even when a thread logs to several tracers, e.g. as a
+// worker of an executor shared by several graphs.
+class GraphTracer::ThreadQueueMap {
+ public:
+  ~ThreadQueueMap() {
+    for (auto& tracer_queue : queues_) {
+      tracer_queue.second->thread_exited.store(true, std::memory_order_release);
+    }
+  }
+
+  ThreadQueue* Find(int64 tracer_id) const {
+    auto it = queues_.find(tracer_id);
+    return it == queues_.end() ? nullptr : it->second.get();
+  }
+
+  // Adds the queue of a tracer, and drops the queues of destroyed tracers.
+  void Insert(int64 tracer_id, std::shared_ptr<ThreadQueue> queue) {
+    for (auto it = queues_.begin(); it != queues_.end();) {
+      if (it->second->tracer_destroyed.load(std::memory_order_acquire)) {
+        queues_.erase(it++);
+      } else {
+        ++it;
+      }
+    }
+    queues_[tracer_id] = std::move(queue);
+  }
+
+ private:
+  absl::flat_hash_map<int64, std::shared_ptr<ThreadQueue>> queues_;
+};
+
+GraphTracer::ThreadQueueMap& GraphTracer::CurrentThreadQueues() {
+  static thread_local ThreadQueueMap thread_queues;
+  return thread_queues;
+}
+
 absl::Duration GraphTracer::GetTraceLogInterval() {
   return profiler_config_.trace_log_interval_usec()
              ? absl::Microseconds(profiler_config_.trace_log_interval_usec())
@@ -52,13 +111,22 @@ int64 GraphTracer::GetTraceLogCapacity() {
 }
 
 GraphTracer::GraphTracer(const ProfilerConfig& profiler_config)
-    : profiler_config_(profiler_config), trace_buffer_(GetTraceLogCapacity()) {
+    : profiler_config_(profiler_config),
+      tracer_id_(NewTracerId()),
+      trace_buffer_(GetTraceLogCapacity()) {
   for (int disabled : profiler_config_.trace_event_types_disabled()) {
     EventType event_type = static_cast<EventType>(disabled);
     (*trace_event_registry())[event_type].set_enabled(false);
   }
 }
 
+GraphTracer::~GraphTracer() {
+  absl::MutexLock lock(&merge_mutex_);
+  for (auto& thread_queue : thread_queues_) {
+    thread_queue->tracer_destroyed.store(true, std::memory_order_release);
+  }
+}
+
 TraceEventRegistry* GraphTracer::trace_event_registry() {
   return trace_builder_.trace_event_registry();
 }
@@ -68,7 +136,12 @@ void GraphTracer::LogEvent(TraceEvent event) {
     return;
   }
   event.set_thread_id(GetCurrentThreadId());
-  trace_buffer_.push_back(event);
+  QueuedEvent queued_event = {LogTime(), event};
+  EventQueue<QueuedEvent>* queue = GetThreadQueue();
+  if (!queue->push_back(queued_event)) {
+    MergeThreadQueues();
+    queue->push_back(queued_event);
+  }
 }
 
 void GraphTracer::LogInputEvents(GraphTrace::EventType event_type,
@@ -114,22 +187,28 @@ void GraphTracer::LogOutputEvents(GraphTrace::EventType event_type,
 }
 
 Timestamp GraphTracer::TimestampAfter(absl::Time begin_time) {
+  MergeThreadQueues();
   return TraceBuilder::TimestampAfter(trace_buffer_, begin_time);
 }
 
 void GraphTracer::GetTrace(absl::Time begin_time, absl::Time end_time,
                            GraphTrace* result) {
+  MergeThreadQueues();
   trace_builder_.CreateTrace(trace_buffer_, begin_time, end_time, result);
   trace_builder_.Clear();
 }
 
 void GraphTracer::GetLog(absl::Time begin_time, absl::Time end_time,
                          GraphTrace* result) {
+  MergeThreadQueues();
   trace_builder_.CreateLog(trace_buffer_, begin_time, end_time, result);
   trace_builder_.Clear();
 }
 
-const TraceBuffer& GraphTracer::GetTraceBuffer() { return trace_buffer_; }
+const TraceBuffer& GraphTracer::GetTraceBuffer() {
+  MergeThreadQueues();
+  return trace_buffer_;
+}
 
 Timestamp GraphTracer::GetOutputTimestamp(const CalculatorContext* context) {
   for (const OutputStreamShard& out_stream : context->Outputs()) {
@@ -142,4 +221,61 @@ Timestamp GraphTracer::GetOutputTimestamp(const CalculatorContext* context) {
   return Timestamp();
 }
 
+EventQueue<GraphTracer::QueuedEvent>* GraphTracer::GetThreadQueue() {
+  ThreadQueueMap& thread_queues = CurrentThreadQueues();
+  ThreadQueue* queue = thread_queues.Find(tracer_id_);
+  if (!queue) {
+    std::shared_ptr<ThreadQueue> new_queue = NewThreadQueue();
+    queue = new_queue.get();
+    thread_queues.Insert(tracer_id_, std::move(new_queue));
+  }
+  return &queue->events;
+}
+
+std::shared_ptr<GraphTracer::ThreadQueue> GraphTracer::NewThreadQueue() {
+  auto queue = std::make_shared<ThreadQueue>(kThreadQueueCapacity);
+  absl::MutexLock lock(&merge_mutex_);
+  thread_queues_.push_back(queue);
+  return queue;
+}
+
+void GraphTracer::MergeThreadQueues() {
+  absl::MutexLock lock(&merge_mutex_);
+  merge_events_.resize(thread_queues_.size());
+  for (int i = 0; i < thread_queues_.size(); ++i) {
+    merge_events_[i].clear();
+  }
+  // The queues of exited threads are drained once more, and then dropped.
+  int num_live_queues = 0;
+  for (int i = 0; i < thread_queues_.size(); ++i) {
+    ThreadQueue* thread_queue = thread_queues_[i].get();
+    const bool thread_exited =
+        thread_queue->thread_exited.load(std::memory_order_acquire);
+    thread_queue->events.PopAll(&merge_events_[i]);
+    if (!thread_exited) {
+      std::swap(thread_queues_[num_live_queues++], thread_queues_[i]);
+    }
+  }
+  thread_queues_.resize(num_live_queues);
+
+  // The events of each thread are already in the order they were logged.
+  std::vector<size_t> next(merge_events_.size(), 0);
+  while (true) {
+    int earliest = -1;
+    for (int i = 0; i < merge_events_.size(); ++i) {
+      const std::vector<QueuedEvent>& events = merge_events_[i];
+      if (next[i] < events.size() &&
+          (earliest == -1 ||
+           events[next[i]].log_time <
+               merge_events_[earliest][next[earliest]].log_time)) {
+        earliest = i;
+      }
+    }
+    if (earliest == -1) {
+      break;
+    }
+    trace_buffer_.push_back(merge_events_[earliest][next[earliest]++].event);
+  }
+}
+
 }  // namespace mediapipe
@@ -15,11 +15,17 @@
 #ifndef MEDIAPIPE_FRAMEWORK_PROFILER_GRAPH_TRACER_H_
 #define MEDIAPIPE_FRAMEWORK_PROFILER_GRAPH_TRACER_H_
 
+#include <atomic>
+#include <memory>
 #include <string>
+#include <vector>
 
+#include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_context.h"
 #include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/profiler/event_queue.h"
 #include "mediapipe/framework/profiler/trace_buffer.h"
 #include "mediapipe/framework/profiler/trace_builder.h"
 
@@ -30,6 +36,10 @@ namespace mediapipe {
 //
 // GraphTracer is thread-safe, and the Log* methods are also non-blocking
 // so they can be called during graph execution with mimimal overhead.
+// Each thread appends its events to its own EventQueue, so that logging
+// threads do not contend with each other. The queued events are merged into
+// the TraceBuffer in the order they were logged, before the TraceBuffer is
+// read or whenever the queue of a logging thread is full.
 //
 // The method GetTrace returns the events for a range of recent Timestamps.
 // The begin_ts should be the first timestamp completely enclosed in the
@@ -55,17 +65,19 @@ class GraphTracer {
   // Create a tracer to record up to |capacity| recent events.
   GraphTracer(const ProfilerConfig& profiler_config);
 
+  ~GraphTracer();
+
   // Returns the registry of trace event types.
   TraceEventRegistry* trace_event_registry();
 
-  // Append a TraceEvent to the TraceBuffer.
+  // Append a TraceEvent to the EventQueue of the current thread.
   void LogEvent(TraceEvent event);
 
-  // Append TraceEvents to the TraceBuffer for task input.
+  // Append TraceEvents to the EventQueue for task input.
   void LogInputEvents(GraphTrace::EventType event_type,
                       const CalculatorContext* context, absl::Time event_time);
 
-  // Append TraceEvents to the TraceBuffer for task output.
+  // Append TraceEvents to the EventQueue for task output.
   void LogOutputEvents(GraphTrace::EventType event_type,
                        const CalculatorContext* context, absl::Time event_time);
 
@@ -85,10 +97,61 @@ class GraphTracer {
   // Returns the timestamp of the first output packet.
   Timestamp GetOutputTimestamp(const CalculatorContext* context);
 
+  // A TraceEvent waiting in an EventQueue, with the steady clock time at
+  // which it was logged.
+  struct QueuedEvent {
+    int64 log_time;
+    TraceEvent event;
+  };
+
+  // The EventQueue of one thread for one tracer. It is shared by the tracer
+  // and the thread, so that either one can go away first.
+  struct ThreadQueue {
+    explicit ThreadQueue(size_t capacity) : events(capacity) {}
+    EventQueue<QueuedEvent> events;
+    // Set when the thread exits. Its remaining events are merged once more,
+    // and the queue is then dropped by the tracer.
+    std::atomic<bool> thread_exited{false};
+    // Set when the tracer is destroyed. The thread then drops the queue.
+    std::atomic<bool> tracer_destroyed{false};
+  };
+
+  // The ThreadQueues of one thread, by tracer id.
+  class ThreadQueueMap;
+
+  // Returns the ThreadQueueMap of the current thread.
+  static ThreadQueueMap& CurrentThreadQueues();
+
+  // Returns the EventQueue of the current thread.
+  EventQueue<QueuedEvent>* GetThreadQueue();
+
+  // Creates the EventQueue of the current thread.
+  std::shared_ptr<ThreadQueue> NewThreadQueue()
+      ABSL_LOCKS_EXCLUDED(merge_mutex_);
+
+  // Moves the TraceEvents of all threads into the TraceBuffer, in the order
+  // they were logged.
+  void MergeThreadQueues() ABSL_LOCKS_EXCLUDED(merge_mutex_);
+
   // The settings for this tracer.
   ProfilerConfig profiler_config_;
 
-  // The circular buffer of TraceEvents.
+  // Identifies this tracer in the thread-local EventQueue cache.
+  const int64 tracer_id_;
+
+  // Serializes the merging of EventQueues, and guards the creation of
+  // EventQueues.
+  absl::Mutex merge_mutex_;
+
+  // The EventQueue of each live logging thread.
+  std::vector<std::shared_ptr<ThreadQueue>> thread_queues_
+      ABSL_GUARDED_BY(merge_mutex_);
+
+  // The events popped from each EventQueue, reused across merges.
+  std::vector<std::vector<QueuedEvent>> merge_events_
+      ABSL_GUARDED_BY(merge_mutex_);
+
+  // The circular buffer of merged TraceEvents.
   TraceBuffer trace_buffer_;
 
   // The builder for the GraphTrace protobuf.
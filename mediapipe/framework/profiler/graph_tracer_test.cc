@@ -18,6 +18,7 @@
 #include <functional>
 #include <map>
 #include <memory>
+#include <thread>  // NOLINT(build/c++11)
 #include <utility>
 #include <vector>
 
@@ -28,6 +29,7 @@
 #include "mediapipe/framework/calculator_profile.pb.h"
 #include "mediapipe/framework/deps/clock.h"
 #include "mediapipe/framework/port/advanced_proto_inc.h"
+#include "mediapipe/framework/port/benchmark.h"
 #include "mediapipe/framework/port/file_helpers.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
@@ -328,6 +330,60 @@ TEST_F(GraphTracerTest, GraphTrace) {
   EXPECT_EQ(4, trace.calculator_trace().size());
 }
 
+// Returns the input timestamps of the TraceEvents logged to a GraphTracer.
+std::vector<int64> LoggedTimestamps(GraphTracer* tracer) {
+  std::vector<int64> result;
+  const TraceBuffer& buffer = tracer->GetTraceBuffer();
+  for (auto iter = buffer.begin(); iter < buffer.end(); ++iter) {
+    result.push_back((*iter).input_ts.Value());
+  }
+  return result;
+}
+
+// Logs one PROCESS TraceEvent at an input timestamp.
+void LogProcessEvent(GraphTracer* tracer, int64 ts) {
+  static const std::string* stream_name = new std::string("stream");
+  tracer->LogEvent(TraceEvent(GraphTrace::PROCESS)
+                       .set_event_time(absl::Now())
+                       .set_input_ts(Timestamp(ts))
+                       .set_stream_id(stream_name));
+}
+
+TEST(GraphTracerThreadTest, TracersShareThread) {
+  ProfilerConfig profiler_config;
+  profiler_config.set_trace_enabled(true);
+  auto tracer_1 = absl::make_unique<GraphTracer>(profiler_config);
+  auto tracer_2 = absl::make_unique<GraphTracer>(profiler_config);
+  for (int64 ts = 0; ts < 3; ++ts) {
+    LogProcessEvent(tracer_1.get(), ts);
+    LogProcessEvent(tracer_2.get(), ts + 10);
+  }
+  EXPECT_THAT(LoggedTimestamps(tracer_1.get()), ElementsAre(0, 1, 2));
+  EXPECT_THAT(LoggedTimestamps(tracer_2.get()), ElementsAre(10, 11, 12));
+
+  // A new tracer on the same thread gets its own queue.
+  tracer_1.reset();
+  auto tracer_3 = absl::make_unique<GraphTracer>(profiler_config);
+  LogProcessEvent(tracer_3.get(), 20);
+  LogProcessEvent(tracer_2.get(), 13);
+  EXPECT_THAT(LoggedTimestamps(tracer_3.get()), ElementsAre(20));
+  EXPECT_THAT(LoggedTimestamps(tracer_2.get()), ElementsAre(10, 11, 12, 13));
+}
+
+TEST(GraphTracerThreadTest, ThreadExits) {
+  ProfilerConfig profiler_config;
+  profiler_config.set_trace_enabled(true);
+  GraphTracer tracer(profiler_config);
+  for (int64 ts = 0; ts < 4; ++ts) {
+    std::thread thread([&tracer, ts] { LogProcessEvent(&tracer, ts); });
+    thread.join();
+  }
+  // The events of exited threads are still merged.
+  EXPECT_THAT(LoggedTimestamps(&tracer), ElementsAre(0, 1, 2, 3));
+  LogProcessEvent(&tracer, 4);
+  EXPECT_THAT(LoggedTimestamps(&tracer), ElementsAre(0, 1, 2, 3, 4));
+}
+
 // Tests showing GraphTracer logging packet latencies.
 class GraphTracerE2ETest : public ::testing::Test {
  protected:
@@ -1423,5 +1479,69 @@ TEST_F(GraphTracerE2ETest, DestructGraph) {
   }
 }
 
+// Measures the cost of logging one TraceEvent from concurrent threads.
+void BM_LogEvent(benchmark::State& state) {
+  static GraphTracer* tracer = [] {
+    ProfilerConfig profiler_config;
+    profiler_config.set_trace_enabled(true);
+    return new GraphTracer(profiler_config);
+  }();
+  static const std::string* stream_name = new std::string("stream");
+  absl::Time event_time = absl::Now();
+  int64 ts = 0;
+  for (auto _ : state) {
+    tracer->LogEvent(TraceEvent(GraphTrace::PROCESS)
+                         .set_event_time(event_time)
+                         .set_input_ts(Timestamp(++ts))
+                         .set_stream_id(stream_name));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LogEvent)->ThreadRange(1, 8)->UseRealTime();
+
+// Measures the cost of a Process() call in a chain of pass-through nodes,
+// with tracing disabled (Arg 0) and enabled (Arg 1).
+void BM_ProcessWithTracing(benchmark::State& state) {
+  constexpr int kNumNodes = 4;
+  constexpr int kNumPackets = 100;
+  CalculatorGraphConfig config;
+  config.add_input_stream("stream_0");
+  for (int i = 0; i < kNumNodes; ++i) {
+    CalculatorGraphConfig::Node* node = config.add_node();
+    node->set_calculator("LambdaCalculator");
+    node->add_input_side_packet("callback");
+    node->add_input_stream(absl::StrCat("stream_", i));
+    node->add_output_stream(absl::StrCat("stream_", i + 1));
+  }
+  config.set_num_threads(kNumNodes);
+  config.mutable_profiler_config()->set_enable_profiler(true);
+  config.mutable_profiler_config()->set_trace_enabled(state.range(0));
+  config.mutable_profiler_config()->set_trace_log_disabled(true);
+  std::function<absl::Status(const InputStreamShardSet&,
+                             OutputStreamShardSet*)>
+      pass_through = [](const InputStreamShardSet& inputs,
+                        OutputStreamShardSet* outputs) {
+        outputs->Index(0).AddPacket(inputs.Index(0).Value());
+        return absl::OkStatus();
+      };
+  CalculatorGraph graph;
+  CHECK(graph.Initialize(config, {{"callback", Adopt(new auto(pass_through))}})
+            .ok());
+
+  for (auto _ : state) {
+    CHECK(graph.StartRun({}).ok());
+    for (int ts = 0; ts < kNumPackets; ++ts) {
+      CHECK(graph
+                .AddPacketToInputStream("stream_0",
+                                        MakePacket<int>(ts).At(Timestamp(ts)))
+                .ok());
+    }
+    CHECK(graph.CloseAllInputStreams().ok());
+    CHECK(graph.WaitUntilDone().ok());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumNodes * kNumPackets);
+}
+BENCHMARK(BM_ProcessWithTracing)->Arg(0)->Arg(1)->UseRealTime();
+
 }  // namespace
 }  // namespace mediapipe
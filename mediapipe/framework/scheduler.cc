@@ -102,6 +102,22 @@ absl::Status Scheduler::SetNonDefaultExecutor(const std::string& name,
   return absl::OkStatus();
 }
 
+absl::Status Scheduler::SetQueueNumShards(const std::string& name,
+                                          int num_shards) {
+  RET_CHECK_EQ(state_, STATE_NOT_STARTED) << "SetQueueNumShards must not be "
+                                             "called after the scheduler has "
+                                             "started";
+  SchedulerQueue* queue = &default_queue_;
+  if (!name.empty()) {
+    auto iter = non_default_queues_.find(name);
+    RET_CHECK(iter != non_default_queues_.end())
+        << "No scheduler queue for the executor \"" << name << "\"";
+    queue = iter->second.get();
+  }
+  queue->SetNumShards(num_shards);
+  return absl::OkStatus();
+}
+
 void Scheduler::SetQueuesRunning(bool running) {
   for (auto queue : scheduler_queues_) {
     queue->SetRunning(running);
@@ -160,7 +176,10 @@ void Scheduler::HandleIdle() {
       state_mutex_.Unlock();
       bool did_unthrottle = graph_->UnthrottleSources();
       state_mutex_.Lock();
-      if (did_unthrottle) {
+      // An error, e.g. from Cancel(), may have been recorded while the mutex
+      // was unlocked. The HandleIdle call that came with it was ignored, so
+      // the loop must run again to quit.
+      if (did_unthrottle || shared_.has_error) {
         continue;
       }
     }
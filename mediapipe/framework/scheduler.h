@@ -59,6 +59,12 @@ class Scheduler {
   absl::Status SetNonDefaultExecutor(const std::string& name,
                                      Executor* executor);
 
+  // Splits the scheduler queue of the executor named |name| into
+  // |num_shards| work-stealing shards. See SchedulerQueue::SetNumShards.
+  // Must be called after the executor is set and before the scheduler is
+  // started.
+  absl::Status SetQueueNumShards(const std::string& name, int num_shards);
+
   // Resets the data members at the beginning of each graph run.
   void Reset();
 
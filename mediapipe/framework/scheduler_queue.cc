@@ -14,10 +14,12 @@
 
 #include "mediapipe/framework/scheduler_queue.h"
 
+#include <atomic>
 #include <memory>
 #include <queue>
 #include <utility>
 
+#include "absl/memory/memory.h"
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/calculator_node.h"
 #include "mediapipe/framework/executor.h"
@@ -34,6 +36,20 @@
 namespace mediapipe {
 namespace internal {
 
+namespace {
+
+// Returns a small integer identifying the calling thread. Threads are
+// numbered in the order in which they first reach a sharded SchedulerQueue,
+// so the worker threads of one executor get consecutive numbers and spread
+// evenly over the shards.
+int ThreadShardHint() {
+  static std::atomic<int> next_hint(0);
+  thread_local int hint = next_hint.fetch_add(1, std::memory_order_relaxed);
+  return hint;
+}
+
+}  // namespace
+
 SchedulerQueue::Item::Item(CalculatorNode* node, CalculatorContext* cc)
     : node_(node), cc_(cc) {
   CHECK(node);
@@ -91,10 +107,24 @@ void SchedulerQueue::Reset() {
   num_pending_tasks_ = 0;
   num_tasks_to_add_ = 0;
   running_count_ = 0;
+  running_.store(false, std::memory_order_release);
 }
 
 void SchedulerQueue::SetExecutor(Executor* executor) { executor_ = executor; }
 
+void SchedulerQueue::SetNumShards(int num_shards) {
+  absl::MutexLock lock(&mutex_);
+  CHECK(queue_.empty() && num_sharded_items_.load() == 0)
+      << "SetNumShards must be called before any node is scheduled.";
+  shards_.clear();
+  if (num_shards <= 1) {
+    return;
+  }
+  for (int i = 0; i < num_shards; ++i) {
+    shards_.push_back(absl::make_unique<Shard>());
+  }
+}
+
 bool SchedulerQueue::IsIdle() {
   VLOG(3) << "Scheduler queue empty: " << queue_.empty()
           << ", # of pending tasks: " << num_pending_tasks_;
@@ -105,6 +135,7 @@ void SchedulerQueue::SetRunning(bool running) {
   absl::MutexLock lock(&mutex_);
   running_count_ += running ? 1 : -1;
   DCHECK_LE(running_count_, 1);
+  running_.store(running_count_ > 0, std::memory_order_release);
 }
 
 void SchedulerQueue::AddNode(CalculatorNode* node, CalculatorContext* cc) {
@@ -131,6 +162,10 @@ void SchedulerQueue::AddNodeForOpen(CalculatorNode* node) {
 }
 
 void SchedulerQueue::AddItemToQueue(Item&& item) {
+  if (!shards_.empty()) {
+    AddItemToShards(std::move(item));
+    return;
+  }
   const CalculatorNode* node = item.Node();
   bool was_idle;
   int tasks_to_add = 0;
@@ -161,10 +196,37 @@ void SchedulerQueue::AddItemToQueue(Item&& item) {
   }
 }
 
+void SchedulerQueue::AddItemToShards(Item&& item) {
+  // The item is pushed before its task is submitted, so that a task always
+  // finds an item in some shard.
+  PushToShard(std::move(item));
+  const bool was_idle =
+      num_sharded_items_.fetch_add(1, std::memory_order_acq_rel) == 0;
+  int tasks_to_add = 1;
+  if (!running_.load(std::memory_order_acquire)) {
+    // Rare: the task must wait for SetRunning(true). mutex_ serializes this
+    // with SubmitWaitingTasksToExecutor.
+    absl::MutexLock lock(&mutex_);
+    ++num_tasks_to_add_;
+    tasks_to_add = running_count_ > 0 ? GetTasksToSubmitToExecutor() : 0;
+  }
+  if (was_idle && idle_callback_) {
+    // Became not idle.
+    idle_callback_(false);
+  }
+  while (tasks_to_add > 0) {
+    executor_->AddTask(this);
+    --tasks_to_add;
+  }
+}
+
 int SchedulerQueue::GetTasksToSubmitToExecutor() {
   int tasks_to_add = num_tasks_to_add_;
   num_tasks_to_add_ = 0;
-  num_pending_tasks_ += tasks_to_add;
+  // Tasks of a sharded queue are tracked by num_sharded_items_ alone.
+  if (shards_.empty()) {
+    num_pending_tasks_ += tasks_to_add;
+  }
   return tasks_to_add;
 }
 
@@ -185,11 +247,47 @@ void SchedulerQueue::SubmitWaitingTasksToExecutor() {
   }
 }
 
+void SchedulerQueue::PushToShard(Item&& item) {
+  Shard& shard = *shards_[ThreadShardHint() % shards_.size()];
+  absl::MutexLock lock(&shard.mutex);
+  shard.queue.push(std::move(item));
+}
+
+SchedulerQueue::Item SchedulerQueue::PopFromShards() {
+  const int num_shards = shards_.size();
+  const int home = ThreadShardHint() % num_shards;
+  // Items are pushed before their tasks are submitted, so there are at least
+  // as many queued items as tasks that have not popped one. A scan can still
+  // come back empty if other tasks emptied the shards it had already visited
+  // and new items were pushed to those shards. Every such retry means that
+  // another task made progress, so the loop does not wait on anything.
+  while (true) {
+    // Visit the home shard first, then steal from the others in order.
+    for (int i = 0; i < num_shards; ++i) {
+      Shard& shard = *shards_[(home + i) % num_shards];
+      absl::MutexLock lock(&shard.mutex);
+      if (!shard.queue.empty()) {
+        Item item = shard.queue.top();
+        shard.queue.pop();
+        return item;
+      }
+    }
+  }
+}
+
 void SchedulerQueue::RunNextTask() {
   CalculatorNode* node;
   CalculatorContext* calculator_context;
   bool is_open_node;
-  {
+  if (!shards_.empty()) {
+    Item item = PopFromShards();
+    node = item.Node();
+    calculator_context = item.Context();
+    is_open_node = item.IsOpenNode();
+
+    CHECK(!node->Closed())
+        << "Scheduled a node that was closed. This should not happen.";
+  } else {
     absl::MutexLock lock(&mutex_);
 
     CHECK(!queue_.empty()) << "Called RunNextTask when the queue is empty. "
@@ -219,7 +317,12 @@ void SchedulerQueue::RunNextTask() {
   }
 
   bool is_idle;
-  {
+  if (!shards_.empty()) {
+    const int num_items =
+        num_sharded_items_.fetch_sub(1, std::memory_order_acq_rel);
+    DCHECK_GT(num_items, 0);
+    is_idle = num_items == 1;
+  } else {
     absl::MutexLock lock(&mutex_);
     DCHECK_GT(num_pending_tasks_, 0);
     --num_pending_tasks_;
@@ -298,9 +401,23 @@ void SchedulerQueue::CleanupAfterRun() {
   bool was_idle;
   {
     absl::MutexLock lock(&mutex_);
-    was_idle = IsIdle();
     CHECK_EQ(num_pending_tasks_, 0);
-    CHECK_EQ(num_tasks_to_add_, queue_.size());
+    if (shards_.empty()) {
+      was_idle = IsIdle();
+      CHECK_EQ(num_tasks_to_add_, queue_.size());
+    } else {
+      // The tasks that were submitted have all completed, so only the items
+      // of tasks that were never submitted remain.
+      const int num_items = num_sharded_items_.exchange(0);
+      was_idle = num_items == 0;
+      CHECK_EQ(num_tasks_to_add_, num_items);
+      for (auto& shard : shards_) {
+        absl::MutexLock shard_lock(&shard->mutex);
+        while (!shard->queue.empty()) {
+          shard->queue.pop();
+        }
+      }
+    }
     num_tasks_to_add_ = 0;
     while (!queue_.empty()) {
       queue_.pop();
@@ -20,6 +20,7 @@
 #include <memory>
 #include <queue>
 #include <utility>
+#include <vector>
 
 #include "absl/base/macros.h"
 #include "absl/synchronization/mutex.h"
@@ -82,6 +83,16 @@ class SchedulerQueue : public TaskQueue {
   // scheduler is started.
   void SetExecutor(Executor* executor);
 
+  // Splits the ready queue into num_shards priority queues. Each thread pushes
+  // to and pops from its own shard, and steals the highest priority item of
+  // another shard when its own shard is empty. While the queue is running,
+  // adding and completing a task only lock a shard and update atomic
+  // counters, so the worker threads no longer share a critical section.
+  // Items are ordered by priority only within each shard. A value of 1 (the
+  // default) keeps a single priority queue. Must be called before the
+  // scheduler is started.
+  void SetNumShards(int num_shards);
+
   // Sets the idle callback. It is called exactly once whenever the queue goes
   // from idle to active, or vice versa.
   // Note: if the queue is accessed by multiple threads, it is possible for
@@ -142,9 +153,29 @@ class SchedulerQueue : public TaskQueue {
   // CheckIfBecameReady.
   void OpenCalculatorNode(CalculatorNode* node) ABSL_LOCKS_EXCLUDED(mutex_);
 
-  // Checks whether the queue has no queued nodes or pending tasks.
+  // Checks whether the queue has no queued nodes or pending tasks. Only used
+  // when the queue is not sharded.
   bool IsIdle() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
+  // Implements AddItemToQueue when the queue is sharded.
+  void AddItemToShards(Item&& item) ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Pushes an item to the shard of the calling thread. Only used when the
+  // queue is sharded.
+  void PushToShard(Item&& item) ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Pops an item from the shard of the calling thread, or steals one from
+  // another shard. Only used when the queue is sharded. Must only be called
+  // for a task that has been submitted to the executor, which guarantees that
+  // a matching item has been or is about to be pushed.
+  Item PopFromShards() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // One partition of the ready queue when the queue is sharded.
+  struct Shard {
+    absl::Mutex mutex;
+    std::priority_queue<Item> queue ABSL_GUARDED_BY(mutex);
+  };
+
   Executor* executor_ = nullptr;
 
   IdleCallback idle_callback_;
@@ -156,15 +187,28 @@ class SchedulerQueue : public TaskQueue {
   // Invariant: running_count_ <= 1.
   int running_count_ ABSL_GUARDED_BY(mutex_) = 0;
 
-  // Number of tasks added to the Executor and not yet complete.
+  // Whether running_count_ > 0. Lets AddItemToShards skip mutex_ while the
+  // queue is running.
+  std::atomic<bool> running_{false};
+
+  // Number of tasks added to the Executor and not yet complete. Unused when
+  // the queue is sharded.
   int num_pending_tasks_ ABSL_GUARDED_BY(mutex_);
 
   // Number of tasks that need to be added to the Executor.
   int num_tasks_to_add_ ABSL_GUARDED_BY(mutex_);
 
-  // Queue of nodes that need to be run.
+  // Queue of nodes that need to be run. Unused when the queue is sharded.
   std::priority_queue<Item> queue_ ABSL_GUARDED_BY(mutex_);
 
+  // Shards of the ready queue. Empty unless SetNumShards was called with a
+  // value greater than 1.
+  std::vector<std::unique_ptr<Shard>> shards_;
+
+  // Number of items added to shards_ and not yet run to completion. The
+  // sharded queue is idle when this is 0.
+  std::atomic<int> num_sharded_items_{0};
+
   SchedulerShared* const shared_;
 
   absl::Mutex mutex_;
@@ -0,0 +1,67 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+
+#include "mediapipe/framework/stream_handler/batch_input_stream_handler.pb.h"
+#include "mediapipe/framework/stream_handler/default_input_stream_handler.h"
+
+namespace mediapipe {
+
+// Input stream handler that delivers the input sets queued for a node in
+// batches of up to max_batch_size timestamps. Input sets are aligned as by
+// DefaultInputStreamHandler. A batch is scheduled as soon as it is complete,
+// or as soon as no more input sets are ready, so batching does not add
+// latency: a node that keeps up with its inputs still runs once per
+// timestamp, and a node that falls behind catches up with larger batches.
+//
+// Calculators whose contract declares SetProcessBatches(true) process a
+// batch in a single Process() call. Other calculators are called once per
+// timestamp of the batch, which still saves the scheduling of each call.
+//
+// Example config:
+//
+// node {
+//   calculator: "PassThroughCalculator"
+//   input_stream: "in"
+//   output_stream: "out"
+//   input_stream_handler {
+//     input_stream_handler: "BatchInputStreamHandler"
+//     options {
+//       [mediapipe.BatchInputStreamHandlerOptions.ext] {
+//         max_batch_size: 16
+//       }
+//     }
+//   }
+// }
+//
+// Batching cannot be combined with max_in_flight > 1, and is not supported
+// for source nodes.
+class BatchInputStreamHandler : public DefaultInputStreamHandler {
+ public:
+  BatchInputStreamHandler() = delete;
+  BatchInputStreamHandler(std::shared_ptr<tool::TagMap> tag_map,
+                          CalculatorContextManager* cc_manager,
+                          const MediaPipeOptions& options,
+                          bool calculator_run_in_parallel)
+      : DefaultInputStreamHandler(std::move(tag_map), cc_manager, options,
+                                  calculator_run_in_parallel) {
+    const auto& ext = options.GetExtension(BatchInputStreamHandlerOptions::ext);
+    SetBatchSize(ext.max_batch_size());
+    SetScheduleIncompleteBatches(true);
+  }
+};
+REGISTER_INPUT_STREAM_HANDLER(BatchInputStreamHandler);
+
+}  // namespace mediapipe
@@ -0,0 +1,229 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/stream_handler/batch_input_stream_handler.pb.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+
+constexpr int kNumBurstPackets = 10;
+
+// Outputs kNumBurstPackets packets at timestamps 0, 1, ... in a single
+// Process() call, so that they are all queued at once for the next node.
+class BurstSourceCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Outputs().Index(0).Set<int>();
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) final {
+    for (int i = 0; i < kNumBurstPackets; ++i) {
+      cc->Outputs().Index(0).AddPacket(MakePacket<int>(i).At(Timestamp(i)));
+    }
+    return tool::StatusStop();
+  }
+};
+REGISTER_CALCULATOR(BurstSourceCalculator);
+
+// Passes its input through, and outputs the batch size of every Process()
+// call in its BATCH_SIZE output stream.
+template <bool kProcessBatches>
+class BatchSizeCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<int>();
+    cc->Outputs().Index(0).Set<int>();
+    cc->Outputs().Tag("BATCH_SIZE").Set<int>();
+    cc->SetProcessBatches(kProcessBatches);
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) final {
+    for (int i = 0; i < cc->BatchSize(); ++i) {
+      const Packet& packet = cc->Inputs().Index(0).BatchValue(i);
+      EXPECT_EQ(packet.Timestamp(), cc->BatchInputTimestamp(i));
+      cc->Outputs().Index(0).AddPacket(packet);
+    }
+    cc->Outputs()
+        .Get("BATCH_SIZE", 0)
+        .AddPacket(MakePacket<int>(cc->BatchSize()).At(cc->InputTimestamp()));
+    return absl::OkStatus();
+  }
+};
+using BatchProcessingCalculator = BatchSizeCalculator<true>;
+REGISTER_CALCULATOR(BatchProcessingCalculator);
+using TimestampProcessingCalculator = BatchSizeCalculator<false>;
+REGISTER_CALCULATOR(TimestampProcessingCalculator);
+
+CalculatorGraphConfig MakeBurstConfig(const std::string& calculator,
+                                      int max_batch_size) {
+  CalculatorGraphConfig config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        node { calculator: "BurstSourceCalculator" output_stream: "burst" }
+        node {
+          input_stream: "burst"
+          output_stream: "out"
+          output_stream: "BATCH_SIZE:batch_size"
+          input_stream_handler {
+            input_stream_handler: "BatchInputStreamHandler"
+          }
+        }
+      )pb");
+  CalculatorGraphConfig::Node* node = config.mutable_node(1);
+  node->set_calculator(calculator);
+  node->mutable_input_stream_handler()
+      ->mutable_options()
+      ->MutableExtension(BatchInputStreamHandlerOptions::ext)
+      ->set_max_batch_size(max_batch_size);
+  return config;
+}
+
+std::vector<int> PacketValues(const std::vector<Packet>& packets) {
+  std::vector<int> values;
+  for (const Packet& packet : packets) {
+    values.push_back(packet.Get<int>());
+  }
+  return values;
+}
+
+TEST(BatchInputStreamHandlerTest, ProcessesQueuedTimestampsInBatches) {
+  CalculatorGraphConfig config =
+      MakeBurstConfig("BatchProcessingCalculator", /*max_batch_size=*/4);
+  std::vector<Packet> out;
+  std::vector<Packet> batch_sizes;
+  tool::AddVectorSink("out", &config, &out);
+  tool::AddVectorSink("batch_size", &config, &batch_sizes);
+
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.Run());
+
+  EXPECT_THAT(PacketValues(out),
+              ElementsAreArray({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+  EXPECT_THAT(PacketValues(batch_sizes), ElementsAre(4, 4, 2));
+  EXPECT_EQ(batch_sizes[1].Timestamp(), Timestamp(4));
+}
+
+TEST(BatchInputStreamHandlerTest, CallsProcessPerTimestampWithoutOptIn) {
+  CalculatorGraphConfig config =
+      MakeBurstConfig("TimestampProcessingCalculator", /*max_batch_size=*/4);
+  std::vector<Packet> out;
+  std::vector<Packet> batch_sizes;
+  tool::AddVectorSink("out", &config, &out);
+  tool::AddVectorSink("batch_size", &config, &batch_sizes);
+
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.Run());
+
+  EXPECT_THAT(PacketValues(out),
+              ElementsAreArray({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+  EXPECT_THAT(PacketValues(batch_sizes),
+              ElementsAreArray(std::vector<int>(kNumBurstPackets, 1)));
+}
+
+// Unlike the batching of DefaultInputStreamHandler, an incomplete batch is
+// processed as soon as no more timestamps are ready.
+TEST(BatchInputStreamHandlerTest, DoesNotWaitForCompleteBatches) {
+  CalculatorGraphConfig config = ParseTextProtoOrDie<CalculatorGraphConfig>(
+      R"pb(
+        input_stream: "in"
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "in"
+          output_stream: "out"
+          input_stream_handler {
+            input_stream_handler: "BatchInputStreamHandler"
+            options {
+              [mediapipe.BatchInputStreamHandlerOptions.ext] {
+                max_batch_size: 8
+              }
+            }
+          }
+        }
+      )pb");
+  std::vector<Packet> out;
+  tool::AddVectorSink("out", &config, &out);
+
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun({}));
+  for (int i = 0; i < 3; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(i).At(Timestamp(i))));
+    MP_ASSERT_OK(graph.WaitUntilIdle());
+    EXPECT_EQ(out.size(), i + 1);
+  }
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+  EXPECT_THAT(PacketValues(out), ElementsAre(0, 1, 2));
+}
+
+// Measures the overhead per packet of a chain of PassThroughCalculators, which
+// run on a single thread and therefore fall behind their inputs. The argument
+// is the maximum batch size, or 1 for DefaultInputStreamHandler.
+void BM_PassThroughChain(benchmark::State& state) {
+  constexpr int kNumNodes = 20;
+  constexpr int kNumPackets = 1000;
+  const int max_batch_size = state.range(0);
+  CalculatorGraphConfig config;
+  config.add_input_stream("in0");
+  config.set_num_threads(1);
+  for (int i = 0; i < kNumNodes; ++i) {
+    CalculatorGraphConfig::Node* node = config.add_node();
+    node->set_calculator("PassThroughCalculator");
+    node->add_input_stream(absl::StrCat("in", i));
+    node->add_output_stream(absl::StrCat("in", i + 1));
+    if (max_batch_size > 1) {
+      auto* handler = node->mutable_input_stream_handler();
+      handler->set_input_stream_handler("BatchInputStreamHandler");
+      handler->mutable_options()
+          ->MutableExtension(BatchInputStreamHandlerOptions::ext)
+          ->set_max_batch_size(max_batch_size);
+    }
+  }
+  CalculatorGraph graph;
+  CHECK(graph.Initialize(config).ok());
+  for (auto _ : state) {
+    CHECK(graph.StartRun({}).ok());
+    for (int t = 0; t < kNumPackets; ++t) {
+      CHECK(graph
+                .AddPacketToInputStream("in0",
+                                        MakePacket<int>(t).At(Timestamp(t)))
+                .ok());
+    }
+    CHECK(graph.CloseAllInputStreams().ok());
+    CHECK(graph.WaitUntilDone().ok());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumPackets * kNumNodes);
+}
+BENCHMARK(BM_PassThroughChain)->Arg(1)->Arg(4)->Arg(16)->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,110 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// A command line utility to compile a text proto graph into a binary
+// CompiledGraphConfig, which CalculatorGraph::Initialize loads without
+// expanding subgraphs or sorting nodes.  It must be linked with the
+// calculators and subgraphs used by the graph.
+
+#include <stdlib.h>
+
+#include <fstream>
+#include <string>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/compiled_graph_config.pb.h"
+#include "mediapipe/framework/port/advanced_proto_inc.h"
+#include "mediapipe/framework/port/canonical_errors.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/tool/node_fusion.h"
+#include "mediapipe/framework/validated_graph_config.h"
+
+ABSL_FLAG(std::string, proto_source, "",
+          "The source file containing CalculatorGraphConfig protobuf text.");
+ABSL_FLAG(std::string, proto_output, "",
+          "An output file in binary CompiledGraphConfig form.");
+ABSL_FLAG(bool, fuse_nodes, false,
+          "Replaces chains of nodes with FusedCalculator nodes, see "
+          "mediapipe/framework/tool/node_fusion.h.");
+
+#define EXIT_IF_ERROR(status) \
+  if (!status.ok()) {         \
+    LOG(ERROR) << status;     \
+    return EXIT_FAILURE;      \
+  }
+
+namespace mediapipe {
+
+absl::Status ReadTextFile(const std::string& proto_source,
+                          proto_ns::Message* result) {
+  std::ifstream ifs(proto_source);
+  proto_ns::io::IstreamInputStream in(&ifs);
+  RET_CHECK(proto_ns::TextFormat::Parse(&in, result))
+      << "could not parse text proto: " << proto_source;
+  return absl::OkStatus();
+}
+
+absl::Status WriteBinaryFile(const std::string& proto_output,
+                             const proto_ns::Message& message) {
+  std::ofstream ofs(proto_output, std::ios_base::out | std::ios_base::trunc |
+                                      std::ios_base::binary);
+  proto_ns::io::OstreamOutputStream out(&ofs);
+  RET_CHECK(message.SerializeToZeroCopyStream(&out))
+      << "could not write binary proto to: " << proto_output;
+  return absl::OkStatus();
+}
+
+absl::Status CompileGraph(const std::string& proto_source,
+                          const std::string& proto_output, bool fuse_nodes) {
+  CalculatorGraphConfig config;
+  MP_RETURN_IF_ERROR(ReadTextFile(proto_source, &config));
+  if (fuse_nodes) {
+    ValidatedGraphConfig unfused_graph;
+    MP_RETURN_IF_ERROR(unfused_graph.Initialize(std::move(config)));
+    ASSIGN_OR_RETURN(config, tool::FuseNodes(unfused_graph));
+  }
+  ValidatedGraphConfig validated_graph;
+  MP_RETURN_IF_ERROR(validated_graph.Initialize(std::move(config)));
+  ASSIGN_OR_RETURN(CompiledGraphConfig compiled_config,
+                   validated_graph.Compile());
+  return WriteBinaryFile(proto_output, compiled_config);
+}
+
+}  // namespace mediapipe
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  absl::ParseCommandLine(argc, argv);
+
+  // Validate command line options.
+  absl::Status status;
+  if (absl::GetFlag(FLAGS_proto_source).empty()) {
+    status.Update(
+        absl::InvalidArgumentError("--proto_source must be specified"));
+  }
+  if (absl::GetFlag(FLAGS_proto_output).empty()) {
+    status.Update(
+        absl::InvalidArgumentError("--proto_output must be specified"));
+  }
+  if (!status.ok()) {
+    return EXIT_FAILURE;
+  }
+  EXIT_IF_ERROR(mediapipe::CompileGraph(absl::GetFlag(FLAGS_proto_source),
+                                        absl::GetFlag(FLAGS_proto_output),
+                                        absl::GetFlag(FLAGS_fuse_nodes)));
+  return EXIT_SUCCESS;
+}
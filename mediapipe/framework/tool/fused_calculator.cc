@@ -0,0 +1,522 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/substitute.h"
+#include "mediapipe/framework/calculator_base.h"
+#include "mediapipe/framework/calculator_context.h"
+#include "mediapipe/framework/calculator_context_manager.h"
+#include "mediapipe/framework/calculator_contract.h"
+#include "mediapipe/framework/calculator_registry.h"
+#include "mediapipe/framework/calculator_state.h"
+#include "mediapipe/framework/collection_item_id.h"
+#include "mediapipe/framework/input_stream_shard.h"
+#include "mediapipe/framework/legacy_calculator_support.h"
+#include "mediapipe/framework/output_stream_shard.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/packet_set.h"
+#include "mediapipe/framework/packet_type.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/framework/timestamp.h"
+#include "mediapipe/framework/tool/fused_calculator.pb.h"
+#include "mediapipe/framework/tool/status_util.h"
+#include "mediapipe/framework/tool/tag_map.h"
+
+namespace mediapipe {
+
+namespace {
+
+// Returns the ids of the entries of |tag_map| by stream or side packet name.
+absl::flat_hash_map<std::string, CollectionItemId> IdsByName(
+    const tool::TagMap& tag_map) {
+  absl::flat_hash_map<std::string, CollectionItemId> ids;
+  for (CollectionItemId id = tag_map.BeginId(); id < tag_map.EndId(); ++id) {
+    ids[tag_map.Names()[id.value()]] = id;
+  }
+  return ids;
+}
+
+}  // namespace
+
+// Runs a chain of calculator nodes back to back within a single node, so that
+// the packets between them are not queued and scheduled as separate tasks.
+// The FusedCalculator node is written by tool::FuseNodes(), see node_fusion.h.
+//
+// Each fused node gets its own CalculatorContext with the streams and side
+// packets of its config. As with DefaultInputStreamHandler, a fused node is
+// invoked at a timestamp only if one of its input streams has a packet at
+// that timestamp. Streams produced and consumed by fused nodes only exist
+// within the FusedCalculator, and their packets must have the input
+// timestamp. All other streams and side packets of the fused nodes are
+// connected to the FusedCalculator node under the same name.
+//
+// Example config:
+// node {
+//   calculator: "FusedCalculator"
+//   input_stream: "in"
+//   output_stream: "out"
+//   options {
+//     [mediapipe.FusedCalculatorOptions.ext] {
+//       node {
+//         calculator: "PassThroughCalculator"
+//         input_stream: "in"
+//         output_stream: "in_copy"
+//       }
+//       node {
+//         calculator: "PassThroughCalculator"
+//         input_stream: "in_copy"
+//         output_stream: "out"
+//       }
+//     }
+//   }
+// }
+class FusedCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc);
+
+  absl::Status Open(CalculatorContext* cc) override;
+  absl::Status Process(CalculatorContext* cc) override;
+  absl::Status Close(CalculatorContext* cc) override;
+
+ private:
+  // Where an input or output stream of a fused node is connected.
+  struct Connection {
+    // The stream of the FusedCalculator node, if any.
+    CollectionItemId outer_id;
+    // The index in packets_ of the stream between fused nodes, if any.
+    int internal_index = -1;
+  };
+
+  // Packets on the streams between fused nodes by timestamp, as pairs of
+  // index in packets_ and packet.
+  using InternalPackets =
+      std::map<Timestamp, std::vector<std::pair<int, Packet>>>;
+
+  // The state of one fused node.
+  struct Stage {
+    std::string name;
+    std::unique_ptr<CalculatorState> state;
+    CalculatorContextManager context_manager;
+    std::unique_ptr<CalculatorBase> calculator;
+    std::unique_ptr<PacketSet> input_side_packets;
+    std::unique_ptr<OutputSidePacketSet> output_side_packets;
+    // Indexed by the CollectionItemIds of the fused node.
+    std::vector<std::string> input_names;
+    std::vector<OutputStreamSpec> output_specs;
+    std::vector<Connection> inputs;
+    std::vector<Connection> outputs;
+  };
+
+  // Creates the calculator and the context of a fused node.
+  absl::Status InitializeStage(const CalculatorGraphConfig::Node& node,
+                               const std::string& package,
+                               CalculatorContext* cc, Stage* stage);
+
+  // Calls Process() of the stages from |first_stage| on at |timestamp|.
+  absl::Status ProcessStages(int first_stage, Timestamp timestamp,
+                             CalculatorContext* cc);
+
+  // Moves the packets output by |stage| to the output streams of the
+  // FusedCalculator, and to the streams between fused nodes. The latter are
+  // stored in |internal_packets| by timestamp if it is not null, and must
+  // have |timestamp| otherwise.
+  absl::Status CollectOutputs(Stage* stage, Timestamp timestamp,
+                              InternalPackets* internal_packets,
+                              CalculatorContext* cc);
+
+  std::vector<std::unique_ptr<Stage>> stages_;
+  // The current packet of each stream between fused nodes.
+  std::vector<Packet> packets_;
+  PacketType any_type_;
+  // Errors reported by the output stream shards of the fused nodes.
+  absl::Status stream_status_;
+};
+REGISTER_CALCULATOR(FusedCalculator);
+
+absl::Status FusedCalculator::GetContract(CalculatorContract* cc) {
+  const auto& options = cc->Options<FusedCalculatorOptions>();
+  RET_CHECK_GT(options.node_size(), 0) << "No node to run.";
+  for (CollectionItemId id = cc->Inputs().BeginId();
+       id < cc->Inputs().EndId(); ++id) {
+    cc->Inputs().Get(id).SetAny();
+  }
+  for (CollectionItemId id = cc->Outputs().BeginId();
+       id < cc->Outputs().EndId(); ++id) {
+    cc->Outputs().Get(id).SetAny();
+  }
+
+  // A side packet is optional only if no fused node requires it.
+  absl::flat_hash_set<std::string> required_side_packets;
+  for (const auto& node : options.node()) {
+    CalculatorContract contract;
+    MP_RETURN_IF_ERROR(contract.Initialize(node));
+    LegacyCalculatorSupport::Scoped<CalculatorContract> s(&contract);
+    ASSIGN_OR_RETURN(auto calculator_factory,
+                     CalculatorBaseRegistry::CreateByNameInNamespace(
+                         options.package(), node.calculator()));
+    MP_RETURN_IF_ERROR(calculator_factory->GetContract(&contract))
+            .SetPrepend()
+        << node.calculator() << ": ";
+    const PacketTypeSet& side_packets = contract.InputSidePackets();
+    for (CollectionItemId id = side_packets.BeginId();
+         id < side_packets.EndId(); ++id) {
+      if (!side_packets.Get(id).IsOptional()) {
+        required_side_packets.insert(
+            side_packets.TagMap()->Names()[id.value()]);
+      }
+    }
+  }
+  for (CollectionItemId id = cc->InputSidePackets().BeginId();
+       id < cc->InputSidePackets().EndId(); ++id) {
+    PacketType& side_packet = cc->InputSidePackets().Get(id).SetAny();
+    if (!required_side_packets.contains(
+            cc->InputSidePackets().TagMap()->Names()[id.value()])) {
+      side_packet.Optional();
+    }
+  }
+
+  // Only nodes with zero timestamp offset are fused.
+  cc->SetTimestampOffset(TimestampDiff(0));
+  return absl::OkStatus();
+}
+
+absl::Status FusedCalculator::InitializeStage(
+    const CalculatorGraphConfig::Node& node, const std::string& package,
+    CalculatorContext* cc, Stage* stage) {
+  RET_CHECK(node.output_side_packet().empty())
+      << "Nodes with output side packets cannot be fused.";
+  ASSIGN_OR_RETURN(auto input_tag_map,
+                   tool::TagMap::Create(node.input_stream()));
+  ASSIGN_OR_RETURN(auto output_tag_map,
+                   tool::TagMap::Create(node.output_stream()));
+  ASSIGN_OR_RETURN(auto side_packet_tag_map,
+                   tool::TagMap::Create(node.input_side_packet()));
+  ASSIGN_OR_RETURN(auto output_side_packet_tag_map,
+                   tool::TagMap::Create(node.output_side_packet()));
+
+  stage->name = node.name().empty() ? node.calculator() : node.name();
+  stage->state = absl::make_unique<CalculatorState>(
+      stage->name, cc->NodeId(), node.calculator(), node,
+      /*profiling_context=*/nullptr);
+
+  const auto outer_side_packet_ids =
+      IdsByName(*cc->InputSidePackets().TagMap());
+  stage->input_side_packets = absl::make_unique<PacketSet>(side_packet_tag_map);
+  for (CollectionItemId id = side_packet_tag_map->BeginId();
+       id < side_packet_tag_map->EndId(); ++id) {
+    const std::string& name = side_packet_tag_map->Names()[id.value()];
+    auto iter = outer_side_packet_ids.find(name);
+    RET_CHECK(iter != outer_side_packet_ids.end())
+        << "Side packet \"" << name << "\" is not connected.";
+    stage->input_side_packets->Get(id) =
+        cc->InputSidePackets().Get(iter->second);
+  }
+  stage->output_side_packets =
+      absl::make_unique<OutputSidePacketSet>(output_side_packet_tag_map);
+  stage->state->SetInputSidePackets(stage->input_side_packets.get());
+  stage->state->SetOutputSidePackets(stage->output_side_packets.get());
+  stage->state->SetCounterFactory(cc->GetCounterFactory());
+
+  stage->input_names = input_tag_map->Names();
+  stage->output_specs.resize(output_tag_map->NumEntries());
+  for (int i = 0; i < stage->output_specs.size(); ++i) {
+    OutputStreamSpec& spec = stage->output_specs[i];
+    spec.name = output_tag_map->Names()[i];
+    spec.packet_type = &any_type_;
+    spec.error_callback = [this](const absl::Status& status) {
+      stream_status_.Update(status);
+    };
+    spec.locked_intro_data = false;
+    spec.offset_enabled = false;
+  }
+  stage->inputs.resize(input_tag_map->NumEntries());
+  stage->outputs.resize(output_tag_map->NumEntries());
+
+  stage->context_manager.Initialize(stage->state.get(), input_tag_map,
+                                    output_tag_map,
+                                    /*calculator_run_in_parallel=*/false);
+  MP_RETURN_IF_ERROR(stage->context_manager.PrepareForRun(
+      [stage](CalculatorContext* context) {
+        for (CollectionItemId id = context->Inputs().BeginId();
+             id < context->Inputs().EndId(); ++id) {
+          context->Inputs().Get(id).SetName(&stage->input_names[id.value()]);
+        }
+        for (CollectionItemId id = context->Outputs().BeginId();
+             id < context->Outputs().EndId(); ++id) {
+          context->Outputs().Get(id).SetSpec(&stage->output_specs[id.value()]);
+        }
+        return absl::OkStatus();
+      }));
+
+  ASSIGN_OR_RETURN(auto calculator_factory,
+                   CalculatorBaseRegistry::CreateByNameInNamespace(
+                       package, node.calculator()));
+  stage->calculator = calculator_factory->CreateCalculator(
+      stage->context_manager.GetDefaultCalculatorContext());
+  return absl::OkStatus();
+}
+
+absl::Status FusedCalculator::Open(CalculatorContext* cc) {
+  const auto& options = cc->Options<FusedCalculatorOptions>();
+  const auto outer_input_ids = IdsByName(*cc->Inputs().TagMap());
+  const auto outer_output_ids = IdsByName(*cc->Outputs().TagMap());
+  any_type_.SetAny();
+
+  // Connects the streams of the fused nodes. A stream consumed by a fused node
+  // and produced by an earlier one is a stream between fused nodes.
+  absl::flat_hash_map<std::string, std::pair<Stage*, int>> producers;
+  for (const auto& node : options.node()) {
+    stages_.push_back(absl::make_unique<Stage>());
+    Stage* stage = stages_.back().get();
+    MP_RETURN_IF_ERROR(InitializeStage(node, options.package(), cc, stage));
+    for (int i = 0; i < stage->inputs.size(); ++i) {
+      const std::string& name = stage->input_names[i];
+      auto producer = producers.find(name);
+      if (producer != producers.end()) {
+        Connection& output =
+            producer->second.first->outputs[producer->second.second];
+        if (output.internal_index < 0) {
+          output.internal_index = packets_.size();
+          packets_.emplace_back();
+        }
+        stage->inputs[i].internal_index = output.internal_index;
+        continue;
+      }
+      auto iter = outer_input_ids.find(name);
+      RET_CHECK(iter != outer_input_ids.end())
+          << "Input stream \"" << name << "\" is not connected.";
+      stage->inputs[i].outer_id = iter->second;
+    }
+    for (int i = 0; i < stage->outputs.size(); ++i) {
+      const std::string& name = stage->output_specs[i].name;
+      RET_CHECK(producers.emplace(name, std::make_pair(stage, i)).second)
+          << "Output stream \"" << name << "\" is produced twice.";
+      auto iter = outer_output_ids.find(name);
+      if (iter != outer_output_ids.end()) {
+        stage->outputs[i].outer_id = iter->second;
+      }
+    }
+  }
+
+  // Opens the fused nodes in order, so that each one sees the headers set by
+  // the previous ones.
+  std::vector<Packet> headers(packets_.size());
+  for (auto& stage : stages_) {
+    CalculatorContext* context =
+        stage->context_manager.GetDefaultCalculatorContext();
+    for (CollectionItemId id = context->Inputs().BeginId();
+         id < context->Inputs().EndId(); ++id) {
+      const Connection& input = stage->inputs[id.value()];
+      context->Inputs().Get(id).SetHeader(
+          input.internal_index >= 0
+              ? headers[input.internal_index]
+              : cc->Inputs().Get(input.outer_id).Header());
+    }
+    for (CollectionItemId id = context->Outputs().BeginId();
+         id < context->Outputs().EndId(); ++id) {
+      context->Outputs().Get(id).Reset(Timestamp::PreStream(), false);
+    }
+    stage->context_manager.PushInputTimestampToContext(context,
+                                                       Timestamp::Unstarted());
+    absl::Status status;
+    {
+      LegacyCalculatorSupport::Scoped<CalculatorContext> s(context);
+      status = stage->calculator->Open(context);
+    }
+    stage->context_manager.PopInputTimestampFromContext(context);
+    MP_RETURN_IF_ERROR(status).SetPrepend() << absl::Substitute(
+        "Calculator::Open() for fused node \"$0\" failed: ", stage->name);
+    MP_RETURN_IF_ERROR(stream_status_);
+
+    for (int i = 0; i < stage->outputs.size(); ++i) {
+      OutputStreamSpec& spec = stage->output_specs[i];
+      spec.locked_intro_data = true;
+      const Connection& output = stage->outputs[i];
+      if (output.internal_index >= 0) {
+        headers[output.internal_index] = spec.header;
+      }
+      if (output.outer_id.IsValid() && !spec.header.IsEmpty()) {
+        cc->Outputs().Get(output.outer_id).SetHeader(spec.header);
+      }
+    }
+    MP_RETURN_IF_ERROR(
+        CollectOutputs(stage.get(), Timestamp::Unset(), nullptr, cc));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status FusedCalculator::Process(CalculatorContext* cc) {
+  std::fill(packets_.begin(), packets_.end(), Packet());
+  return ProcessStages(0, cc->InputTimestamp(), cc);
+}
+
+absl::Status FusedCalculator::ProcessStages(int first_stage,
+                                            Timestamp timestamp,
+                                            CalculatorContext* cc) {
+  // As in CalculatorNode::ProcessNode(), StatusStop() from a node stops the
+  // graph after its outputs have been propagated.
+  bool stopped = false;
+  for (int s = first_stage; s < stages_.size(); ++s) {
+    Stage* stage = stages_[s].get();
+    CalculatorContext* context =
+        stage->context_manager.GetDefaultCalculatorContext();
+    bool has_packet = false;
+    for (const Connection& input : stage->inputs) {
+      const Packet& packet = input.internal_index >= 0
+                                 ? packets_[input.internal_index]
+                                 : cc->Inputs().Get(input.outer_id).Value();
+      has_packet |= !packet.IsEmpty();
+    }
+    if (!has_packet) {
+      continue;
+    }
+
+    for (CollectionItemId id = context->Inputs().BeginId();
+         id < context->Inputs().EndId(); ++id) {
+      const Connection& input = stage->inputs[id.value()];
+      Packet packet = input.internal_index >= 0
+                          ? packets_[input.internal_index]
+                          : cc->Inputs().Get(input.outer_id).Value();
+      context->Inputs().Get(id).AddPacket(std::move(packet),
+                                          /*is_done=*/false);
+    }
+    for (CollectionItemId id = context->Outputs().BeginId();
+         id < context->Outputs().EndId(); ++id) {
+      OutputStreamShard& output = context->Outputs().Get(id);
+      output.Reset(std::max(output.NextTimestampBound(), timestamp), false);
+    }
+    stage->context_manager.PushInputTimestampToContext(context, timestamp);
+    absl::Status status;
+    {
+      LegacyCalculatorSupport::Scoped<CalculatorContext> s(context);
+      status = stage->calculator->Process(context);
+    }
+    stage->context_manager.PopInputTimestampFromContext(context);
+    for (CollectionItemId id = context->Inputs().BeginId();
+         id < context->Inputs().EndId(); ++id) {
+      context->Inputs().Get(id).ClearCurrentPacket();
+    }
+
+    if (status == tool::StatusStop()) {
+      stopped = true;
+    } else {
+      MP_RETURN_IF_ERROR(status).SetPrepend() << absl::Substitute(
+          "Calculator::Process() for fused node \"$0\" failed: ", stage->name);
+    }
+    MP_RETURN_IF_ERROR(stream_status_);
+    MP_RETURN_IF_ERROR(CollectOutputs(stage, timestamp, nullptr, cc));
+  }
+  return stopped ? tool::StatusStop() : absl::OkStatus();
+}
+
+absl::Status FusedCalculator::CollectOutputs(Stage* stage, Timestamp timestamp,
+                                             InternalPackets* internal_packets,
+                                             CalculatorContext* cc) {
+  CalculatorContext* context =
+      stage->context_manager.GetDefaultCalculatorContext();
+  for (CollectionItemId id = context->Outputs().BeginId();
+       id < context->Outputs().EndId(); ++id) {
+    OutputStreamShard& shard = context->Outputs().Get(id);
+    const Connection& output = stage->outputs[id.value()];
+    for (Packet& packet : *shard.OutputQueue()) {
+      if (output.internal_index >= 0) {
+        if (internal_packets) {
+          (*internal_packets)[packet.Timestamp()].emplace_back(
+              output.internal_index, packet);
+        } else {
+          RET_CHECK(packet.Timestamp() == timestamp)
+              << "Fused node \"" << stage->name << "\" output a packet at "
+              << packet.Timestamp().DebugString() << " on stream \""
+              << shard.Name() << "\", expected " << timestamp.DebugString()
+              << ".";
+          packets_[output.internal_index] = packet;
+        }
+      }
+      if (output.outer_id.IsValid()) {
+        cc->Outputs().Get(output.outer_id).AddPacket(std::move(packet));
+      }
+    }
+    shard.OutputQueue()->clear();
+
+    if (!output.outer_id.IsValid()) {
+      continue;
+    }
+    OutputStream& outer = cc->Outputs().Get(output.outer_id);
+    if (shard.IsClosed()) {
+      outer.Close();
+    } else if (shard.updated_next_timestamp_bound_ != Timestamp::Unset() &&
+               shard.NextTimestampBound() > outer.NextTimestampBound()) {
+      outer.SetNextTimestampBound(shard.NextTimestampBound());
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status FusedCalculator::Close(CalculatorContext* cc) {
+  for (int s = 0; s < stages_.size(); ++s) {
+    Stage* stage = stages_[s].get();
+    CalculatorContext* context =
+        stage->context_manager.GetDefaultCalculatorContext();
+    for (CollectionItemId id = context->Inputs().BeginId();
+         id < context->Inputs().EndId(); ++id) {
+      // Marks the stream done without leaving a packet in the queue.
+      context->Inputs().Get(id).AddPacket(Packet(), /*is_done=*/true);
+      context->Inputs().Get(id).ClearCurrentPacket();
+    }
+    for (CollectionItemId id = context->Outputs().BeginId();
+         id < context->Outputs().EndId(); ++id) {
+      OutputStreamShard& output = context->Outputs().Get(id);
+      output.Reset(output.NextTimestampBound(), output.IsClosed());
+    }
+    stage->context_manager.SetGraphStatusInContext(context, cc->GraphStatus());
+    stage->context_manager.PushInputTimestampToContext(context,
+                                                       Timestamp::Done());
+    absl::Status status;
+    {
+      LegacyCalculatorSupport::Scoped<CalculatorContext> s(context);
+      status = stage->calculator->Close(context);
+    }
+    stage->context_manager.PopInputTimestampFromContext(context);
+    MP_RETURN_IF_ERROR(status).SetPrepend() << absl::Substitute(
+        "Calculator::Close() for fused node \"$0\" failed: ", stage->name);
+    MP_RETURN_IF_ERROR(stream_status_);
+
+    // Packets output in Close() on the streams between fused nodes are
+    // processed by the subsequent fused nodes, in timestamp order.
+    InternalPackets internal_packets;
+    MP_RETURN_IF_ERROR(
+        CollectOutputs(stage, Timestamp::Done(), &internal_packets, cc));
+    for (auto& entry : internal_packets) {
+      std::fill(packets_.begin(), packets_.end(), Packet());
+      for (auto& packet : entry.second) {
+        packets_[packet.first] = std::move(packet.second);
+      }
+      MP_RETURN_IF_ERROR(ProcessStages(s + 1, entry.first, cc));
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace mediapipe
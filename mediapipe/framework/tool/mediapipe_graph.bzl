@@ -13,6 +13,10 @@ Example:
     ]
   )
 
+mediapipe_compiled_graph() converts a graph from text format to a serialized
+CompiledGraphConfig, with subgraphs expanded and nodes sorted.  Its deps must
+include the calculators and subgraphs used by the graph.
+
 """
 
 load("//mediapipe/framework:encode_binary_proto.bzl", "encode_binary_proto", "generate_proto_descriptor_set")
@@ -63,6 +67,38 @@ def mediapipe_binary_graph(name, graph = None, output_name = None, deps = [], te
         testonly = testonly,
     )
 
+def mediapipe_compiled_graph(name, graph = None, output_name = None, deps = [], testonly = False, **kwargs):
+    """Compiles a graph from text format to a binary CompiledGraphConfig."""
+
+    if not graph:
+        fail("No input graph file specified.")
+
+    if not output_name:
+        fail("Must specify the output_name.")
+
+    # Compile the graph compiler binary using the calculators of the graph.
+    native.cc_binary(
+        name = name + "_compile_graph",
+        visibility = ["//visibility:private"],
+        deps = [clean_dep("//mediapipe/framework/tool:compile_graph")] + deps,
+        tags = ["manual"],
+        testonly = testonly,
+    )
+
+    # Invoke the graph compiler binary.
+    native.genrule(
+        name = name,
+        srcs = [graph],
+        outs = [output_name],
+        cmd = (
+            "$(location " + name + "_compile_graph" + ") " +
+            ("--proto_source=$(location %s) " % graph) +
+            ("--proto_output=\"$@\" ")
+        ),
+        tools = [name + "_compile_graph"],
+        testonly = testonly,
+    )
+
 def data_as_c_string(
         name,
         srcs,
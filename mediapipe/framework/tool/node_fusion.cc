@@ -0,0 +1,246 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/tool/node_fusion.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/calculator_contract.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/framework/timestamp.h"
+#include "mediapipe/framework/tool/fused_calculator.pb.h"
+#include "mediapipe/framework/tool/name_util.h"
+
+namespace mediapipe {
+
+namespace tool {
+
+namespace {
+
+constexpr char kFusedCalculator[] = "FusedCalculator";
+constexpr char kDefaultInputStreamHandler[] = "DefaultInputStreamHandler";
+constexpr char kInOrderOutputStreamHandler[] = "InOrderOutputStreamHandler";
+
+// Appends |name| to |names| unless it is already in |added|.
+void AddUnique(const std::string& name, absl::flat_hash_set<std::string>* added,
+               std::vector<std::string>* names) {
+  if (added->insert(name).second) {
+    names->push_back(name);
+  }
+}
+
+}  // namespace
+
+bool IsFusableNode(const CalculatorGraphConfig::Node& node,
+                   const NodeTypeInfo& node_type_info) {
+  const CalculatorContract& contract = node_type_info.Contract();
+  if (node.calculator() == kFusedCalculator ||
+      contract.GetTimestampOffset() != TimestampDiff(0) ||
+      contract.GetProcessTimestampBounds() ||
+      !contract.ServiceRequests().empty()) {
+    return false;
+  }
+  if (node.input_stream().empty() || node.output_stream().empty() ||
+      !node.output_side_packet().empty() ||
+      !node.input_stream_info().empty() || !node.executor().empty() ||
+      node.max_in_flight() > 1) {
+    return false;
+  }
+  // The input stream handler of the node config takes priority.
+  const std::string input_stream_handler =
+      node.has_input_stream_handler()
+          ? node.input_stream_handler().input_stream_handler()
+          : contract.GetInputStreamHandler();
+  if ((!input_stream_handler.empty() &&
+       input_stream_handler != kDefaultInputStreamHandler) ||
+      node.input_stream_handler().has_options()) {
+    return false;
+  }
+  if (node.has_output_stream_handler() &&
+      (node.output_stream_handler().output_stream_handler() !=
+           kInOrderOutputStreamHandler ||
+       node.output_stream_handler().has_options())) {
+    return false;
+  }
+  return true;
+}
+
+absl::StatusOr<CalculatorGraphConfig> FuseNodes(
+    const ValidatedGraphConfig& validated_graph,
+    const std::vector<std::string>& observed_streams) {
+  RET_CHECK(validated_graph.Initialized());
+  const CalculatorGraphConfig& config = validated_graph.Config();
+  const int num_nodes = config.node_size();
+
+  // The streams that must remain streams of the graph.
+  absl::flat_hash_set<std::string> observed(observed_streams.begin(),
+                                            observed_streams.end());
+  ASSIGN_OR_RETURN(auto graph_outputs, TagMap::Create(config.output_stream()));
+  observed.insert(graph_outputs->Names().begin(), graph_outputs->Names().end());
+
+  // The nodes consuming each stream, and the stream and side packet
+  // producers of each node. Back edges are ignored, as for the topological
+  // order of the nodes in the config.
+  absl::flat_hash_map<std::string, std::vector<int>> consumers;
+  std::vector<std::vector<int>> producers(num_nodes);
+  const auto& input_streams = validated_graph.InputStreamInfos();
+  const auto& output_streams = validated_graph.OutputStreamInfos();
+  for (const EdgeInfo& input : input_streams) {
+    if (input.parent_node.type != NodeTypeInfo::NodeType::CALCULATOR) {
+      continue;
+    }
+    consumers[input.name].push_back(input.parent_node.index);
+    const auto& upstream = output_streams[input.upstream].parent_node;
+    if (!input.back_edge &&
+        upstream.type == NodeTypeInfo::NodeType::CALCULATOR) {
+      producers[input.parent_node.index].push_back(upstream.index);
+    }
+  }
+  const auto& output_side_packets = validated_graph.OutputSidePacketInfos();
+  for (const EdgeInfo& input : validated_graph.InputSidePacketInfos()) {
+    if (input.parent_node.type != NodeTypeInfo::NodeType::CALCULATOR ||
+        input.upstream < 0) {
+      continue;
+    }
+    const auto& upstream = output_side_packets[input.upstream].parent_node;
+    if (upstream.type == NodeTypeInfo::NodeType::CALCULATOR) {
+      producers[input.parent_node.index].push_back(upstream.index);
+    }
+  }
+
+  // The transitive producers of each node. The nodes of the validated config
+  // are sorted topologically.
+  std::vector<std::vector<bool>> ancestors(num_nodes,
+                                           std::vector<bool>(num_nodes));
+  for (int i = 0; i < num_nodes; ++i) {
+    for (int producer : producers[i]) {
+      ancestors[i][producer] = true;
+      for (int j = 0; j < producer; ++j) {
+        if (ancestors[producer][j]) ancestors[i][j] = true;
+      }
+    }
+  }
+
+  // Groups the nodes into chains. A fusable node joins the chain of the
+  // producer of one of its single-consumer input streams, unless one of its
+  // other producers depends on the chain, which would create a cycle.
+  const auto& node_infos = validated_graph.CalculatorInfos();
+  std::vector<int> chain_of(num_nodes, -1);
+  std::vector<std::vector<int>> chains;
+  for (int i = 0; i < num_nodes; ++i) {
+    if (!IsFusableNode(config.node(i), node_infos[i])) {
+      continue;
+    }
+    int chain = -1;
+    const NodeTypeInfo& node_info = node_infos[i];
+    for (int k = 0; k < node_info.InputStreamTypes().NumEntries(); ++k) {
+      const EdgeInfo& input =
+          input_streams[node_info.InputStreamBaseIndex() + k];
+      const auto& upstream = output_streams[input.upstream].parent_node;
+      if (upstream.type == NodeTypeInfo::NodeType::CALCULATOR &&
+          chain_of[upstream.index] >= 0 &&
+          consumers[input.name].size() == 1 &&
+          !observed.contains(input.name)) {
+        chain = chain_of[upstream.index];
+        break;
+      }
+    }
+    if (chain >= 0) {
+      bool creates_cycle = false;
+      for (int producer : producers[i]) {
+        if (chain_of[producer] == chain) continue;
+        for (int member : chains[chain]) {
+          creates_cycle |= ancestors[producer][member];
+        }
+      }
+      if (creates_cycle) chain = -1;
+    }
+    if (chain < 0) {
+      chain = chains.size();
+      chains.emplace_back();
+    }
+    chains[chain].push_back(i);
+    chain_of[i] = chain;
+  }
+
+  CalculatorGraphConfig result = config;
+  result.clear_node();
+  for (int i = 0; i < num_nodes; ++i) {
+    const int chain = chain_of[i];
+    if (chain < 0 || chains[chain].size() == 1) {
+      *result.add_node() = config.node(i);
+      continue;
+    }
+    if (chains[chain].front() != i) {
+      continue;
+    }
+
+    CalculatorGraphConfig::Node* fused = result.add_node();
+    fused->set_calculator(kFusedCalculator);
+    fused->set_name(absl::StrCat("fused__", CanonicalNodeName(config, i)));
+    fused->mutable_input_stream_handler()->set_input_stream_handler(
+        kDefaultInputStreamHandler);
+    auto* options =
+        fused->mutable_options()->MutableExtension(FusedCalculatorOptions::ext);
+    options->set_package(validated_graph.Package());
+
+    absl::flat_hash_set<std::string> produced;
+    for (int member : chains[chain]) {
+      for (const auto& output : config.node(member).output_stream()) {
+        produced.insert(ParseNameFromStream(output));
+      }
+    }
+    absl::flat_hash_set<std::string> added_streams;
+    absl::flat_hash_set<std::string> added_side_packets;
+    std::vector<std::string> inputs;
+    std::vector<std::string> outputs;
+    std::vector<std::string> side_packets;
+    for (int member : chains[chain]) {
+      const CalculatorGraphConfig::Node& node = config.node(member);
+      CalculatorGraphConfig::Node* fused_node = options->add_node();
+      *fused_node = node;
+      fused_node->set_name(CanonicalNodeName(config, member));
+      fused_node->clear_input_stream_handler();
+      fused_node->clear_output_stream_handler();
+      for (const auto& input : node.input_stream()) {
+        const std::string name = ParseNameFromStream(input);
+        if (!produced.contains(name)) AddUnique(name, &added_streams, &inputs);
+      }
+      for (const auto& output : node.output_stream()) {
+        const std::string name = ParseNameFromStream(output);
+        bool consumed_outside = observed.contains(name);
+        for (int consumer : consumers[name]) {
+          consumed_outside |= chain_of[consumer] != chain;
+        }
+        if (consumed_outside) AddUnique(name, &added_streams, &outputs);
+      }
+      for (const auto& side_packet : node.input_side_packet()) {
+        AddUnique(ParseNameFromStream(side_packet), &added_side_packets,
+                  &side_packets);
+      }
+    }
+    for (const auto& name : inputs) fused->add_input_stream(name);
+    for (const auto& name : outputs) fused->add_output_stream(name);
+    for (const auto& name : side_packets) fused->add_input_side_packet(name);
+  }
+  return result;
+}
+
+}  // namespace tool
+}  // namespace mediapipe
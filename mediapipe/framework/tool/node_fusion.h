@@ -0,0 +1,59 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_TOOL_NODE_FUSION_H_
+#define MEDIAPIPE_FRAMEWORK_TOOL_NODE_FUSION_H_
+
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mediapipe/framework/validated_graph_config.h"
+
+namespace mediapipe {
+
+namespace tool {
+
+// Returns true if the node can run within a FusedCalculator: its outputs
+// have the input timestamp (TimestampOffset 0 in its contract), it uses the
+// default input and output stream handlers, runs on the default executor
+// without parallel Process() calls, and has no output side packets, graph
+// services, or back edges.
+bool IsFusableNode(const CalculatorGraphConfig::Node& node,
+                   const NodeTypeInfo& node_type_info);
+
+// Returns the config of |validated_graph| in which each chain of fusable
+// nodes connected by single-consumer streams is replaced by a
+// FusedCalculator node, which calls the Process() methods of the chain back
+// to back on one thread. This saves the queueing and scheduling of a task per
+// node and packet, which dominates the latency of chains of cheap
+// calculators. The packets on the graph output streams and on the streams
+// listed in |observed_streams| are the same as in the original graph, but the
+// streams between fused nodes are no longer streams of the graph, so
+// streams observed with CalculatorGraph::ObserveOutputStream() or
+// AddOutputStreamPoller() must be listed in |observed_streams|.
+//
+// The returned config is meant to initialize a CalculatorGraph. Fused nodes
+// are invoked once all the inputs of the FusedCalculator node are settled at
+// a timestamp, so a fused node may wait for the inputs of a later node of its
+// chain.
+absl::StatusOr<CalculatorGraphConfig> FuseNodes(
+    const ValidatedGraphConfig& validated_graph,
+    const std::vector<std::string>& observed_streams = {});
+
+}  // namespace tool
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_TOOL_NODE_FUSION_H_
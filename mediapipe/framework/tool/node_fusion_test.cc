@@ -0,0 +1,362 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/tool/node_fusion.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/tool/fused_calculator.pb.h"
+#include "mediapipe/framework/tool/sink.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::SizeIs;
+
+// Adds the OFFSET side packet to its int input.
+class AddOffsetCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<int>();
+    cc->Outputs().Index(0).Set<int>();
+    cc->InputSidePackets().Tag("OFFSET").Set<int>();
+    cc->SetTimestampOffset(TimestampDiff(0));
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) final {
+    const int value = cc->Inputs().Index(0).Get<int>() +
+                      cc->InputSidePackets().Tag("OFFSET").Get<int>();
+    cc->Outputs().Index(0).Add(new int(value), cc->InputTimestamp());
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(AddOffsetCalculator);
+
+// Outputs the number of its input packets at Timestamp::Max() in Close().
+class CountInCloseCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).SetAny();
+    cc->Outputs().Index(0).Set<int>();
+    cc->SetTimestampOffset(TimestampDiff(0));
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) final {
+    ++count_;
+    return absl::OkStatus();
+  }
+
+  absl::Status Close(CalculatorContext* cc) final {
+    cc->Outputs().Index(0).Add(new int(count_), Timestamp::Max());
+    return absl::OkStatus();
+  }
+
+ private:
+  int count_ = 0;
+};
+REGISTER_CALCULATOR(CountInCloseCalculator);
+
+// Returns the config of |graph| with fused nodes.
+CalculatorGraphConfig FuseGraph(
+    const CalculatorGraphConfig& graph,
+    const std::vector<std::string>& observed_streams = {}) {
+  ValidatedGraphConfig validated_graph;
+  MP_EXPECT_OK(validated_graph.Initialize(graph));
+  auto fused_graph = tool::FuseNodes(validated_graph, observed_streams);
+  MP_EXPECT_OK(fused_graph);
+  return fused_graph.value();
+}
+
+// Runs |graph| with int packets at timestamps 0, 1, ... in its input stream
+// "in", and returns the packets of |output_streams|.
+std::map<std::string, std::vector<Packet>> RunGraph(
+    CalculatorGraphConfig graph, const std::vector<std::string>& output_streams,
+    const std::map<std::string, Packet>& side_packets = {}) {
+  std::map<std::string, std::vector<Packet>> outputs;
+  for (const auto& stream : output_streams) {
+    tool::AddVectorSink(stream, &graph, &outputs[stream]);
+  }
+  CalculatorGraph calculator_graph;
+  MP_EXPECT_OK(calculator_graph.Initialize(graph));
+  MP_EXPECT_OK(calculator_graph.StartRun(side_packets));
+  for (int t = 0; t < 10; ++t) {
+    MP_EXPECT_OK(calculator_graph.AddPacketToInputStream(
+        "in", MakePacket<int>(t).At(Timestamp(t))));
+  }
+  MP_EXPECT_OK(calculator_graph.CloseAllInputStreams());
+  MP_EXPECT_OK(calculator_graph.WaitUntilDone());
+  return outputs;
+}
+
+// Expects the same packets in |expected| and |actual|.
+void ExpectSamePackets(
+    const std::map<std::string, std::vector<Packet>>& expected,
+    const std::map<std::string, std::vector<Packet>>& actual) {
+  ASSERT_EQ(expected.size(), actual.size());
+  for (const auto& entry : expected) {
+    const std::vector<Packet>& packets = actual.at(entry.first);
+    ASSERT_EQ(entry.second.size(), packets.size()) << entry.first;
+    for (int i = 0; i < packets.size(); ++i) {
+      EXPECT_EQ(entry.second[i].Timestamp(), packets[i].Timestamp());
+      EXPECT_EQ(entry.second[i].Get<int>(), packets[i].Get<int>());
+    }
+  }
+}
+
+TEST(NodeFusionTest, FusesChainOfNodes) {
+  CalculatorGraphConfig graph =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "in"
+        input_side_packet: "offset"
+        output_stream: "out"
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "in"
+          output_stream: "a"
+        }
+        node {
+          calculator: "AddOffsetCalculator"
+          input_stream: "a"
+          input_side_packet: "OFFSET:offset"
+          output_stream: "b"
+        }
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "b"
+          output_stream: "out"
+        }
+      )pb");
+  CalculatorGraphConfig fused_graph = FuseGraph(graph);
+  ASSERT_THAT(fused_graph.node(), SizeIs(1));
+  const CalculatorGraphConfig::Node& fused = fused_graph.node(0);
+  EXPECT_EQ("FusedCalculator", fused.calculator());
+  EXPECT_THAT(fused.input_stream(), ElementsAre("in"));
+  EXPECT_THAT(fused.output_stream(), ElementsAre("out"));
+  EXPECT_THAT(fused.input_side_packet(), ElementsAre("offset"));
+  EXPECT_THAT(fused.options().GetExtension(FusedCalculatorOptions::ext).node(),
+              SizeIs(3));
+
+  const std::map<std::string, Packet> side_packets = {
+      {"offset", MakePacket<int>(100)}};
+  auto expected = RunGraph(graph, {"out"}, side_packets);
+  ASSERT_THAT(expected["out"], SizeIs(10));
+  EXPECT_EQ(109, expected["out"].back().Get<int>());
+  ExpectSamePackets(expected, RunGraph(fused_graph, {"out"}, side_packets));
+}
+
+TEST(NodeFusionTest, ProcessesPacketsOutputInClose) {
+  CalculatorGraphConfig graph =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "in"
+        output_stream: "out"
+        node {
+          calculator: "CountInCloseCalculator"
+          input_stream: "in"
+          output_stream: "count"
+        }
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "count"
+          output_stream: "out"
+        }
+      )pb");
+  CalculatorGraphConfig fused_graph = FuseGraph(graph);
+  ASSERT_THAT(fused_graph.node(), SizeIs(1));
+
+  auto expected = RunGraph(graph, {"out"});
+  ASSERT_THAT(expected["out"], SizeIs(1));
+  EXPECT_EQ(10, expected["out"][0].Get<int>());
+  ExpectSamePackets(expected, RunGraph(fused_graph, {"out"}));
+}
+
+TEST(NodeFusionTest, KeepsStreamsWithSeveralConsumers) {
+  CalculatorGraphConfig graph =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "in"
+        output_stream: "out1"
+        output_stream: "out2"
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "in"
+          output_stream: "a"
+        }
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "a"
+          output_stream: "b1"
+        }
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "b1"
+          output_stream: "out1"
+        }
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "a"
+          output_stream: "out2"
+        }
+      )pb");
+  CalculatorGraphConfig fused_graph = FuseGraph(graph);
+  // Only the chain from "a" to "out1" is fused.
+  ASSERT_THAT(fused_graph.node(), SizeIs(3));
+  int num_fused = 0;
+  for (const auto& node : fused_graph.node()) {
+    if (node.calculator() == "FusedCalculator") {
+      ++num_fused;
+      EXPECT_THAT(node.input_stream(), ElementsAre("a"));
+      EXPECT_THAT(node.output_stream(), ElementsAre("out1"));
+    }
+  }
+  EXPECT_EQ(1, num_fused);
+  ExpectSamePackets(RunGraph(graph, {"out1", "out2"}),
+                    RunGraph(fused_graph, {"out1", "out2"}));
+}
+
+TEST(NodeFusionTest, KeepsObservedStreams) {
+  CalculatorGraphConfig graph =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "in"
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "in"
+          output_stream: "a"
+        }
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "a"
+          output_stream: "b"
+        }
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "b"
+          output_stream: "out"
+        }
+      )pb");
+  CalculatorGraphConfig fused_graph = FuseGraph(graph, {"b", "out"});
+  ASSERT_THAT(fused_graph.node(), SizeIs(2));
+  EXPECT_EQ("FusedCalculator", fused_graph.node(0).calculator());
+  EXPECT_THAT(fused_graph.node(0).output_stream(), ElementsAre("b"));
+  EXPECT_EQ("PassThroughCalculator", fused_graph.node(1).calculator());
+  ExpectSamePackets(RunGraph(graph, {"b", "out"}),
+                    RunGraph(fused_graph, {"b", "out"}));
+}
+
+TEST(NodeFusionTest, DoesNotCreateCycles) {
+  // Fusing the first and last node would create a cycle through the
+  // ImmediateInputStreamHandler node, which is not fusable.
+  CalculatorGraphConfig graph =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: "in"
+        output_stream: "out"
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "in"
+          input_stream: "in"
+          output_stream: "a1"
+          output_stream: "a2"
+        }
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "a2"
+          output_stream: "c"
+          input_stream_handler {
+            input_stream_handler: "ImmediateInputStreamHandler"
+          }
+        }
+        node {
+          calculator: "AddOffsetCalculator"
+          input_stream: "a1"
+          input_side_packet: "OFFSET:offset"
+          output_stream: "b"
+        }
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "b"
+          input_stream: "c"
+          output_stream: "out"
+          output_stream: "c_out"
+        }
+      )pb");
+  CalculatorGraphConfig fused_graph = FuseGraph(graph);
+  // The AddOffsetCalculator node is fused with the first node, but the last
+  // node depends on the second node, which depends on the first node.
+  ASSERT_THAT(fused_graph.node(), SizeIs(3));
+  std::vector<std::string> calculators;
+  for (const auto& node : fused_graph.node()) {
+    calculators.push_back(node.calculator());
+  }
+  EXPECT_THAT(calculators,
+              ElementsAre("FusedCalculator", "PassThroughCalculator",
+                          "PassThroughCalculator"));
+
+  const std::map<std::string, Packet> side_packets = {
+      {"offset", MakePacket<int>(1)}};
+  ExpectSamePackets(RunGraph(graph, {"out"}, side_packets),
+                    RunGraph(fused_graph, {"out"}, side_packets));
+}
+
+// Measures the latency of a packet through a chain of PassThroughCalculator
+// nodes, with and without node fusion.
+void BM_PassThroughChainLatency(benchmark::State& state) {
+  constexpr int kNumNodes = 20;
+  const bool fuse_nodes = state.range(0);
+  CalculatorGraphConfig config;
+  config.add_input_stream("in0");
+  config.add_output_stream(absl::StrCat("in", kNumNodes));
+  for (int i = 0; i < kNumNodes; ++i) {
+    CalculatorGraphConfig::Node* node = config.add_node();
+    node->set_calculator("PassThroughCalculator");
+    node->add_input_stream(absl::StrCat("in", i));
+    node->add_output_stream(absl::StrCat("in", i + 1));
+  }
+  if (fuse_nodes) {
+    ValidatedGraphConfig validated_graph;
+    CHECK(validated_graph.Initialize(config).ok());
+    config = tool::FuseNodes(validated_graph).value();
+  }
+  CalculatorGraph graph;
+  CHECK(graph.Initialize(config).ok());
+  auto poller = graph.AddOutputStreamPoller(absl::StrCat("in", kNumNodes));
+  CHECK(poller.ok());
+  CHECK(graph.StartRun({}).ok());
+  int t = 0;
+  Packet packet;
+  for (auto _ : state) {
+    CHECK(graph
+              .AddPacketToInputStream("in0",
+                                      MakePacket<int>(t).At(Timestamp(t)))
+              .ok());
+    CHECK(poller->Next(&packet));
+    ++t;
+  }
+  CHECK(graph.CloseAllInputStreams().ok());
+  CHECK(graph.WaitUntilDone().ok());
+}
+BENCHMARK(BM_PassThroughChainLatency)->Arg(0)->Arg(1)->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
@@ -16,13 +16,17 @@
 
 #include <memory>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/substitute.h"
+#include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_base.h"
+#include "mediapipe/framework/compiled_graph_config.pb.h"
 #include "mediapipe/framework/graph_service_manager.h"
 #include "mediapipe/framework/legacy_calculator_support.h"
 #include "mediapipe/framework/packet_generator.h"
@@ -142,6 +146,65 @@ absl::Status AddPredefinedExecutorConfigs(CalculatorGraphConfig* graph_config) {
   return absl::OkStatus();
 }
 
+// Process-wide cache of the configs compiled by
+// ValidatedGraphConfig::Initialize, keyed by the serialized input config and
+// graph options.
+class CompiledConfigCache {
+ public:
+  static CompiledConfigCache& Get() {
+    static CompiledConfigCache* cache = new CompiledConfigCache();
+    return *cache;
+  }
+
+  std::shared_ptr<const CompiledGraphConfig> Lookup(const std::string& key) {
+    absl::MutexLock lock(&mutex_);
+    auto iter = entries_.find(key);
+    return iter == entries_.end() ? nullptr : iter->second;
+  }
+
+  void Insert(const std::string& key,
+              std::shared_ptr<const CompiledGraphConfig> compiled_config) {
+    absl::MutexLock lock(&mutex_);
+    // Graphs are normally created from a handful of configs.  Start over
+    // rather than grow without bound if that is not the case.
+    if (entries_.size() >= kMaxEntries) {
+      entries_.clear();
+    }
+    entries_[key] = std::move(compiled_config);
+  }
+
+  void Clear() {
+    absl::MutexLock lock(&mutex_);
+    entries_.clear();
+  }
+
+ private:
+  static constexpr int kMaxEntries = 64;
+
+  absl::Mutex mutex_;
+  absl::flat_hash_map<std::string, std::shared_ptr<const CompiledGraphConfig>>
+      entries_ ABSL_GUARDED_BY(mutex_);
+};
+
+// Subgraphs can depend on graph services and on local graph registries, which
+// are not part of the cache key, so such configs are not cached.
+bool IsCompiledConfigCacheable(const GraphRegistry* graph_registry,
+                               const GraphServiceManager* service_manager) {
+  return (graph_registry == nullptr ||
+          graph_registry == &GraphRegistry::global_graph_registry) &&
+         (service_manager == nullptr ||
+          service_manager->ServicePackets().empty());
+}
+
+std::string CompiledConfigCacheKey(
+    const CalculatorGraphConfig& config,
+    const Subgraph::SubgraphOptions* graph_options) {
+  const std::string serialized_config = config.SerializeAsString();
+  return absl::StrCat(
+      serialized_config.size(), ":", serialized_config,
+      graph_options ? graph_options->SerializeAsString() : "");
+}
+
 }  // namespace
 
 // static
@@ -330,29 +393,116 @@ absl::Status ValidatedGraphConfig::Initialize(
           << input_config.DebugString();
 #endif
 
+  const bool cacheable =
+      IsCompiledConfigCacheable(graph_registry, service_manager);
+  std::string cache_key;
+  if (cacheable) {
+    cache_key = CompiledConfigCacheKey(input_config, graph_options);
+    std::shared_ptr<const CompiledGraphConfig> compiled_config =
+        CompiledConfigCache::Get().Lookup(cache_key);
+    if (compiled_config) {
+      return Initialize(*compiled_config);
+    }
+  }
+
   config_ = std::move(input_config);
   MP_RETURN_IF_ERROR(
       PerformBasicTransforms(graph_registry, graph_options, service_manager));
+  MP_RETURN_IF_ERROR(InitializeGraphInfo(/*compiled_config=*/nullptr));
+
+#if !defined(MEDIAPIPE_MOBILE)
+  VLOG(1) << "ValidatedGraphConfig produced canonical config:\n"
+          << config_.DebugString();
+#endif
+  initialized_ = true;
+
+  if (cacheable) {
+    ASSIGN_OR_RETURN(CompiledGraphConfig compiled_config, Compile());
+    CompiledConfigCache::Get().Insert(
+        cache_key, std::make_shared<const CompiledGraphConfig>(
+                       std::move(compiled_config)));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status ValidatedGraphConfig::Initialize(
+    const CompiledGraphConfig& compiled_config) {
+  RET_CHECK(!initialized_)
+      << "ValidatedGraphConfig can be initialized only once.";
+  config_ = compiled_config.config();
+  MP_RETURN_IF_ERROR(InitializeGraphInfo(&compiled_config));
+  initialized_ = true;
+  return absl::OkStatus();
+}
+
+absl::StatusOr<CompiledGraphConfig> ValidatedGraphConfig::Compile() const {
+  RET_CHECK(initialized_) << "ValidatedGraphConfig is not initialized.";
+  CompiledGraphConfig compiled_config;
+  *compiled_config.mutable_config() = config_;
+  for (const NodeTypeInfo* node_type_info : sorted_nodes_) {
+    CompiledGraphConfig::NodeRef* node_ref =
+        compiled_config.add_sorted_node();
+    node_ref->set_type(node_type_info->Node().type ==
+                               NodeTypeInfo::NodeType::PACKET_GENERATOR
+                           ? CompiledGraphConfig::NodeRef::PACKET_GENERATOR
+                           : CompiledGraphConfig::NodeRef::CALCULATOR);
+    node_ref->set_index(node_type_info->Node().index);
+  }
+  return compiled_config;
+}
+
+// static
+void ValidatedGraphConfig::ClearCompiledConfigCache() {
+  CompiledConfigCache::Get().Clear();
+}
+
+absl::Status ValidatedGraphConfig::InitializeGraphInfo(
+    const CompiledGraphConfig* compiled_config) {
   // Initialize the basic node information.
   MP_RETURN_IF_ERROR(InitializeGeneratorInfo());
   MP_RETURN_IF_ERROR(InitializeCalculatorInfo());
   MP_RETURN_IF_ERROR(InitializeStatusHandlerInfo());
 
   sorted_nodes_.reserve(generators_.size() + calculators_.size());
-  // Initialize sorted_nodes_ to list generators before calculators.
-  for (int index = 0; index < generators_.size(); ++index) {
-    NodeTypeInfo* node_type_info = &generators_[index];
-    RET_CHECK(node_type_info->Node().type ==
-              NodeTypeInfo::NodeType::PACKET_GENERATOR);
-    RET_CHECK_EQ(node_type_info->Node().index, index);
-    sorted_nodes_.push_back(node_type_info);
-  }
-  for (int index = 0; index < calculators_.size(); ++index) {
-    NodeTypeInfo* node_type_info = &calculators_[index];
-    RET_CHECK(node_type_info->Node().type ==
-              NodeTypeInfo::NodeType::CALCULATOR);
-    RET_CHECK_EQ(node_type_info->Node().index, index);
-    sorted_nodes_.push_back(node_type_info);
+  if (compiled_config && compiled_config->sorted_node_size() > 0) {
+    // Start from the order of the previous topological sort.
+    RET_CHECK_EQ(compiled_config->sorted_node_size(),
+                 generators_.size() + calculators_.size());
+    for (const auto& node_ref : compiled_config->sorted_node()) {
+      RET_CHECK(node_ref.type() ==
+                    CompiledGraphConfig::NodeRef::PACKET_GENERATOR ||
+                node_ref.type() == CompiledGraphConfig::NodeRef::CALCULATOR)
+          << "Invalid node type in sorted_node: " << node_ref.type();
+      std::vector<NodeTypeInfo>* node_type_infos =
+          node_ref.type() == CompiledGraphConfig::NodeRef::PACKET_GENERATOR
+              ? &generators_
+              : &calculators_;
+      RET_CHECK(node_ref.index() >= 0 &&
+                node_ref.index() < node_type_infos->size())
+          << "Invalid node index in sorted_node: " << node_ref.index();
+      sorted_nodes_.push_back(&(*node_type_infos)[node_ref.index()]);
+    }
+    RET_CHECK_EQ(absl::flat_hash_set<NodeTypeInfo*>(sorted_nodes_.begin(),
+                                                    sorted_nodes_.end())
+                     .size(),
+                 sorted_nodes_.size())
+        << "sorted_node lists a node more than once.";
+  } else {
+    // Initialize sorted_nodes_ to list generators before calculators.
+    for (int index = 0; index < generators_.size(); ++index) {
+      NodeTypeInfo* node_type_info = &generators_[index];
+      RET_CHECK(node_type_info->Node().type ==
+                NodeTypeInfo::NodeType::PACKET_GENERATOR);
+      RET_CHECK_EQ(node_type_info->Node().index, index);
+      sorted_nodes_.push_back(node_type_info);
+    }
+    for (int index = 0; index < calculators_.size(); ++index) {
+      NodeTypeInfo* node_type_info = &calculators_[index];
+      RET_CHECK(node_type_info->Node().type ==
+                NodeTypeInfo::NodeType::CALCULATOR);
+      RET_CHECK_EQ(node_type_info->Node().index, index);
+      sorted_nodes_.push_back(node_type_info);
+    }
   }
 
   // Initialize the side packet information.
@@ -398,12 +548,6 @@ absl::Status ValidatedGraphConfig::Initialize(
   MP_RETURN_IF_ERROR(ComputeSourceDependence());
 
   MP_RETURN_IF_ERROR(ValidateExecutors());
-
-#if !defined(MEDIAPIPE_MOBILE)
-  VLOG(1) << "ValidatedGraphConfig produced canonical config:\n"
-          << config_.DebugString();
-#endif
-  initialized_ = true;
   return absl::OkStatus();
 }
 
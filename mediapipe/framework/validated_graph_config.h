@@ -21,6 +21,7 @@
 #include "absl/container/flat_hash_set.h"
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_contract.h"
+#include "mediapipe/framework/compiled_graph_config.pb.h"
 #include "mediapipe/framework/graph_service_manager.h"
 #include "mediapipe/framework/packet_generator.pb.h"
 #include "mediapipe/framework/packet_type.h"
@@ -194,6 +195,12 @@ class ValidatedGraphConfig {
   // Initializes the ValidatedGraphConfig.  This function must be called
   // before any other functions.  Subgraphs are specified through the
   // global graph registry or an optional local graph registry.
+  //
+  // If the subgraphs come from the global graph registry and no graph
+  // services are set, the result of subgraph expansion and topological
+  // sorting is kept in an in-process cache keyed by the serialized config and
+  // graph options, so that initializing another ValidatedGraphConfig from the
+  // same config only rebuilds the calculator contracts and the stream tables.
   absl::Status Initialize(
       CalculatorGraphConfig input_config,
       const GraphRegistry* graph_registry = nullptr,
@@ -223,6 +230,19 @@ class ValidatedGraphConfig {
       const Subgraph::SubgraphOptions* graph_options = nullptr,
       const GraphServiceManager* service_manager = nullptr);
 
+  // Initializes the ValidatedGraphConfig from a config returned by Compile(),
+  // possibly in another process.  Subgraph expansion and the topological sort
+  // are skipped.
+  absl::Status Initialize(const CompiledGraphConfig& compiled_config);
+
+  // Returns the canonical config together with the topological order of its
+  // nodes, for initializing other ValidatedGraphConfigs without repeating
+  // subgraph expansion and sorting.
+  absl::StatusOr<CompiledGraphConfig> Compile() const;
+
+  // Clears the in-process cache of compiled configs used by Initialize().
+  static void ClearCompiledConfigCache();
+
   // Returns true if the ValidatedGraphConfig has been initialized.
   bool Initialized() const { return initialized_; }
 
@@ -309,6 +329,11 @@ class ValidatedGraphConfig {
       const Subgraph::SubgraphOptions* graph_options,
       const GraphServiceManager* service_manager);
 
+  // Initializes the node, stream and side packet information of the
+  // canonical config_.  If |compiled_config| is not null, the nodes are
+  // visited in its topological order instead of sorting them again.
+  absl::Status InitializeGraphInfo(const CompiledGraphConfig* compiled_config);
+
   // Initialize the PacketGenerator information.
   absl::Status InitializeGeneratorInfo();
   // Initialize the Calculator information.
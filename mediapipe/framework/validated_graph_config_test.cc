@@ -9,9 +9,13 @@
 #include "mediapipe/framework/api2/port.h"
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/compiled_graph_config.pb.h"
 #include "mediapipe/framework/graph_service.h"
+#include "mediapipe/framework/port/benchmark.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status.h"
 #include "mediapipe/framework/port/status_matchers.h"
 
 namespace mediapipe {
@@ -163,4 +167,163 @@ TEST(ValidatedGraphConfigTest, InitializeSubgraphWithServiceCalculatorB) {
   }
 }
 
+int no_op_chain_subgraph_expansions = 0;
+
+// Expands to a chain of three NoOp nodes.
+class NoOpChainSubgraph : public Subgraph {
+  absl::StatusOr<CalculatorGraphConfig> GetConfig(
+      SubgraphContext* sc) override {
+    ++no_op_chain_subgraph_expansions;
+    return ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+      input_stream: "NN:in"
+      output_stream: "NN:out"
+      node {
+        calculator: "CalculatorA"
+        input_stream: "NN:in"
+        output_stream: "NN:a"
+      }
+      node {
+        calculator: "CalculatorB"
+        input_stream: "NN:a"
+        output_stream: "NN:b"
+      }
+      node {
+        calculator: "CalculatorC"
+        input_stream: "NN:b"
+        output_stream: "NN:out"
+      }
+    )pb");
+  }
+};
+REGISTER_MEDIAPIPE_GRAPH(NoOpChainSubgraph);
+
+// Returns a graph of |num_subgraphs| chained NoOpChainSubgraphs, listed in
+// reverse order so that the expanded nodes need sorting.
+CalculatorGraphConfig NoOpChainGraph(int num_subgraphs) {
+  CalculatorGraphConfig config;
+  config.add_input_stream("s0");
+  for (int i = num_subgraphs; i > 0; --i) {
+    CalculatorGraphConfig::Node* node = config.add_node();
+    node->set_calculator("NoOpChainSubgraph");
+    node->add_input_stream(absl::StrCat("NN:s", i - 1));
+    node->add_output_stream(absl::StrCat("NN:s", i));
+  }
+  return config;
+}
+
+TEST(ValidatedGraphConfigTest, InitializeFromCompiledConfig) {
+  ValidatedGraphConfig validated_graph;
+  MP_ASSERT_OK(validated_graph.Initialize(NoOpChainGraph(3)));
+  // The canonical config lists the nodes in topological order.
+  ASSERT_EQ(validated_graph.Config().node_size(), 9);
+  EXPECT_EQ(validated_graph.Config().node(0).input_stream(0), "NN:s0");
+  auto compiled_config = validated_graph.Compile();
+  MP_ASSERT_OK(compiled_config);
+  EXPECT_EQ(compiled_config->sorted_node_size(), 9);
+
+  // Round trip through the serialized form written by compile_graph.
+  CompiledGraphConfig loaded_config;
+  ASSERT_TRUE(
+      loaded_config.ParseFromString(compiled_config->SerializeAsString()));
+  ValidatedGraphConfig loaded_graph;
+  MP_ASSERT_OK(loaded_graph.Initialize(loaded_config));
+  ASSERT_TRUE(loaded_graph.Initialized());
+  EXPECT_THAT(loaded_graph.Config(), EqualsProto(validated_graph.Config()));
+  ASSERT_EQ(loaded_graph.CalculatorInfos().size(),
+            validated_graph.CalculatorInfos().size());
+  ASSERT_EQ(loaded_graph.InputStreamInfos().size(),
+            validated_graph.InputStreamInfos().size());
+  for (int i = 0; i < loaded_graph.InputStreamInfos().size(); ++i) {
+    EXPECT_EQ(loaded_graph.InputStreamInfos()[i].name,
+              validated_graph.InputStreamInfos()[i].name);
+    EXPECT_EQ(loaded_graph.InputStreamInfos()[i].upstream,
+              validated_graph.InputStreamInfos()[i].upstream);
+  }
+  ASSERT_EQ(loaded_graph.OutputStreamInfos().size(),
+            validated_graph.OutputStreamInfos().size());
+  for (int i = 0; i < loaded_graph.OutputStreamInfos().size(); ++i) {
+    EXPECT_EQ(loaded_graph.OutputStreamInfos()[i].name,
+              validated_graph.OutputStreamInfos()[i].name);
+  }
+}
+
+TEST(ValidatedGraphConfigTest, InitializeRejectsInvalidSortedNodes) {
+  ValidatedGraphConfig validated_graph;
+  MP_ASSERT_OK(validated_graph.Initialize(NoOpChainGraph(1)));
+  auto compiled_config = validated_graph.Compile();
+  MP_ASSERT_OK(compiled_config);
+
+  CompiledGraphConfig out_of_range = *compiled_config;
+  out_of_range.mutable_sorted_node(0)->set_index(3);
+  EXPECT_FALSE(ValidatedGraphConfig().Initialize(out_of_range).ok());
+
+  CompiledGraphConfig duplicate = *compiled_config;
+  *duplicate.mutable_sorted_node(0) = duplicate.sorted_node(1);
+  EXPECT_FALSE(ValidatedGraphConfig().Initialize(duplicate).ok());
+}
+
+TEST(ValidatedGraphConfigTest, InitializeReusesCachedCompiledConfig) {
+  ValidatedGraphConfig::ClearCompiledConfigCache();
+  no_op_chain_subgraph_expansions = 0;
+  CalculatorGraphConfig expected_config;
+  for (int i = 0; i < 3; ++i) {
+    ValidatedGraphConfig config;
+    MP_ASSERT_OK(config.Initialize(NoOpChainGraph(4)));
+    if (i == 0) {
+      expected_config = config.Config();
+    }
+    EXPECT_THAT(config.Config(), EqualsProto(expected_config));
+  }
+  EXPECT_EQ(no_op_chain_subgraph_expansions, 4);
+
+  // Other configs are compiled separately.
+  ValidatedGraphConfig other_config;
+  MP_ASSERT_OK(other_config.Initialize(NoOpChainGraph(2)));
+  EXPECT_EQ(no_op_chain_subgraph_expansions, 6);
+}
+
+TEST(ValidatedGraphConfigTest, InitializeWithServicesSkipsCompiledConfigCache) {
+  ValidatedGraphConfig::ClearCompiledConfigCache();
+  no_op_chain_subgraph_expansions = 0;
+  GraphServiceManager service_manager;
+  MP_ASSERT_OK(service_manager.SetServiceObject(
+      kStringTestService, std::make_shared<std::string>("CalculatorA")));
+  for (int i = 0; i < 2; ++i) {
+    ValidatedGraphConfig config;
+    MP_ASSERT_OK(config.Initialize(NoOpChainGraph(2),
+                                   /*graph_registry=*/nullptr,
+                                   /*subgraph_options=*/nullptr,
+                                   /*service_manager=*/&service_manager));
+  }
+  EXPECT_EQ(no_op_chain_subgraph_expansions, 4);
+}
+
+// Measures the initialization of a graph of 16 NoOpChainSubgraphs when
+// expanding and sorting it (0), when reusing the cached compiled config (1),
+// and when loading a compiled config (2).
+void BM_InitializeNoOpChainGraph(benchmark::State& state) {
+  const CalculatorGraphConfig graph = NoOpChainGraph(16);
+  ValidatedGraphConfig::ClearCompiledConfigCache();
+  ValidatedGraphConfig validated_graph;
+  MEDIAPIPE_CHECK_OK(validated_graph.Initialize(graph));
+  const CompiledGraphConfig compiled_config =
+      validated_graph.Compile().value();
+  for (auto _ : state) {
+    ValidatedGraphConfig config;
+    switch (state.range(0)) {
+      case 0:
+        ValidatedGraphConfig::ClearCompiledConfigCache();
+        MEDIAPIPE_CHECK_OK(config.Initialize(graph));
+        break;
+      case 1:
+        MEDIAPIPE_CHECK_OK(config.Initialize(graph));
+        break;
+      case 2:
+        MEDIAPIPE_CHECK_OK(config.Initialize(compiled_config));
+        break;
+    }
+  }
+}
+BENCHMARK(BM_InitializeNoOpChainGraph)->Arg(0)->Arg(1)->Arg(2);
+
 }  // namespace mediapipe
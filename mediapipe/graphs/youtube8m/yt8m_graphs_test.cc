@@ -0,0 +1,64 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "absl/container/flat_hash_set.h"
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/deps/file_path.h"
+#include "mediapipe/framework/port/file_helpers.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/tool/test_util.h"
+#include "mediapipe/framework/validated_graph_config.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr char kGraphDir[] = "mediapipe/graphs/youtube8m";
+
+// Validates the graph in |file_name| and checks that every side packet that
+// no node produces is an input side packet of the graph.
+void ExpectValidGraph(const std::string& file_name) {
+  std::string contents;
+  MP_ASSERT_OK(file::GetContents(
+      file::JoinPath(GetTestRootDir(), kGraphDir, file_name), &contents));
+  CalculatorGraphConfig config;
+  ASSERT_TRUE(ParseTextProto<CalculatorGraphConfig>(contents, &config));
+
+  ValidatedGraphConfig validated_graph;
+  MP_ASSERT_OK(validated_graph.Initialize(config));
+  absl::flat_hash_set<std::string> graph_side_packets(
+      config.input_side_packet().begin(), config.input_side_packet().end());
+  for (const EdgeInfo& side_packet : validated_graph.InputSidePacketInfos()) {
+    if (side_packet.upstream < 0) {
+      EXPECT_TRUE(graph_side_packets.contains(side_packet.name))
+          << file_name << ": nothing produces side packet "
+          << side_packet.name;
+    }
+  }
+}
+
+TEST(Yt8mGraphsTest, FeatureExtractionGraphIsValid) {
+  ExpectValidGraph("feature_extraction.pbtxt");
+}
+
+TEST(Yt8mGraphsTest, LocalVideoModelInferenceGraphIsValid) {
+  ExpectValidGraph("local_video_model_inference.pbtxt");
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -17,6 +17,7 @@
 from mediapipe.python._framework_bindings import resource_util
 from mediapipe.python._framework_bindings.calculator_graph import CalculatorGraph
 from mediapipe.python._framework_bindings.calculator_graph import GraphInputStreamAddMode
+from mediapipe.python._framework_bindings.graph_batch_runner import GraphBatchRunner
 from mediapipe.python._framework_bindings.image import Image
 from mediapipe.python._framework_bindings.image_frame import ImageFormat
 from mediapipe.python._framework_bindings.image_frame import ImageFrame
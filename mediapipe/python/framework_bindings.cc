@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "mediapipe/python/pybind/calculator_graph.h"
+#include "mediapipe/python/pybind/graph_batch_runner.h"
 #include "mediapipe/python/pybind/image.h"
 #include "mediapipe/python/pybind/image_frame.h"
 #include "mediapipe/python/pybind/matrix.h"
@@ -37,6 +38,7 @@ PYBIND11_MODULE(_framework_bindings, m) {
   PacketGetterSubmodule(&m);
   CalculatorGraphSubmodule(&m);
   ValidatedGraphConfigSubmodule(&m);
+  GraphBatchRunnerSubmodule(&m);
 }
 
 }  // namespace python
@@ -0,0 +1,85 @@
+# Copyright 2021 The MediaPipe Authors.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Tests for mediapipe.python._framework_bindings.graph_batch_runner."""
+
+from absl.testing import absltest
+import mediapipe as mp
+
+_PASS_THROUGH_CONFIG = """
+  input_stream: 'in'
+  output_stream: 'out'
+  node {
+    calculator: 'PassThroughCalculator'
+    input_stream: 'in'
+    output_stream: 'out'
+  }
+"""
+
+
+class GraphBatchRunnerTest(absltest.TestCase):
+
+  def test_invalid_output_stream(self):
+    with self.assertRaisesRegex(RuntimeError, 'unknown'):
+      mp.GraphBatchRunner(
+          graph_config=_PASS_THROUGH_CONFIG, output_streams=['unknown'])
+
+  def test_run_jobs(self):
+    runner = mp.GraphBatchRunner(
+        graph_config=_PASS_THROUGH_CONFIG,
+        num_graphs=2,
+        output_streams=['out'])
+    expected = {}
+    for job in range(5):
+      packets = [
+          mp.packet_creator.create_int(job * 10 + i).at(i) for i in range(3)
+      ]
+      job_id = runner.add_job(input_packets={'in': packets})
+      expected[job_id] = [job * 10 + i for i in range(3)]
+    runner.close()
+    with self.assertRaisesRegex(RuntimeError, 'Close'):
+      runner.add_job()
+
+    outputs = {}
+    done = []
+    for job_id, stream_name, packet in runner:
+      if stream_name is None:
+        done.append(job_id)
+      else:
+        self.assertEqual(stream_name, 'out')
+        self.assertNotIn(job_id, done)
+        outputs.setdefault(job_id, []).append(
+            mp.packet_getter.get_int(packet))
+    self.assertCountEqual(done, expected.keys())
+    self.assertEqual(outputs, expected)
+
+  def test_failed_job(self):
+    runner = mp.GraphBatchRunner(
+        graph_config=_PASS_THROUGH_CONFIG, output_streams=['out'])
+    runner.add_job(
+        input_packets={'in': [mp.packet_creator.create_int(1).at(0)]})
+    runner.add_job(
+        input_packets={'unknown': [mp.packet_creator.create_int(1).at(0)]})
+    runner.close()
+    iterator = iter(runner)
+    self.assertEqual(next(iterator)[0], 0)
+    self.assertEqual(next(iterator), (0, None, None))
+    with self.assertRaisesRegex(RuntimeError, 'Job 1 failed'):
+      next(iterator)
+    with self.assertRaises(StopIteration):
+      next(iterator)
+
+
+if __name__ == '__main__':
+  absltest.main()
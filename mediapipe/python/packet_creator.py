@@ -48,6 +48,7 @@ create_string_vector = _packet_creator.create_string_vector
 create_packet_vector = _packet_creator.create_packet_vector
 create_string_to_packet_map = _packet_creator.create_string_to_packet_map
 create_matrix = _packet_creator.create_matrix
+create_tensor = _packet_creator.create_tensor
 
 
 def create_image_frame(data: Union[image_frame.ImageFrame, np.ndarray],
@@ -34,8 +34,12 @@ get_str_list = _packet_getter.get_str_list
 get_packet_list = _packet_getter.get_packet_list
 get_str_to_packet_dict = _packet_getter.get_str_to_packet_dict
 get_image = _packet_getter.get_image
+get_image_numpy_view = _packet_getter.get_image_numpy_view
 get_image_frame = _packet_getter.get_image_frame
+get_image_frame_numpy_view = _packet_getter.get_image_frame_numpy_view
 get_matrix = _packet_getter.get_matrix
+get_tensor = _packet_getter.get_tensor
+get_tensor_list = _packet_getter.get_tensor_list
 
 
 def get_proto(packet: mp_packet.Packet) -> Type[message.Message]:
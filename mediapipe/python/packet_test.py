@@ -475,6 +475,53 @@ class PacketTest(absltest.TestCase):
     # copy mode.
     self.assertEqual(sys.getrefcount(rgb_data), initial_ref_count)
 
+  def test_image_frame_packet_numpy_view(self):
+    # Each row of 5 SRGB pixels is padded from 15 to 16 bytes when copied.
+    w, h, channels = 5, random.randrange(3, 100), 3
+    rgb_data = np.random.randint(255, size=(h, w, channels), dtype=np.uint8)
+    p = mp.packet_creator.create_image_frame(
+        image_format=mp.ImageFormat.SRGB, data=rgb_data, copy=True)
+    output_ndarray = mp.packet_getter.get_image_frame_numpy_view(p)
+    self.assertFalse(output_ndarray.flags.c_contiguous)
+    self.assertFalse(output_ndarray.flags.writeable)
+    # The numpy view keeps the packet content alive.
+    del p
+    gc.collect()
+    self.assertTrue(np.array_equal(rgb_data, output_ndarray))
+
+    # In reference mode, the numpy view points to the input data.
+    rgb_data.flags.writeable = False
+    p = mp.packet_creator.create_image_frame(
+        image_format=mp.ImageFormat.SRGB, data=rgb_data)
+    output_ndarray = mp.packet_getter.get_image_frame_numpy_view(p)
+    self.assertTrue(np.shares_memory(rgb_data, output_ndarray))
+
+  def test_image_packet_numpy_view(self):
+    w, h, channels = 5, random.randrange(3, 100), 3
+    rgb_data = np.random.randint(255, size=(h, w, channels), dtype=np.uint8)
+    rgb_data.flags.writeable = False
+    p = mp.packet_creator.create_image(
+        image_format=mp.ImageFormat.SRGB, data=rgb_data)
+    output_ndarray = mp.packet_getter.get_image_numpy_view(p)
+    self.assertFalse(output_ndarray.flags.writeable)
+    self.assertTrue(np.shares_memory(rgb_data, output_ndarray))
+    del p
+    gc.collect()
+    self.assertTrue(np.array_equal(rgb_data, output_ndarray))
+
+  def test_tensor_packet(self):
+    for dtype in [np.float32, np.float16, np.uint8, np.int8]:
+      np_tensor = np.arange(24, dtype=dtype).reshape(1, 2, 3, 4)
+      p = mp.packet_creator.create_tensor(np_tensor)
+      output_tensor = mp.packet_getter.get_tensor(p)
+      del p
+      gc.collect()
+      self.assertEqual(output_tensor.dtype, dtype)
+      self.assertFalse(output_tensor.flags.writeable)
+      self.assertTrue(np.array_equal(np_tensor, output_tensor))
+    with self.assertRaisesRegex(TypeError, 'Tensor data should be'):
+      mp.packet_creator.create_tensor(np.arange(4, dtype=np.int64))
+
   def test_matrix_packet(self):
     np_matrix = np.array([[.1, .2, .3], [.4, .5, .6]])
     initial_ref_count = sys.getrefcount(np_matrix)
@@ -0,0 +1,256 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/python/pybind/graph_batch_runner.h"
+
+#include <memory>
+
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/graph_batch_runner.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/validated_graph_config.h"
+#include "mediapipe/python/pybind/util.h"
+#include "pybind11/pybind11.h"
+#include "pybind11/stl.h"
+
+namespace mediapipe {
+namespace python {
+
+namespace py = pybind11;
+
+namespace {
+
+std::map<std::string, Packet> ToPacketMap(const py::dict& packets) {
+  std::map<std::string, Packet> packet_map;
+  for (const auto& kv_pair : packets) {
+    packet_map[kv_pair.first.cast<std::string>()] =
+        kv_pair.second.cast<Packet>();
+  }
+  return packet_map;
+}
+
+// Destroys the runner without holding the GIL. ~GraphBatchRunner waits for
+// the graph threads, which need the GIL to release packets that reference
+// Python objects.
+struct GraphBatchRunnerDeleter {
+  void operator()(GraphBatchRunner* runner) const {
+    py::gil_scoped_release gil_release;
+    delete runner;
+  }
+};
+
+}  // namespace
+
+void GraphBatchRunnerSubmodule(pybind11::module* module) {
+  py::module m = module->def_submodule("graph_batch_runner",
+                                       "MediaPipe graph batch runner module.");
+
+  py::class_<GraphBatchRunner,
+             std::unique_ptr<GraphBatchRunner, GraphBatchRunnerDeleter>>
+      graph_batch_runner(
+          m, "GraphBatchRunner",
+          R"doc(Runs a queue of jobs on several instances of the same graph.
+
+  Each job is one run of a graph instance, e.g. the processing of one video.
+  The graph instances run their calculators on a single shared executor, and
+  the outputs of all the jobs are returned by iterating over the runner.)doc");
+
+  graph_batch_runner.def(
+      py::init([](py::kwargs kwargs) {
+        bool init_with_binary_graph = false;
+        bool init_with_graph_proto = false;
+        bool init_with_validated_graph_config = false;
+        CalculatorGraphConfig graph_config_proto;
+        GraphBatchRunner::Options options;
+        std::map<std::string, Packet> side_packets;
+        for (const auto& kw : kwargs) {
+          const std::string& key = kw.first.cast<std::string>();
+          if (key == "binary_graph_path") {
+            init_with_binary_graph = true;
+            std::string file_name(kw.second.cast<py::object>().str());
+            graph_config_proto = ReadCalculatorGraphConfigFromFile(file_name);
+          } else if (key == "graph_config") {
+            init_with_graph_proto = true;
+            if (!ParseTextProto<CalculatorGraphConfig>(
+                    kw.second.cast<py::object>().str(), &graph_config_proto)) {
+              throw RaisePyError(
+                  PyExc_RuntimeError,
+                  absl::StrCat("Failed to parse: ",
+                               std::string(kw.second.cast<py::object>().str()))
+                      .c_str());
+            }
+          } else if (key == "validated_graph_config") {
+            init_with_validated_graph_config = true;
+            graph_config_proto =
+                py::cast<ValidatedGraphConfig*>(kw.second)->Config();
+          } else if (key == "num_graphs") {
+            options.num_graphs = kw.second.cast<int>();
+          } else if (key == "num_threads") {
+            options.num_threads = kw.second.cast<int>();
+          } else if (key == "output_streams") {
+            options.output_streams =
+                kw.second.cast<std::vector<std::string>>();
+          } else if (key == "side_packets") {
+            side_packets = ToPacketMap(kw.second.cast<py::dict>());
+          } else if (key == "max_queued_outputs") {
+            options.max_queued_outputs = kw.second.cast<int>();
+          } else {
+            throw RaisePyError(
+                PyExc_RuntimeError,
+                absl::StrCat("Unknown kwargs input argument: ", key).c_str());
+          }
+        }
+
+        if ((init_with_binary_graph ? 1 : 0) + (init_with_graph_proto ? 1 : 0) +
+                (init_with_validated_graph_config ? 1 : 0) !=
+            1) {
+          throw RaisePyError(PyExc_ValueError,
+                             "Please provide one of the following: "
+                             "\'binary_graph_path\' to initialize the graph "
+                             "with a binary graph file, or "
+                             "\'graph_config\' to initialize the graph with a "
+                             "graph config proto, or "
+                             "\'validated_graph_config\' to initialize the "
+                             "graph with a ValidatedGraphConfig object.");
+        }
+        auto status_or_runner = GraphBatchRunner::Create(
+            graph_config_proto, options, side_packets);
+        RaisePyErrorIfNotOk(status_or_runner.status());
+        return std::move(status_or_runner).value().release();
+      }),
+      R"doc(Initialize GraphBatchRunner object.
+
+  Args:
+    binary_graph_path: The path to a binary mediapipe graph file (.binarypb).
+    graph_config: A single CalculatorGraphConfig proto message or its text proto
+      format.
+    validated_graph_config: A ValidatedGraphConfig object.
+    num_graphs: The number of graph instances, i.e. the number of jobs run at
+      once. Defaults to 1.
+    num_threads: The number of threads shared by all graph instances. Defaults
+      to one thread per CPU core.
+    output_streams: A list of the graph output streams to collect.
+    side_packets: A dict maps from input side packet names to the packets
+      shared by all jobs, e.g. models.
+    max_queued_outputs: If positive, the graph instances are throttled while
+      this many outputs are waiting to be returned.
+
+  Raises:
+    FileNotFoundError: If the binary graph file can't be found.
+    ValueError: If the input arguments prvoided are more than needed or the
+      graph validation process contains error.
+
+  Examples:
+    runner = mp.GraphBatchRunner(
+        graph_config=config, num_graphs=16, output_streams=['detections'])
+)doc");
+
+  graph_batch_runner.def(
+      "add_job",
+      [](GraphBatchRunner* self, const py::dict& input_side_packets,
+         const py::dict& input_packets) {
+        GraphBatchRunner::Job job;
+        job.side_packets = ToPacketMap(input_side_packets);
+        for (const auto& kv_pair : input_packets) {
+          job.input_packets[kv_pair.first.cast<std::string>()] =
+              kv_pair.second.cast<std::vector<Packet>>();
+        }
+        auto status_or_job_id = self->AddJob(std::move(job));
+        RaisePyErrorIfNotOk(status_or_job_id.status());
+        return status_or_job_id.value();
+      },
+      R"doc(Queue a job, and return its id.
+
+  Jobs are started in the order they are added, as graph instances become
+  available.
+
+  Args:
+    input_side_packets: A dict maps from the input side packet names of the
+      run to the packets, in addition to the shared side packets.
+    input_packets: A dict maps from graph input stream names to the lists of
+      packets added to the streams. The packets must have timestamps. All graph
+      input streams are closed after the packets are added.
+
+  Raises:
+    RuntimeError: If close() has been called.
+
+  Examples:
+    job_id = runner.add_job(
+        input_side_packets={
+            'input_video_path': packet_creator.create_string(path)
+        })
+)doc",
+      py::arg("input_side_packets") = py::dict(),
+      py::arg("input_packets") = py::dict());
+
+  graph_batch_runner.def(
+      "close",
+      [](GraphBatchRunner* self) {
+        py::gil_scoped_release gil_release;
+        self->Close();
+      },
+      R"doc(Indicate that no more jobs will be added.
+
+  The iteration over the runner stops once all the jobs are done.)doc");
+
+  graph_batch_runner.def("__iter__",
+                         [](py::object self) -> py::object { return self; });
+
+  graph_batch_runner.def(
+      "__next__",
+      [](GraphBatchRunner* self) {
+        GraphBatchRunner::Output output;
+        bool has_output;
+        {
+          py::gil_scoped_release gil_release;
+          has_output = self->Next(&output);
+        }
+        if (!has_output) {
+          throw py::stop_iteration();
+        }
+        if (!output.stream_name.empty()) {
+          return py::make_tuple(output.job_id, output.stream_name,
+                                output.packet);
+        }
+        if (!output.status.ok()) {
+          throw RaisePyError(
+              StatusCodeToPyError(output.status.code()),
+              absl::StrCat("Job ", output.job_id,
+                           " failed: ", output.status.message())
+                  .c_str());
+        }
+        return py::make_tuple(output.job_id, py::none(), py::none());
+      },
+      R"doc(Wait for the next output of any job.
+
+  Returns:
+    A (job_id, stream_name, packet) tuple for every output packet. The packets
+    of one job and stream are in timestamp order. When a job is done, a
+    (job_id, None, None) tuple is returned.
+
+  Raises:
+    RuntimeError: If a job failed. The iteration can continue with the outputs
+      of the other jobs.
+
+  Examples:
+    for job_id, stream_name, packet in runner:
+      if stream_name is None:
+        print(f'Job {job_id} is done.')
+)doc");
+}
+
+}  // namespace python
+}  // namespace mediapipe
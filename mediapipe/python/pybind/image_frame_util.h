@@ -53,7 +53,12 @@ std::unique_ptr<ImageFrame> CreateImageFrame(
   auto image_frame = absl::make_unique<ImageFrame>(
       format, /*width=*/cols, /*height=*/rows, width_step,
       static_cast<uint8*>(data.request().ptr),
-      /*deleter=*/[data_pyobject](uint8*) { Py_XDECREF(data_pyobject); });
+      // The image frame may be released by a graph thread that doesn't hold
+      // the GIL.
+      /*deleter=*/[data_pyobject](uint8*) {
+        py::gil_scoped_acquire gil_acquire;
+        Py_XDECREF(data_pyobject);
+      });
   Py_XINCREF(data_pyobject);
   return image_frame;
 }
@@ -124,6 +129,48 @@ inline py::array GenerateDataPyArrayOnDemand(const ImageFrame& image_frame,
   return GenerateContiguousDataArray(image_frame, py_object);
 }
 
+template <typename T>
+py::array GenerateDataPyArrayViewHelper(const ImageFrame& image_frame,
+                                        const py::object& base) {
+  std::vector<int> shape{image_frame.Height(), image_frame.Width()};
+  std::vector<int> strides{image_frame.WidthStep(),
+                           image_frame.NumberOfChannels() *
+                               static_cast<int>(sizeof(T))};
+  if (image_frame.NumberOfChannels() > 1) {
+    shape.push_back(image_frame.NumberOfChannels());
+    strides.push_back(sizeof(T));
+  }
+  py::array_t<T> data_view(
+      shape, strides, reinterpret_cast<const T*>(image_frame.PixelData()),
+      base);
+  py::detail::array_proxy(data_view.ptr())->flags &=
+      ~py::detail::npy_api::NPY_ARRAY_WRITEABLE_;
+  return data_view;
+}
+
+// Generates an unwritable pyarray object that points to the pixel data of the
+// image frame without copying it. If the rows of the image frame are padded,
+// the pyarray is strided rather than contiguous. The base object must keep the
+// image frame alive for as long as the pyarray exists.
+inline py::array GenerateDataPyArrayView(const ImageFrame& image_frame,
+                                         const py::object& base) {
+  if (image_frame.IsEmpty()) {
+    throw RaisePyError(PyExc_RuntimeError, "ImageFrame is unallocated.");
+  }
+  switch (image_frame.ChannelSize()) {
+    case sizeof(uint8):
+      return GenerateDataPyArrayViewHelper<uint8>(image_frame, base);
+    case sizeof(uint16):
+      return GenerateDataPyArrayViewHelper<uint16>(image_frame, base);
+    case sizeof(float):
+      return GenerateDataPyArrayViewHelper<float>(image_frame, base);
+    default:
+      throw RaisePyError(PyExc_RuntimeError,
+                         "Unsupported image frame channel size. Data is not "
+                         "uint8, uint16, or float?");
+  }
+}
+
 // Gets the cached contiguous data array from the "__contiguous_data" attribute.
 // If the attribute doesn't exist, the function calls
 // GenerateContiguousDataArray() to generate the contiguous data pyarray object,
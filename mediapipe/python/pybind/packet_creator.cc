@@ -14,10 +14,13 @@
 
 #include "mediapipe/python/pybind/packet_creator.h"
 
+#include <cstring>
+
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "mediapipe/framework/formats/image.h"
 #include "mediapipe/framework/formats/matrix.h"
+#include "mediapipe/framework/formats/tensor.h"
 #include "mediapipe/framework/packet.h"
 #include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/timestamp.h"
@@ -72,6 +75,32 @@ Packet CreateImagePacket(mediapipe::ImageFormat::Format format,
   return Packet();
 }
 
+Packet CreateTensorPacket(const py::array& data) {
+  Tensor::ElementType element_type;
+  if (data.dtype().is(py::dtype::of<float>())) {
+    element_type = Tensor::ElementType::kFloat32;
+  } else if (data.dtype().is(py::dtype("float16"))) {
+    element_type = Tensor::ElementType::kFloat16;
+  } else if (data.dtype().is(py::dtype::of<uint8>())) {
+    element_type = Tensor::ElementType::kUInt8;
+  } else if (data.dtype().is(py::dtype::of<int8>())) {
+    element_type = Tensor::ElementType::kInt8;
+  } else {
+    throw RaisePyError(PyExc_TypeError,
+                       "Tensor data should be a float32, float16, uint8, or "
+                       "int8 numpy ndarray.");
+  }
+  // Tensor owns its storage, so the data is copied once into the CPU buffer.
+  // Only non-contiguous data needs to be made contiguous first.
+  py::array contiguous_data = py::array::ensure(data, py::array::c_style);
+  auto tensor = absl::make_unique<Tensor>(
+      element_type, Tensor::Shape(std::vector<int>(
+                        data.shape(), data.shape() + data.ndim())));
+  std::memcpy(tensor->GetCpuWriteView().buffer<void>(), contiguous_data.data(),
+              tensor->bytes());
+  return Adopt(tensor.release());
+}
+
 }  // namespace
 
 namespace py = pybind11;
@@ -566,6 +595,29 @@ void PublicPacketCreators(pybind11::module* m) {
 )doc",
       py::arg().noconvert(), py::return_value_policy::move);
 
+  m->def("create_tensor", &CreateTensorPacket,
+         R"doc(Create a MediaPipe Tensor Packet from a numpy ndarray.
+
+  The method copies the data into the CPU buffer of the Tensor, which has the
+  shape and element type of the ndarray. Use packet_getter.get_tensor() to
+  read the data back without copying it.
+
+  Args:
+    data: A float32, float16, uint8, or int8 numpy ndarray.
+
+  Returns:
+    A MediaPipe Tensor Packet.
+
+  Raises:
+    TypeError: If the input is not a numpy ndarray of a supported type.
+
+  Examples:
+    packet = mp.packet_creator.create_tensor(
+        np.array([[.1, .2, .3], [.4, .5, .6]], dtype=np.float32))
+    data = mp.packet_getter.get_tensor(packet)
+)doc",
+         py::arg("data").noconvert(), py::return_value_policy::move);
+
   m->def(
       "create_matrix",
       // Eigen Map class
@@ -17,6 +17,7 @@
 #include "absl/status/statusor.h"
 #include "mediapipe/framework/formats/image.h"
 #include "mediapipe/framework/formats/matrix.h"
+#include "mediapipe/framework/formats/tensor.h"
 #include "mediapipe/framework/packet.h"
 #include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/timestamp.h"
@@ -36,6 +37,52 @@ const T& GetContent(const Packet& packet) {
   return packet.Get<T>();
 }
 
+// Returns a capsule that keeps a copy of the packet, and thus its payload,
+// alive. It is used as the base object of the pyarrays that point to the
+// payload data.
+py::capsule PacketCapsule(const Packet& packet) {
+  return py::capsule(new Packet(packet), [](void* packet_copy) {
+    delete reinterpret_cast<Packet*>(packet_copy);
+  });
+}
+
+// Generates an unwritable pyarray object that points to the CPU data of the
+// tensor without copying it.
+py::array GenerateTensorPyArrayView(const Tensor& tensor,
+                                    const py::object& base) {
+  py::dtype dtype;
+  switch (tensor.element_type()) {
+    case Tensor::ElementType::kFloat32:
+      dtype = py::dtype::of<float>();
+      break;
+    case Tensor::ElementType::kFloat16:
+      dtype = py::dtype("float16");
+      break;
+    case Tensor::ElementType::kUInt8:
+      dtype = py::dtype::of<uint8>();
+      break;
+    case Tensor::ElementType::kInt8:
+      dtype = py::dtype::of<int8>();
+      break;
+    default:
+      throw RaisePyError(PyExc_RuntimeError,
+                         "Unsupported tensor element type.");
+  }
+  // Requesting the view brings the CPU buffer up to date. The view holds a
+  // lock on the tensor, so it is released right away. The CPU buffer stays in
+  // place until the tensor is destroyed, since a tensor in a packet is not
+  // written to.
+  const void* buffer;
+  {
+    py::gil_scoped_release gil_release;
+    buffer = tensor.GetCpuReadView().buffer<void>();
+  }
+  py::array data_view(dtype, tensor.shape().dims, buffer, base);
+  py::detail::array_proxy(data_view.ptr())->flags &=
+      ~py::detail::npy_api::NPY_ARRAY_WRITEABLE_;
+  return data_view;
+}
+
 }  // namespace
 
 namespace py = pybind11;
@@ -378,6 +425,115 @@ void PublicPacketGetters(pybind11::module* m) {
 )doc",
          py::return_value_policy::reference_internal);
 
+  m->def(
+      "get_image_frame_numpy_view",
+      [](const Packet& packet) {
+        return GenerateDataPyArrayView(GetContent<ImageFrame>(packet),
+                                       PacketCapsule(packet));
+      },
+      R"doc(Get the pixel data of a MediaPipe ImageFrame Packet as an unwritable numpy ndarray.
+
+  The returned numpy ndarray points to the pixel data in the packet without
+  copying it, and keeps the packet content alive. If the image frame rows are
+  padded, the ndarray is strided rather than contiguous.
+
+  Args:
+    packet: A MediaPipe ImageFrame Packet.
+
+  Returns:
+    An unwritable numpy ndarray.
+
+  Raises:
+    ValueError: If the Packet doesn't contain ImageFrame.
+
+  Examples:
+    packet = packet_creator.create_image_frame(frame)
+    data = packet_getter.get_image_frame_numpy_view(packet)
+)doc");
+
+  m->def(
+      "get_image_numpy_view",
+      [](const Packet& packet) {
+        return GenerateDataPyArrayView(
+            *GetContent<Image>(packet).GetImageFrameSharedPtr(),
+            PacketCapsule(packet));
+      },
+      R"doc(Get the pixel data of a MediaPipe Image Packet as an unwritable numpy ndarray.
+
+  The returned numpy ndarray points to the pixel data in the packet without
+  copying it, and keeps the packet content alive. If the image rows are padded,
+  the ndarray is strided rather than contiguous.
+
+  Args:
+    packet: A MediaPipe Image Packet.
+
+  Returns:
+    An unwritable numpy ndarray.
+
+  Raises:
+    ValueError: If the Packet doesn't contain Image.
+
+  Examples:
+    packet = packet_creator.create_image(frame)
+    data = packet_getter.get_image_numpy_view(packet)
+)doc");
+
+  m->def(
+      "get_tensor",
+      [](const Packet& packet) {
+        return GenerateTensorPyArrayView(GetContent<Tensor>(packet),
+                                         PacketCapsule(packet));
+      },
+      R"doc(Get the content of a MediaPipe Tensor Packet as an unwritable numpy ndarray.
+
+  The returned numpy ndarray points to the tensor data in the packet without
+  copying it, and keeps the packet content alive.
+
+  Args:
+    packet: A MediaPipe Tensor Packet.
+
+  Returns:
+    An unwritable numpy ndarray.
+
+  Raises:
+    ValueError: If the Packet doesn't contain Tensor.
+
+  Examples:
+    packet = mp.packet_creator.create_tensor(
+        np.array([[.1, .2], [.3, .4]], dtype=np.float32))
+    data = mp.packet_getter.get_tensor(packet)
+)doc");
+
+  m->def(
+      "get_tensor_list",
+      [](const Packet& packet) {
+        const auto& tensors = GetContent<std::vector<Tensor>>(packet);
+        py::object base = PacketCapsule(packet);
+        std::vector<py::array> results;
+        results.reserve(tensors.size());
+        for (const Tensor& tensor : tensors) {
+          results.push_back(GenerateTensorPyArrayView(tensor, base));
+        }
+        return results;
+      },
+      R"doc(Get the content of a MediaPipe Tensor vector Packet as a list of unwritable numpy ndarrays.
+
+  The returned numpy ndarrays point to the tensor data in the packet without
+  copying it, and keep the packet content alive.
+
+  Args:
+    packet: A MediaPipe Packet that holds std::vector<Tensor>.
+
+  Returns:
+    A list of unwritable numpy ndarrays.
+
+  Raises:
+    ValueError: If the Packet doesn't contain std::vector<Tensor>.
+
+  Examples:
+    data = mp.packet_getter.get_tensor_list(output_tensors_packet)
+)doc");
+
   m->def(
       "get_matrix",
       [](const Packet& packet) {
@@ -49,6 +49,7 @@ from mediapipe.framework.formats import rect_pb2
 from mediapipe.modules.objectron.calculators import annotation_data_pb2
 from mediapipe.modules.objectron.calculators import lift_2d_frame_annotation_to_3d_calculator_pb2
 # pylint: enable=unused-import
+from mediapipe.python._framework_bindings import _packet_creator
 from mediapipe.python._framework_bindings import calculator_graph
 from mediapipe.python._framework_bindings import image_frame
 from mediapipe.python._framework_bindings import packet
@@ -351,10 +352,18 @@ class SolutionBase:
             input_stream_type == PacketDataType.IMAGE):
         if data.shape[2] != RGB_CHANNELS:
           raise ValueError('Input image must contain three channel rgb data.')
+        # Writeable frames are copied, since callers commonly draw on them
+        # after process() returns, while the graph may retain the input packet
+        # and the outputs may view its pixels. Read-only frames and the
+        # private contiguous copy of non-contiguous frames are referenced.
+        if data.flags.c_contiguous:
+          image_data, copy = data, data.flags.writeable
+        else:
+          image_data, copy = np.ascontiguousarray(data), False
         self._graph.add_packet_to_input_stream(
             stream=stream_name,
-            packet=self._make_packet(input_stream_type,
-                                     data).at(self._simulated_timestamp))
+            packet=self._make_packet(input_stream_type, image_data,
+                                     copy=copy).at(self._simulated_timestamp))
       else:
         self._graph.add_packet_to_input_stream(
             stream=stream_name,
@@ -581,12 +590,23 @@ class SolutionBase:
         return
     extension_list.add().Pack(extension_value)
 
-  def _make_packet(self, packet_data_type: PacketDataType,
-                   data: Any) -> packet.Packet:
+  def _make_packet(self,
+                   packet_data_type: PacketDataType,
+                   data: Any,
+                   copy: Optional[bool] = None) -> packet.Packet:
     if (packet_data_type == PacketDataType.IMAGE_FRAME or
         packet_data_type == PacketDataType.IMAGE):
-      return getattr(packet_creator, 'create_' + packet_data_type.value)(
-          data, image_format=image_frame.ImageFormat.SRGB)
+      if copy is None:
+        return getattr(packet_creator, 'create_' + packet_data_type.value)(
+            data, image_format=image_frame.ImageFormat.SRGB)
+      # Calls the internal creators directly, since the public ones warn about
+      # referencing writeable data.
+      # pylint:disable=protected-access
+      return getattr(
+          _packet_creator,
+          '_create_' + packet_data_type.value + '_from_pixel_data')(
+              image_frame.ImageFormat.SRGB, data, copy)
+      # pylint:enable=protected-access
     else:
       return getattr(packet_creator, 'create_' + packet_data_type.value)(data)
 
@@ -609,8 +629,8 @@ class SolutionBase:
       return packet_getter.get_str(output_packet)
     elif (packet_data_type == PacketDataType.IMAGE_FRAME or
           packet_data_type == PacketDataType.IMAGE):
-      return getattr(packet_getter, 'get_' +
-                     packet_data_type.value)(output_packet).numpy_view()
+      return getattr(packet_getter, 'get_' + packet_data_type.value +
+                     '_numpy_view')(output_packet)
     else:
       return getattr(packet_getter, 'get_' + packet_data_type.value)(
           output_packet)
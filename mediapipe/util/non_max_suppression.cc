@@ -0,0 +1,349 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/non_max_suppression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#include "mediapipe/framework/port/logging.h"
+
+namespace mediapipe {
+
+namespace {
+
+// Below this number of boxes, comparing all pairs is faster than building a
+// grid.
+constexpr int kMinBoxesForGrid = 256;
+
+// Boxes covering more grid cells than this are kept in a separate list, which
+// is checked for every query.
+constexpr int kMaxCellsPerBox = 16;
+
+bool IsFinite(const Rectangle_f& rect) {
+  return std::isfinite(rect.xmin()) && std::isfinite(rect.ymin()) &&
+         std::isfinite(rect.xmax()) && std::isfinite(rect.ymax());
+}
+
+// Returns the box indices sorted by decreasing score.
+std::vector<int> SortByScore(absl::Span<const ScoredBox> boxes) {
+  std::vector<int> order(boxes.size());
+  for (int i = 0; i < boxes.size(); ++i) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [&boxes](int i, int j) {
+    return boxes[i].score > boxes[j].score;
+  });
+  return order;
+}
+
+// A uniform grid over a set of boxes, used to find the inserted boxes that may
+// overlap a given box.
+//
+// Two boxes whose intersection has a positive area always share a cell, so
+// any pair with a positive overlap similarity is found. Boxes with
+// non-finite coordinates cannot be placed in the grid: they are returned for
+// every query when inserted, and must be compared with all boxes when queried.
+class BoxGrid {
+ public:
+  explicit BoxGrid(absl::Span<const ScoredBox> boxes);
+
+  static bool IsIndexable(const Rectangle_f& rect) { return IsFinite(rect); }
+
+  void Insert(int index);
+
+  // Calls |visit| once for each inserted box that may overlap |rect|, until
+  // it returns true. Returns whether |visit| returned true.
+  template <typename Visitor>
+  bool VisitNearby(const Rectangle_f& rect, const Visitor& visit);
+
+ private:
+  struct CellRange {
+    int x0, y0, x1, y1;
+    int size() const {
+      return std::max(0, x1 - x0 + 1) * std::max(0, y1 - y0 + 1);
+    }
+  };
+  int CellIndex(float value, float origin, float cell_size,
+                int num_cells) const;
+  CellRange GetCellRange(const Rectangle_f& rect) const;
+
+  absl::Span<const ScoredBox> boxes_;
+  float origin_x_ = 0.f;
+  float origin_y_ = 0.f;
+  float cell_width_ = 0.f;
+  float cell_height_ = 0.f;
+  int num_cells_x_ = 1;
+  int num_cells_y_ = 1;
+  std::vector<std::vector<int>> cells_;
+  // Inserted boxes that are not in cells_.
+  std::vector<int> unplaced_;
+  // All inserted boxes.
+  std::vector<int> inserted_;
+  // The last query that visited each box.
+  std::vector<int> last_visit_;
+  int num_queries_ = 0;
+};
+
+BoxGrid::BoxGrid(absl::Span<const ScoredBox> boxes)
+    : boxes_(boxes), last_visit_(boxes.size(), -1) {
+  // Each axis gets about sqrt(n) cells, or fewer if the boxes are larger than
+  // that on average.
+  float xmin = std::numeric_limits<float>::max();
+  float ymin = std::numeric_limits<float>::max();
+  float xmax = std::numeric_limits<float>::lowest();
+  float ymax = std::numeric_limits<float>::lowest();
+  double total_width = 0;
+  double total_height = 0;
+  int num_placed = 0;
+  for (const ScoredBox& box : boxes) {
+    if (!IsIndexable(box.rect) || box.rect.IsEmpty()) continue;
+    xmin = std::min(xmin, box.rect.xmin());
+    ymin = std::min(ymin, box.rect.ymin());
+    xmax = std::max(xmax, box.rect.xmax());
+    ymax = std::max(ymax, box.rect.ymax());
+    total_width += box.rect.Width();
+    total_height += box.rect.Height();
+    ++num_placed;
+  }
+  if (num_placed == 0) {
+    cells_.resize(1);
+    return;
+  }
+  const int max_cells_per_axis =
+      std::max(1, static_cast<int>(std::sqrt(num_placed)));
+  origin_x_ = xmin;
+  origin_y_ = ymin;
+  cell_width_ = std::max(static_cast<float>(total_width / num_placed),
+                         (xmax - xmin) / max_cells_per_axis);
+  cell_height_ = std::max(static_cast<float>(total_height / num_placed),
+                          (ymax - ymin) / max_cells_per_axis);
+  if (cell_width_ > 0.f && std::isfinite(cell_width_)) {
+    num_cells_x_ = std::min(
+        max_cells_per_axis,
+        static_cast<int>(std::ceil((xmax - xmin) / cell_width_)) + 1);
+  }
+  if (cell_height_ > 0.f && std::isfinite(cell_height_)) {
+    num_cells_y_ = std::min(
+        max_cells_per_axis,
+        static_cast<int>(std::ceil((ymax - ymin) / cell_height_)) + 1);
+  }
+  cells_.resize(num_cells_x_ * num_cells_y_);
+}
+
+int BoxGrid::CellIndex(float value, float origin, float cell_size,
+                       int num_cells) const {
+  if (num_cells == 1) return 0;
+  // Monotonic in |value|, so overlapping intervals get overlapping cells.
+  const float cell = std::floor((value - origin) / cell_size);
+  return static_cast<int>(
+      std::min(std::max(cell, 0.f), static_cast<float>(num_cells - 1)));
+}
+
+BoxGrid::CellRange BoxGrid::GetCellRange(const Rectangle_f& rect) const {
+  return {CellIndex(rect.xmin(), origin_x_, cell_width_, num_cells_x_),
+          CellIndex(rect.ymin(), origin_y_, cell_height_, num_cells_y_),
+          CellIndex(rect.xmax(), origin_x_, cell_width_, num_cells_x_),
+          CellIndex(rect.ymax(), origin_y_, cell_height_, num_cells_y_)};
+}
+
+void BoxGrid::Insert(int index) {
+  inserted_.push_back(index);
+  const Rectangle_f& rect = boxes_[index].rect;
+  if (!IsIndexable(rect)) {
+    unplaced_.push_back(index);
+    return;
+  }
+  const CellRange range = GetCellRange(rect);
+  if (range.size() > kMaxCellsPerBox) {
+    unplaced_.push_back(index);
+    return;
+  }
+  for (int y = range.y0; y <= range.y1; ++y) {
+    for (int x = range.x0; x <= range.x1; ++x) {
+      cells_[y * num_cells_x_ + x].push_back(index);
+    }
+  }
+}
+
+template <typename Visitor>
+bool BoxGrid::VisitNearby(const Rectangle_f& rect, const Visitor& visit) {
+  DCHECK(IsIndexable(rect));
+  const CellRange range = GetCellRange(rect);
+  if (range.size() > kMaxCellsPerBox) {
+    for (int index : inserted_) {
+      if (visit(index)) return true;
+    }
+    return false;
+  }
+  for (int index : unplaced_) {
+    if (visit(index)) return true;
+  }
+  // Boxes covering several cells are visited once.
+  const int query = num_queries_++;
+  for (int y = range.y0; y <= range.y1; ++y) {
+    for (int x = range.x0; x <= range.x1; ++x) {
+      for (int index : cells_[y * num_cells_x_ + x]) {
+        if (last_visit_[index] == query) continue;
+        last_visit_[index] = query;
+        if (visit(index)) return true;
+      }
+    }
+  }
+  return false;
+}
+
+bool UseGrid(absl::Span<const ScoredBox> boxes,
+             const NonMaxSuppressionOptions& options) {
+  // With a negative threshold, boxes that do not intersect also suppress
+  // each other, so the grid does not apply.
+  return boxes.size() >= kMinBoxesForGrid &&
+         options.min_suppression_threshold >= 0.f;
+}
+
+}  // namespace
+
+float OverlapSimilarity(OverlapType overlap_type, const Rectangle_f& rect1,
+                        const Rectangle_f& rect2) {
+  if (!rect1.Intersects(rect2)) return 0.0f;
+  const float intersection_area = Rectangle_f(rect1).Intersect(rect2).Area();
+  float normalization;
+  switch (overlap_type) {
+    case OverlapType::kJaccard:
+      normalization = Rectangle_f(rect1).Union(rect2).Area();
+      break;
+    case OverlapType::kModifiedJaccard:
+      normalization = rect2.Area();
+      break;
+    case OverlapType::kIntersectionOverUnion:
+      normalization = rect1.Area() + rect2.Area() - intersection_area;
+      break;
+    default:
+      return 0.0f;
+  }
+  return normalization > 0.0f ? intersection_area / normalization : 0.0f;
+}
+
+std::vector<int> NonMaxSuppression(absl::Span<const ScoredBox> boxes,
+                                   const NonMaxSuppressionOptions& options) {
+  const std::vector<int> order = SortByScore(boxes);
+  const int max_num_boxes = options.max_num_boxes > -1
+                                ? options.max_num_boxes
+                                : static_cast<int>(boxes.size());
+  const bool use_grid = UseGrid(boxes, options);
+  BoxGrid grid(use_grid ? boxes : absl::Span<const ScoredBox>());
+
+  std::vector<int> retained;
+  for (int index : order) {
+    const ScoredBox& box = boxes[index];
+    if (options.min_score > 0 && box.score < options.min_score) {
+      break;
+    }
+    // The current box is suppressed iff there exists a retained box, whose
+    // location overlaps more than the specified threshold with the location
+    // of the current box.
+    auto suppresses = [&](int retained_index) {
+      const ScoredBox& retained_box = boxes[retained_index];
+      if (options.class_aware && retained_box.class_id != box.class_id) {
+        return false;
+      }
+      return OverlapSimilarity(options.overlap_type, retained_box.rect,
+                               box.rect) > options.min_suppression_threshold;
+    };
+    bool suppressed;
+    if (use_grid && BoxGrid::IsIndexable(box.rect)) {
+      suppressed = grid.VisitNearby(box.rect, suppresses);
+    } else {
+      suppressed = std::any_of(retained.begin(), retained.end(), suppresses);
+    }
+    if (!suppressed) {
+      retained.push_back(index);
+      if (use_grid) grid.Insert(index);
+    }
+    if (retained.size() >= max_num_boxes) {
+      break;
+    }
+  }
+  return retained;
+}
+
+std::vector<WeightedBoxCluster> WeightedNonMaxSuppression(
+    absl::Span<const ScoredBox> boxes,
+    const NonMaxSuppressionOptions& options) {
+  const std::vector<int> order = SortByScore(boxes);
+  std::vector<int> rank(boxes.size());
+  for (int i = 0; i < order.size(); ++i) {
+    rank[order[i]] = i;
+  }
+  const bool use_grid = UseGrid(boxes, options);
+  BoxGrid grid(use_grid ? boxes : absl::Span<const ScoredBox>());
+  if (use_grid) {
+    for (int index : order) grid.Insert(index);
+  }
+
+  std::vector<bool> removed(boxes.size(), false);
+  std::vector<WeightedBoxCluster> clusters;
+  std::vector<int> member_ranks;
+  int next_rank = 0;
+  int num_remaining = boxes.size();
+  while (num_remaining > 0) {
+    while (removed[order[next_rank]]) ++next_rank;
+    const int top_index = order[next_rank];
+    const ScoredBox& top = boxes[top_index];
+    if (options.min_score > 0 && top.score < options.min_score) {
+      break;
+    }
+
+    member_ranks.clear();
+    auto add_member = [&](int index) {
+      const ScoredBox& box = boxes[index];
+      if (!removed[index] &&
+          (!options.class_aware || box.class_id == top.class_id) &&
+          OverlapSimilarity(options.overlap_type, box.rect, top.rect) >
+              options.min_suppression_threshold) {
+        member_ranks.push_back(rank[index]);
+      }
+      return false;
+    };
+    if (use_grid && BoxGrid::IsIndexable(top.rect)) {
+      grid.VisitNearby(top.rect, add_member);
+      // Members are merged in order of decreasing score.
+      std::sort(member_ranks.begin(), member_ranks.end());
+    } else {
+      for (int r = next_rank; r < order.size(); ++r) {
+        add_member(order[r]);
+      }
+    }
+
+    WeightedBoxCluster cluster;
+    cluster.top_index = top_index;
+    cluster.members.reserve(member_ranks.size());
+    for (int member_rank : member_ranks) {
+      const int index = order[member_rank];
+      cluster.members.push_back(index);
+      removed[index] = true;
+    }
+    num_remaining -= member_ranks.size();
+    clusters.push_back(std::move(cluster));
+    // Stops if no box was removed.
+    if (member_ranks.empty()) {
+      break;
+    }
+  }
+  return clusters;
+}
+
+}  // namespace mediapipe
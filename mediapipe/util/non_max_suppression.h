@@ -0,0 +1,92 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_UTIL_NON_MAX_SUPPRESSION_H_
+#define MEDIAPIPE_UTIL_NON_MAX_SUPPRESSION_H_
+
+#include <vector>
+
+#include "absl/types/span.h"
+#include "mediapipe/framework/port/rectangle.h"
+
+namespace mediapipe {
+
+// Measures of the overlap between two boxes.
+enum class OverlapType {
+  // Intersection area over the area of the bounding box of both boxes.
+  kJaccard,
+  // Intersection area over the area of the second box.
+  kModifiedJaccard,
+  // Intersection area over the area of the union of both boxes.
+  kIntersectionOverUnion,
+};
+
+// A box taking part in non-maximum suppression.
+struct ScoredBox {
+  Rectangle_f rect;
+  float score;
+  // Only used if NonMaxSuppressionOptions::class_aware is set.
+  int class_id = 0;
+};
+
+struct NonMaxSuppressionOptions {
+  OverlapType overlap_type = OverlapType::kJaccard;
+  // A box is suppressed by a box with a higher score if their overlap is
+  // greater than this threshold.
+  float min_suppression_threshold = 1.0f;
+  // If positive, boxes with a lower score are not retained. They may still be
+  // merged into a cluster by WeightedNonMaxSuppression.
+  float min_score = -1.0f;
+  // The maximum number of boxes retained by NonMaxSuppression, or -1 for no
+  // limit.
+  int max_num_boxes = -1;
+  // If set, boxes only suppress boxes with the same class_id.
+  bool class_aware = false;
+};
+
+// Computes an overlap similarity between two rectangles, as defined by
+// |overlap_type|.
+float OverlapSimilarity(OverlapType overlap_type, const Rectangle_f& rect1,
+                        const Rectangle_f& rect2);
+
+// Returns the indices of the boxes that are not suppressed by a retained box
+// with a higher score, in order of decreasing score. Boxes with equal scores
+// are visited in input order.
+//
+// For larger inputs, boxes are looked up in a uniform grid, so that each box
+// is only compared with the retained boxes near it rather than with all of
+// them.
+std::vector<int> NonMaxSuppression(absl::Span<const ScoredBox> boxes,
+                                   const NonMaxSuppressionOptions& options);
+
+// A group of boxes merged by WeightedNonMaxSuppression.
+struct WeightedBoxCluster {
+  // The box with the highest score among the boxes that were left when the
+  // cluster was formed.
+  int top_index;
+  // The boxes that overlap the top box, in order of decreasing score. This
+  // includes the top box itself, unless it overlaps nothing (e.g. because its
+  // area is zero), in which case it is empty.
+  std::vector<int> members;
+};
+
+// Repeatedly takes the box with the highest score, and groups it with all
+// remaining boxes overlapping it. Stops after the first cluster with no
+// members. options.max_num_boxes is ignored.
+std::vector<WeightedBoxCluster> WeightedNonMaxSuppression(
+    absl::Span<const ScoredBox> boxes, const NonMaxSuppressionOptions& options);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_NON_MAX_SUPPRESSION_H_
@@ -0,0 +1,222 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/non_max_suppression.h"
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+ScoredBox MakeBox(float xmin, float ymin, float width, float height,
+                  float score, int class_id = 0) {
+  ScoredBox box;
+  box.rect = Rectangle_f(xmin, ymin, width, height);
+  box.score = score;
+  box.class_id = class_id;
+  return box;
+}
+
+// Returns |num_boxes| random boxes, with about |boxes_per_object| boxes
+// around each object.
+std::vector<ScoredBox> MakeCrowdedScene(int num_boxes, int boxes_per_object,
+                                        int seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> unit(0.f, 1.f);
+  std::uniform_real_distribution<float> jitter(-0.005f, 0.005f);
+  std::vector<ScoredBox> boxes;
+  float x = 0, y = 0, size = 0;
+  for (int i = 0; i < num_boxes; ++i) {
+    if (i % boxes_per_object == 0) {
+      size = 0.01f + 0.04f * unit(rng);
+      x = unit(rng) * (1.f - size);
+      y = unit(rng) * (1.f - size);
+    }
+    boxes.push_back(MakeBox(x + jitter(rng), y + jitter(rng),
+                            size + jitter(rng), size + jitter(rng), unit(rng),
+                            i % 3));
+  }
+  return boxes;
+}
+
+// Compares every box with every retained box.
+std::vector<int> ExhaustiveNonMaxSuppression(
+    const std::vector<ScoredBox>& boxes,
+    const NonMaxSuppressionOptions& options) {
+  std::vector<int> order(boxes.size());
+  for (int i = 0; i < order.size(); ++i) order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [&boxes](int i, int j) {
+    return boxes[i].score > boxes[j].score;
+  });
+  std::vector<int> retained;
+  for (int index : order) {
+    bool suppressed = false;
+    for (int retained_index : retained) {
+      if ((!options.class_aware ||
+           boxes[index].class_id == boxes[retained_index].class_id) &&
+          OverlapSimilarity(options.overlap_type, boxes[retained_index].rect,
+                            boxes[index].rect) >
+              options.min_suppression_threshold) {
+        suppressed = true;
+        break;
+      }
+    }
+    if (!suppressed) retained.push_back(index);
+  }
+  return retained;
+}
+
+TEST(NonMaxSuppressionTest, OverlapSimilarity) {
+  const Rectangle_f rect1(0.f, 0.f, 2.f, 2.f);
+  const Rectangle_f rect2(1.f, 0.f, 2.f, 1.f);
+  EXPECT_FLOAT_EQ(1.f / 6.f,
+                  OverlapSimilarity(OverlapType::kJaccard, rect1, rect2));
+  EXPECT_FLOAT_EQ(
+      0.5f, OverlapSimilarity(OverlapType::kModifiedJaccard, rect1, rect2));
+  EXPECT_FLOAT_EQ(0.2f, OverlapSimilarity(OverlapType::kIntersectionOverUnion,
+                                          rect1, rect2));
+  EXPECT_EQ(0.f, OverlapSimilarity(OverlapType::kIntersectionOverUnion, rect1,
+                                   Rectangle_f(3.f, 3.f, 1.f, 1.f)));
+}
+
+TEST(NonMaxSuppressionTest, SuppressesOverlappingBoxes) {
+  const std::vector<ScoredBox> boxes = {
+      MakeBox(0.1f, 0.1f, 0.2f, 0.2f, 0.5f),
+      MakeBox(0.12f, 0.1f, 0.2f, 0.2f, 0.9f),
+      MakeBox(0.6f, 0.6f, 0.2f, 0.2f, 0.7f),
+      MakeBox(0.6f, 0.6f, 0.2f, 0.2f, 0.1f),
+  };
+  NonMaxSuppressionOptions options;
+  options.overlap_type = OverlapType::kIntersectionOverUnion;
+  options.min_suppression_threshold = 0.3f;
+  EXPECT_THAT(NonMaxSuppression(boxes, options), ElementsAre(1, 2));
+
+  options.max_num_boxes = 1;
+  EXPECT_THAT(NonMaxSuppression(boxes, options), ElementsAre(1));
+
+  options.max_num_boxes = -1;
+  options.min_score = 0.8f;
+  EXPECT_THAT(NonMaxSuppression(boxes, options), ElementsAre(1));
+}
+
+TEST(NonMaxSuppressionTest, ClassAwareSuppression) {
+  const std::vector<ScoredBox> boxes = {
+      MakeBox(0.1f, 0.1f, 0.2f, 0.2f, 0.9f, /*class_id=*/0),
+      MakeBox(0.1f, 0.1f, 0.2f, 0.2f, 0.8f, /*class_id=*/1),
+      MakeBox(0.1f, 0.1f, 0.2f, 0.2f, 0.7f, /*class_id=*/0),
+  };
+  NonMaxSuppressionOptions options;
+  options.overlap_type = OverlapType::kIntersectionOverUnion;
+  options.min_suppression_threshold = 0.3f;
+  EXPECT_THAT(NonMaxSuppression(boxes, options), ElementsAre(0));
+  options.class_aware = true;
+  EXPECT_THAT(NonMaxSuppression(boxes, options), ElementsAre(0, 1));
+}
+
+TEST(NonMaxSuppressionTest, WeightedClusters) {
+  const std::vector<ScoredBox> boxes = {
+      MakeBox(0.6f, 0.6f, 0.2f, 0.2f, 0.6f),
+      MakeBox(0.1f, 0.1f, 0.2f, 0.2f, 0.5f),
+      MakeBox(0.61f, 0.6f, 0.2f, 0.2f, 0.8f),
+      MakeBox(0.11f, 0.1f, 0.2f, 0.2f, 0.9f),
+      MakeBox(0.1f, 0.12f, 0.2f, 0.2f, 0.7f),
+  };
+  NonMaxSuppressionOptions options;
+  options.overlap_type = OverlapType::kIntersectionOverUnion;
+  options.min_suppression_threshold = 0.3f;
+  const auto clusters = WeightedNonMaxSuppression(boxes, options);
+  ASSERT_EQ(2, clusters.size());
+  EXPECT_EQ(3, clusters[0].top_index);
+  EXPECT_THAT(clusters[0].members, ElementsAre(3, 4, 1));
+  EXPECT_EQ(2, clusters[1].top_index);
+  EXPECT_THAT(clusters[1].members, ElementsAre(2, 0));
+}
+
+TEST(NonMaxSuppressionTest, WeightedStopsAtBoxWithoutArea) {
+  const std::vector<ScoredBox> boxes = {
+      MakeBox(0.1f, 0.1f, 0.f, 0.2f, 0.9f),
+      MakeBox(0.6f, 0.6f, 0.2f, 0.2f, 0.5f),
+  };
+  NonMaxSuppressionOptions options;
+  options.min_suppression_threshold = 0.3f;
+  const auto clusters = WeightedNonMaxSuppression(boxes, options);
+  ASSERT_EQ(1, clusters.size());
+  EXPECT_EQ(0, clusters[0].top_index);
+  EXPECT_THAT(clusters[0].members, IsEmpty());
+}
+
+TEST(NonMaxSuppressionTest, MatchesExhaustiveSearch) {
+  std::vector<ScoredBox> boxes =
+      MakeCrowdedScene(/*num_boxes=*/2000, /*boxes_per_object=*/10, 0);
+  // Large, empty and non-finite boxes are handled outside of the grid.
+  boxes.push_back(MakeBox(0.f, 0.f, 1.f, 1.f, 0.5f));
+  boxes.push_back(MakeBox(0.5f, 0.5f, -0.1f, 0.1f, 0.5f));
+  boxes.push_back(MakeBox(0.2f, 0.2f, std::numeric_limits<float>::infinity(),
+                          0.1f, 0.5f));
+  boxes.push_back(
+      MakeBox(std::numeric_limits<float>::quiet_NaN(), 0.2f, 0.1f, 0.1f, 0.5f));
+  for (OverlapType overlap_type :
+       {OverlapType::kJaccard, OverlapType::kModifiedJaccard,
+        OverlapType::kIntersectionOverUnion}) {
+    for (float threshold : {-0.1f, 0.f, 0.3f, 0.9f}) {
+      for (bool class_aware : {false, true}) {
+        NonMaxSuppressionOptions options;
+        options.overlap_type = overlap_type;
+        options.min_suppression_threshold = threshold;
+        options.class_aware = class_aware;
+        EXPECT_EQ(ExhaustiveNonMaxSuppression(boxes, options),
+                  NonMaxSuppression(boxes, options))
+            << static_cast<int>(overlap_type) << " " << threshold << " "
+            << class_aware;
+      }
+    }
+  }
+}
+
+void BM_NonMaxSuppression(benchmark::State& state) {
+  const std::vector<ScoredBox> boxes =
+      MakeCrowdedScene(state.range(0), /*boxes_per_object=*/10, 0);
+  NonMaxSuppressionOptions options;
+  options.overlap_type = OverlapType::kIntersectionOverUnion;
+  options.min_suppression_threshold = 0.3f;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(NonMaxSuppression(boxes, options));
+  }
+}
+BENCHMARK(BM_NonMaxSuppression)->Arg(100)->Arg(1000)->Arg(10000);
+
+void BM_WeightedNonMaxSuppression(benchmark::State& state) {
+  const std::vector<ScoredBox> boxes =
+      MakeCrowdedScene(state.range(0), /*boxes_per_object=*/10, 0);
+  NonMaxSuppressionOptions options;
+  options.overlap_type = OverlapType::kIntersectionOverUnion;
+  options.min_suppression_threshold = 0.3f;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(WeightedNonMaxSuppression(boxes, options));
+  }
+}
+BENCHMARK(BM_WeightedNonMaxSuppression)->Arg(100)->Arg(1000)->Arg(10000);
+
+}  // namespace
+}  // namespace mediapipe
@@ -61,6 +61,9 @@
 //   int GetMyFeatureSize(sequence)
 //   Repeated<TYPE> GetMyFeatureAt(sequence)
 //
+// VECTOR_{INT64,FLOAT}_FEATURE_LIST additionally define:
+//   FeatureListValues<TYPE> GetAllMyFeature(sequence)
+//
 // To see the exact types, please see the actual definitions, but this list
 // should be sufficient for quick reference.
 //
@@ -247,6 +250,66 @@ inline const proto_ns::RepeatedPtrField<std::string>& GetBytesAt(
   return fl.feature().Get(index).bytes_list().value();
 }
 
+// The values of all the timesteps of a feature list, stored contiguously. The
+// values at timestep i are values[offsets[i]] to values[offsets[i + 1] - 1].
+template <typename T>
+struct FeatureListValues {
+  std::vector<T> values;
+  std::vector<int> offsets = {0};
+
+  // Returns the number of timesteps.
+  int size() const { return offsets.size() - 1; }
+  // Returns the range of the values at the timestep.
+  const T* begin(int index) const { return values.data() + offsets[index]; }
+  const T* end(int index) const { return values.data() + offsets[index + 1]; }
+};
+
+// Copies the values of all the features of a feature list in one pass. The
+// key is looked up once, rather than once per timestep as with GetFloatsAt.
+template <typename T, typename GetValues>
+FeatureListValues<T> GetAllValues(const tensorflow::SequenceExample& sequence,
+                                  const std::string& key,
+                                  GetValues get_values) {
+  FeatureListValues<T> result;
+  const auto it = sequence.feature_lists().feature_list().find(key);
+  if (it == sequence.feature_lists().feature_list().end()) {
+    return result;
+  }
+  const auto& features = it->second.feature();
+  int num_values = 0;
+  for (const tensorflow::Feature& feature : features) {
+    num_values += get_values(feature).size();
+  }
+  result.values.reserve(num_values);
+  result.offsets.reserve(features.size() + 1);
+  for (const tensorflow::Feature& feature : features) {
+    const auto& values = get_values(feature);
+    result.values.insert(result.values.end(), values.begin(), values.end());
+    result.offsets.push_back(result.values.size());
+  }
+  return result;
+}
+
+// Returns the float values of all the timesteps of the feature list indicated
+// by key. Returns no timesteps if the feature list is not present.
+inline FeatureListValues<float> GetAllFloats(
+    const tensorflow::SequenceExample& sequence, const std::string& key) {
+  return GetAllValues<float>(
+      sequence, key, [](const tensorflow::Feature& feature) -> const auto& {
+        return feature.float_list().value();
+      });
+}
+
+// Returns the int64 values of all the timesteps of the feature list indicated
+// by key. Returns no timesteps if the feature list is not present.
+inline FeatureListValues<int64> GetAllInt64s(
+    const tensorflow::SequenceExample& sequence, const std::string& key) {
+  return GetAllValues<int64>(
+      sequence, key, [](const tensorflow::Feature& feature) -> const auto& {
+        return feature.int64_list().value();
+      });
+}
+
 // Adds any iterable (with begin and end) to a FeatureList as a float Feature.
 template <typename TContainer>
 void AddFloatContainer(const std::string& key, const TContainer& float_list,
@@ -1053,6 +1116,11 @@ void AddBytesContainer(const std::string& key, const TContainer& bytes_list,
       int index) {                                                            \
     return GetInt64sAt(sequence, merge_prefix(prefix, key), index);           \
   }                                                                           \
+  inline FeatureListValues<int64> CONCAT_STR2(GetAll, name)(                  \
+      const std::string& prefix,                                              \
+      const tensorflow::SequenceExample& sequence) {                          \
+    return GetAllInt64s(sequence, merge_prefix(prefix, key));                 \
+  }                                                                           \
   inline void CONCAT_STR2(Clear, name)(                                       \
       const std::string& prefix, tensorflow::SequenceExample* sequence) {     \
     sequence->mutable_feature_lists()->mutable_feature_list()->erase(         \
@@ -1088,6 +1156,10 @@ void AddBytesContainer(const std::string& key, const TContainer& bytes_list,
       const tensorflow::SequenceExample& sequence, int index) {               \
     return CONCAT_STR3(Get, name, At)(prefix, sequence, index);               \
   }                                                                           \
+  inline FeatureListValues<int64> CONCAT_STR2(                                \
+      GetAll, name)(const tensorflow::SequenceExample& sequence) {            \
+    return CONCAT_STR2(GetAll, name)(prefix, sequence);                       \
+  }                                                                           \
   inline void CONCAT_STR2(Clear,                                              \
                           name)(tensorflow::SequenceExample * sequence) {     \
     CONCAT_STR2(Clear, name)(prefix, sequence);                               \
@@ -1127,6 +1199,11 @@ void AddBytesContainer(const std::string& key, const TContainer& bytes_list,
       int index) {                                                            \
     return GetFloatsAt(sequence, merge_prefix(prefix, key), index);           \
   }                                                                           \
+  inline FeatureListValues<float> CONCAT_STR2(GetAll, name)(                  \
+      const std::string& prefix,                                              \
+      const tensorflow::SequenceExample& sequence) {                          \
+    return GetAllFloats(sequence, merge_prefix(prefix, key));                 \
+  }                                                                           \
   inline void CONCAT_STR2(Clear, name)(                                       \
       const std::string& prefix, tensorflow::SequenceExample* sequence) {     \
     sequence->mutable_feature_lists()->mutable_feature_list()->erase(         \
@@ -1162,6 +1239,10 @@ void AddBytesContainer(const std::string& key, const TContainer& bytes_list,
       const tensorflow::SequenceExample& sequence, int index) {               \
     return CONCAT_STR3(Get, name, At)(prefix, sequence, index);               \
   }                                                                           \
+  inline FeatureListValues<float> CONCAT_STR2(                                \
+      GetAll, name)(const tensorflow::SequenceExample& sequence) {            \
+    return CONCAT_STR2(GetAll, name)(prefix, sequence);                       \
+  }                                                                           \
   inline void CONCAT_STR2(Clear,                                              \
                           name)(tensorflow::SequenceExample * sequence) {     \
     CONCAT_STR2(Clear, name)(prefix, sequence);                               \
@@ -238,6 +238,25 @@ TEST_F(MediaSequenceUtilTest, GetBytesAt) {
   EXPECT_EQ("Helena Bonham Carter", actors1[2]);
 }
 
+TEST_F(MediaSequenceUtilTest, GetAllFloats) {
+  const auto ratings = GetAllFloats(sequence_example_, "movie_ratings");
+  ASSERT_EQ(2, ratings.size());
+  EXPECT_THAT(ratings.values, testing::ElementsAre(4.5, 5.0, 2.3));
+  EXPECT_THAT(std::vector<float>(ratings.begin(1), ratings.end(1)),
+              testing::ElementsAre(5.0, 2.3));
+  EXPECT_EQ(0, GetAllFloats(sequence_example_, "missing").size());
+}
+
+TEST_F(MediaSequenceUtilTest, GetAllInt64s) {
+  const auto runtimes = GetAllInt64s(sequence_example_, "runtimes");
+  ASSERT_EQ(2, runtimes.size());
+  EXPECT_THAT(runtimes.offsets, testing::ElementsAre(0, 2, 3));
+  EXPECT_THAT(std::vector<int64>(runtimes.begin(0), runtimes.end(0)),
+              testing::ElementsAre(123, 84));
+  EXPECT_THAT(std::vector<int64>(runtimes.begin(1), runtimes.end(1)),
+              testing::ElementsAre(97));
+}
+
 TEST_F(MediaSequenceUtilTest, RoundTripFloatList) {
   tensorflow::SequenceExample sequence_example;
   std::string key = "key";
@@ -618,6 +637,9 @@ TEST_F(MediaSequenceUtilTest, VectorInt64FeatureList) {
               testing::ElementsAreArray(test_value[1]));
   ASSERT_EQ(test_value.size(), GetVectorInt64FeatureListSize(example));
   ASSERT_TRUE(HasVectorInt64FeatureList(example));
+  const auto all_values = GetAllVectorInt64FeatureList(example);
+  ASSERT_EQ(test_value.size(), all_values.size());
+  ASSERT_THAT(all_values.values, testing::ElementsAre(47, 42, 3, 5));
   ClearVectorInt64FeatureList(&example);
   ASSERT_FALSE(HasVectorInt64FeatureList(example));
   ASSERT_EQ(0, GetVectorInt64FeatureListSize(example));
@@ -642,6 +664,9 @@ TEST_F(MediaSequenceUtilTest, VectorFloatFeatureList) {
               testing::ElementsAreArray(test_value[1]));
   ASSERT_EQ(test_value.size(), GetVectorFloatFeatureListSize(example));
   ASSERT_TRUE(HasVectorFloatFeatureList(example));
+  const auto all_values = GetAllVectorFloatFeatureList(example);
+  ASSERT_EQ(test_value.size(), all_values.size());
+  ASSERT_THAT(all_values.values, testing::ElementsAre(47, 42, 3, 5));
   ClearVectorFloatFeatureList(&example);
   ASSERT_FALSE(HasVectorFloatFeatureList(example));
   ASSERT_EQ(0, GetVectorFloatFeatureListSize(example));
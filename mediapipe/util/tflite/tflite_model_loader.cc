@@ -14,38 +14,111 @@
 
 #include "mediapipe/util/tflite/tflite_model_loader.h"
 
+#include <memory>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/port/file_helpers.h"
+#include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/util/resource_util.h"
+#include "mediapipe/util/resource_util_custom.h"
 
 namespace mediapipe {
 
-absl::StatusOr<api2::Packet<TfLiteModelPtr>> TfLiteModelLoader::LoadFromPath(
+namespace {
+
+// A model shared by all the users of a path. The mutex is held while the
+// model is loaded, so that concurrent users of the path load it only once.
+struct CachedModel {
+  absl::Mutex mutex;
+  std::weak_ptr<tflite::FlatBufferModel> model ABSL_GUARDED_BY(mutex);
+};
+
+class ModelCache {
+ public:
+  static ModelCache* GetInstance() {
+    static ModelCache* cache = new ModelCache();
+    return cache;
+  }
+
+  std::shared_ptr<CachedModel> GetEntry(const std::string& path) {
+    absl::MutexLock lock(&mutex_);
+    std::shared_ptr<CachedModel>& entry = entries_[path];
+    if (!entry) {
+      entry = std::make_shared<CachedModel>();
+    }
+    return entry;
+  }
+
+ private:
+  absl::Mutex mutex_;
+  // Entries are never removed, but only hold a weak reference to the model.
+  absl::flat_hash_map<std::string, std::shared_ptr<CachedModel>> entries_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+absl::StatusOr<std::shared_ptr<tflite::FlatBufferModel>> LoadModel(
     const std::string& path) {
-  std::string model_path = path;
+  // A custom resource provider decides what the path refers to, so it must be
+  // asked for the contents even if a file with that path exists.
+  if (!HasCustomGlobalResourceProvider()) {
+    auto status_or_file_path = mediapipe::PathToResourceAsFile(path);
+    if (status_or_file_path.ok() &&
+        file::Exists(status_or_file_path.value()).ok()) {
+      VLOG(2) << "Mapping the model from " << status_or_file_path.value();
+      std::shared_ptr<tflite::FlatBufferModel> model =
+          tflite::FlatBufferModel::VerifyAndBuildFromFile(
+              status_or_file_path.value().c_str());
+      RET_CHECK(model) << "Failed to load model from path " << path;
+      return model;
+    }
+  }
 
-  std::string model_blob;
+  auto model_blob = std::make_shared<std::string>();
   auto status_or_content =
-      mediapipe::GetResourceContents(model_path, &model_blob);
+      mediapipe::GetResourceContents(path, model_blob.get());
   // TODO: get rid of manual resolving with PathToResourceAsFile
   // as soon as it's incorporated into GetResourceContents.
   if (!status_or_content.ok()) {
     ASSIGN_OR_RETURN(auto resolved_path,
-                     mediapipe::PathToResourceAsFile(model_path));
+                     mediapipe::PathToResourceAsFile(path));
     VLOG(2) << "Loading the model from " << resolved_path;
     MP_RETURN_IF_ERROR(
-        mediapipe::GetResourceContents(resolved_path, &model_blob));
+        mediapipe::GetResourceContents(resolved_path, model_blob.get()));
   }
 
   auto model = tflite::FlatBufferModel::VerifyAndBuildFromBuffer(
-      model_blob.data(), model_blob.size());
-  RET_CHECK(model) << "Failed to load model from path " << model_path;
-  return api2::MakePacket<TfLiteModelPtr>(
-      model.release(),
-      [model_blob = std::move(model_blob)](tflite::FlatBufferModel* model) {
+      model_blob->data(), model_blob->size());
+  RET_CHECK(model) << "Failed to load model from path " << path;
+  return std::shared_ptr<tflite::FlatBufferModel>(
+      model.release(), [model_blob](tflite::FlatBufferModel* model) {
         // It's required that model_blob is deleted only after
         // model is deleted, hence capturing model_blob.
         delete model;
       });
 }
 
+}  // namespace
+
+absl::StatusOr<api2::Packet<TfLiteModelPtr>> TfLiteModelLoader::LoadFromPath(
+    const std::string& path) {
+  std::shared_ptr<CachedModel> entry =
+      ModelCache::GetInstance()->GetEntry(path);
+  std::shared_ptr<tflite::FlatBufferModel> model;
+  {
+    absl::MutexLock lock(&entry->mutex);
+    model = entry->model.lock();
+    if (!model) {
+      ASSIGN_OR_RETURN(model, LoadModel(path));
+      entry->model = model;
+    }
+  }
+  return api2::MakePacket<TfLiteModelPtr>(
+      model.get(), [model](tflite::FlatBufferModel*) {
+        // The model is deleted with its last TfLiteModelPtr.
+      });
+}
+
 }  // namespace mediapipe
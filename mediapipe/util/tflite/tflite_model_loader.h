@@ -30,6 +30,13 @@ class TfLiteModelLoader {
  public:
   // Returns a Packet containing a TfLiteModelPtr, pointing to a model loaded
   // from the specified file path.
+  //
+  // Models are cached for the whole process, keyed by path: while a model
+  // loaded from a path is in use, loading the same path again returns a
+  // TfLiteModelPtr to the same tflite::FlatBufferModel, which can be shared
+  // by interpreters in any number of calculators and graphs. When the
+  // resource is a plain file, it is memory-mapped read-only rather than
+  // copied, so the model data is shared with the page cache.
   static absl::StatusOr<api2::Packet<TfLiteModelPtr>> LoadFromPath(
       const std::string& path);
 };
@@ -0,0 +1,114 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/tflite/tflite_model_loader.h"
+
+#include <unistd.h>
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/util/resource_util.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr char kModelPath[] =
+    "mediapipe/modules/face_landmark/face_landmark.tflite";
+
+// Returns the resident set size of the process, or 0 if it is unknown.
+int64 ResidentSetBytes() {
+  std::ifstream statm("/proc/self/statm");
+  int64 total_pages = 0, resident_pages = 0;
+  if (!(statm >> total_pages >> resident_pages)) {
+    return 0;
+  }
+  return resident_pages * sysconf(_SC_PAGESIZE);
+}
+
+TEST(TfLiteModelLoaderTest, SharesModelsLoadedFromTheSamePath) {
+  auto status_or_model1 = TfLiteModelLoader::LoadFromPath(kModelPath);
+  MP_ASSERT_OK(status_or_model1);
+  auto status_or_model2 = TfLiteModelLoader::LoadFromPath(kModelPath);
+  MP_ASSERT_OK(status_or_model2);
+  const TfLiteModelPtr& model1 = status_or_model1.value().Get();
+  const TfLiteModelPtr& model2 = status_or_model2.value().Get();
+  ASSERT_NE(model1, nullptr);
+  EXPECT_EQ(model1.get(), model2.get());
+  EXPECT_GT(model1->GetModel()->subgraphs()->size(), 0);
+}
+
+TEST(TfLiteModelLoaderTest, ReloadsModelAfterAllUsersAreGone) {
+  {
+    auto status_or_model = TfLiteModelLoader::LoadFromPath(kModelPath);
+    MP_ASSERT_OK(status_or_model);
+  }
+  auto status_or_model = TfLiteModelLoader::LoadFromPath(kModelPath);
+  MP_ASSERT_OK(status_or_model);
+  ASSERT_NE(status_or_model.value().Get(), nullptr);
+  EXPECT_GT(status_or_model.value().Get()->GetModel()->subgraphs()->size(), 0);
+}
+
+TEST(TfLiteModelLoaderTest, FailsOnMissingModel) {
+  EXPECT_FALSE(
+      TfLiteModelLoader::LoadFromPath("mediapipe/does_not_exist.tflite").ok());
+}
+
+// Loads the model once for each of range(0) graph instances, as
+// TfLiteModelLoader does, and reports the memory held by the instances.
+void BM_LoadSharedModel(benchmark::State& state) {
+  int64 rss_bytes = 0;
+  for (auto _ : state) {
+    const int64 rss_before = ResidentSetBytes();
+    std::vector<api2::Packet<TfLiteModelPtr>> models;
+    for (int i = 0; i < state.range(0); ++i) {
+      auto status_or_model = TfLiteModelLoader::LoadFromPath(kModelPath);
+      CHECK(status_or_model.ok());
+      models.push_back(std::move(status_or_model).value());
+    }
+    rss_bytes = ResidentSetBytes() - rss_before;
+  }
+  state.counters["rss_bytes"] = rss_bytes;
+}
+BENCHMARK(BM_LoadSharedModel)->Arg(1)->Arg(8)->Arg(40);
+
+// Copies the model into every one of range(0) graph instances, as reading it
+// with LocalFileContentsCalculator does.
+void BM_LoadModelCopies(benchmark::State& state) {
+  int64 rss_bytes = 0;
+  for (auto _ : state) {
+    const int64 rss_before = ResidentSetBytes();
+    std::vector<std::string> blobs(state.range(0));
+    std::vector<std::unique_ptr<tflite::FlatBufferModel>> models;
+    for (std::string& blob : blobs) {
+      CHECK(GetResourceContents(kModelPath, &blob).ok());
+      models.push_back(tflite::FlatBufferModel::VerifyAndBuildFromBuffer(
+          blob.data(), blob.size()));
+      CHECK(models.back());
+    }
+    rss_bytes = ResidentSetBytes() - rss_before;
+  }
+  state.counters["rss_bytes"] = rss_bytes;
+}
+BENCHMARK(BM_LoadModelCopies)->Arg(1)->Arg(8)->Arg(40);
+
+}  // namespace
+}  // namespace mediapipe
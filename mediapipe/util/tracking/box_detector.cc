@@ -261,8 +261,6 @@ void BoxDetectorInterface::DetectAndAddBox(
     return;
   }
 
-  const auto &image_query_settings = options_.image_query_settings();
-
   cv::Mat grayscale;
   if (image.channels() == 3) {
     cv::cvtColor(image, grayscale, cv::COLOR_BGR2GRAY);
@@ -272,6 +270,39 @@ void BoxDetectorInterface::DetectAndAddBox(
     grayscale = image;
   }
 
+  DetectAndAddBoxFromGrayscale(grayscale, tracked_boxes, timestamp_msec,
+                               detected_boxes);
+}
+
+void BoxDetectorInterface::DetectAndAddBox(
+    const TrackingFrame &tracking_frame, const TimedBoxProtoList &tracked_boxes,
+    int64 timestamp_msec, TimedBoxProtoList *detected_boxes) {
+  if (!CheckDetectAndAddBox(tracked_boxes)) {
+    return;
+  }
+
+  // Each pyramid level halves the resolution, which avoids most of the
+  // downscaling for large frames.
+  const float longer_edge_scaled =
+      options_.image_query_settings().pyramid_bottom_size();
+  int level = 0;
+  while (level < tracking_frame.pyramid_levels) {
+    const cv::Mat &next_level = tracking_frame.PyramidImage(level + 1);
+    if (std::max(next_level.cols, next_level.rows) < longer_edge_scaled) {
+      break;
+    }
+    ++level;
+  }
+
+  DetectAndAddBoxFromGrayscale(tracking_frame.PyramidImage(level),
+                               tracked_boxes, timestamp_msec, detected_boxes);
+}
+
+void BoxDetectorInterface::DetectAndAddBoxFromGrayscale(
+    const cv::Mat &grayscale, const TimedBoxProtoList &tracked_boxes,
+    int64 timestamp_msec, TimedBoxProtoList *detected_boxes) {
+  const auto &image_query_settings = options_.image_query_settings();
+
   cv::Mat resize_image;
   const int longer_edge = std::max(grayscale.cols, grayscale.rows);
   const float longer_edge_scaled = image_query_settings.pyramid_bottom_size();
@@ -23,6 +23,7 @@
 #include "mediapipe/util/tracking/box_tracker.pb.h"
 #include "mediapipe/util/tracking/flow_packager.pb.h"
 #include "mediapipe/util/tracking/tracking.h"
+#include "mediapipe/util/tracking/tracking_frame.h"
 
 namespace mediapipe {
 
@@ -79,6 +80,13 @@ class BoxDetectorInterface {
                        const TimedBoxProtoList &tracked_boxes,
                        int64 timestamp_msec, TimedBoxProtoList *detected_boxes);
 
+  // Same as above, but extracts features from a precomputed TrackingFrame,
+  // skipping the grayscale conversion. Features are extracted from the
+  // smallest pyramid level that is not smaller than pyramid_bottom_size.
+  void DetectAndAddBox(const TrackingFrame &tracking_frame,
+                       const TimedBoxProtoList &tracked_boxes,
+                       int64 timestamp_msec, TimedBoxProtoList *detected_boxes);
+
   // Stops detection of box with `box_id`.
   void CancelBoxDetection(int box_id);
 
@@ -114,6 +122,13 @@ class BoxDetectorInterface {
   // Check if add / detect action will be called based on input `tracked_boxes`.
   bool CheckDetectAndAddBox(const TimedBoxProtoList &tracked_boxes);
 
+  // Extracts ORB features from `grayscale`, downscaled to pyramid_bottom_size,
+  // and calls DetectAndAddBoxFromFeatures.
+  void DetectAndAddBoxFromGrayscale(const cv::Mat &grayscale,
+                                    const TimedBoxProtoList &tracked_boxes,
+                                    int64 timestamp_msec,
+                                    TimedBoxProtoList *detected_boxes);
+
   // Returns feature indices that are within the given box. If the box size
   // isn't big enough to cover sufficient features to reacquire the box, this
   // function will try to iteratively enlarge the box size by roughly 5
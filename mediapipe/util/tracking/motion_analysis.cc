@@ -360,6 +360,29 @@ bool MotionAnalysis::AddFrameGeneric(
     const RegionFlowFeatureList* external_features,
     std::function<void(RegionFlowFeatureList*)>* modify_features,
     RegionFlowFeatureList* output_feature_list) {
+  return AddFrameImpl(frame, nullptr, timestamp_usec, initial_transform,
+                      rejection_transform, external_features, modify_features,
+                      output_feature_list);
+}
+
+bool MotionAnalysis::AddTrackingFrame(const TrackingFrame& tracking_frame,
+                                      const cv::Mat& frame,
+                                      int64 timestamp_usec,
+                                      RegionFlowFeatureList* feature_list) {
+  return AddFrameImpl(frame, &tracking_frame, timestamp_usec, Homography(),
+                      nullptr,  // rejection_transform
+                      nullptr,  // external features
+                      nullptr,  // feature modification function
+                      feature_list);
+}
+
+bool MotionAnalysis::AddFrameImpl(
+    const cv::Mat& frame, const TrackingFrame* tracking_frame,
+    int64 timestamp_usec, const Homography& initial_transform,
+    const Homography* rejection_transform,
+    const RegionFlowFeatureList* external_features,
+    std::function<void(RegionFlowFeatureList*)>* modify_features,
+    RegionFlowFeatureList* output_feature_list) {
   // Don't check input sizes here, RegionFlowComputation does that based
   // on its internal options.
   CHECK(feature_computation_) << "Calls to AddFrame* can NOT be mixed "
@@ -368,8 +391,13 @@ bool MotionAnalysis::AddFrameGeneric(
   // Compute RegionFlow.
   {
     MEASURE_TIME << "CALL RegionFlowComputation::AddImage";
-    if (!region_flow_computation_->AddImageWithSeed(frame, timestamp_usec,
-                                                    initial_transform)) {
+    const bool success =
+        tracking_frame != nullptr
+            ? region_flow_computation_->AddTrackingFrame(
+                  *tracking_frame, timestamp_usec, initial_transform)
+            : region_flow_computation_->AddImageWithSeed(
+                  frame, timestamp_usec, initial_transform);
+    if (!success) {
       LOG(ERROR) << "Error while computing region flow.";
       return false;
     }
@@ -69,6 +69,7 @@
 #include "mediapipe/util/tracking/region_flow.pb.h"
 #include "mediapipe/util/tracking/region_flow_computation.h"
 #include "mediapipe/util/tracking/streaming_buffer.h"
+#include "mediapipe/util/tracking/tracking_frame.h"
 
 namespace mediapipe {
 
@@ -113,6 +114,14 @@ class MotionAnalysis {
       std::function<void(RegionFlowFeatureList*)>* modify_features = nullptr,
       RegionFlowFeatureList* feature_list = nullptr);
 
+  // Same as AddFrame, but tracks the precomputed tracking_frame of frame
+  // (see tracking_frame.h) instead of converting frame to grayscale and
+  // building its pyramid. Frame is only used for feature descriptors, if
+  // those are required by the options.
+  bool AddTrackingFrame(const TrackingFrame& tracking_frame,
+                        const cv::Mat& frame, int64 timestamp_usec,
+                        RegionFlowFeatureList* feature_list = nullptr);
+
   // Instead of tracking passed frames, uses result directly as supplied by
   // features. Can not be mixed with above AddFrame* calls.
   void AddFeatures(const RegionFlowFeatureList& features);
@@ -176,9 +185,21 @@ class MotionAnalysis {
   // Number of frames/features added so far.
   int NumFrames() const { return frame_num_; }
 
+  // Options in effect, i.e. with the settings of the analysis policy applied.
+  const MotionAnalysisOptions& options() const { return options_; }
+
  private:
   void InitPolicyOptions();
 
+  // Implements AddFrameGeneric. Tracks tracking_frame instead of frame if set.
+  bool AddFrameImpl(
+      const cv::Mat& frame, const TrackingFrame* tracking_frame,
+      int64 timestamp_usec, const Homography& initial_transform,
+      const Homography* rejection_transform,
+      const RegionFlowFeatureList* external_features,
+      std::function<void(RegionFlowFeatureList*)>* modify_features,
+      RegionFlowFeatureList* output_feature_list);
+
   // Compute saliency from buffered features and motions.
   void ComputeSaliency();
 
@@ -0,0 +1,219 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/tracking/parallel_motion_analysis.h"
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/util/tracking/measure_time.h"
+#include "mediapipe/util/tracking/motion_analysis.h"
+
+namespace mediapipe {
+
+namespace {
+
+// Rounds value up to a multiple of base.
+int RoundUpToMultiple(int value, int base) {
+  return (value + base - 1) / base * base;
+}
+
+}  // namespace
+
+ParallelMotionAnalysis::ParallelMotionAnalysis(
+    const MotionAnalysisOptions& options, int frame_width, int frame_height)
+    : options_(options),
+      frame_width_(frame_width),
+      frame_height_(frame_height) {
+  CHECK(!options_.compute_motion_saliency())
+      << "Motion saliency is not supported for chunked analysis.";
+
+  // Chunks are aligned to the estimation clips, whose size depends on the
+  // analysis policy.
+  const int clip_size = std::max(
+      1, MotionAnalysis(options_, frame_width_, frame_height_)
+             .options()
+             .estimation_clip_size());
+  const auto& chunk_options = options_.chunk_options();
+  chunk_size_ =
+      RoundUpToMultiple(std::max(1, chunk_options.chunk_size()), clip_size);
+  chunk_overlap_ =
+      RoundUpToMultiple(std::max(0, chunk_options.chunk_overlap()), clip_size);
+  num_threads_ = std::max(1, chunk_options.num_threads());
+
+  current_chunk_.reset(new Chunk());
+  workers_.reset(new ThreadPool("ParallelMotionAnalysis", num_threads_));
+  workers_->StartWorkers();
+}
+
+ParallelMotionAnalysis::~ParallelMotionAnalysis() {
+  // Runs all scheduled chunks before joining the workers.
+  workers_.reset();
+}
+
+void ParallelMotionAnalysis::AddFrame(const cv::Mat& frame,
+                                      int64 timestamp_usec) {
+  current_chunk_->frames.push_back(frame.clone());
+  current_chunk_->timestamps.push_back(timestamp_usec);
+  ++frame_num_;
+
+  if (current_chunk_->frames.size() ==
+      current_chunk_->num_overlap_frames + chunk_size_) {
+    ScheduleCurrentChunk();
+  }
+}
+
+void ParallelMotionAnalysis::ScheduleCurrentChunk() {
+  // Begin the next chunk with the overlap. Frames are not modified, so they
+  // can be shared between chunks.
+  std::unique_ptr<Chunk> next_chunk(new Chunk());
+  const int num_frames = current_chunk_->frames.size();
+  next_chunk->num_overlap_frames = std::min(chunk_overlap_, num_frames);
+  next_chunk->frames.assign(
+      current_chunk_->frames.end() - next_chunk->num_overlap_frames,
+      current_chunk_->frames.end());
+  next_chunk->timestamps.assign(
+      current_chunk_->timestamps.end() - next_chunk->num_overlap_frames,
+      current_chunk_->timestamps.end());
+
+  Chunk* chunk = current_chunk_.get();
+  {
+    absl::MutexLock lock(&mutex_);
+    mutex_.Await(
+        absl::Condition(this, &ParallelMotionAnalysis::CanScheduleChunk));
+    chunks_.push_back(std::move(current_chunk_));
+    ++num_running_chunks_;
+  }
+  current_chunk_ = std::move(next_chunk);
+
+  workers_->Schedule([this, chunk]() {
+    absl::Status status = AnalyzeChunk(chunk);
+    // Frames that are still shared with the next chunk stay alive there.
+    chunk->frames.clear();
+    absl::MutexLock lock(&mutex_);
+    chunk->status = std::move(status);
+    chunk->done = true;
+    --num_running_chunks_;
+  });
+}
+
+absl::Status ParallelMotionAnalysis::AnalyzeChunk(Chunk* chunk) const {
+  MEASURE_TIME << "ParallelMotionAnalysis::AnalyzeChunk";
+  MotionAnalysis motion_analysis(options_, frame_width_, frame_height_);
+  std::vector<std::unique_ptr<RegionFlowFeatureList>> features;
+  std::vector<std::unique_ptr<CameraMotion>> camera_motions;
+  const int num_frames = chunk->frames.size();
+  for (int k = 0; k < num_frames; ++k) {
+    if (!motion_analysis.AddFrame(chunk->frames[k], chunk->timestamps[k])) {
+      return absl::InternalError(absl::StrCat(
+          "Error while analyzing frame at ", chunk->timestamps[k]));
+    }
+    motion_analysis.GetResults(k + 1 == num_frames, &features,
+                               &camera_motions);
+  }
+  if (features.size() != chunk->frames.size() ||
+      camera_motions.size() != chunk->frames.size()) {
+    return absl::InternalError(absl::StrCat(
+        "Expected results for ", num_frames, " frames, got ", features.size(),
+        " features and ", camera_motions.size(), " camera motions."));
+  }
+
+  chunk->features.assign(
+      std::make_move_iterator(features.begin() + chunk->num_overlap_frames),
+      std::make_move_iterator(features.end()));
+  chunk->camera_motions.assign(
+      std::make_move_iterator(camera_motions.begin() +
+                              chunk->num_overlap_frames),
+      std::make_move_iterator(camera_motions.end()));
+  return absl::OkStatus();
+}
+
+void ParallelMotionAnalysis::RemapTrackIds(Chunk* chunk) {
+  absl::flat_hash_map<int, int> track_ids;
+  auto remap = [this, &track_ids](int track_id) {
+    auto it = track_ids.find(track_id);
+    if (it == track_ids.end()) {
+      it = track_ids.emplace(track_id, next_track_id_++).first;
+    }
+    return it->second;
+  };
+
+  for (auto& feature_list : chunk->features) {
+    for (auto& feature : *feature_list->mutable_feature()) {
+      if (feature.track_id() >= 0) {
+        feature.set_track_id(remap(feature.track_id()));
+      }
+    }
+    for (int& track_id :
+         *feature_list->mutable_actively_discarded_tracked_ids()) {
+      track_id = remap(track_id);
+    }
+  }
+}
+
+absl::StatusOr<int> ParallelMotionAnalysis::GetResults(
+    bool flush, std::vector<std::unique_ptr<RegionFlowFeatureList>>* features,
+    std::vector<std::unique_ptr<CameraMotion>>* camera_motion) {
+  if (flush && current_chunk_->frames.size() >
+                   current_chunk_->num_overlap_frames) {
+    ScheduleCurrentChunk();
+  }
+
+  std::deque<std::unique_ptr<Chunk>> done_chunks;
+  {
+    absl::MutexLock lock(&mutex_);
+    if (flush) {
+      mutex_.Await(
+          absl::Condition(this, &ParallelMotionAnalysis::AllChunksDone));
+    }
+    while (!chunks_.empty() && chunks_.front()->done) {
+      if (!chunks_.front()->status.ok()) {
+        return chunks_.front()->status;
+      }
+      done_chunks.push_back(std::move(chunks_.front()));
+      chunks_.pop_front();
+    }
+  }
+
+  int num_output_frames = 0;
+  for (auto& chunk : done_chunks) {
+    RemapTrackIds(chunk.get());
+    num_output_frames += chunk->features.size();
+    if (features != nullptr) {
+      std::move(chunk->features.begin(), chunk->features.end(),
+                std::back_inserter(*features));
+    }
+    if (camera_motion != nullptr) {
+      std::move(chunk->camera_motions.begin(), chunk->camera_motions.end(),
+                std::back_inserter(*camera_motion));
+    }
+  }
+  return num_output_frames;
+}
+
+bool ParallelMotionAnalysis::CanScheduleChunk() const {
+  return num_running_chunks_ < num_threads_;
+}
+
+bool ParallelMotionAnalysis::AllChunksDone() const {
+  return num_running_chunks_ == 0;
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,141 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Computes region flow and camera motions for offline video analysis by
+// splitting the video into temporal chunks, which are analyzed concurrently by
+// independent MotionAnalysis instances (each running its own
+// RegionFlowComputation and MotionEstimation::EstimateMotionsParallel).
+//
+// Each chunk additionally tracks the last chunk_overlap frames of the previous
+// chunk, whose results are discarded, so that feature tracks are established
+// at the chunk boundary. Chunk boundaries are aligned to the estimation clips
+// of MotionAnalysis, so camera motions are estimated over the same clips as
+// when the whole video is analyzed serially; they match the serial results
+// up to the differences of feature tracking right after a boundary.
+// Track ids are made unique across chunks. Tracks do not continue across a
+// chunk boundary though: a feature tracked across it ends with the last frame
+// of one chunk and continues under a new track id in the next chunk.
+//
+// Usage example:
+//
+// ParallelMotionAnalysis motion_analysis(options, 960, 540);
+// for (int k = 0; k < N; ++k) {
+//   motion_analysis.AddFrame(input_frames[k], timestamps[k]);
+//   // Outputs results of finished chunks, if any.
+//   ASSIGN_OR_RETURN(int num_frames, motion_analysis.GetResults(
+//                        k + 1 == N, &features, &camera_motions));
+// }
+
+#ifndef MEDIAPIPE_UTIL_TRACKING_PARALLEL_MOTION_ANALYSIS_H_
+#define MEDIAPIPE_UTIL_TRACKING_PARALLEL_MOTION_ANALYSIS_H_
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/opencv_core_inc.h"
+#include "mediapipe/framework/port/threadpool.h"
+#include "mediapipe/util/tracking/camera_motion.pb.h"
+#include "mediapipe/util/tracking/motion_analysis.pb.h"
+#include "mediapipe/util/tracking/region_flow.pb.h"
+
+namespace mediapipe {
+
+class ParallelMotionAnalysis {
+ public:
+  // Motion saliency is not supported, as it is smoothed across chunks. It can
+  // be computed from the results via MotionAnalysis::EnqueueFeaturesAndMotions.
+  ParallelMotionAnalysis(const MotionAnalysisOptions& options, int frame_width,
+                         int frame_height);
+  // Waits for all scheduled chunks.
+  ~ParallelMotionAnalysis();
+  ParallelMotionAnalysis(const ParallelMotionAnalysis&) = delete;
+  ParallelMotionAnalysis& operator=(const ParallelMotionAnalysis&) = delete;
+
+  // Call with every frame, in order. The frame is copied. Blocks while
+  // chunk_options().num_threads() chunks are being analyzed.
+  void AddFrame(const cv::Mat& frame, int64 timestamp_usec);
+
+  // Returns the results of the analyzed chunks in frame order (features and
+  // camera motions, both optional), and the number of returned frames.
+  // Set flush to true to analyze the remaining frames and wait for all of
+  // them, e.g. when the end of the video is reached.
+  // Returns an error if a frame of a finished chunk could not be analyzed.
+  absl::StatusOr<int> GetResults(
+      bool flush,
+      std::vector<std::unique_ptr<RegionFlowFeatureList>>* features = nullptr,
+      std::vector<std::unique_ptr<CameraMotion>>* camera_motion = nullptr);
+
+  // Number of frames added so far.
+  int NumFrames() const { return frame_num_; }
+
+ private:
+  struct Chunk {
+    // Frames to track, starting with the overlap of the previous chunk.
+    std::vector<cv::Mat> frames;
+    std::vector<int64> timestamps;
+    // Number of leading frames whose results are discarded.
+    int num_overlap_frames = 0;
+    // Results of the frames after the overlap, set once done.
+    std::vector<std::unique_ptr<RegionFlowFeatureList>> features;
+    std::vector<std::unique_ptr<CameraMotion>> camera_motions;
+    // Error while analyzing the chunk, if any.
+    absl::Status status;
+    bool done = false;
+  };
+
+  // Schedules the analysis of current_chunk_ and begins the next chunk with
+  // its last frames.
+  void ScheduleCurrentChunk();
+
+  // Runs MotionAnalysis over the frames of the chunk.
+  absl::Status AnalyzeChunk(Chunk* chunk) const;
+
+  // Replaces the chunk's track ids by ids that are unique across chunks.
+  void RemapTrackIds(Chunk* chunk);
+
+  bool CanScheduleChunk() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  bool AllChunksDone() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  MotionAnalysisOptions options_;
+  int frame_width_ = 0;
+  int frame_height_ = 0;
+  int frame_num_ = 0;
+
+  int chunk_size_ = 0;
+  int chunk_overlap_ = 0;
+  int num_threads_ = 0;
+
+  // Chunk receiving the added frames.
+  std::unique_ptr<Chunk> current_chunk_;
+
+  absl::Mutex mutex_;
+  // Scheduled chunks, in frame order. Chunks are removed once their results
+  // are returned by GetResults.
+  std::deque<std::unique_ptr<Chunk>> chunks_ ABSL_GUARDED_BY(mutex_);
+  int num_running_chunks_ ABSL_GUARDED_BY(mutex_) = 0;
+
+  // Next unused track id.
+  int next_track_id_ = 0;
+
+  std::unique_ptr<ThreadPool> workers_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_TRACKING_PARALLEL_MOTION_ANALYSIS_H_
@@ -0,0 +1,157 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/tracking/parallel_motion_analysis.h"
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "mediapipe/framework/deps/file_path.h"
+#include "mediapipe/framework/port/file_helpers.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/opencv_core_inc.h"
+#include "mediapipe/framework/port/opencv_highgui_inc.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/util/tracking/motion_analysis.h"
+
+namespace mediapipe {
+namespace {
+
+using ::testing::HasSubstr;
+
+constexpr int kNumFrames = 40;
+
+class ParallelMotionAnalysisTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::string png_data;
+    MEDIAPIPE_CHECK_OK(file::GetContents(
+        file::JoinPath("./", "/mediapipe/util/tracking/testdata/",
+                       "stabilize_test.png"),
+        &png_data));
+    std::vector<char> buffer(png_data.begin(), png_data.end());
+    const cv::Mat original_frame = cv::imdecode(cv::Mat(buffer), 1);
+    ASSERT_FALSE(original_frame.empty());
+
+    // Creates a movie by displacing the image to random positions.
+    constexpr int kBorder = 40;
+    const int frame_width = original_frame.cols - 2 * kBorder;
+    const int frame_height = original_frame.rows - 2 * kBorder;
+    std::mt19937_64 random(900913);
+    std::uniform_int_distribution<> uniform_dist(-5, 5);
+    int x = kBorder;
+    int y = kBorder;
+    for (int f = 0; f < kNumFrames; ++f) {
+      x = std::min(2 * kBorder, std::max(0, x + uniform_dist(random)));
+      y = std::min(2 * kBorder, std::max(0, y + uniform_dist(random)));
+      movie_.push_back(original_frame(cv::Rect(x, y, frame_width, frame_height))
+                           .clone());
+    }
+
+    options_.set_estimation_clip_size(8);
+    auto* chunk_options = options_.mutable_chunk_options();
+    chunk_options->set_chunk_size(16);
+    chunk_options->set_chunk_overlap(8);
+    chunk_options->set_num_threads(2);
+  }
+
+  MotionAnalysisOptions options_;
+  std::vector<cv::Mat> movie_;
+};
+
+TEST_F(ParallelMotionAnalysisTest, MatchesSerialAnalysis) {
+  const int width = movie_[0].cols;
+  const int height = movie_[0].rows;
+
+  MotionAnalysis serial_analysis(options_, width, height);
+  std::vector<std::unique_ptr<CameraMotion>> serial_motions;
+  ParallelMotionAnalysis parallel_analysis(options_, width, height);
+  std::vector<std::unique_ptr<RegionFlowFeatureList>> features;
+  std::vector<std::unique_ptr<CameraMotion>> motions;
+  for (int f = 0; f < kNumFrames; ++f) {
+    const bool flush = f + 1 == kNumFrames;
+    ASSERT_TRUE(serial_analysis.AddFrame(movie_[f], f * 1000));
+    serial_analysis.GetResults(flush, nullptr, &serial_motions);
+    parallel_analysis.AddFrame(movie_[f], f * 1000);
+    MP_ASSERT_OK(parallel_analysis.GetResults(flush, &features, &motions));
+  }
+
+  ASSERT_EQ(kNumFrames, serial_motions.size());
+  ASSERT_EQ(kNumFrames, motions.size());
+  ASSERT_EQ(kNumFrames, features.size());
+  for (int f = 0; f < kNumFrames; ++f) {
+    EXPECT_EQ(f * 1000, features[f]->timestamp_usec());
+    EXPECT_NEAR(serial_motions[f]->translation().dx(),
+                motions[f]->translation().dx(), 0.5f)
+        << "Frame " << f;
+    EXPECT_NEAR(serial_motions[f]->translation().dy(),
+                motions[f]->translation().dy(), 0.5f)
+        << "Frame " << f;
+  }
+}
+
+TEST_F(ParallelMotionAnalysisTest, TrackIdsAreUniqueAcrossChunks) {
+  options_.mutable_flow_options()
+      ->mutable_tracking_options()
+      ->set_tracking_policy(TrackingOptions::POLICY_LONG_TRACKS);
+  ParallelMotionAnalysis parallel_analysis(options_, movie_[0].cols,
+                                           movie_[0].rows);
+  for (int f = 0; f < kNumFrames; ++f) {
+    parallel_analysis.AddFrame(movie_[f], f * 1000);
+  }
+  std::vector<std::unique_ptr<RegionFlowFeatureList>> features;
+  auto num_frames = parallel_analysis.GetResults(true, &features);
+  MP_ASSERT_OK(num_frames);
+  ASSERT_EQ(kNumFrames, *num_frames);
+
+  // Each track covers consecutive frames, i.e. ids are not reused by a later
+  // chunk.
+  absl::flat_hash_map<int, int> last_frame_of_track;
+  for (int f = 0; f < kNumFrames; ++f) {
+    for (const auto& feature : features[f]->feature()) {
+      if (feature.track_id() < 0) {
+        continue;
+      }
+      auto it = last_frame_of_track.find(feature.track_id());
+      if (it != last_frame_of_track.end()) {
+        EXPECT_EQ(f - 1, it->second) << "Track " << feature.track_id();
+      }
+      last_frame_of_track[feature.track_id()] = f;
+    }
+  }
+  EXPECT_FALSE(last_frame_of_track.empty());
+}
+
+TEST_F(ParallelMotionAnalysisTest, ReturnsErrorOfFailedFrame) {
+  ParallelMotionAnalysis parallel_analysis(options_, movie_[0].cols,
+                                           movie_[0].rows);
+  // A frame of the wrong size can not be tracked.
+  const cv::Mat small_frame = movie_[0](cv::Rect(0, 0, 16, 16)).clone();
+  for (int f = 0; f < kNumFrames; ++f) {
+    parallel_analysis.AddFrame(f == 20 ? small_frame : movie_[f], f * 1000);
+  }
+  std::vector<std::unique_ptr<RegionFlowFeatureList>> features;
+  auto num_frames = parallel_analysis.GetResults(true, &features);
+  EXPECT_FALSE(num_frames.ok());
+  EXPECT_THAT(num_frames.status().message(), HasSubstr("20000"));
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -298,6 +298,9 @@ struct RegionFlowComputation::FrameTrackingData {
   // has not been computed yet.
   int pyramid_levels = 0;
 
+  // Set if pyramid references the (read-only) pyramid of a TrackingFrame.
+  bool pyramid_shared = false;
+
   // Features extracted in this frame or tracked from a source frame.
   std::vector<cv::Point2f> features;
 
@@ -392,6 +395,7 @@ struct RegionFlowComputation::FrameTrackingData {
 
   void BuildPyramid(int levels, int window_size, bool with_derivative) {
     if (use_cv_tracking) {
+      CHECK(!pyramid_shared);
 #if CV_MAJOR_VERSION >= 3
       // No-op if not called for opencv 3.0 (c interface computes
       // pyramids in place).
@@ -410,6 +414,15 @@ struct RegionFlowComputation::FrameTrackingData {
     frame_num = frame_num_;
     timestamp_usec = timestamp_;
     pyramid_levels = 0;
+    if (pyramid_shared) {
+      // Release the shared pyramid and the extraction levels that might
+      // reference it, so that they are not overwritten in place.
+      pyramid.clear();
+      for (int i = 1; i < extraction_pyramid.size(); ++i) {
+        extraction_pyramid[i] = cv::Mat(extraction_pyramid[i].size(), CV_8UC1);
+      }
+      pyramid_shared = false;
+    }
     ResetFeatures();
     neighborhoods.reset();
     orb.Reset();
@@ -843,6 +856,13 @@ bool RegionFlowComputation::AddImageWithSeed(
   return AddImageAndTrack(source, cv::Mat(), timestamp_usec, initial_transform);
 }
 
+bool RegionFlowComputation::AddTrackingFrame(
+    const TrackingFrame& tracking_frame, int64 timestamp_usec,
+    const Homography& initial_transform) {
+  return AddImageAndTrack(tracking_frame.grayscale, cv::Mat(), timestamp_usec,
+                          initial_transform, &tracking_frame);
+}
+
 bool RegionFlowComputation::AddImageWithMask(const cv::Mat& source,
                                              const cv::Mat& source_mask,
                                              int64 timestamp_usec) {
@@ -1032,44 +1052,98 @@ bool RegionFlowComputation::InitFrame(const cv::Mat& source,
   return true;
 }
 
+bool RegionFlowComputation::InitFrameFromTrackingFrame(
+    const TrackingFrame& tracking_frame, FrameTrackingData* data) {
+  const cv::Mat& source = tracking_frame.grayscale;
+  if (source.empty() || source.type() != CV_8UC1) {
+    LOG(ERROR) << "Expecting CV_8UC1 grayscale tracking frame.";
+    return false;
+  }
+
+  // Copies into the preallocated frame, which is modified in place below.
+  cv::Mat& dest_frame = data->frame;
+  const bool resized =
+      source.cols != frame_width_ || source.rows != frame_height_;
+  if (resized) {
+    cv::resize(source, dest_frame, dest_frame.size(), 0, 0, CV_INTER_AREA);
+  } else {
+    source.copyTo(dest_frame);
+  }
+
+  const auto& visual_options = options_.visual_consistency_options();
+  if (visual_options.compute_consistency()) {
+    const int dimension = visual_options.tiny_image_dimension();
+    data->tiny_image.create(dimension, dimension, CV_8UC1);
+    cv::resize(dest_frame, data->tiny_image, data->tiny_image.size(), 0, 0,
+               CV_INTER_AREA);
+  }
+
+  if (options_.histogram_equalization()) {
+    cv::equalizeHist(dest_frame, dest_frame);
+  }
+
+  if (options_.gain_correction()) {
+    data->mean_intensity = cv::mean(dest_frame)[0];
+  }
+
+  const int window_size = options_.tracking_options().tracking_window_size();
+  const bool with_derivative = options_.compute_derivative_in_pyramid();
+  if (use_cv_tracking_ && !resized && !options_.histogram_equalization() &&
+      tracking_frame.pyramid_levels >= pyramid_levels_ &&
+      tracking_frame.window_size == window_size &&
+      tracking_frame.with_derivative == with_derivative) {
+    // Only the headers are copied; the pyramid is read-only during tracking.
+    data->pyramid = tracking_frame.pyramid;
+    data->pyramid_levels = tracking_frame.pyramid_levels;
+    data->pyramid_shared = true;
+  } else {
+    data->BuildPyramid(pyramid_levels_, window_size, with_derivative);
+  }
+
+  return true;
+}
+
 bool RegionFlowComputation::AddImageAndTrack(
     const cv::Mat& source, const cv::Mat& source_mask, int64 timestamp_usec,
-    const Homography& initial_transform) {
+    const Homography& initial_transform, const TrackingFrame* tracking_frame) {
   VLOG(1) << "Processing frame " << frame_num_ << " at " << timestamp_usec;
   MEASURE_TIME << "AddImageAndTrack";
 
-  if (options_.downsample_mode() ==
-      RegionFlowComputationOptions::DOWNSAMPLE_TO_INPUT_SIZE) {
-    if (frame_width_ != source.cols || frame_height_ != source.rows) {
-      LOG(ERROR) << "Source input dimensions incompatible with "
-                 << "DOWNSAMPLE_TO_INPUT_SIZE. frame_width_: " << frame_width_
-                 << ", source.cols: " << source.cols
-                 << ", frame_height_: " << frame_height_
-                 << ", source.rows: " << source.rows;
-      return false;
-    }
-
-    if (!source_mask.empty()) {
-      if (frame_width_ != source_mask.cols ||
-          frame_height_ != source_mask.rows) {
-        LOG(ERROR) << "Input mask dimensions incompatible with "
-                   << "DOWNSAMPLE_TO_INPUT_SIZE";
+  // Dimensions of tracking frames are handled by InitFrameFromTrackingFrame.
+  if (tracking_frame == nullptr) {
+    if (options_.downsample_mode() ==
+        RegionFlowComputationOptions::DOWNSAMPLE_TO_INPUT_SIZE) {
+      if (frame_width_ != source.cols || frame_height_ != source.rows) {
+        LOG(ERROR) << "Source input dimensions incompatible with "
+                   << "DOWNSAMPLE_TO_INPUT_SIZE. frame_width_: " << frame_width_
+                   << ", source.cols: " << source.cols
+                   << ", frame_height_: " << frame_height_
+                   << ", source.rows: " << source.rows;
         return false;
       }
-    }
-  } else {
-    if (original_width_ != source.cols || original_height_ != source.rows) {
-      LOG(ERROR) << "Source input dimensions differ from those specified "
-                 << "in the constructor";
-      return false;
-    }
-    if (!source_mask.empty()) {
-      if (original_width_ != source_mask.cols ||
-          original_height_ != source_mask.rows) {
-        LOG(ERROR) << "Input mask dimensions incompatible with those "
-                   << "specified in the constructor";
+
+      if (!source_mask.empty()) {
+        if (frame_width_ != source_mask.cols ||
+            frame_height_ != source_mask.rows) {
+          LOG(ERROR) << "Input mask dimensions incompatible with "
+                     << "DOWNSAMPLE_TO_INPUT_SIZE";
+          return false;
+        }
+      }
+    } else {
+      if (original_width_ != source.cols || original_height_ != source.rows) {
+        LOG(ERROR) << "Source input dimensions differ from those specified "
+                   << "in the constructor";
         return false;
       }
+      if (!source_mask.empty()) {
+        if (original_width_ != source_mask.cols ||
+            original_height_ != source_mask.rows) {
+          LOG(ERROR) << "Input mask dimensions incompatible with those "
+                     << "specified in the constructor";
+          return false;
+        }
+      }
     }
   }
 
@@ -1097,7 +1171,9 @@ bool RegionFlowComputation::AddImageAndTrack(
     curr_data->initial_transform.reset(new Homography(transform));
   }
 
-  if (!InitFrame(source, source_mask, curr_data)) {
+  if (tracking_frame != nullptr
+          ? !InitFrameFromTrackingFrame(*tracking_frame, curr_data)
+          : !InitFrame(source, source_mask, curr_data)) {
     LOG(ERROR) << "Could not init frame.";
     return false;
   }
@@ -58,6 +58,7 @@
 #include "mediapipe/util/tracking/region_flow.h"
 #include "mediapipe/util/tracking/region_flow.pb.h"
 #include "mediapipe/util/tracking/region_flow_computation.pb.h"
+#include "mediapipe/util/tracking/tracking_frame.h"
 
 namespace mediapipe {
 class RegionFlowFeatureList;
@@ -104,6 +105,16 @@ class RegionFlowComputation {
                                 const cv::Mat& source_mask,
                                 int64 timestamp_usec);
 
+  // Same as AddImageWithSeed, but tracks a precomputed grayscale frame.
+  // The frame is downscaled if it does not match the tracking resolution.
+  // Its pyramid is used without copying if it was built with the tracking
+  // window size and derivative setting of the options and has sufficient
+  // levels (and histogram equalization is not used); otherwise the pyramid is
+  // rebuilt. Visual consistency is computed from the grayscale frame.
+  virtual bool AddTrackingFrame(const TrackingFrame& tracking_frame,
+                                int64 timestamp_usec,
+                                const Homography& initial_transform);
+
   // Call after AddImage* to retrieve last downscaled, grayscale image.
   cv::Mat GetGrayscaleFrameFromResults();
 
@@ -188,10 +199,16 @@ class RegionFlowComputation {
   bool InitFrame(const cv::Mat& source, const cv::Mat& source_mask,
                  FrameTrackingData* data);
 
-  // Adds image to the current buffer and starts tracking.
+  // Same as above for a precomputed TrackingFrame.
+  bool InitFrameFromTrackingFrame(const TrackingFrame& tracking_frame,
+                                  FrameTrackingData* data);
+
+  // Adds image to the current buffer and starts tracking. If tracking_frame
+  // is set, it is used instead of source and source_mask.
   bool AddImageAndTrack(const cv::Mat& source, const cv::Mat& source_mask,
                         int64 timestamp_usec,
-                        const Homography& initial_transform);
+                        const Homography& initial_transform,
+                        const TrackingFrame* tracking_frame = nullptr);
 
   // Computes *change* in visual difference between adjacent frames. Normalized
   // w.r.t. number of channels and number of pixels. For this to be meaningful
@@ -0,0 +1,71 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/tracking/tracking_frame.h"
+
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/opencv_imgproc_inc.h"
+#include "mediapipe/framework/port/opencv_video_inc.h"
+#include "mediapipe/util/tracking/measure_time.h"
+
+namespace mediapipe {
+
+void ComputeTrackingFrame(const cv::Mat& image, int width, int height,
+                          int pyramid_levels, int window_size,
+                          bool with_derivative, TrackingFrame* tracking_frame) {
+  MEASURE_TIME << "ComputeTrackingFrame";
+  CHECK(tracking_frame != nullptr);
+  CHECK_EQ(CV_8U, image.depth());
+  CHECK_GE(pyramid_levels, 0);
+
+  // Downscale first, so that the color conversion runs on fewer pixels.
+  cv::Mat resized;
+  if (image.cols != width || image.rows != height) {
+    cv::resize(image, resized, cv::Size(width, height), 0, 0, CV_INTER_AREA);
+  } else {
+    resized = image;
+  }
+
+  // Always allocates a new grayscale image, as the previous one might still be
+  // referenced by consumers of an earlier frame.
+  switch (resized.channels()) {
+    case 1:
+      tracking_frame->grayscale = resized.clone();
+      break;
+    case 3:
+      tracking_frame->grayscale = cv::Mat();
+      cv::cvtColor(resized, tracking_frame->grayscale, cv::COLOR_RGB2GRAY);
+      break;
+    case 4:
+      tracking_frame->grayscale = cv::Mat();
+      cv::cvtColor(resized, tracking_frame->grayscale, cv::COLOR_RGBA2GRAY);
+      break;
+    default:
+      LOG(FATAL) << "Unsupported number of channels: " << resized.channels();
+  }
+
+  tracking_frame->pyramid.clear();
+  tracking_frame->pyramid_levels = pyramid_levels;
+  tracking_frame->window_size = window_size;
+  tracking_frame->with_derivative = with_derivative;
+  if (pyramid_levels > 0) {
+    // OpenCV expects the window diameter.
+    tracking_frame->pyramid_levels = cv::buildOpticalFlowPyramid(
+        tracking_frame->grayscale, tracking_frame->pyramid,
+        cv::Size(2 * window_size + 1, 2 * window_size + 1), pyramid_levels,
+        with_derivative);
+  }
+}
+
+}  // namespace mediapipe
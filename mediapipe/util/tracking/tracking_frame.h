@@ -0,0 +1,73 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Grayscale version of a video frame at tracking resolution together with its
+// Lucas-Kanade pyramid. Computed once per frame (e.g. by
+// TrackingFrameCalculator), it can be passed to RegionFlowComputation (via
+// MotionAnalysis::AddTrackingFrame) and BoxDetectorInterface, which otherwise
+// each convert, downscale and build pyramids for the same frame.
+//
+// Example:
+// TrackingFrame tracking_frame;
+// ComputeTrackingFrame(frame, 320, 240, 4, 10, true, &tracking_frame);
+// motion_analysis.AddTrackingFrame(tracking_frame, timestamp_usec);
+// box_detector->DetectAndAddBox(tracking_frame, tracked_boxes, timestamp_msec,
+//                               &detected_boxes);
+
+#ifndef MEDIAPIPE_UTIL_TRACKING_TRACKING_FRAME_H_
+#define MEDIAPIPE_UTIL_TRACKING_TRACKING_FRAME_H_
+
+#include <vector>
+
+#include "mediapipe/framework/port/opencv_core_inc.h"
+
+namespace mediapipe {
+
+struct TrackingFrame {
+  // CV_8UC1 grayscale frame.
+  cv::Mat grayscale;
+
+  // Pyramid of grayscale as computed by cv::buildOpticalFlowPyramid, i.e.
+  // pyramid_levels + 1 images (interleaved with their derivatives if
+  // with_derivative is set). Empty if pyramid_levels is zero.
+  // Consumers only read the pyramid, so it can be shared across calculators.
+  std::vector<cv::Mat> pyramid;
+
+  // Parameters the pyramid was built with. Consumers use the pyramid only if
+  // the parameters are compatible with their own settings, and rebuild it
+  // otherwise.
+  int pyramid_levels = 0;
+  // Tracking window radius, see TrackingOptions::tracking_window_size.
+  int window_size = 0;
+  bool with_derivative = false;
+
+  // Returns the image at the specified pyramid level (level 0 is the
+  // grayscale frame itself).
+  const cv::Mat& PyramidImage(int level) const {
+    return level == 0 ? grayscale
+                      : pyramid[with_derivative ? 2 * level : level];
+  }
+};
+
+// Computes tracking_frame for an 8-bit RGB, RGBA or grayscale image.
+// The image is downscaled to width x height (area based) before conversion to
+// grayscale. A pyramid with pyramid_levels levels is built for tracking windows
+// of radius window_size, unless pyramid_levels is zero.
+void ComputeTrackingFrame(const cv::Mat& image, int width, int height,
+                          int pyramid_levels, int window_size,
+                          bool with_derivative, TrackingFrame* tracking_frame);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_TRACKING_TRACKING_FRAME_H_
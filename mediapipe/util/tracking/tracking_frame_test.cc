@@ -0,0 +1,144 @@
+// Copyright 2021 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/tracking/tracking_frame.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/deps/file_path.h"
+#include "mediapipe/framework/port/file_helpers.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/opencv_core_inc.h"
+#include "mediapipe/framework/port/opencv_highgui_inc.h"
+#include "mediapipe/framework/port/opencv_imgproc_inc.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/util/tracking/region_flow.pb.h"
+#include "mediapipe/util/tracking/region_flow_computation.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr int kNumFrames = 10;
+
+class TrackingFrameTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::string png_data;
+    MEDIAPIPE_CHECK_OK(file::GetContents(
+        file::JoinPath("./", "/mediapipe/util/tracking/testdata/",
+                       "stabilize_test.png"),
+        &png_data));
+    std::vector<char> buffer(png_data.begin(), png_data.end());
+    cv::Mat bgr_frame = cv::imdecode(cv::Mat(buffer), 1);
+    ASSERT_FALSE(bgr_frame.empty());
+    cv::cvtColor(bgr_frame, original_frame_, cv::COLOR_BGR2RGB);
+
+    // Creates a movie by moving the image diagonally.
+    constexpr int kBorder = 20;
+    const int frame_width = original_frame_.cols - 2 * kBorder;
+    const int frame_height = original_frame_.rows - 2 * kBorder;
+    for (int f = 0; f < kNumFrames; ++f) {
+      movie_.push_back(original_frame_(cv::Rect(2 * kBorder - 4 * f,
+                                                2 * kBorder - 4 * f,
+                                                frame_width, frame_height))
+                           .clone());
+    }
+
+    options_.set_image_format(RegionFlowComputationOptions::FORMAT_RGB);
+  }
+
+  // Tracks movie_ via AddImage and via AddTrackingFrame with TrackingFrames
+  // computed with the specified parameters, and expects the same features.
+  void ExpectSameFlow(int pyramid_levels, int window_size) {
+    const int width = movie_[0].cols;
+    const int height = movie_[0].rows;
+    RegionFlowComputation image_flow(options_, width, height);
+    RegionFlowComputation tracking_frame_flow(options_, width, height);
+    for (int f = 0; f < kNumFrames; ++f) {
+      ASSERT_TRUE(image_flow.AddImage(movie_[f], f));
+      TrackingFrame tracking_frame;
+      ComputeTrackingFrame(movie_[f], width, height, pyramid_levels,
+                           window_size,
+                           options_.compute_derivative_in_pyramid(),
+                           &tracking_frame);
+      ASSERT_TRUE(tracking_frame_flow.AddTrackingFrame(tracking_frame, f,
+                                                       Homography()));
+
+      std::unique_ptr<RegionFlowFeatureList> expected(
+          image_flow.RetrieveRegionFlowFeatureList(false, false, nullptr,
+                                                   nullptr));
+      std::unique_ptr<RegionFlowFeatureList> features(
+          tracking_frame_flow.RetrieveRegionFlowFeatureList(false, false,
+                                                            nullptr, nullptr));
+      ASSERT_EQ(expected->feature_size(), features->feature_size())
+          << "Frame " << f;
+      for (int k = 0; k < features->feature_size(); ++k) {
+        EXPECT_NEAR(expected->feature(k).x(), features->feature(k).x(), 1e-3f);
+        EXPECT_NEAR(expected->feature(k).y(), features->feature(k).y(), 1e-3f);
+        EXPECT_NEAR(expected->feature(k).dx(), features->feature(k).dx(),
+                    1e-3f);
+        EXPECT_NEAR(expected->feature(k).dy(), features->feature(k).dy(),
+                    1e-3f);
+      }
+    }
+  }
+
+  cv::Mat original_frame_;
+  std::vector<cv::Mat> movie_;
+  RegionFlowComputationOptions options_;
+};
+
+TEST_F(TrackingFrameTest, ComputesGrayscaleAndPyramid) {
+  TrackingFrame tracking_frame;
+  const int width = original_frame_.cols / 2;
+  const int height = original_frame_.rows / 2;
+  ComputeTrackingFrame(original_frame_, width, height, 3, 10, true,
+                       &tracking_frame);
+
+  EXPECT_EQ(CV_8UC1, tracking_frame.grayscale.type());
+  EXPECT_EQ(width, tracking_frame.grayscale.cols);
+  EXPECT_EQ(height, tracking_frame.grayscale.rows);
+  EXPECT_EQ(3, tracking_frame.pyramid_levels);
+  EXPECT_EQ(10, tracking_frame.window_size);
+  EXPECT_TRUE(tracking_frame.with_derivative);
+  // Image and derivative per level.
+  EXPECT_EQ(8, tracking_frame.pyramid.size());
+  for (int level = 1; level <= 3; ++level) {
+    const cv::Mat& image = tracking_frame.PyramidImage(level);
+    EXPECT_EQ(CV_8UC1, image.type());
+    EXPECT_EQ((tracking_frame.PyramidImage(level - 1).cols + 1) / 2,
+              image.cols);
+    EXPECT_EQ((tracking_frame.PyramidImage(level - 1).rows + 1) / 2,
+              image.rows);
+  }
+}
+
+TEST_F(TrackingFrameTest, RegionFlowMatchesImageInputWithSharedPyramid) {
+  ExpectSameFlow(/*pyramid_levels=*/6,
+                 options_.tracking_options().tracking_window_size());
+}
+
+TEST_F(TrackingFrameTest, RegionFlowMatchesImageInputWithRebuiltPyramid) {
+  // Different window size, so that the pyramid is rebuilt.
+  ExpectSameFlow(/*pyramid_levels=*/6,
+                 options_.tracking_options().tracking_window_size() + 1);
+  // No pyramid.
+  ExpectSameFlow(/*pyramid_levels=*/0,
+                 options_.tracking_options().tracking_window_size());
+}
+
+}  // namespace
+}  // namespace mediapipe